@@ -0,0 +1,226 @@
+#ifndef ACCESSOR_H
+#define ACCESSOR_H
+
+#include <json.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Vertex.h"
+
+// Component types a glTF accessor can store its elements in.
+enum class ComponentType : unsigned int
+{
+    Byte          = 5120,
+    UnsignedByte  = 5121,
+    Short         = 5122,
+    UnsignedShort = 5123,
+    UnsignedInt   = 5125,
+    Float         = 5126
+};
+
+// Size in bytes of a single component of the given type.
+inline unsigned int componentSize(ComponentType type)
+{
+    switch (type)
+    {
+    case ComponentType::Byte:
+    case ComponentType::UnsignedByte:
+        return 1;
+    case ComponentType::Short:
+    case ComponentType::UnsignedShort:
+        return 2;
+    case ComponentType::UnsignedInt:
+    case ComponentType::Float:
+        return 4;
+    }
+    throw std::invalid_argument("Component type is invalid");
+}
+
+// Number of components per element for a glTF accessor type.
+inline unsigned int componentCount(const std::string& type)
+{
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2")   return 2;
+    if (type == "VEC3")   return 3;
+    if (type == "VEC4")   return 4;
+    if (type == "MAT2")   return 4;
+    if (type == "MAT3")   return 9;
+    if (type == "MAT4")   return 16;
+    throw std::invalid_argument("Type is invalid (not SCALAR, VEC2, VEC3, VEC4 or MATn)");
+}
+
+// A typed, strided view straight into a loaded glTF buffer. Owns nothing, so it is only valid
+// as long as the buffer it was made from.
+struct AccessorView
+{
+    const unsigned char* data = nullptr;     // First byte of the first element.
+    size_t count = 0;                        // Number of elements.
+    size_t stride = 0;                       // Bytes between two consecutive elements.
+    unsigned int components = 0;             // Components per element (1 for SCALAR, 3 for VEC3...).
+    ComponentType componentType = ComponentType::Float;
+    bool normalized = false;                 // Integer components map to [0, 1] or [-1, 1].
+
+    bool empty() const { return data == nullptr || count == 0; }
+
+    // Reads component 'c' of element 'i' as a float, honouring the normalized flag.
+    float readFloat(size_t i, unsigned int c) const
+    {
+        const unsigned char* src = data + i * stride + c * componentSize(componentType);
+        switch (componentType)
+        {
+        case ComponentType::Float:
+        {
+            float value;
+            std::memcpy(&value, src, sizeof(float));
+            return value;
+        }
+        case ComponentType::UnsignedByte:
+            return normalized ? *src / 255.0f : (float)*src;
+        case ComponentType::Byte:
+        {
+            int8_t value;
+            std::memcpy(&value, src, sizeof(int8_t));
+            return normalized ? std::max(value / 127.0f, -1.0f) : (float)value;
+        }
+        case ComponentType::UnsignedShort:
+        {
+            uint16_t value;
+            std::memcpy(&value, src, sizeof(uint16_t));
+            return normalized ? value / 65535.0f : (float)value;
+        }
+        case ComponentType::Short:
+        {
+            int16_t value;
+            std::memcpy(&value, src, sizeof(int16_t));
+            return normalized ? std::max(value / 32767.0f, -1.0f) : (float)value;
+        }
+        case ComponentType::UnsignedInt:
+        {
+            uint32_t value;
+            std::memcpy(&value, src, sizeof(uint32_t));
+            return (float)value;
+        }
+        }
+        return 0.0f;
+    }
+
+    // Reads up to 'n' components of element 'i' into 'dst', zero filling what the accessor doesn't have.
+    void readElement(size_t i, float* dst, unsigned int n) const
+    {
+        unsigned int available = n < components ? n : components;
+        if (empty())
+            available = 0;
+        else if (componentType == ComponentType::Float)
+            std::memcpy(dst, data + i * stride, available * sizeof(float));
+        else
+            for (unsigned int c = 0; c < available; c++)
+                dst[c] = readFloat(i, c);
+
+        for (unsigned int c = available; c < n; c++)
+            dst[c] = 0.0f;
+    }
+};
+
+// Builds a view over the elements of accessor 'accessorIndex'. A negative index, or an accessor
+// without a bufferView (all zeros by the spec), yields an empty view.
+inline AccessorView makeAccessorView(const nlohmann::json& gltf, int accessorIndex, const std::vector<std::vector<unsigned char>>& buffers)
+{
+    AccessorView view;
+    if (accessorIndex < 0)
+        return view;
+
+    const nlohmann::json& accessor = gltf["accessors"][accessorIndex];
+    view.count = accessor["count"];
+    view.components = componentCount(accessor["type"]);
+    view.componentType = static_cast<ComponentType>(accessor["componentType"].get<unsigned int>());
+    view.normalized = accessor.value("normalized", false);
+
+    if (!accessor.contains("bufferView"))
+        return view;
+
+    const nlohmann::json& bufferView = gltf["bufferViews"][accessor["bufferView"].get<unsigned int>()];
+    unsigned int bufferIndex = bufferView.value("buffer", 0u);
+    size_t byteOffset = bufferView.value("byteOffset", (size_t)0) + accessor.value("byteOffset", (size_t)0);
+    size_t byteLength = bufferView["byteLength"];
+    size_t elementSize = (size_t)view.components * componentSize(view.componentType);
+    view.stride = bufferView.value("byteStride", elementSize);
+
+    // Make sure every element we are going to touch actually lives inside the bufferView and the buffer.
+    size_t viewEnd = bufferView.value("byteOffset", (size_t)0) + byteLength;
+    size_t accessorEnd = view.count ? byteOffset + (view.count - 1) * view.stride + elementSize : byteOffset;
+    if (bufferIndex >= buffers.size() || accessorEnd > viewEnd || viewEnd > buffers[bufferIndex].size())
+        throw std::out_of_range("Accessor " + std::to_string(accessorIndex) + " reaches outside of its buffer");
+
+    view.data = buffers[bufferIndex].data() + byteOffset;
+    return view;
+}
+
+// Fills the interleaved vertex array in a single pass over all the attribute views.
+// Attributes that are missing are left as zeros.
+inline void assembleVertices(const AccessorView& positions, const AccessorView& normals, const AccessorView& tangents,
+    const AccessorView& texCoords, Vertex* vertices, size_t count)
+{
+    const AccessorView* attributes[] = { &positions, &normals, &tangents, &texCoords };
+    for (const AccessorView* attribute : attributes)
+        if (!attribute->empty() && attribute->count < count)
+            throw std::out_of_range("Vertex attribute has fewer elements than the mesh has vertices");
+
+    for (size_t i = 0; i < count; i++)
+    {
+        Vertex& vertex = vertices[i];
+        positions.readElement(i, &vertex.Position.x, 3);
+        normals.readElement(i, &vertex.Normal.x, 3);
+        // Tangents are VEC4 with handedness in w, which we don't use.
+        tangents.readElement(i, &vertex.Tangent.x, 3);
+        texCoords.readElement(i, &vertex.TexCoord.x, 2);
+    }
+}
+
+// Decodes an index accessor of any unsigned (or legacy signed short) component type to 32 bit indices.
+inline void readIndices(const AccessorView& view, uint32_t* indices)
+{
+    if (view.empty())
+        return;
+
+    switch (view.componentType)
+    {
+    case ComponentType::UnsignedInt:
+        if (view.stride == sizeof(uint32_t))
+        {
+            std::memcpy(indices, view.data, view.count * sizeof(uint32_t));
+            return;
+        }
+        for (size_t i = 0; i < view.count; i++)
+            std::memcpy(&indices[i], view.data + i * view.stride, sizeof(uint32_t));
+        return;
+    case ComponentType::UnsignedShort:
+        for (size_t i = 0; i < view.count; i++)
+        {
+            uint16_t value;
+            std::memcpy(&value, view.data + i * view.stride, sizeof(uint16_t));
+            indices[i] = value;
+        }
+        return;
+    case ComponentType::Short:
+        for (size_t i = 0; i < view.count; i++)
+        {
+            int16_t value;
+            std::memcpy(&value, view.data + i * view.stride, sizeof(int16_t));
+            indices[i] = (uint32_t)value;
+        }
+        return;
+    case ComponentType::UnsignedByte:
+        for (size_t i = 0; i < view.count; i++)
+            indices[i] = view.data[i * view.stride];
+        return;
+    default:
+        throw std::invalid_argument("Index accessor must be UNSIGNED_BYTE, UNSIGNED_SHORT or UNSIGNED_INT");
+    }
+}
+
+#endif
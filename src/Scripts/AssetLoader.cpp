@@ -0,0 +1,193 @@
+#include "AssetLoader.h"
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+
+// Maps the package baked from 'file' if there is one that is at least as new as the .gltf
+static std::shared_ptr<PackageReader> openPackage(const std::string& file)
+{
+	namespace fs = std::filesystem;
+	std::error_code error;
+
+	fs::path package = fs::path(file).replace_extension(".pack");
+	if (!fs::exists(package, error))
+		return nullptr;
+
+	if (fs::last_write_time(package, error) < fs::last_write_time(file, error))
+	{
+		std::cout << "Package " << package.string() << " is older than its source, loading the .gltf instead." << std::endl;
+		return nullptr;
+	}
+
+	try
+	{
+		return std::make_shared<PackageReader>(package.string().c_str());
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return nullptr;
+	}
+}
+
+void AssetLoader::LoadModel(Model& model, const std::string& file)
+{
+	Schedule([this, &model, file]()
+	{
+		// A baked package skips the JSON, the buffer copies and the image decoding, everything uploads from the mapping
+		if (std::shared_ptr<PackageReader> package = openPackage(file))
+		{
+			QueueUpload([&model, package]() { model.UploadPackage(*package); });
+			for (unsigned int image = 0; image < package->imageCount(); image++)
+			{
+				// Streamed textures start small and grow as their model needs it
+				if (TextureStreamer* streamer = m_Streamer)
+				{
+					QueueUpload([streamer, &model, package, image]() { streamer->Register(model, package, image); });
+					continue;
+				}
+
+				// Images no mesh uses aren't baked
+				TextureData pixels = package->image(image);
+				if (pixels.valid() && pixels.compression != BlockFormat::None && !Texture::CompressedFormatSupported(pixels.compression))
+					pixels = pixels.Decompress();
+				if (pixels.valid())
+					QueueUpload([&model, image, pixels]() { model.UploadTexture(image, pixels); });
+			}
+			return;
+		}
+
+		std::shared_ptr<ModelData> data;
+		try
+		{
+			data = std::make_shared<ModelData>(Model::Decode(file.c_str()));
+		}
+		catch (...)
+		{
+			std::cout << "ERROR::ASSET_LOADER::MODEL_NOT_LOADED " << file << std::endl;
+			return;
+		}
+
+		QueueUpload([&model, data]() { model.Upload(*data); });
+
+		// Only decode the images some mesh actually uses. Their uploads are queued after the geometry
+		// upload above, so the meshes they belong to always exist by the time they run.
+		std::vector<bool> used(data->imagePaths.size(), false);
+		for (const MeshData& mesh : data->meshes)
+			for (int image : mesh.images)
+				if (image >= 0 && image < (int)used.size())
+					used[image] = true;
+
+		for (unsigned int image = 0; image < used.size(); image++)
+		{
+			if (!used[image])
+				continue;
+
+			std::string path = data->imagePaths[image];
+			Schedule([this, &model, image, path]()
+			{
+				TextureData pixels = TextureData::Decode(path.c_str());
+				if (!pixels.valid())
+				{
+					std::cout << "Texture failed to load at path: " << path << std::endl;
+					return;
+				}
+				QueueUpload([&model, image, pixels]() { model.UploadTexture(image, pixels); });
+			});
+		}
+	});
+}
+
+void AssetLoader::LoadPixels(const std::string& file, bool hdr, std::function<void(TextureData&)> onDecoded)
+{
+	Schedule([this, file, hdr, onDecoded]()
+	{
+		TextureData pixels = TextureData::Decode(file.c_str(), hdr);
+		if (!pixels.valid())
+		{
+			std::cout << "Texture failed to load at path: " << file << std::endl;
+			return;
+		}
+		QueueUpload([pixels, onDecoded]() mutable { onDecoded(pixels); });
+	});
+}
+
+void AssetLoader::Load(std::function<std::function<void()>()> load)
+{
+	Schedule([this, load]()
+	{
+		if (std::function<void()> upload = load())
+			QueueUpload(std::move(upload));
+	});
+}
+
+void AssetLoader::ProcessUploads(double budgetMs)
+{
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point start = Clock::now();
+
+	do
+	{
+		std::function<void()> upload;
+		{
+			std::lock_guard<std::mutex> lock(m_UploadMutex);
+			if (m_Uploads.empty())
+				return;
+			upload = std::move(m_Uploads.front());
+			m_Uploads.pop_front();
+		}
+
+		try
+		{
+			upload();
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "ERROR::ASSET_LOADER::UPLOAD_FAILED " << e.what() << std::endl;
+		}
+		catch (...)
+		{
+			std::cout << "ERROR::ASSET_LOADER::UPLOAD_FAILED" << std::endl;
+		}
+		m_InFlight--;
+	} while (std::chrono::duration<double, std::milli>(Clock::now() - start).count() < budgetMs);
+}
+
+void AssetLoader::Shutdown()
+{
+	m_Jobs.Wait();
+
+	std::lock_guard<std::mutex> lock(m_UploadMutex);
+	m_InFlight -= (int)m_Uploads.size();
+	m_Uploads.clear();
+}
+
+void AssetLoader::Schedule(std::function<void()> job)
+{
+	m_InFlight++;
+	m_Jobs.Schedule([this, job]()
+	{
+		// A decode that throws still counts as finished, or the loader would never be idle again
+		try
+		{
+			job();
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "ERROR::ASSET_LOADER::DECODE_FAILED " << e.what() << std::endl;
+		}
+		catch (...)
+		{
+			std::cout << "ERROR::ASSET_LOADER::DECODE_FAILED" << std::endl;
+		}
+		m_InFlight--;
+	});
+}
+
+void AssetLoader::QueueUpload(std::function<void()> upload)
+{
+	m_InFlight++;
+	std::lock_guard<std::mutex> lock(m_UploadMutex);
+	m_Uploads.push_back(std::move(upload));
+}
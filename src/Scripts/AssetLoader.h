@@ -0,0 +1,58 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include "JobSystem.h"
+#include "Model.h"
+#include "TextureStreamer.h"
+
+// Streams assets in without blocking the GL thread.
+// Parsing, file reads and image decoding run on the job system, the finished data is handed back
+// to the GL thread through an upload queue that ProcessUploads drains once per frame.
+class AssetLoader
+{
+public:
+	// Decodes on 'jobs', which must outlive the loader
+	explicit AssetLoader(JobSystem& jobs) : m_Jobs(jobs) {}
+	~AssetLoader() { Shutdown(); }
+
+	// Decodes 'file' in the background. The model's geometry shows up first and its textures follow
+	// one by one, until then the model simply draws nothing (or untextured). 'model' must outlive the load.
+	// If a baked .pack sits next to the .gltf it is mapped and uploaded from instead.
+	void LoadModel(Model& model, const std::string& file);
+	// Hands the textures of packages loaded from now on to 'streamer' instead of uploading all their levels, nullptr uploads everything.
+	void SetTextureStreamer(TextureStreamer* streamer) { m_Streamer = streamer; }
+	// Decodes an image in the background and calls 'onDecoded' with the pixels on the GL thread.
+	void LoadPixels(const std::string& file, bool hdr, std::function<void(TextureData&)> onDecoded);
+	// Runs 'load' in the background, then the upload it returns (if any) on the GL thread.
+	void Load(std::function<std::function<void()>()> load);
+
+	// Runs queued GL uploads until the queue is empty or 'budgetMs' milliseconds are spent.
+	// At least one upload runs per call so loading always makes progress. GL thread only.
+	void ProcessUploads(double budgetMs);
+
+	// True once every decode has finished and every upload has run.
+	bool IsIdle() const { return m_InFlight.load() == 0; }
+
+	// Waits for the job system and drops any upload that hasn't run yet.
+	void Shutdown();
+
+private:
+	// Runs 'job' on the job system, counted in flight until it returns or throws
+	void Schedule(std::function<void()> job);
+	void QueueUpload(std::function<void()> upload);
+
+	JobSystem& m_Jobs;
+	TextureStreamer* m_Streamer = nullptr;
+	std::mutex m_UploadMutex;
+	std::deque<std::function<void()>> m_Uploads;
+	///<summary>Decode jobs plus uploads that haven't finished yet.</summary>
+	std::atomic<int> m_InFlight{ 0 };
+};
+
+#endif
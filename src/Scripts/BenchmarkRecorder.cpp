@@ -0,0 +1,188 @@
+#include "BenchmarkRecorder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+#include <json.h>
+
+using json = nlohmann::json;
+
+void BenchmarkRecorder::Init()
+{
+	GLint bits = 0;
+	glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+	m_GpuTimer = bits > 0;
+	if (!m_GpuTimer)
+		return;
+
+	for (Slot& slot : m_Slots)
+	{
+		glGenQueries(1, &slot.begin);
+		glGenQueries(1, &slot.end);
+	}
+}
+
+void BenchmarkRecorder::Destroy()
+{
+	for (Slot& slot : m_Slots)
+	{
+		if (slot.begin != 0)
+		{
+			glDeleteQueries(1, &slot.begin);
+			glDeleteQueries(1, &slot.end);
+		}
+		slot = Slot();
+	}
+	m_GpuTimer = false;
+}
+
+void BenchmarkRecorder::BeginFrame()
+{
+	m_FrameStart = std::chrono::steady_clock::now();
+	if (!m_GpuTimer)
+		return;
+
+	//The Slot Was Last Used QueryLatency Frames Ago, Its Queries Are Done by Now on Anything But a Stalled GPU.
+	Slot& slot = m_Slots[m_Frame % QueryLatency];
+	if (slot.pending)
+		Resolve(slot);
+	glQueryCounter(slot.begin, GL_TIMESTAMP);
+}
+
+void BenchmarkRecorder::EndFrame(bool measured)
+{
+	if (measured)
+		m_CpuMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_FrameStart).count());
+
+	if (m_GpuTimer)
+	{
+		Slot& slot = m_Slots[m_Frame % QueryLatency];
+		glQueryCounter(slot.end, GL_TIMESTAMP);
+		slot.pending = true;
+		slot.measured = measured;
+	}
+	m_Frame++;
+}
+
+void BenchmarkRecorder::Finish()
+{
+	// Oldest first, so the GPU times stay in frame order
+	for (unsigned int i = 0; i < QueryLatency; i++)
+	{
+		Slot& slot = m_Slots[(m_Frame + i) % QueryLatency];
+		if (slot.pending)
+			Resolve(slot);
+	}
+}
+
+void BenchmarkRecorder::Resolve(Slot& slot)
+{
+	// Blocks until the GPU got there
+	GLuint64 begin = 0, end = 0;
+	glGetQueryObjectui64v(slot.begin, GL_QUERY_RESULT, &begin);
+	glGetQueryObjectui64v(slot.end, GL_QUERY_RESULT, &end);
+	if (slot.measured)
+		m_GpuMs.push_back(end > begin ? (end - begin) / 1e6 : 0.0);
+	slot.pending = false;
+}
+
+// Value below which 'percent' percent of the sorted times lie, by nearest rank
+static double percentile(const std::vector<double>& sorted, double percent)
+{
+	const size_t rank = (size_t)std::ceil(percent / 100.0 * sorted.size());
+	return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+static json statistics(const std::vector<double>& times, unsigned int buckets)
+{
+	if (times.empty())
+		return json();
+
+	std::vector<double> sorted = times;
+	std::sort(sorted.begin(), sorted.end());
+	double sum = 0.0;
+	for (double time : sorted)
+		sum += time;
+
+	// Buckets 1, 2 or 5 times a power of ten wide, so histograms of different runs line up
+	const double low = sorted.front(), high = sorted.back();
+	const double rough = std::max((high - low) / buckets, 1e-3);
+	const double magnitude = std::pow(10.0, std::floor(std::log10(rough)));
+	double width = 10.0 * magnitude;
+	for (double step : { 1.0, 2.0, 5.0 })
+	{
+		if (step * magnitude >= rough)
+		{
+			width = step * magnitude;
+			break;
+		}
+	}
+	const double start = std::floor(low / width) * width;
+	std::vector<size_t> counts((size_t)((high - start) / width) + 1, 0);
+	for (double time : sorted)
+		counts[std::min(counts.size() - 1, (size_t)((time - start) / width))]++;
+
+	json stats;
+	stats["mean"] = sum / sorted.size();
+	stats["min"] = low;
+	stats["max"] = high;
+	stats["p50"] = percentile(sorted, 50.0);
+	stats["p95"] = percentile(sorted, 95.0);
+	stats["p99"] = percentile(sorted, 99.0);
+	stats["histogram"] = { { "startMs", start }, { "bucketMs", width }, { "counts", counts } };
+	stats["frames"] = times;
+	return stats;
+}
+
+bool BenchmarkRecorder::WriteReport(const std::string& path, const BenchmarkInfo& info) const
+{
+	char date[32];
+	const std::time_t now = std::time(nullptr);
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+	json report;
+	report["date"] = date;
+	report["renderer"] = info.renderer;
+	report["glVersion"] = info.glVersion;
+	report["cameraPath"] = info.cameraPath;
+	report["width"] = info.width;
+	report["height"] = info.height;
+	report["frameTime"] = info.frameTime;
+	report["daysSinceJ2000"] = info.days;
+	report["reversedZ"] = info.reversedZ;
+	report["multiDrawIndirect"] = info.multiDrawIndirect;
+	report["warmupFrames"] = info.warmupFrames;
+	report["frames"] = m_CpuMs.size();
+	report["cpuMs"] = statistics(m_CpuMs, HistogramBuckets);
+	report["gpuMs"] = statistics(m_GpuMs, HistogramBuckets);
+
+	std::ofstream out(path);
+	if (!out)
+		return false;
+	out << report.dump(2) << std::endl;
+	return (bool)out;
+}
+
+std::string BenchmarkRecorder::Summary() const
+{
+	std::ostringstream summary;
+	summary.setf(std::ios::fixed);
+	summary.precision(3);
+	const char* names[2] = { "CPU", "GPU" };
+	const std::vector<double>* series[2] = { &m_CpuMs, &m_GpuMs };
+	for (int i = 0; i < 2; i++)
+	{
+		std::vector<double> sorted = *series[i];
+		std::sort(sorted.begin(), sorted.end());
+		summary << names[i] << " ms/frame: ";
+		if (sorted.empty())
+			summary << "not measured" << std::endl;
+		else
+			summary << "p50 " << percentile(sorted, 50.0) << ", p95 " << percentile(sorted, 95.0) << ", p99 " << percentile(sorted, 99.0)
+					<< ", max " << sorted.back() << std::endl;
+	}
+	return summary.str();
+}
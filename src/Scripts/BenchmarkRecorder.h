@@ -0,0 +1,72 @@
+#ifndef BENCHMARK_RECORDER_H
+#define BENCHMARK_RECORDER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../../vendor/glad/include/glad.h"
+
+// What a benchmark ran on and with, written at the top of its report
+struct BenchmarkInfo
+{
+	std::string renderer, glVersion, cameraPath;
+	int width = 0, height = 0, warmupFrames = 0;
+	float frameTime = 0.0f;
+	double days = 0.0;
+	bool reversedZ = false, multiDrawIndirect = false;
+};
+
+// Records the CPU and GPU time of every frame of a benchmark run and writes their percentiles and histograms as JSON.
+// CPU time runs from BeginFrame until EndFrame, once the frame is submitted. GPU time is between timestamp queries written
+// at the same two points, read back QueryLatency frames later so the run never waits on the GPU for them.
+// Warmup frames are timed like the others but left out of the report. GL thread only.
+class BenchmarkRecorder
+{
+public:
+	// Frames a timestamp query has to finish before it is read
+	static const unsigned int QueryLatency = 4;
+	// Histograms have about this many buckets, each a round number of milliseconds wide
+	static const unsigned int HistogramBuckets = 40;
+
+	BenchmarkRecorder() {}
+	BenchmarkRecorder(const BenchmarkRecorder&) = delete;
+	BenchmarkRecorder& operator=(const BenchmarkRecorder&) = delete;
+
+	// Creates the queries, GPU times are left out if the driver's timestamps have no bits
+	void Init();
+	// Deletes the queries, call while the context is still alive
+	void Destroy();
+
+	void BeginFrame();
+	// Ends the frame started by BeginFrame, 'measured' is false for warmup frames
+	void EndFrame(bool measured);
+	// Waits for the GPU times of the frames still in flight
+	void Finish();
+
+	// Writes the report to 'path', false if it can't be written. Call after Finish.
+	bool WriteReport(const std::string& path, const BenchmarkInfo& info) const;
+	// One line each of the CPU and GPU percentiles, for the console
+	std::string Summary() const;
+
+	size_t MeasuredFrames() const { return m_CpuMs.size(); }
+
+private:
+	struct Slot
+	{
+		GLuint begin = 0, end = 0;
+		bool pending = false, measured = false;
+	};
+
+	// Reads the GPU time of 'slot', waiting for it if it isn't done yet
+	void Resolve(Slot& slot);
+
+	Slot m_Slots[QueryLatency];
+	unsigned int m_Frame = 0;
+	bool m_GpuTimer = false;
+	std::chrono::steady_clock::time_point m_FrameStart;
+
+	std::vector<double> m_CpuMs, m_GpuMs;
+};
+
+#endif
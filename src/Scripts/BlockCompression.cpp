@@ -0,0 +1,537 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// The 16 texels of a block, RGBA
+	typedef float Block[16][4];
+
+	// Reads the block at ('blockX', 'blockY'), texels past the edge repeat the last row or column
+	void LoadBlock(const unsigned char* pixels, int width, int height, int channels, int blockX, int blockY, Block block)
+	{
+		for (int y = 0; y < 4; y++)
+		{
+			const int row = std::min(blockY * 4 + y, height - 1);
+			for (int x = 0; x < 4; x++)
+			{
+				const int column = std::min(blockX * 4 + x, width - 1);
+				const unsigned char* texel = pixels + ((size_t)row * width + column) * channels;
+				for (int c = 0; c < 4; c++)
+					block[y * 4 + x][c] = c < channels ? texel[c] : (c == 3 ? 255.0f : 0.0f);
+			}
+		}
+	}
+
+	// Writes the texels of a decoded block that lie inside the image
+	void StoreBlock(const unsigned char decoded[16][4], int width, int height, int channels, int blockX, int blockY, unsigned char* pixels)
+	{
+		for (int y = 0; y < 4 && blockY * 4 + y < height; y++)
+			for (int x = 0; x < 4 && blockX * 4 + x < width; x++)
+				std::memcpy(pixels + ((size_t)(blockY * 4 + y) * width + blockX * 4 + x) * channels, decoded[y * 4 + x], channels);
+	}
+
+	// Direction of the largest spread of 'count' dimensional points around their mean, by power iteration.
+	// Falls back to the diagonal for a block of a single color.
+	void PrincipalAxis(const Block block, int count, float mean[4], float axis[4])
+	{
+		for (int c = 0; c < count; c++)
+		{
+			mean[c] = 0.0f;
+			for (int i = 0; i < 16; i++)
+				mean[c] += block[i][c];
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[4][4] = {};
+		for (int i = 0; i < 16; i++)
+			for (int a = 0; a < count; a++)
+				for (int b = 0; b < count; b++)
+					covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+
+		// Start from the column of the channel varying the most, a fixed start could be orthogonal to the answer
+		int widest = 0;
+		for (int c = 1; c < count; c++)
+			if (covariance[c][c] > covariance[widest][widest])
+				widest = c;
+		for (int c = 0; c < count; c++)
+			axis[c] = covariance[widest][widest] > 0.0f ? covariance[c][widest] : 1.0f;
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = {};
+			float length = 0.0f;
+			for (int a = 0; a < count; a++)
+			{
+				for (int b = 0; b < count; b++)
+					next[a] += covariance[a][b] * axis[b];
+				length = std::max(length, std::abs(next[a]));
+			}
+			if (length < 1e-6f)
+				break;
+			for (int c = 0; c < count; c++)
+				axis[c] = next[c] / length;
+		}
+	}
+
+	// Endpoints spanning the block along its principal axis
+	void AxisEndpoints(const Block block, int count, float low[4], float high[4])
+	{
+		float mean[4], axis[4];
+		PrincipalAxis(block, count, mean, axis);
+
+		float minimum = 0.0f, maximum = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			float t = 0.0f;
+			for (int c = 0; c < count; c++)
+				t += (block[i][c] - mean[c]) * axis[c];
+			minimum = std::min(minimum, t);
+			maximum = std::max(maximum, t);
+		}
+
+		float lengthSquared = 0.0f;
+		for (int c = 0; c < count; c++)
+			lengthSquared += axis[c] * axis[c];
+		for (int c = 0; c < count; c++)
+		{
+			low[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * minimum / lengthSquared));
+			high[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * maximum / lengthSquared));
+		}
+	}
+
+	// Endpoints minimizing the squared error of 'weights' (0 picks 'a', 1 picks 'b') over the block, false if they are degenerate
+	bool LeastSquaresEndpoints(const Block block, int count, const float weights[16], float a[4], float b[4])
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = {}, bx[4] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			const float wb = weights[i], wa = 1.0f - wb;
+			aa += wa * wa;
+			ab += wa * wb;
+			bb += wb * wb;
+			for (int c = 0; c < count; c++)
+			{
+				ax[c] += wa * block[i][c];
+				bx[c] += wb * block[i][c];
+			}
+		}
+
+		const float determinant = aa * bb - ab * ab;
+		if (std::abs(determinant) < 1e-6f)
+			return false;
+		for (int c = 0; c < count; c++)
+		{
+			a[c] = std::min(255.0f, std::max(0.0f, (ax[c] * bb - bx[c] * ab) / determinant));
+			b[c] = std::min(255.0f, std::max(0.0f, (bx[c] * aa - ax[c] * ab) / determinant));
+		}
+		return true;
+	}
+
+	// Index of the palette entry closest to every texel, returns the total squared error
+	float PickIndices(const Block block, int count, const float palette[][4], int paletteSize, int indices[16])
+	{
+		float total = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			float best = 1e30f;
+			for (int p = 0; p < paletteSize; p++)
+			{
+				float error = 0.0f;
+				for (int c = 0; c < count; c++)
+				{
+					float d = block[i][c] - palette[p][c];
+					error += d * d;
+				}
+				if (error < best)
+				{
+					best = error;
+					indices[i] = p;
+				}
+			}
+			total += best;
+		}
+		return total;
+	}
+
+	#pragma region BC1
+
+	uint16_t To565(const float color[4])
+	{
+		int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+		int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+		int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	void From565(uint16_t packed, float color[4])
+	{
+		int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = (float)((r << 3) | (r >> 2));
+		color[1] = (float)((g << 2) | (g >> 4));
+		color[2] = (float)((b << 3) | (b >> 2));
+		color[3] = 255.0f;
+	}
+
+	// The four colors of a block in four color mode, in index order
+	void BC1Palette(uint16_t color0, uint16_t color1, float palette[4][4])
+	{
+		From565(color0, palette[0]);
+		From565(color1, palette[1]);
+		for (int c = 0; c < 4; c++)
+		{
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+	}
+
+	// Encodes the RGB of 'block' into 8 bytes, always in four color mode so it is valid inside BC3 too
+	void EncodeBC1(const Block block, unsigned char* out)
+	{
+		float low[4], high[4];
+		AxisEndpoints(block, 3, low, high);
+		uint16_t color0 = To565(high), color1 = To565(low);
+
+		// Refit the endpoints to the indices they produce, keep whichever is better
+		int indices[16];
+		float palette[4][4];
+		BC1Palette(color0, color1, palette);
+		float error = PickIndices(block, 3, palette, 4, indices);
+		for (int iteration = 0; iteration < 2 && color0 != color1; iteration++)
+		{
+			static const float IndexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+			float weights[16], a[4], b[4];
+			for (int i = 0; i < 16; i++)
+				weights[i] = IndexWeights[indices[i]];
+			if (!LeastSquaresEndpoints(block, 3, weights, a, b))
+				break;
+
+			uint16_t refit0 = To565(a), refit1 = To565(b);
+			int refitIndices[16];
+			float refitPalette[4][4];
+			BC1Palette(refit0, refit1, refitPalette);
+			float refitError = PickIndices(block, 3, refitPalette, 4, refitIndices);
+			if (refitError >= error)
+				break;
+			color0 = refit0;
+			color1 = refit1;
+			error = refitError;
+			std::copy(refitIndices, refitIndices + 16, indices);
+		}
+
+		// Four color mode needs color0 > color1, swapping the endpoints swaps index 0 with 1 and 2 with 3
+		if (color0 < color1)
+		{
+			std::swap(color0, color1);
+			for (int i = 0; i < 16; i++)
+				indices[i] ^= 1;
+		}
+		else if (color0 == color1)
+		{
+			std::fill(indices, indices + 16, 0);
+		}
+
+		uint32_t bits = 0;
+		for (int i = 0; i < 16; i++)
+			bits |= (uint32_t)indices[i] << (i * 2);
+		out[0] = (unsigned char)(color0 & 0xFF);
+		out[1] = (unsigned char)(color0 >> 8);
+		out[2] = (unsigned char)(color1 & 0xFF);
+		out[3] = (unsigned char)(color1 >> 8);
+		for (int i = 0; i < 4; i++)
+			out[4 + i] = (unsigned char)(bits >> (i * 8));
+	}
+
+	void DecodeBC1(const unsigned char* in, unsigned char decoded[16][4])
+	{
+		const uint16_t color0 = (uint16_t)(in[0] | (in[1] << 8));
+		const uint16_t color1 = (uint16_t)(in[2] | (in[3] << 8));
+		const uint32_t bits = (uint32_t)in[4] | ((uint32_t)in[5] << 8) | ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+
+		float palette[4][4];
+		BC1Palette(color0, color1, palette);
+		if (color0 <= color1)
+		{
+			// Three color mode, the fourth entry is transparent black
+			for (int c = 0; c < 4; c++)
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) * 0.5f;
+				palette[3][c] = 0.0f;
+			}
+		}
+
+		for (int i = 0; i < 16; i++)
+			for (int c = 0; c < 4; c++)
+				decoded[i][c] = (unsigned char)(palette[(bits >> (i * 2)) & 3][c] + 0.5f);
+	}
+
+	#pragma endregion
+
+	#pragma region BC4
+
+	// Encodes channel 'channel' of 'block' into 8 bytes, in eight value mode
+	void EncodeBC4(const Block block, int channel, unsigned char* out)
+	{
+		float minimum = 255.0f, maximum = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			minimum = std::min(minimum, block[i][channel]);
+			maximum = std::max(maximum, block[i][channel]);
+		}
+
+		const int value0 = (int)(maximum + 0.5f), value1 = (int)(minimum + 0.5f);
+		uint64_t bits = 0;
+		if (value0 > value1)
+		{
+			// Index 0 is value0, 1 is value1 and 2 - 7 step from value0 to value1 in sevenths
+			for (int i = 0; i < 16; i++)
+			{
+				int step = (int)((value0 - block[i][channel]) * 7.0f / (value0 - value1) + 0.5f);
+				step = std::min(7, std::max(0, step));
+				int index = step == 0 ? 0 : (step == 7 ? 1 : step + 1);
+				bits |= (uint64_t)index << (i * 3);
+			}
+		}
+
+		out[0] = (unsigned char)value0;
+		out[1] = (unsigned char)value1;
+		for (int i = 0; i < 6; i++)
+			out[2 + i] = (unsigned char)(bits >> (i * 8));
+	}
+
+	void DecodeBC4(const unsigned char* in, int channel, unsigned char decoded[16][4])
+	{
+		const int value0 = in[0], value1 = in[1];
+		uint64_t bits = 0;
+		for (int i = 0; i < 6; i++)
+			bits |= (uint64_t)in[2 + i] << (i * 8);
+
+		int palette[8] = { value0, value1 };
+		if (value0 > value1)
+		{
+			for (int i = 1; i < 7; i++)
+				palette[i + 1] = ((7 - i) * value0 + i * value1 + 3) / 7;
+		}
+		else
+		{
+			for (int i = 1; i < 5; i++)
+				palette[i + 1] = ((5 - i) * value0 + i * value1 + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		for (int i = 0; i < 16; i++)
+			decoded[i][channel] = (unsigned char)palette[(bits >> (i * 3)) & 7];
+	}
+
+	#pragma endregion
+
+	#pragma region BC7
+
+	const int BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Mode 6 endpoint: 7 bits per channel plus a p-bit shared by the channels, as the 8 bit values they decode to
+	struct BC7Endpoint
+	{
+		int quantized[4];
+		int pBit;
+
+		int value(int c) const { return (quantized[c] << 1) | pBit; }
+	};
+
+	// Closest mode 6 endpoint to 'color', trying both p-bits
+	BC7Endpoint QuantizeBC7(const float color[4])
+	{
+		BC7Endpoint best = {};
+		float bestError = 1e30f;
+		for (int pBit = 0; pBit < 2; pBit++)
+		{
+			BC7Endpoint endpoint;
+			endpoint.pBit = pBit;
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++)
+			{
+				endpoint.quantized[c] = std::min(127, std::max(0, (int)((color[c] - pBit) * 0.5f + 0.5f)));
+				float d = (float)endpoint.value(c) - color[c];
+				error += d * d;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				best = endpoint;
+			}
+		}
+		return best;
+	}
+
+	void BC7Palette(const BC7Endpoint& endpoint0, const BC7Endpoint& endpoint1, float palette[16][4])
+	{
+		for (int i = 0; i < 16; i++)
+			for (int c = 0; c < 4; c++)
+				palette[i][c] = (float)(((64 - BC7Weights[i]) * endpoint0.value(c) + BC7Weights[i] * endpoint1.value(c) + 32) >> 6);
+	}
+
+	// Appends the low 'count' bits of 'value' to the 128 bit block, least significant bit first
+	void PutBits(unsigned char* out, int& position, uint32_t value, int count)
+	{
+		for (int i = 0; i < count; i++, position++)
+			if ((value >> i) & 1)
+				out[position >> 3] |= (unsigned char)(1 << (position & 7));
+	}
+
+	uint32_t GetBits(const unsigned char* in, int& position, int count)
+	{
+		uint32_t value = 0;
+		for (int i = 0; i < count; i++, position++)
+			value |= (uint32_t)((in[position >> 3] >> (position & 7)) & 1) << i;
+		return value;
+	}
+
+	// Encodes 'block' as a mode 6 block: one subset, RGBA endpoints and 4 bit indices
+	void EncodeBC7(const Block block, unsigned char* out)
+	{
+		float low[4], high[4];
+		AxisEndpoints(block, 4, low, high);
+		BC7Endpoint endpoint0 = QuantizeBC7(low), endpoint1 = QuantizeBC7(high);
+
+		int indices[16];
+		float palette[16][4];
+		BC7Palette(endpoint0, endpoint1, palette);
+		float error = PickIndices(block, 4, palette, 16, indices);
+
+		for (int iteration = 0; iteration < 2; iteration++)
+		{
+			float weights[16], a[4], b[4];
+			for (int i = 0; i < 16; i++)
+				weights[i] = BC7Weights[indices[i]] / 64.0f;
+			if (!LeastSquaresEndpoints(block, 4, weights, a, b))
+				break;
+
+			BC7Endpoint refit0 = QuantizeBC7(a), refit1 = QuantizeBC7(b);
+			int refitIndices[16];
+			float refitPalette[16][4];
+			BC7Palette(refit0, refit1, refitPalette);
+			float refitError = PickIndices(block, 4, refitPalette, 16, refitIndices);
+			if (refitError >= error)
+				break;
+			endpoint0 = refit0;
+			endpoint1 = refit1;
+			error = refitError;
+			std::copy(refitIndices, refitIndices + 16, indices);
+		}
+
+		// The first index is stored without its top bit, which has to be 0: swap the endpoints if it isn't
+		if (indices[0] >= 8)
+		{
+			std::swap(endpoint0, endpoint1);
+			for (int i = 0; i < 16; i++)
+				indices[i] = 15 - indices[i];
+		}
+
+		std::memset(out, 0, 16);
+		int position = 0;
+		PutBits(out, position, 1u << 6, 7);
+		for (int c = 0; c < 4; c++)
+		{
+			PutBits(out, position, (uint32_t)endpoint0.quantized[c], 7);
+			PutBits(out, position, (uint32_t)endpoint1.quantized[c], 7);
+		}
+		PutBits(out, position, (uint32_t)endpoint0.pBit, 1);
+		PutBits(out, position, (uint32_t)endpoint1.pBit, 1);
+		for (int i = 0; i < 16; i++)
+			PutBits(out, position, (uint32_t)indices[i], i == 0 ? 3 : 4);
+	}
+
+	void DecodeBC7(const unsigned char* in, unsigned char decoded[16][4])
+	{
+		// Only mode 6 is understood, other modes decode to black like an invalid block
+		if ((in[0] & 0x7F) != (1 << 6))
+		{
+			std::memset(decoded, 0, 16 * 4);
+			return;
+		}
+
+		int position = 7;
+		BC7Endpoint endpoint0, endpoint1;
+		for (int c = 0; c < 4; c++)
+		{
+			endpoint0.quantized[c] = (int)GetBits(in, position, 7);
+			endpoint1.quantized[c] = (int)GetBits(in, position, 7);
+		}
+		endpoint0.pBit = (int)GetBits(in, position, 1);
+		endpoint1.pBit = (int)GetBits(in, position, 1);
+
+		float palette[16][4];
+		BC7Palette(endpoint0, endpoint1, palette);
+		for (int i = 0; i < 16; i++)
+		{
+			int index = (int)GetBits(in, position, i == 0 ? 3 : 4);
+			for (int c = 0; c < 4; c++)
+				decoded[i][c] = (unsigned char)palette[index][c];
+		}
+	}
+
+	#pragma endregion
+}
+
+namespace BlockCompression
+{
+	void Encode(BlockFormat format, const unsigned char* pixels, int width, int height, int channels, unsigned char* blocks)
+	{
+		const int blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+		const size_t blockBytes = BlockBytes(format);
+
+		Block block;
+		for (int blockY = 0; blockY < blocksHigh; blockY++)
+		{
+			for (int blockX = 0; blockX < blocksWide; blockX++)
+			{
+				LoadBlock(pixels, width, height, channels, blockX, blockY, block);
+				unsigned char* out = blocks + ((size_t)blockY * blocksWide + blockX) * blockBytes;
+				switch (format)
+				{
+				case BlockFormat::BC1:	EncodeBC1(block, out);											break;
+				case BlockFormat::BC3:	EncodeBC4(block, 3, out); EncodeBC1(block, out + 8);			break;
+				case BlockFormat::BC4:	EncodeBC4(block, 0, out);										break;
+				case BlockFormat::BC5:	EncodeBC4(block, 0, out); EncodeBC4(block, 1, out + 8);			break;
+				case BlockFormat::BC7:	EncodeBC7(block, out);											break;
+				default: break;
+				}
+			}
+		}
+	}
+
+	void Decode(BlockFormat format, const unsigned char* blocks, int width, int height, int channels, unsigned char* pixels)
+	{
+		const int blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+		const size_t blockBytes = BlockBytes(format);
+
+		for (int blockY = 0; blockY < blocksHigh; blockY++)
+		{
+			for (int blockX = 0; blockX < blocksWide; blockX++)
+			{
+				const unsigned char* in = blocks + ((size_t)blockY * blocksWide + blockX) * blockBytes;
+				// Channels the format doesn't store decode like GL fills them in
+				unsigned char decoded[16][4];
+				for (int i = 0; i < 16; i++)
+				{
+					decoded[i][0] = decoded[i][1] = decoded[i][2] = 0;
+					decoded[i][3] = 255;
+				}
+
+				switch (format)
+				{
+				case BlockFormat::BC1:	DecodeBC1(in, decoded);											break;
+				case BlockFormat::BC3:	DecodeBC1(in + 8, decoded); DecodeBC4(in, 3, decoded);			break;
+				case BlockFormat::BC4:	DecodeBC4(in, 0, decoded);										break;
+				case BlockFormat::BC5:	DecodeBC4(in, 0, decoded); DecodeBC4(in + 8, 1, decoded);		break;
+				case BlockFormat::BC7:	DecodeBC7(in, decoded);											break;
+				default: break;
+				}
+				StoreBlock(decoded, width, height, channels, blockX, blockY, pixels);
+			}
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+
+// GPU block compression formats an image can be baked to. Each stores 4x4 texel blocks in a fixed number of bytes,
+// the GPU samples them directly so they stay compressed in video memory too.
+enum class BlockFormat : uint32_t
+{
+	// Uncompressed, tightly packed 8 bit channels
+	None = 0,
+	// RGB in 8 bytes a block (DXT1), 4 bits per texel
+	BC1 = 1,
+	// RGBA, a BC4 alpha block followed by a BC1 color block (DXT5), 8 bits per texel
+	BC3 = 3,
+	// One channel in 8 bytes a block (RGTC1), 4 bits per texel
+	BC4 = 4,
+	// Two channels, one BC4 block each (RGTC2), 8 bits per texel
+	BC5 = 5,
+	// RGBA in 16 bytes a block (BPTC), 8 bits per texel. Only mode 6 is written (and read back by Decode).
+	BC7 = 7
+};
+
+// CPU encoder and decoder for the block formats, no GPU or GL context involved.
+// Images are 8 bit per channel with 1 - 4 channels. Channels a format doesn't store are dropped, the ones it stores
+// but the image lacks read as 0 (alpha as 255), the same way GL expands an uncompressed upload.
+namespace BlockCompression
+{
+	inline size_t BlockBytes(BlockFormat format)
+	{
+		return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+	}
+
+	// Bytes of the blocks covering a 'width' x 'height' level, partial blocks at the edges count as whole ones
+	inline size_t LevelSize(BlockFormat format, int width, int height)
+	{
+		return (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4) * BlockBytes(format);
+	}
+
+	// Encodes 'pixels' into LevelSize(format, width, height) bytes of 'blocks', in rows of blocks from the top.
+	// Rows of blocks are independent, a caller can split the image along them and encode the parts on different threads.
+	void Encode(BlockFormat format, const unsigned char* pixels, int width, int height, int channels, unsigned char* blocks);
+	// Decodes 'blocks' back into 'width' x 'height' pixels with 'channels' channels each
+	void Decode(BlockFormat format, const unsigned char* blocks, int width, int height, int channels, unsigned char* pixels);
+}
+
+#endif
@@ -0,0 +1,120 @@
+#include "BloomRenderer.h"
+
+#include <algorithm>
+#include <iostream>
+
+void BloomRenderer::Init(Shader& downsample, Shader& upsample, int width, int height)
+{
+	m_Downsample = &downsample;
+	m_Upsample = &upsample;
+	downsample.use();
+	downsample.setInt("source", 0);
+	m_KarisAverageUniform = downsample.uniform<bool>("karisAverage");
+	upsample.use();
+	upsample.setInt("source", 0);
+	m_RadiusUniform = upsample.uniform<float>("radius");
+
+	// The full screen triangle comes from the vertex index, but core profiles still want a vertex array bound
+	glGenVertexArrays(1, &m_VAO);
+	glGenFramebuffers(1, &m_FBO);
+
+	m_Width = width;
+	m_Height = height;
+	CreateLevels();
+}
+
+void BloomRenderer::Resize(int width, int height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+
+	m_Width = width;
+	m_Height = height;
+	DeleteLevels();
+	CreateLevels();
+}
+
+void BloomRenderer::Destroy()
+{
+	DeleteLevels();
+	glDeleteFramebuffers(1, &m_FBO);
+	glDeleteVertexArrays(1, &m_VAO);
+	m_FBO = m_VAO = 0;
+}
+
+void BloomRenderer::CreateLevels()
+{
+	int width = std::max(m_Width / 2, 1), height = std::max(m_Height / 2, 1);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+	while ((int)m_Levels.size() < MaxLevels && (m_Levels.empty() || std::min(width, height) >= MinLevelSize))
+	{
+		//Bloom Only Adds Light, Packed Floats Without Sign or Alpha Are Plenty & Half The Bandwidth of RGBA16F.
+		Level level = { 0, width, height };
+		glGenTextures(1, &level.texture);
+		glBindTexture(GL_TEXTURE_2D, level.texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, width, height, 0, GL_RGB, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		m_Levels.push_back(level);
+
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Levels[0].texture, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::BLOOM_RENDERER::FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void BloomRenderer::DeleteLevels()
+{
+	for (Level& level : m_Levels)
+		glDeleteTextures(1, &level.texture);
+	m_Levels.clear();
+}
+
+void BloomRenderer::Render(GLuint brightness, int levels, float radius)
+{
+	levels = std::min(std::max(levels, 1), (int)m_Levels.size());
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+	glBindVertexArray(m_VAO);
+	glActiveTexture(GL_TEXTURE0);
+	glDisable(GL_BLEND);
+
+	//Down The Chain, Each Level Filtered From The One Above. Only The First Reads The Screen Sized Brightness.
+	m_Downsample->use();
+	GLuint source = brightness;
+	for (int i = 0; i < levels; i++)
+	{
+		const Level& level = m_Levels[i];
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, level.texture, 0);
+		glViewport(0, 0, level.width, level.height);
+		m_KarisAverageUniform.set(i == 0);
+		glBindTexture(GL_TEXTURE_2D, source);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		source = level.texture;
+	}
+
+	//Back Up, Each Level Adds The Blurred One Below Onto Itself.
+	m_Upsample->use();
+	m_RadiusUniform.set(radius);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	for (int i = levels - 2; i >= 0; i--)
+	{
+		const Level& level = m_Levels[i];
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, level.texture, 0);
+		glViewport(0, 0, level.width, level.height);
+		glBindTexture(GL_TEXTURE_2D, m_Levels[i + 1].texture);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+	glDisable(GL_BLEND);
+
+	glBindVertexArray(0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, m_Width, m_Height);
+}
@@ -0,0 +1,61 @@
+#ifndef BLOOM_RENDERER_H
+#define BLOOM_RENDERER_H
+
+#include <vector>
+
+#include "../../vendor/glad/include/glad.h"
+#include "Shader.h"
+
+// Blurs the brightness texture of the lighting pass for bloom on a chain of ever smaller levels, the first one half the
+// screen's size. The brightness is downsampled level by level with a 13 tap filter, then upsampled back with a 3x3 tent
+// filter, every level adding the blurred one below onto itself, so level 0 ends up holding all of them (Call of Duty's &
+// Unreal's bloom). Each level halves the pixels, so the whole chain costs about as much as one pass at the screen's size
+// however wide the bloom gets. Drawn with Bloom.vs, BloomDownsample.fs & BloomUpsample.fs. GL thread only.
+class BloomRenderer
+{
+public:
+	// Levels the chain has at most
+	static const int MaxLevels = 8;
+	// Levels stop once the shorter side would be less than this many pixels
+	static const int MinLevelSize = 8;
+
+	BloomRenderer() {}
+	BloomRenderer(const BloomRenderer&) = delete;
+	BloomRenderer& operator=(const BloomRenderer&) = delete;
+
+	// Creates the levels for a screen of 'width' x 'height' & caches the uniforms of the two shaders
+	void Init(Shader& downsample, Shader& upsample, int width, int height);
+	// Recreates the levels for a new screen size
+	void Resize(int width, int height);
+	// Deletes every texture and buffer, call while the context is still alive
+	void Destroy();
+
+	// Blurs 'brightness' (screen sized) over the first 'levels' levels, 'radius' widens the upsample filter in texels.
+	// Leaves blending off, framebuffer 0 bound and the viewport at the screen's size.
+	void Render(GLuint brightness, int levels, float radius);
+	// The bloom of the last Render, half the screen's size. Sum of every level, divide by the levels rendered to normalize.
+	GLuint Result() const { return m_Levels.empty() ? 0 : m_Levels[0].texture; }
+	// Levels the current screen size allows
+	int LevelCount() const { return (int)m_Levels.size(); }
+
+private:
+	struct Level
+	{
+		GLuint texture;
+		int width, height;
+	};
+
+	void CreateLevels();
+	void DeleteLevels();
+
+	Shader* m_Downsample = nullptr;
+	Shader* m_Upsample = nullptr;
+	Uniform<bool> m_KarisAverageUniform;
+	Uniform<float> m_RadiusUniform;
+
+	int m_Width = 0, m_Height = 0;
+	std::vector<Level> m_Levels;
+	GLuint m_FBO = 0, m_VAO = 0;
+};
+
+#endif
@@ -0,0 +1,327 @@
+#include "BodyRenderer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+
+void BodyRenderer::Init(Shader& shader)
+{
+	glGenVertexArrays(1, &m_VAO);
+	glGenBuffers(1, &m_InstanceBuffer);
+	glGenBuffers(1, &m_MaterialBuffer);
+	glGenBuffers(1, &m_CommandBuffer);
+
+	//Array i Samples Texture Unit i.
+	GLint units[TextureArrays::MaxArrays];
+	std::iota(units, units + TextureArrays::MaxArrays, 0);
+	shader.use();
+	glUniform1iv(shader.location("textureArrays"), TextureArrays::MaxArrays, units);
+}
+
+void BodyRenderer::Destroy()
+{
+	GLuint buffers[] = { m_VertexBuffer, m_IndexBuffer, m_InstanceIndexBuffer, m_InstanceBuffer, m_MaterialBuffer, m_CommandBuffer };
+	glDeleteBuffers(6, buffers);
+	glDeleteVertexArrays(1, &m_VAO);
+	m_TextureArrays.Destroy();
+
+	m_VAO = m_VertexBuffer = m_IndexBuffer = m_InstanceIndexBuffer = m_InstanceBuffer = m_MaterialBuffer = m_CommandBuffer = 0;
+	m_VertexCapacity = m_IndexCapacity = m_VertexBytes = m_IndexBytes = 0;
+	m_InstanceIndexCount = 0;
+	m_Models.clear();
+	m_Meshes.clear();
+	m_Materials.clear();
+	m_MaterialSources.clear();
+}
+
+void BodyRenderer::Begin()
+{
+	m_Submissions.clear();
+}
+
+void BodyRenderer::Submit(uint32_t model, const glm::mat4& matrix, bool doubleSided)
+{
+	m_Submissions.push_back({ model, doubleSided, matrix });
+}
+
+void BodyRenderer::Draw(std::vector<Model>& models)
+{
+	m_DrawCalls = 0;
+	m_DrawnMeshes = 0;
+
+	//Merge Models That Finished Loading Since The Last Frame.
+	if (m_Models.size() < models.size())
+		m_Models.resize(models.size());
+	for (const Submission& submission : m_Submissions)
+	{
+		ModelRange& range = m_Models[submission.model];
+		if (!range.merged && models[submission.model].IsLoaded())
+			Merge(models[submission.model], submission.model);
+		if (range.merged && submission.doubleSided && range.firstBackMesh == NoBackFaces)
+			MergeBackFaces(submission.model);
+	}
+	AdoptTextures(models);
+
+	//Split Every Body Into Its Meshes, Double Sided Ones Into Their Back Faces Too.
+	m_Items.clear();
+	for (const Submission& submission : m_Submissions)
+	{
+		const ModelRange& range = m_Models[submission.model];
+		if (!range.merged)
+			continue;
+
+		const Model& model = models[submission.model];
+		for (uint32_t i = 0; i < range.meshCount; i++)
+		{
+			glm::mat4 matrix = submission.matrix * model.MeshMatrix(i);
+			m_Items.push_back({ range.firstMesh + i, matrix });
+			if (submission.doubleSided)
+				m_Items.push_back({ range.firstBackMesh + i, matrix });
+		}
+	}
+	if (m_Items.empty())
+		return;
+
+	//Bodies Drawing The Same Mesh Become Instances of One Command.
+	std::stable_sort(m_Items.begin(), m_Items.end(), [](const DrawItem& a, const DrawItem& b) { return a.mesh < b.mesh; });
+
+	m_Instances.clear();
+	m_Commands.clear();
+	for (size_t i = 0; i < m_Items.size(); i++)
+	{
+		const DrawItem& item = m_Items[i];
+		const MeshRange& mesh = m_Meshes[item.mesh];
+		if (i == 0 || item.mesh != m_Items[i - 1].mesh)
+			m_Commands.push_back({ mesh.count, 0, mesh.firstIndex, mesh.baseVertex, (GLuint)m_Instances.size() });
+		m_Commands.back().instanceCount++;
+		m_Instances.push_back({ item.matrix, mesh.material, { 0, 0, 0 } });
+	}
+	m_DrawnMeshes = (unsigned int)m_Instances.size();
+
+	//Upload This Frame's Instances & Commands, Orphaning Last Frame's Storage. The Material Table Only When It Changed.
+	ReserveInstanceIndices((GLuint)m_Instances.size());
+	if (m_VertexArrayDirty)
+		SetupVertexArray();
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_InstanceBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_Instances.size() * sizeof(Instance), m_Instances.data(), GL_STREAM_DRAW);
+	if (m_MaterialsDirty)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_MaterialBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_Materials.size() * sizeof(MaterialEntry), m_Materials.data(), GL_STATIC_DRAW);
+		m_MaterialsDirty = false;
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, InstanceBinding, m_InstanceBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MaterialBinding, m_MaterialBuffer);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_CommandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, m_Commands.size() * sizeof(DrawElementsIndirectCommand), m_Commands.data(), GL_STREAM_DRAW);
+
+	//Every Body in One Multi Draw, Nothing Changes Between Its Draws.
+	m_TextureArrays.Bind(0);
+	glBindVertexArray(m_VAO);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei)m_Commands.size(), 0);
+	m_DrawCalls = 1;
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void BodyRenderer::AdoptTextures(std::vector<Model>& models)
+{
+	// Meshes can share a texture, it is copied once and the 2D texture goes away after everyone using it is pointed at the copy.
+	// A texture arriving for a slot that already has one replaces it (TextureStreamer changing its resident levels), the old layer is freed.
+	// One the arrays can't take stays a 2D texture, its slot keeps what it had and it isn't tried again.
+	std::unordered_map<GLuint, uint32_t> adopted;
+	std::unordered_set<uint32_t> replaced;
+	for (size_t i = 0; i < m_Materials.size(); i++)
+	{
+		Material& material = models[m_MaterialSources[i].first].meshes[m_MaterialSources[i].second].material;
+		Texture* slots[4] = { &material.baseColorTexture, &material.metallicRoughnessTexture, &material.emissiveTexture, &material.normalTexture };
+		for (int slot = 0; slot < 4; slot++)
+		{
+			Texture& texture = *slots[slot];
+			if (texture.type == TextureType::None || texture.ID == 0 || m_RejectedTextures.count(texture.ID))
+				continue;
+
+			auto found = adopted.find(texture.ID);
+			if (found == adopted.end())
+				found = adopted.emplace(texture.ID, m_TextureArrays.Add(texture.ID)).first;
+			if (found->second == TextureArrays::None)
+				continue;
+			if (m_Materials[i].textures[slot] != TextureArrays::None)
+				replaced.insert(m_Materials[i].textures[slot]);
+			m_Materials[i].textures[slot] = found->second;
+			texture.ID = 0;
+			m_MaterialsDirty = true;
+		}
+	}
+
+	for (const auto& texture : adopted)
+	{
+		if (texture.second == TextureArrays::None)
+			m_RejectedTextures.insert(texture.first);
+		else
+			glDeleteTextures(1, &texture.first);
+	}
+	for (uint32_t location : replaced)
+		m_TextureArrays.Remove(location);
+}
+
+void BodyRenderer::Merge(const Model& model, uint32_t index)
+{
+	GLsizeiptr vertexBytes = 0, indexBytes = 0;
+	for (const Mesh& mesh : model.meshes)
+	{
+		vertexBytes += mesh.getVertexCount() * (GLsizeiptr)sizeof(Vertex);
+		indexBytes += mesh.getIndexCount() * (GLsizeiptr)sizeof(GLuint);
+	}
+
+	// The element buffer binding is vertex array state, keep ours out of it while the buffers move
+	glBindVertexArray(0);
+	Reserve(m_VertexBuffer, m_VertexCapacity, m_VertexBytes, m_VertexBytes + vertexBytes);
+	Reserve(m_IndexBuffer, m_IndexCapacity, m_IndexBytes, m_IndexBytes + indexBytes);
+
+	ModelRange& range = m_Models[index];
+	range.firstMesh = (uint32_t)m_Meshes.size();
+	range.meshCount = (uint32_t)model.meshes.size();
+
+	//Copy Each Mesh Over on The GPU, Packaged Meshes Keep No CPU Copy.
+	for (uint32_t i = 0; i < range.meshCount; i++)
+	{
+		const Mesh& mesh = model.meshes[i];
+		const GLsizeiptr meshVertexBytes = mesh.getVertexCount() * (GLsizeiptr)sizeof(Vertex);
+		const GLsizeiptr meshIndexBytes = mesh.getIndexCount() * (GLsizeiptr)sizeof(GLuint);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, mesh.vertexBuffer());
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_VertexBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, m_VertexBytes, meshVertexBytes);
+		glBindBuffer(GL_COPY_READ_BUFFER, mesh.indexBuffer());
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_IndexBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, m_IndexBytes, meshIndexBytes);
+
+		// Indices stay relative to their mesh, baseVertex moves them to where it landed
+		m_Meshes.push_back({ (GLuint)mesh.getIndexCount(), (GLuint)(m_IndexBytes / sizeof(GLuint)), (GLint)(m_VertexBytes / sizeof(Vertex)), (uint32_t)m_Materials.size() });
+		m_VertexBytes += meshVertexBytes;
+		m_IndexBytes += meshIndexBytes;
+
+		// Textures are picked up by AdoptTextures once they arrive
+		MaterialEntry entry = {};
+		entry.metallicRoughness = glm::vec2(mesh.material.metallicFactor, mesh.material.roughnessFactor);
+		std::fill(entry.textures, entry.textures + 4, TextureArrays::None);
+		m_Materials.push_back(entry);
+		m_MaterialSources.push_back({ index, i });
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	range.merged = true;
+	m_VertexArrayDirty = true;
+	m_MaterialsDirty = true;
+}
+
+void BodyRenderer::MergeBackFaces(uint32_t index)
+{
+	ModelRange& range = m_Models[index];
+
+	// Read the front faces back once, rings are small and this happens a single time per model
+	std::vector<GLuint> indices;
+	for (uint32_t i = 0; i < range.meshCount; i++)
+	{
+		const MeshRange& front = m_Meshes[range.firstMesh + i];
+		size_t offset = indices.size();
+		indices.resize(offset + front.count);
+		glBindBuffer(GL_COPY_READ_BUFFER, m_IndexBuffer);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, front.firstIndex * sizeof(GLuint), front.count * sizeof(GLuint), indices.data() + offset);
+		for (size_t triangle = offset; triangle + 2 < indices.size(); triangle += 3)
+			std::swap(indices[triangle + 1], indices[triangle + 2]);
+	}
+
+	glBindVertexArray(0);
+	const GLsizeiptr bytes = indices.size() * sizeof(GLuint);
+	Reserve(m_IndexBuffer, m_IndexCapacity, m_IndexBytes, m_IndexBytes + bytes);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_IndexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, m_IndexBytes, bytes, indices.data());
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	range.firstBackMesh = (uint32_t)m_Meshes.size();
+	GLuint firstIndex = (GLuint)(m_IndexBytes / sizeof(GLuint));
+	for (uint32_t i = 0; i < range.meshCount; i++)
+	{
+		MeshRange back = m_Meshes[range.firstMesh + i];
+		back.firstIndex = firstIndex;
+		firstIndex += back.count;
+		m_Meshes.push_back(back);
+	}
+	m_IndexBytes += bytes;
+	m_VertexArrayDirty = true;
+}
+
+void BodyRenderer::Reserve(GLuint& buffer, GLsizeiptr& capacity, GLsizeiptr used, GLsizeiptr needed)
+{
+	if (needed <= capacity)
+		return;
+
+	// Doubling keeps the copies down to O(total size) however the models trickle in
+	GLsizeiptr grownCapacity = std::max(needed, capacity * 2);
+	GLuint grown;
+	glGenBuffers(1, &grown);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+	glBufferData(GL_COPY_WRITE_BUFFER, grownCapacity, nullptr, GL_STATIC_DRAW);
+	if (used > 0)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+	}
+	glDeleteBuffers(1, &buffer);
+
+	buffer = grown;
+	capacity = grownCapacity;
+}
+
+void BodyRenderer::SetupVertexArray()
+{
+	glBindVertexArray(m_VAO);
+
+	// Same layout as Mesh::setupMesh
+	glBindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoord));
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_InstanceIndexBuffer);
+	glEnableVertexAttribArray(InstanceIndexAttribute);
+	glVertexAttribIPointer(InstanceIndexAttribute, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+	glVertexAttribDivisor(InstanceIndexAttribute, 1);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_VertexArrayDirty = false;
+}
+
+void BodyRenderer::ReserveInstanceIndices(GLuint count)
+{
+	if (count <= m_InstanceIndexCount)
+		return;
+
+	m_InstanceIndexCount = std::max(std::max(count, m_InstanceIndexCount * 2), 1024u);
+	std::vector<GLuint> indices(m_InstanceIndexCount);
+	std::iota(indices.begin(), indices.end(), 0u);
+
+	if (m_InstanceIndexBuffer == 0)
+		glGenBuffers(1, &m_InstanceIndexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_InstanceIndexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
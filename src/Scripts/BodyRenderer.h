@@ -0,0 +1,153 @@
+#ifndef BODY_RENDERER_H
+#define BODY_RENDERER_H
+
+#include <cstdint>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "GLExtensions.h"
+#include "Model.h"
+#include "TextureArrays.h"
+
+// Draws every body with a single glMultiDrawElementsIndirect instead of one draw per mesh.
+// The meshes of every model are merged into one shared vertex and index buffer as the models finish loading.
+// Each frame the submitted bodies become indirect commands, one per distinct mesh with every body using it as an instance,
+// and their transforms and material indices go into a shader storage buffer that ModelBatched.vs reads.
+// Materials live in a table on the GPU that only changes when a texture arrives. Their textures move into TextureArrays,
+// the renderer takes them over: the 2D texture is deleted and the material keeps its type with an ID of 0.
+// A texture arriving again for the same slot (streamed mips) replaces the layer it had.
+// Needs GLExtensions::MultiDrawIndirect. GL thread only.
+class BodyRenderer
+{
+public:
+	// Binding points of the storage buffers in ModelBatched.vs
+	static const GLuint InstanceBinding = 0;
+	static const GLuint MaterialBinding = 1;
+	// Vertex attribute carrying the instance index, the model's attributes use 0 - 3
+	static const GLuint InstanceIndexAttribute = 4;
+
+	BodyRenderer() {}
+	BodyRenderer(const BodyRenderer&) = delete;
+	BodyRenderer& operator=(const BodyRenderer&) = delete;
+
+	// Creates the shared buffers and points the texture array samplers of 'shader' at their units
+	void Init(Shader& shader);
+	// Deletes every buffer, call while the context is still alive
+	void Destroy();
+
+	// Starts a new frame, forgetting the bodies submitted for the last one
+	void Begin();
+	// Queues a body drawing 'model' (an index into the model list Draw gets) with 'matrix'.
+	// Double sided bodies are drawn with back face culling off.
+	void Submit(uint32_t model, const glm::mat4& matrix, bool doubleSided);
+	// Draws everything submitted since Begin with the batched shader bound. Models that haven't loaded yet draw nothing.
+	// Takes over the textures that arrived in 'models' since the last call.
+	void Draw(std::vector<Model>& models);
+
+	// Multi draw calls the last Draw issued and the meshes they drew
+	unsigned int DrawCalls() const { return m_DrawCalls; }
+	unsigned int DrawnMeshes() const { return m_DrawnMeshes; }
+	// Texture arrays the materials' textures ended up in
+	unsigned int TextureArrayCount() const { return (unsigned int)m_TextureArrays.size(); }
+
+private:
+	// Where a mesh lives in the shared buffers
+	struct MeshRange
+	{
+		GLuint count;
+		GLuint firstIndex;
+		GLint baseVertex;
+		// Index into the material table, the back faces of a mesh share the front's
+		uint32_t material;
+	};
+
+	static const uint32_t NoBackFaces = 0xFFFFFFFFu;
+
+	// Merged meshes of a model, 'merged' stays false until the model has loaded
+	struct ModelRange
+	{
+		bool merged = false;
+		uint32_t firstMesh = 0;
+		uint32_t meshCount = 0;
+		// Copies of the meshes with their winding reversed, made the first time a double sided body uses the model
+		uint32_t firstBackMesh = NoBackFaces;
+	};
+
+	// A submitted body
+	struct Submission
+	{
+		uint32_t model;
+		bool doubleSided;
+		glm::mat4 matrix;
+	};
+
+	// One mesh of one body, sorted so that bodies sharing a mesh end up next to each other
+	struct DrawItem
+	{
+		uint32_t mesh;
+		glm::mat4 matrix;
+	};
+
+	// Layout of the storage buffers, std430 in ModelBatched.vs
+	struct Instance
+	{
+		glm::mat4 model;
+		GLuint material;
+		GLuint padding[3];
+	};
+	struct MaterialEntry
+	{
+		glm::vec2 metallicRoughness;
+		GLuint padding[2];
+		// TextureArrays location of the base color, metallic roughness, emission & normal texture, TextureArrays::None if there is none
+		GLuint textures[4];
+	};
+
+	// Copies the meshes of model 'index' into the shared buffers and adds their materials to the table
+	void Merge(const Model& model, uint32_t index);
+	// Appends the meshes of model 'index' again with every triangle flipped, so double sided bodies draw with culling on
+	void MergeBackFaces(uint32_t index);
+	// Moves textures that arrived since the last frame into the arrays and points the material table at them
+	void AdoptTextures(std::vector<Model>& models);
+	// Grows 'buffer' to hold at least 'needed' bytes, keeping its first 'used' bytes
+	static void Reserve(GLuint& buffer, GLsizeiptr& capacity, GLsizeiptr used, GLsizeiptr needed);
+	// Points the vertex array at the current shared and identity buffers
+	void SetupVertexArray();
+	// Makes sure the identity buffer counts up to at least 'count'
+	void ReserveInstanceIndices(GLuint count);
+
+	GLuint m_VAO = 0;
+	GLuint m_VertexBuffer = 0, m_IndexBuffer = 0;
+	GLsizeiptr m_VertexCapacity = 0, m_IndexCapacity = 0;
+	GLsizeiptr m_VertexBytes = 0, m_IndexBytes = 0;
+	// Holds 0, 1, 2, ... read once per instance, so instance i of a command gets baseInstance + i.
+	// gl_BaseInstance needs GL 4.6, an instanced attribute gets the same index on 4.3.
+	GLuint m_InstanceIndexBuffer = 0;
+	GLuint m_InstanceIndexCount = 0;
+	GLuint m_InstanceBuffer = 0, m_MaterialBuffer = 0, m_CommandBuffer = 0;
+	// True once a buffer the vertex array reads from has been replaced
+	bool m_VertexArrayDirty = false;
+	// True once the material table changed and has to be uploaded again
+	bool m_MaterialsDirty = false;
+
+	TextureArrays m_TextureArrays;
+	// 2D textures TextureArrays::Add turned down, they stay with their mesh
+	std::unordered_set<GLuint> m_RejectedTextures;
+
+	std::vector<ModelRange> m_Models;
+	std::vector<MeshRange> m_Meshes;
+	std::vector<MaterialEntry> m_Materials;
+	// Model and mesh index behind every material, to pick up its textures as they stream in
+	std::vector<std::pair<uint32_t, uint32_t>> m_MaterialSources;
+
+	std::vector<Submission> m_Submissions;
+	std::vector<DrawItem> m_Items;
+	std::vector<Instance> m_Instances;
+	std::vector<DrawElementsIndirectCommand> m_Commands;
+
+	unsigned int m_DrawCalls = 0;
+	unsigned int m_DrawnMeshes = 0;
+};
+
+#endif
@@ -29,7 +29,8 @@ class Camera
 {
 public:
     // camera Attributes
-    glm::vec3 Position;
+    // In double precision, the renderer draws everything relative to it so the GPU only sees small offsets
+    glm::dvec3 Position;
     glm::vec3 Front;
     glm::vec3 Up;
     glm::vec3 Right;
@@ -45,7 +46,7 @@ public:
     bool updateRotation;
 
     // constructor with vectors
-    Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
+    Camera(glm::dvec3 position = glm::dvec3(0.0), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
     {
         Position = position;
         WorldUp = up;
@@ -57,35 +58,46 @@ public:
     // constructor with scalar values
     Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
     {
-        Position = glm::vec3(posX, posY, posZ);
+        Position = glm::dvec3(posX, posY, posZ);
         WorldUp = glm::vec3(upX, upY, upZ);
         Yaw = yaw;
         Pitch = pitch;
         updateCameraVectors();
     }
 
-    // returns the view matrix calculated using Euler Angles and the LookAt Matrix
+    // returns the view matrix calculated using Euler Angles and the LookAt Matrix, for a world that is already
+    // camera relative (floating origin), so it only rotates
     glm::mat4 GetViewMatrix()
     {
-        return glm::lookAt(Position, Position + Front, Up);
+        return glm::lookAt(glm::vec3(0.0f), Front, Up);
+    }
+
+    // places the camera at a pose, e.g. one played back from a CameraPath
+    void SetPose(const glm::dvec3& position, float yaw, float pitch, float zoom)
+    {
+        Position = position;
+        Yaw = yaw;
+        Pitch = pitch;
+        Zoom = zoom;
+        updateCameraVectors();
     }
 
     // processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
     void ProcessKeyboard(Camera_Movement direction, float deltaTime)
     {
-        float velocity = MovementSpeed * deltaTime;
+        double velocity = (double)MovementSpeed * deltaTime;
         if (direction == FORWARD)
-            Position += Front * velocity;
+            Position += glm::dvec3(Front) * velocity;
         if (direction == BACKWARD)
-            Position -= Front * velocity;
+            Position -= glm::dvec3(Front) * velocity;
         if (direction == LEFT)
-            Position -= Right * velocity;
+            Position -= glm::dvec3(Right) * velocity;
         if (direction == RIGHT)
-            Position += Right * velocity;
+            Position += glm::dvec3(Right) * velocity;
         if (direction == UP)
-            Position += Up * velocity;
+            Position += glm::dvec3(Up) * velocity;
         if (direction == DOWN)
-            Position -= Up * velocity;
+            Position -= glm::dvec3(Up) * velocity;
     }
 
     // processes input received from a mouse input system. Expects the offset value in both the x and y direction.
@@ -0,0 +1,76 @@
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#include <json.h>
+
+using json = nlohmann::json;
+
+CameraPath CameraPath::Load(const char* file, const BodyTable& bodies)
+{
+	std::ifstream in(file);
+	if (!in)
+		throw std::invalid_argument(std::string("ERROR::CAMERA_PATH::FILE_NOT_READ ") + file);
+
+	json JSON = json::parse(in, nullptr, false);
+	if (JSON.is_discarded() || !JSON.contains("keyframes") || !JSON["keyframes"].is_array() || JSON["keyframes"].empty())
+		throw std::invalid_argument(std::string("ERROR::CAMERA_PATH::PARSE_FAILED ") + file);
+
+	CameraPath path;
+	for (const json& key : JSON["keyframes"])
+	{
+		CameraKeyframe keyframe;
+		keyframe.time = key.value("time", 0.0);
+		if (!path.keyframes.empty() && keyframe.time < path.keyframes.back().time)
+			throw std::invalid_argument("ERROR::CAMERA_PATH::TIME_GOES_BACKWARDS " + std::to_string(keyframe.time));
+
+		if (key.contains("position"))
+		{
+			const json& position = key["position"];
+			if (!position.is_array() || position.size() != 3)
+				throw std::invalid_argument("ERROR::CAMERA_PATH::BAD_POSITION " + std::to_string(keyframe.time));
+			keyframe.position = glm::dvec3(position[0].get<double>(), position[1].get<double>(), position[2].get<double>());
+		}
+
+		if (key.contains("body"))
+		{
+			const std::string name = key["body"].get<std::string>();
+			auto it = std::find(bodies.names.begin(), bodies.names.end(), name);
+			if (it == bodies.names.end())
+				throw std::invalid_argument("ERROR::CAMERA_PATH::UNKNOWN_BODY " + name);
+			keyframe.body = (int)(it - bodies.names.begin());
+		}
+
+		keyframe.yaw = key.value("yaw", keyframe.yaw);
+		keyframe.pitch = glm::clamp(key.value("pitch", keyframe.pitch), -89.0f, 89.0f);
+		keyframe.zoom = glm::clamp(key.value("zoom", keyframe.zoom), 1.0f, 45.0f);
+		path.keyframes.push_back(keyframe);
+	}
+	return path;
+}
+
+static glm::dvec3 absolutePosition(const CameraKeyframe& keyframe, const BodyTable& bodies)
+{
+	return keyframe.body < 0 ? keyframe.position : bodies.positions[keyframe.body] + keyframe.position;
+}
+
+CameraPose CameraPath::Sample(double time, const BodyTable& bodies) const
+{
+	// First keyframe later than 'time', the pose is between it and the one before
+	auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time, [](double t, const CameraKeyframe& keyframe) { return t < keyframe.time; });
+	const CameraKeyframe& a = next == keyframes.begin() ? *next : *(next - 1);
+	const CameraKeyframe& b = next == keyframes.end() ? keyframes.back() : *next;
+
+	const double span = b.time - a.time;
+	const double t = span > 0.0 ? glm::clamp((time - a.time) / span, 0.0, 1.0) : 0.0;
+	const float f = (float)t;
+
+	CameraPose pose;
+	pose.position = glm::mix(absolutePosition(a, bodies), absolutePosition(b, bodies), t);
+	pose.yaw = glm::mix(a.yaw, b.yaw, f);
+	pose.pitch = glm::mix(a.pitch, b.pitch, f);
+	pose.zoom = glm::mix(a.zoom, b.zoom, f);
+	return pose;
+}
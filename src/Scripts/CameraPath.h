@@ -0,0 +1,47 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <vector>
+
+#include "../../vendor/glm/glm.hpp"
+#include "Scene.h"
+
+// One pose of a camera path
+struct CameraKeyframe
+{
+	// Seconds from the start of the path
+	double time = 0.0;
+	// Relative to body 'body', or absolute if it is -1
+	glm::dvec3 position = glm::dvec3(0.0);
+	int body = -1;
+	// In degrees, like Camera's Yaw, Pitch and Zoom
+	float yaw = -90.0f, pitch = 0.0f, zoom = 45.0f;
+};
+
+// Where the camera is at one time along a path, in absolute coordinates
+struct CameraPose
+{
+	glm::dvec3 position;
+	float yaw, pitch, zoom;
+};
+
+// A scripted camera flight for benchmarks: keyframes of position, yaw, pitch and zoom at times in seconds, read from a file
+//   { "keyframes": [ { "time": 0, "body": "Earth", "position": [0, 0, 0.03], "yaw": -90, "pitch": 0, "zoom": 45 }, ... ] }
+// A keyframe with a "body" is placed relative to that body where it is at the time of playback, so a path keeps up with
+// the planets along their orbits whatever date it is played at. Poses in between are interpolated linearly.
+class CameraPath
+{
+public:
+	// Reads a path file, looking body names up in 'bodies'. Throws std::invalid_argument if it can't be read,
+	// has no keyframes, its times go backwards or it names a body the scene doesn't have.
+	static CameraPath Load(const char* file, const BodyTable& bodies);
+
+	// The pose 'time' seconds in, held at the first and last keyframe outside of the path
+	CameraPose Sample(double time, const BodyTable& bodies) const;
+	// Time of the last keyframe
+	double Duration() const { return keyframes.empty() ? 0.0 : keyframes.back().time; }
+
+	std::vector<CameraKeyframe> keyframes;
+};
+
+#endif
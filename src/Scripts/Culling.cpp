@@ -0,0 +1,364 @@
+#include "Culling.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define CULLING_SSE2
+#endif
+
+// Leaves are tested in groups of four lanes and their lanes are bits of a mask
+static_assert(BodyBVH::LeafSize % 4 == 0 && BodyBVH::LeafSize <= 32, "LeafSize has to be a multiple of 4, up to 32");
+
+static glm::vec4 row(const glm::mat4& m, int i)
+{
+	return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+}
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+{
+	// -w <= x <= w and -w <= y <= w in clip space, so w + x, w - x, w + y and w - y must not go negative
+	Frustum frustum;
+	const glm::vec4 w = row(viewProjection, 3);
+	frustum.planes[0] = w + row(viewProjection, 0);
+	frustum.planes[1] = w - row(viewProjection, 0);
+	frustum.planes[2] = w + row(viewProjection, 1);
+	frustum.planes[3] = w - row(viewProjection, 1);
+	for (glm::vec4& plane : frustum.planes)
+		plane /= glm::length(glm::vec3(plane));
+	return frustum;
+}
+
+bool Frustum::Intersects(const glm::vec3& center, float radius) const
+{
+	for (const glm::vec4& plane : planes)
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			return false;
+	return true;
+}
+
+void BodyBVH::Update(const glm::dvec3* positions, const float* radii, size_t count)
+{
+	m_Positions = positions;
+	m_Radii = radii;
+	if (count != m_BodyCount || m_FramesSinceBuild >= RebuildInterval)
+	{
+		Build(positions, count);
+		m_BodyCount = count;
+		m_FramesSinceBuild = 0;
+
+		m_RefittedLeaves = 0;
+		for (uint32_t i = 0; i < (uint32_t)m_Nodes.size(); i++)
+		{
+			if (m_Nodes[i].count == 0)
+				continue;
+			FitLeaf(i, positions, radii);
+			m_RefittedLeaves++;
+		}
+		FitInnerNodes();
+	}
+	else
+	{
+		// Reads the bodies in their own order, unlike fitting a leaf, which jumps to wherever its bodies are
+		m_Refit.clear();
+		for (size_t body = 0; body < count; body++)
+			Check((uint32_t)body, positions, radii);
+		FitFlagged(positions, radii);
+	}
+	m_FramesSinceBuild++;
+}
+
+void BodyBVH::Update(const glm::dvec3* positions, const float* radii, size_t count, const uint32_t* moved, size_t movedCount)
+{
+	if (count != m_BodyCount || m_FramesSinceBuild >= RebuildInterval)
+	{
+		Update(positions, radii, count);
+		return;
+	}
+
+	m_Positions = positions;
+	m_Radii = radii;
+	m_Refit.clear();
+	for (size_t i = 0; i < movedCount; i++)
+		Check(moved[i], positions, radii);
+	FitFlagged(positions, radii);
+	m_FramesSinceBuild++;
+}
+
+void BodyBVH::Check(uint32_t body, const glm::dvec3* positions, const float* radii)
+{
+	const uint32_t leaf = m_Leaves[body];
+	const Node& node = m_Nodes[leaf];
+	const glm::vec3 center(positions[body] - m_Origin);
+	const float radius = radii[body];
+	const bool inside = center.x - radius >= node.min.x && center.y - radius >= node.min.y && center.z - radius >= node.min.z &&
+						center.x + radius <= node.max.x && center.y + radius <= node.max.y && center.z + radius <= node.max.z;
+	if (!inside && !m_Flagged[leaf])
+	{
+		m_Flagged[leaf] = 1;
+		m_Refit.push_back(leaf);
+	}
+}
+
+void BodyBVH::FitFlagged(const glm::dvec3* positions, const float* radii)
+{
+	for (uint32_t leaf : m_Refit)
+	{
+		FitLeaf(leaf, positions, radii);
+		m_Flagged[leaf] = 0;
+	}
+	m_RefittedLeaves = m_Refit.size();
+	if (!m_Refit.empty())
+		FitInnerNodes();
+}
+
+// Spreads the low 10 bits of 'v' out to every third bit
+static uint32_t spreadBits(uint32_t v)
+{
+	v = (v | (v << 16)) & 0x030000FF;
+	v = (v | (v << 8)) & 0x0300F00F;
+	v = (v | (v << 4)) & 0x030C30C3;
+	v = (v | (v << 2)) & 0x09249249;
+	return v;
+}
+
+void BodyBVH::Build(const glm::dvec3* positions, size_t count)
+{
+	m_Nodes.clear();
+	m_Bodies.clear();
+	if (count == 0)
+		return;
+
+	// The boxes are relative to the middle of the bodies, where floats are the finest across all of them
+	glm::dvec3 lowest(INFINITY), highest(-INFINITY);
+	for (size_t i = 0; i < count; i++)
+	{
+		lowest = glm::min(lowest, positions[i]);
+		highest = glm::max(highest, positions[i]);
+	}
+	m_Origin = (lowest + highest) * 0.5;
+
+	// Bodies sorted along a Morton curve through their box, halving a range of the sorted keys is then a split in space.
+	// One sort instead of partitioning the bodies again on every level.
+	const glm::vec3 low(lowest - m_Origin), high(highest - m_Origin);
+	const glm::vec3 scale = 1023.0f / glm::max(high - low, glm::vec3(1e-30f));
+
+	std::vector<uint64_t> keys(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		const glm::uvec3 cell(glm::clamp((glm::vec3(positions[i] - m_Origin) - low) * scale, glm::vec3(0.0f), glm::vec3(1023.0f)));
+		keys[i] = (uint64_t)(spreadBits(cell.x) | (spreadBits(cell.y) << 1) | (spreadBits(cell.z) << 2)) << 32 | i;
+	}
+	// Radix sort on the 30 bits of code above the body, a byte at a time and stable so bodies stay in order within a cell
+	std::vector<uint64_t> sorted(count);
+	for (int shift = 32; shift < 64; shift += 8)
+	{
+		size_t offsets[257] = {};
+		for (uint64_t key : keys)
+			offsets[((key >> shift) & 0xFF) + 1]++;
+		for (int i = 0; i < 256; i++)
+			offsets[i + 1] += offsets[i];
+		for (uint64_t key : keys)
+			sorted[offsets[(key >> shift) & 0xFF]++] = key;
+		keys.swap(sorted);
+	}
+
+	m_Nodes.reserve(4 * (count / LeafSize + 1));
+	m_Bodies.reserve(count);
+	m_Leaves.assign(count, 0);
+	m_Nodes.push_back(Node());
+	Split(0, keys.data(), 0, (uint32_t)count);
+	m_Flagged.assign(m_Nodes.size(), 0);
+}
+
+void BodyBVH::Split(uint32_t index, const uint64_t* keys, uint32_t begin, uint32_t end)
+{
+	if (end - begin <= LeafSize)
+	{
+		m_Nodes[index].first = (uint32_t)m_Bodies.size();
+		m_Nodes[index].count = end - begin;
+		for (uint32_t i = begin; i < end; i++)
+		{
+			m_Bodies.push_back((uint32_t)keys[i]);
+			m_Leaves[(uint32_t)keys[i]] = index;
+		}
+		return;
+	}
+
+	const uint32_t middle = begin + (end - begin) / 2;
+	const uint32_t left = (uint32_t)m_Nodes.size();
+	m_Nodes[index].first = left;
+	m_Nodes[index].count = 0;
+	m_Nodes.push_back(Node());
+	m_Nodes.push_back(Node());
+	Split(left, keys, begin, middle);
+	Split(left + 1, keys, middle, end);
+}
+
+void BodyBVH::FitLeaf(uint32_t index, const glm::dvec3* positions, const float* radii)
+{
+	Node& node = m_Nodes[index];
+	glm::vec3 low(INFINITY), high(-INFINITY);
+	for (uint32_t i = node.first; i < node.first + node.count; i++)
+	{
+		const uint32_t body = m_Bodies[i];
+		const glm::vec3 center(positions[body] - m_Origin);
+		low = glm::min(low, center - radii[body]);
+		high = glm::max(high, center + radii[body]);
+	}
+
+	// Floats this far out are only good to a few parts in ten million, the room covers that even around a lone tiny body
+	const glm::vec3 size = high - low;
+	const glm::vec3 magnitude = glm::max(glm::abs(low), glm::abs(high));
+	const float room = std::max(LeafRoom * std::max(size.x, std::max(size.y, size.z)), 1e-6f * std::max(magnitude.x, std::max(magnitude.y, magnitude.z)));
+	node.min = low - room;
+	node.max = high + room;
+}
+
+void BodyBVH::FitInnerNodes()
+{
+	// Children always come after their parent, so walking backwards sees them first
+	for (size_t i = m_Nodes.size(); i-- > 0;)
+	{
+		Node& node = m_Nodes[i];
+		if (node.count != 0)
+			continue;
+		const Node& left = m_Nodes[node.first];
+		const Node& right = m_Nodes[node.first + 1];
+		node.min = glm::min(left.min, right.min);
+		node.max = glm::max(left.max, right.max);
+	}
+	const glm::vec3 magnitude = glm::max(glm::abs(m_Nodes[0].min), glm::abs(m_Nodes[0].max));
+	m_Extent = std::max(magnitude.x, std::max(magnitude.y, magnitude.z));
+}
+
+void BodyBVH::Cull(const Frustum& frustum, const glm::dvec3& origin, double pixelsPerRadian, float minPixels,
+				   std::vector<uint32_t>& visible, std::vector<uint32_t>& points) const
+{
+	visible.clear();
+	points.clear();
+	if (m_Nodes.empty())
+		return;
+
+	// The planes moved over to the tree's origin for the boxes, in double since the camera can be far from it.
+	// A box is only outside once it is past the rounding of its corners and of the moved planes.
+	const glm::dvec3 offset = m_Origin - origin;
+	glm::vec4 boxPlanes[4];
+	float tolerance = m_Extent;
+	for (int i = 0; i < 4; i++)
+	{
+		const glm::vec4& plane = frustum.planes[i];
+		boxPlanes[i] = glm::vec4(glm::vec3(plane), (float)(plane.w + glm::dot(glm::dvec3(glm::vec3(plane)), offset)));
+		tolerance = std::max(tolerance, std::abs(boxPlanes[i].w));
+	}
+	tolerance *= 1e-6f;
+
+	// A sphere of radius r at distance d spans about 2 r / d radians, it is a point if 2 r pixelsPerRadian < minPixels d.
+	// Compared squared, so no lane needs a square root.
+	const float diameterScale = (float)(2.0 * pixelsPerRadian);
+	const float minPixelsSquared = minPixels * minPixels;
+
+	uint32_t stack[64];
+	unsigned int depth = 0;
+	stack[depth++] = 0;
+	while (depth > 0)
+	{
+		const Node& node = m_Nodes[stack[--depth]];
+
+		//The Box is Outside if Its Corner Furthest Along a Plane's Normal is Behind It.
+		bool outside = false;
+		for (const glm::vec4& plane : boxPlanes)
+		{
+			const glm::vec3 corner(plane.x >= 0.0f ? node.max.x : node.min.x, plane.y >= 0.0f ? node.max.y : node.min.y, plane.z >= 0.0f ? node.max.z : node.min.z);
+			if (glm::dot(glm::vec3(plane), corner) + plane.w < -tolerance)
+			{
+				outside = true;
+				break;
+			}
+		}
+		if (outside)
+			continue;
+
+		if (node.count == 0)
+		{
+			// A median split of n bodies is at most log2(n) deep, 64 entries cover anything that fits in memory
+			stack[depth++] = node.first;
+			stack[depth++] = node.first + 1;
+			continue;
+		}
+
+		// Only the leaves reached read their spheres, subtracted in double, the offsets from the camera are small enough for floats.
+		// Unused lanes get a negative radius and fail every test.
+		float x[LeafSize], y[LeafSize], z[LeafSize], r[LeafSize];
+		for (uint32_t lane = 0; lane < LeafSize; lane++)
+		{
+			if (lane < node.count)
+			{
+				const uint32_t body = m_Bodies[node.first + lane];
+				const glm::vec3 center(m_Positions[body] - origin);
+				x[lane] = center.x;
+				y[lane] = center.y;
+				z[lane] = center.z;
+				r[lane] = m_Radii[body];
+			}
+			else
+			{
+				x[lane] = y[lane] = z[lane] = 0.0f;
+				r[lane] = -1.0f;
+			}
+		}
+
+		uint32_t inside = 0, small = 0;
+#if defined(CULLING_SSE2)
+		for (uint32_t group = 0; group < node.count; group += 4)
+		{
+			const __m128 gx = _mm_loadu_ps(x + group);
+			const __m128 gy = _mm_loadu_ps(y + group);
+			const __m128 gz = _mm_loadu_ps(z + group);
+			const __m128 gr = _mm_loadu_ps(r + group);
+			const __m128 negativeR = _mm_sub_ps(_mm_setzero_ps(), gr);
+
+			__m128 mask = _mm_cmpge_ps(gr, _mm_setzero_ps());
+			for (const glm::vec4& plane : frustum.planes)
+			{
+				__m128 distance = _mm_add_ps(_mm_mul_ps(gx, _mm_set1_ps(plane.x)), _mm_mul_ps(gy, _mm_set1_ps(plane.y)));
+				distance = _mm_add_ps(distance, _mm_add_ps(_mm_mul_ps(gz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+				mask = _mm_and_ps(mask, _mm_cmpge_ps(distance, negativeR));
+			}
+
+			const __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(gx, gx), _mm_mul_ps(gy, gy)), _mm_mul_ps(gz, gz));
+			const __m128 diameter = _mm_mul_ps(gr, _mm_set1_ps(diameterScale));
+			const __m128 outsideSphere = _mm_cmpgt_ps(distanceSquared, _mm_mul_ps(gr, gr));
+			const __m128 tiny = _mm_cmplt_ps(_mm_mul_ps(diameter, diameter), _mm_mul_ps(_mm_set1_ps(minPixelsSquared), distanceSquared));
+
+			inside |= (uint32_t)_mm_movemask_ps(mask) << group;
+			small |= (uint32_t)_mm_movemask_ps(_mm_and_ps(tiny, outsideSphere)) << group;
+		}
+#else
+		for (uint32_t lane = 0; lane < node.count; lane++)
+		{
+			const glm::vec3 center(x[lane], y[lane], z[lane]);
+			const float radius = r[lane];
+			if (radius < 0.0f || !frustum.Intersects(center, radius))
+				continue;
+
+			inside |= 1u << lane;
+			const float distanceSquared = glm::dot(center, center);
+			const float diameter = radius * diameterScale;
+			if (distanceSquared > radius * radius && diameter * diameter < minPixelsSquared * distanceSquared)
+				small |= 1u << lane;
+		}
+#endif
+
+		for (uint32_t lane = 0; lane < node.count; lane++)
+		{
+			if (!(inside & (1u << lane)))
+				continue;
+			if (small & (1u << lane))
+				points.push_back(m_Bodies[node.first + lane]);
+			else
+				visible.push_back(m_Bodies[node.first + lane]);
+		}
+	}
+}
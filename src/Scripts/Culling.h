@@ -0,0 +1,98 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../../vendor/glm/glm.hpp"
+
+// The four side planes of a view-projection, normals pointing inwards, for positions relative to the camera.
+// Near and far are left out: the side planes already meet at the camera, so nothing behind it passes,
+// and they read the same under every depth convention (reversed-Z, infinite far plane).
+struct Frustum
+{
+	glm::vec4 planes[4];
+
+	static Frustum FromMatrix(const glm::mat4& viewProjection);
+	// True if part of the sphere may be inside
+	bool Intersects(const glm::vec3& center, float radius) const;
+};
+
+// Bounding volume hierarchy over the bounding spheres of the bodies.
+// The boxes are kept relative to a fixed point picked at the last build, so a moving camera changes nothing in the tree.
+// Every leaf's box is fitted with some room to spare around its bodies. Each frame one pass in body order finds the bodies
+// that left their leaf's box, and only their leaves are fitted again. The others stay as they were. A caller that knows which
+// bodies moved can have only those checked.
+// The tree is rebuilt every RebuildInterval frames, once the boxes have drifted apart.
+// Cull reads the spheres of the leaves it reaches relative to the camera, LeafSize of them are tested at once in SIMD passes of four.
+class BodyBVH
+{
+public:
+	static const unsigned int LeafSize = 32;
+	static const unsigned int RebuildInterval = 120;
+	// Room a leaf is fitted with around its bodies, as a share of its size on its longest axis
+	static constexpr float LeafRoom = 0.25f;
+
+	// Moves the tree to the spheres at 'positions' with 'radii' (world units), refitting the leaves bodies have moved out of.
+	// Rebuilds it when the count changes or the last build is RebuildInterval frames old.
+	// Cull reads the same arrays, they have to stay as they are until it is done.
+	void Update(const glm::dvec3* positions, const float* radii, size_t count);
+	// Same, for a caller that knows which bodies moved or changed their radius since the last Update, listed in 'moved'.
+	// Only those are checked against their leaves, the others have to be where they were.
+	void Update(const glm::dvec3* positions, const float* radii, size_t count, const uint32_t* moved, size_t movedCount);
+
+	// Fills 'visible' with the bodies inside 'frustum', which is relative to 'origin', and 'points' with those inside it that
+	// project smaller than 'minPixels' across, which aren't in 'visible'. A body the camera is inside of is always visible.
+	void Cull(const Frustum& frustum, const glm::dvec3& origin, double pixelsPerRadian, float minPixels,
+			  std::vector<uint32_t>& visible, std::vector<uint32_t>& points) const;
+
+	size_t NodeCount() const { return m_Nodes.size(); }
+	// Leaves the last Update fitted again, all of them after a rebuild
+	size_t RefittedLeaves() const { return m_RefittedLeaves; }
+
+private:
+	struct Node
+	{
+		glm::vec3 min;
+		// Leaf: first of its bodies in m_Bodies. Inner: first of the two children, which are stored next to each other.
+		uint32_t first;
+		glm::vec3 max;
+		// Bodies in a leaf, 0 for inner nodes
+		uint32_t count;
+	};
+
+	void Build(const glm::dvec3* positions, size_t count);
+	// Creates the subtree over keys[begin, end) at node 'index', the low 32 bits of a key are its body
+	void Split(uint32_t index, const uint64_t* keys, uint32_t begin, uint32_t end);
+	// Flags the leaf of 'body' for fitting if the body has left its box
+	void Check(uint32_t body, const glm::dvec3* positions, const float* radii);
+	// Fits the flagged leaves again, then the inner nodes above them
+	void FitFlagged(const glm::dvec3* positions, const float* radii);
+	// Fits leaf 'index' around its bodies, with LeafRoom to spare
+	void FitLeaf(uint32_t index, const glm::dvec3* positions, const float* radii);
+	// Fits every inner node around its children
+	void FitInnerNodes();
+
+	std::vector<Node> m_Nodes;
+	// Bodies in leaf order
+	std::vector<uint32_t> m_Bodies;
+	// Leaf of every body
+	std::vector<uint32_t> m_Leaves;
+	// Leaves found to need fitting this frame, flagged by node so each is listed once
+	std::vector<uint32_t> m_Refit;
+	std::vector<unsigned char> m_Flagged;
+
+	// Point the boxes are relative to, and how far from it the furthest box corner is
+	glm::dvec3 m_Origin = glm::dvec3(0.0);
+	float m_Extent = 0.0f;
+	// Arrays of the last Update
+	const glm::dvec3* m_Positions = nullptr;
+	const float* m_Radii = nullptr;
+
+	size_t m_BodyCount = 0;
+	size_t m_RefittedLeaves = 0;
+	unsigned int m_FramesSinceBuild = 0;
+};
+
+#endif
@@ -0,0 +1,415 @@
+#include "EnvironmentBaker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define ENVIRONMENT_BAKER_SSE2
+#endif
+
+static const double PI = 3.14159265358979323846;
+
+// Coefficients of the first three bands of real spherical harmonics
+static const float Y0 = 0.282095f, Y1 = 0.488603f, Y2 = 1.092548f, Y20 = 0.315392f, Y22 = 0.546274f;
+
+glm::vec3 SphericalHarmonics::Evaluate(const glm::vec3& d) const
+{
+	const glm::vec3* c = coefficients;
+	return c[0] * Y0
+		+ c[1] * (Y1 * d.y) + c[2] * (Y1 * d.z) + c[3] * (Y1 * d.x)
+		+ c[4] * (Y2 * d.x * d.y) + c[5] * (Y2 * d.y * d.z) + c[6] * (Y20 * (3.0f * d.z * d.z - 1.0f))
+		+ c[7] * (Y2 * d.x * d.z) + c[8] * (Y22 * (d.x * d.x - d.y * d.y));
+}
+
+#pragma region Sampling
+
+// Direction through the center of texel (x, y) of 'face' of a 'size' cubemap, GL's face layout
+static glm::vec3 faceDirection(int face, int x, int y, int size)
+{
+	const float s = 2.0f * (x + 0.5f) / size - 1.0f, t = 2.0f * (y + 0.5f) / size - 1.0f;
+	switch (face)
+	{
+	case 0:		return glm::normalize(glm::vec3(1.0f, -t, -s));
+	case 1:		return glm::normalize(glm::vec3(-1.0f, -t, s));
+	case 2:		return glm::normalize(glm::vec3(s, 1.0f, t));
+	case 3:		return glm::normalize(glm::vec3(s, -1.0f, -t));
+	case 4:		return glm::normalize(glm::vec3(s, -t, 1.0f));
+	default:	return glm::normalize(glm::vec3(-s, -t, -1.0f));
+	}
+}
+
+// Bilinear RGB of 'pixels' ('width' x 'height', 'channels' each) at texel coordinates (x, y), clamped to the edges
+static glm::vec3 bilinear(const float* pixels, int width, int height, int channels, float x, float y)
+{
+	x = std::min(std::max(x, 0.0f), (float)(width - 1));
+	y = std::min(std::max(y, 0.0f), (float)(height - 1));
+	const int x0 = (int)x, y0 = (int)y, x1 = std::min(x0 + 1, width - 1), y1 = std::min(y0 + 1, height - 1);
+	const float fx = x - x0, fy = y - y0;
+
+	auto texel = [&](int tx, int ty) { const float* p = pixels + ((size_t)ty * width + tx) * channels; return glm::vec3(p[0], p[1], p[2]); };
+	return glm::mix(glm::mix(texel(x0, y0), texel(x1, y0), fx), glm::mix(texel(x0, y1), texel(x1, y1), fx), fy);
+}
+
+// The equirectangular environment in 'direction', mapped like equirectangular_to_cubemap.fs
+static glm::vec3 sampleEquirectangular(const EnvironmentImage& environment, const glm::vec3& direction)
+{
+	const float u = std::atan2(direction.z, direction.x) / (float)(2.0 * PI) + 0.5f;
+	const float v = std::asin(std::min(std::max(direction.y, -1.0f), 1.0f)) / (float)PI + 0.5f;
+	return bilinear(environment.pixels, environment.width, environment.height, environment.channels,
+		u * environment.width - 0.5f, v * environment.height - 0.5f);
+}
+
+// Level 'level' of 'cubemap' in 'direction', within the face the direction points at
+static glm::vec3 sampleFace(const CubemapData& cubemap, const glm::vec3& direction, int level)
+{
+	const glm::vec3 a = glm::abs(direction);
+	int face;
+	float sc, tc, major;
+	if (a.x >= a.y && a.x >= a.z)
+	{
+		face = direction.x > 0.0f ? 0 : 1;
+		sc = direction.x > 0.0f ? -direction.z : direction.z;
+		tc = -direction.y;
+		major = a.x;
+	}
+	else if (a.y >= a.z)
+	{
+		face = direction.y > 0.0f ? 2 : 3;
+		sc = direction.x;
+		tc = direction.y > 0.0f ? direction.z : -direction.z;
+		major = a.y;
+	}
+	else
+	{
+		face = direction.z > 0.0f ? 4 : 5;
+		sc = direction.z > 0.0f ? direction.x : -direction.x;
+		tc = -direction.y;
+		major = a.z;
+	}
+
+	const int size = cubemap.LevelSize(level);
+	const float s = (sc / major + 1.0f) * 0.5f, t = (tc / major + 1.0f) * 0.5f;
+	return bilinear(cubemap.Face(level, face), size, size, 3, s * size - 0.5f, t * size - 0.5f);
+}
+
+// 'cubemap' in 'direction' at a fractional 'lod', blending the two closest levels
+static glm::vec3 sampleCubemap(const CubemapData& cubemap, const glm::vec3& direction, float lod)
+{
+	const int last = (int)cubemap.levels.size() - 1;
+	lod = std::min(std::max(lod, 0.0f), (float)last);
+	const int level = std::min((int)lod, last);
+	const float blend = lod - level;
+	const glm::vec3 color = sampleFace(cubemap, direction, level);
+	return blend > 0.0f ? glm::mix(color, sampleFace(cubemap, direction, level + 1), blend) : color;
+}
+
+#pragma endregion
+
+#pragma region GGX
+
+// Van der Corpus sequence against i / count, the same points prefilter.fs & brdf.fs sample
+static glm::vec2 hammersley(uint32_t i, uint32_t count)
+{
+	uint32_t bits = i;
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return glm::vec2((float)i / (float)count, (float)bits * 2.3283064365386963e-10f);
+}
+
+// Halfway vector around +Z for 'xi', distributed like the GGX lobe of 'roughness'
+static glm::vec3 importanceSampleGGX(const glm::vec2& xi, float roughness)
+{
+	const float a = roughness * roughness;
+	const float phi = (float)(2.0 * PI) * xi.x;
+	const float cosTheta = std::sqrt((1.0f - xi.y) / (1.0f + (a * a - 1.0f) * xi.y));
+	const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+	return glm::vec3(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+}
+
+static float geometrySchlickGGX(float cosine, float roughness)
+{
+	const float k = roughness * roughness / 2.0f;
+	return cosine / (cosine * (1.0f - k) + k);
+}
+
+#pragma endregion
+
+// Sums over 'count' (a multiple of 4) texels of a row of one channel: L, L cos, L sin, L cos^2 & L cos sin of the longitude.
+// Lanes are added up at the end in the same order with or without SSE2, so both give the same sums.
+static void rowMoments(const float* radiance, const float* cosines, const float* sines, int count, double sums[5])
+{
+	float lanes[5][4];
+#if defined(ENVIRONMENT_BAKER_SSE2)
+	__m128 m[5] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+	for (int x = 0; x < count; x += 4)
+	{
+		const __m128 l = _mm_loadu_ps(radiance + x), c = _mm_loadu_ps(cosines + x), s = _mm_loadu_ps(sines + x);
+		const __m128 lc = _mm_mul_ps(l, c);
+		m[0] = _mm_add_ps(m[0], l);
+		m[1] = _mm_add_ps(m[1], lc);
+		m[2] = _mm_add_ps(m[2], _mm_mul_ps(l, s));
+		m[3] = _mm_add_ps(m[3], _mm_mul_ps(lc, c));
+		m[4] = _mm_add_ps(m[4], _mm_mul_ps(lc, s));
+	}
+	for (int k = 0; k < 5; k++)
+		_mm_storeu_ps(lanes[k], m[k]);
+#else
+	std::fill(&lanes[0][0], &lanes[0][0] + 20, 0.0f);
+	for (int x = 0; x < count; x += 4)
+		for (int lane = 0; lane < 4; lane++)
+		{
+			const float l = radiance[x + lane], c = cosines[x + lane], s = sines[x + lane];
+			const float lc = l * c;
+			lanes[0][lane] += l;
+			lanes[1][lane] += lc;
+			lanes[2][lane] += l * s;
+			lanes[3][lane] += lc * c;
+			lanes[4][lane] += lc * s;
+		}
+#endif
+	for (int k = 0; k < 5; k++)
+		sums[k] = ((double)lanes[k][0] + lanes[k][1]) + ((double)lanes[k][2] + lanes[k][3]);
+}
+
+SphericalHarmonics EnvironmentBaker::ProjectIrradiance(const EnvironmentImage& environment, JobSystem& jobs)
+{
+	const int width = environment.width, height = environment.height, channels = environment.channels;
+	// Padded with zero radiance to whole groups of 4
+	const int padded = (width + 3) & ~3;
+
+	// Every row shares the longitudes of the columns
+	std::vector<float> cosines(padded, 0.0f), sines(padded, 0.0f);
+	for (int x = 0; x < width; x++)
+	{
+		const double longitude = ((x + 0.5) / width - 0.5) * 2.0 * PI;
+		cosines[x] = (float)std::cos(longitude);
+		sines[x] = (float)std::sin(longitude);
+	}
+
+	// Moments over the longitude of every row & channel, the latitude is the same along a row
+	std::vector<double> moments((size_t)height * 15);
+	jobs.ParallelFor(height, 16, [&](size_t begin, size_t end)
+	{
+		std::vector<float> radiance(padded, 0.0f);
+		for (size_t y = begin; y < end; y++)
+		{
+			const float* row = environment.pixels + y * width * channels;
+			for (int c = 0; c < 3; c++)
+			{
+				for (int x = 0; x < width; x++)
+					radiance[x] = row[(size_t)x * channels + c];
+				rowMoments(radiance.data(), cosines.data(), sines.data(), padded, &moments[y * 15 + c * 5]);
+			}
+		}
+	});
+
+	// Rows are added up top to bottom whichever thread projected them. A texel of a row covers dLongitude times the
+	// difference of the sines of the latitudes bounding the row, exactly, so the solid angles add up to 4 PI.
+	double sums[9][3] = {};
+	for (int y = 0; y < height; y++)
+	{
+		const double latitude = ((y + 0.5) / height - 0.5) * PI;
+		const double bottom = ((double)y / height - 0.5) * PI, top = ((y + 1.0) / height - 0.5) * PI;
+		const double up = std::sin(latitude), across = std::cos(latitude);
+		const double weight = (2.0 * PI / width) * (std::sin(top) - std::sin(bottom));
+		for (int c = 0; c < 3; c++)
+		{
+			const double* m = &moments[(size_t)y * 15 + c * 5];
+			const double sum = m[0], cosSum = m[1], sinSum = m[2], cos2Sum = m[3], cosSinSum = m[4];
+			const double sin2Sum = sum - cos2Sum;
+			sums[0][c] += weight * Y0 * sum;
+			sums[1][c] += weight * Y1 * up * sum;
+			sums[2][c] += weight * Y1 * across * sinSum;
+			sums[3][c] += weight * Y1 * across * cosSum;
+			sums[4][c] += weight * Y2 * across * up * cosSum;
+			sums[5][c] += weight * Y2 * up * across * sinSum;
+			sums[6][c] += weight * Y20 * (3.0 * across * across * sin2Sum - sum);
+			sums[7][c] += weight * Y2 * across * across * cosSinSum;
+			sums[8][c] += weight * Y22 * (across * across * cos2Sum - up * up * sum);
+		}
+	}
+
+	// Convolving with the clamped cosine scales band l by A_l (PI, 2PI/3, PI/4), irradiance / PI by A_l / PI
+	static const double band[9] = { 1.0, 2.0 / 3.0, 2.0 / 3.0, 2.0 / 3.0, 0.25, 0.25, 0.25, 0.25, 0.25 };
+	SphericalHarmonics harmonics;
+	for (int i = 0; i < 9; i++)
+		harmonics.coefficients[i] = glm::vec3((float)(sums[i][0] * band[i]), (float)(sums[i][1] * band[i]), (float)(sums[i][2] * band[i]));
+	return harmonics;
+}
+
+CubemapData EnvironmentBaker::Cubemap(const EnvironmentImage& environment, int size, JobSystem& jobs)
+{
+	CubemapData cubemap;
+	cubemap.size = size;
+	cubemap.levels.emplace_back((size_t)6 * size * size * 3);
+
+	float* faces = cubemap.levels[0].data();
+	jobs.ParallelFor((size_t)6 * size, 16, [&](size_t begin, size_t end)
+	{
+		for (size_t row = begin; row < end; row++)
+		{
+			const int face = (int)(row / size), y = (int)(row % size);
+			float* texel = faces + row * size * 3;
+			for (int x = 0; x < size; x++, texel += 3)
+			{
+				const glm::vec3 color = sampleEquirectangular(environment, faceDirection(face, x, y, size));
+				texel[0] = color.r;
+				texel[1] = color.g;
+				texel[2] = color.b;
+			}
+		}
+	});
+
+	// Every mip averages the 2x2 texels above it
+	for (int level = 1; cubemap.LevelSize(level - 1) > 1; level++)
+	{
+		const int source = cubemap.LevelSize(level - 1), target = cubemap.LevelSize(level);
+		std::vector<float> pixels((size_t)6 * target * target * 3);
+		const std::vector<float>& above = cubemap.levels[level - 1];
+		for (int face = 0; face < 6; face++)
+			for (int y = 0; y < target; y++)
+				for (int x = 0; x < target; x++)
+					for (int c = 0; c < 3; c++)
+					{
+						auto at = [&](int tx, int ty) { return above[(((size_t)face * source + std::min(ty, source - 1)) * source + std::min(tx, source - 1)) * 3 + c]; };
+						pixels[(((size_t)face * target + y) * target + x) * 3 + c] =
+							(at(2 * x, 2 * y) + at(2 * x + 1, 2 * y) + at(2 * x, 2 * y + 1) + at(2 * x + 1, 2 * y + 1)) * 0.25f;
+					}
+		cubemap.levels.push_back(std::move(pixels));
+	}
+	return cubemap;
+}
+
+CubemapData EnvironmentBaker::Irradiance(const SphericalHarmonics& irradiance, int size)
+{
+	CubemapData cubemap;
+	cubemap.size = size;
+	cubemap.levels.emplace_back((size_t)6 * size * size * 3);
+
+	float* texel = cubemap.levels[0].data();
+	for (int face = 0; face < 6; face++)
+		for (int y = 0; y < size; y++)
+			for (int x = 0; x < size; x++, texel += 3)
+			{
+				// The first bands ring a little below 0 on the dark side of a bright light
+				const glm::vec3 color = glm::max(irradiance.Evaluate(faceDirection(face, x, y, size)), glm::vec3(0.0f));
+				texel[0] = color.r;
+				texel[1] = color.g;
+				texel[2] = color.b;
+			}
+	return cubemap;
+}
+
+CubemapData EnvironmentBaker::Prefilter(const CubemapData& environment, int size, int levels, JobSystem& jobs)
+{
+	CubemapData prefiltered;
+	prefiltered.size = size;
+
+	// The solid angle of a texel of the environment's first level, prefilter.fs assumes 512 texel faces instead
+	const float texelAngle = (float)(4.0 * PI / (6.0 * environment.size * environment.size));
+	for (int level = 0; level < levels; level++)
+	{
+		const int levelSize = prefiltered.LevelSize(level);
+		const float roughness = levels > 1 ? (float)level / (float)(levels - 1) : 0.0f;
+
+		// With V = N every texel takes the same samples around its own normal, the directions & mips are worked out once
+		struct Sample { glm::vec3 light; float weight, lod; };
+		std::vector<Sample> samples;
+		if (roughness == 0.0f)
+			samples.push_back({ glm::vec3(0.0f, 0.0f, 1.0f), 1.0f, 0.0f });
+		else
+		{
+			for (uint32_t i = 0; i < SampleCount; i++)
+			{
+				const glm::vec3 halfway = importanceSampleGGX(hammersley(i, SampleCount), roughness);
+				const glm::vec3 light = glm::normalize(2.0f * halfway.z * halfway - glm::vec3(0.0f, 0.0f, 1.0f));
+				if (light.z <= 0.0f)
+					continue;
+
+				const float a2 = roughness * roughness * roughness * roughness;
+				const float denominator = halfway.z * halfway.z * (a2 - 1.0f) + 1.0f;
+				const float distribution = a2 / ((float)PI * denominator * denominator);
+				const float pdf = distribution * halfway.z / (4.0f * halfway.z) + 0.0001f;
+				const float sampleAngle = 1.0f / ((float)SampleCount * pdf + 0.0001f);
+				samples.push_back({ light, light.z, 0.5f * std::log2(sampleAngle / texelAngle) });
+			}
+		}
+
+		prefiltered.levels.emplace_back((size_t)6 * levelSize * levelSize * 3);
+		float* faces = prefiltered.levels.back().data();
+		jobs.ParallelFor((size_t)6 * levelSize, 1, [&](size_t begin, size_t end)
+		{
+			for (size_t row = begin; row < end; row++)
+			{
+				const int face = (int)(row / levelSize), y = (int)(row % levelSize);
+				float* texel = faces + row * levelSize * 3;
+				for (int x = 0; x < levelSize; x++, texel += 3)
+				{
+					const glm::vec3 normal = faceDirection(face, x, y, levelSize);
+					const glm::vec3 up = std::abs(normal.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+					const glm::vec3 tangent = glm::normalize(glm::cross(up, normal));
+					const glm::vec3 bitangent = glm::cross(normal, tangent);
+
+					glm::vec3 color(0.0f);
+					float weight = 0.0f;
+					for (const Sample& sample : samples)
+					{
+						const glm::vec3 light = glm::normalize(tangent * sample.light.x + bitangent * sample.light.y + normal * sample.light.z);
+						color += sampleCubemap(environment, light, sample.lod) * sample.weight;
+						weight += sample.weight;
+					}
+					color /= weight;
+					texel[0] = color.r;
+					texel[1] = color.g;
+					texel[2] = color.b;
+				}
+			}
+		});
+	}
+	return prefiltered;
+}
+
+std::vector<float> EnvironmentBaker::BrdfLUT(int size, JobSystem& jobs)
+{
+	std::vector<float> lut((size_t)size * size * 2);
+	jobs.ParallelFor(size, 1, [&](size_t begin, size_t end)
+	{
+		std::vector<glm::vec3> halfways(SampleCount);
+		for (size_t y = begin; y < end; y++)
+		{
+			// Roughness is constant along a row, so are the halfway vectors around N = +Z
+			const float roughness = (y + 0.5f) / size;
+			for (uint32_t i = 0; i < SampleCount; i++)
+				halfways[i] = importanceSampleGGX(hammersley(i, SampleCount), roughness);
+
+			for (int x = 0; x < size; x++)
+			{
+				const float NdotV = (x + 0.5f) / size;
+				const glm::vec3 view(std::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV);
+				const float viewGeometry = geometrySchlickGGX(NdotV, roughness);
+
+				float scale = 0.0f, bias = 0.0f;
+				for (const glm::vec3& halfway : halfways)
+				{
+					const float VdotH = glm::dot(view, halfway);
+					const glm::vec3 light = glm::normalize(2.0f * VdotH * halfway - view);
+					if (light.z <= 0.0f)
+						continue;
+
+					const float visibility = geometrySchlickGGX(light.z, roughness) * viewGeometry * std::max(VdotH, 0.0f) / (std::max(halfway.z, 0.0f) * NdotV);
+					const float fresnel = std::pow(1.0f - std::max(VdotH, 0.0f), 5.0f);
+					scale += (1.0f - fresnel) * visibility;
+					bias += fresnel * visibility;
+				}
+				lut[((size_t)y * size + x) * 2] = scale / SampleCount;
+				lut[((size_t)y * size + x) * 2 + 1] = bias / SampleCount;
+			}
+		}
+	});
+	return lut;
+}
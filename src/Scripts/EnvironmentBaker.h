@@ -0,0 +1,62 @@
+#ifndef ENVIRONMENT_BAKER_H
+#define ENVIRONMENT_BAKER_H
+
+#include <vector>
+
+#include "../../vendor/glm/glm.hpp"
+#include "JobSystem.h"
+
+// An equirectangular environment as it is decoded for GL: float pixels, rows from the bottom (-Y) up.
+struct EnvironmentImage
+{
+	const float* pixels = nullptr;
+	int width = 0, height = 0;
+	// 3 or more, only the first three are read
+	int channels = 3;
+};
+
+// The first three bands of spherical harmonics (9 coefficients per channel) of an environment's irradiance.
+// Scaled so Evaluate returns irradiance / PI, the same thing the irradiance cubemap holds.
+struct SphericalHarmonics
+{
+	glm::vec3 coefficients[9] = {};
+
+	glm::vec3 Evaluate(const glm::vec3& direction) const;
+};
+
+// RGB float faces of every level of a cubemap, +X to -Z, each one's rows in the order GL uploads them.
+struct CubemapData
+{
+	int size = 0;
+	// levels[level] holds the 6 faces of LevelSize(level)^2 texels one after another
+	std::vector<std::vector<float>> levels;
+
+	int LevelSize(int level) const { return size >> level > 1 ? size >> level : 1; }
+	const float* Face(int level, int face) const { return levels[level].data() + (size_t)face * LevelSize(level) * LevelSize(level) * 3; }
+};
+
+// CPU version of the image based lighting bake SetupPBR runs on the GPU, for machines with software GL and for
+// baking offline. Nothing here touches OpenGL. Work is spread over the job system, every texel or row is computed
+// on its own and sums are added up in a fixed order, so a bake comes out the same to the bit on every run.
+namespace EnvironmentBaker
+{
+	// Identifies the results of this baker, change it with anything that changes them
+	const char* const Name = "EnvironmentBaker 1";
+	// GGX samples per texel of the prefiltered levels and the BRDF LUT, as prefilter.fs & brdf.fs take
+	const unsigned int SampleCount = 1024;
+
+	// Projects the radiance of 'environment' onto spherical harmonics and convolves them with the cosine lobe.
+	// Rows are projected in parallel, the texels of a row 4 at a time with SSE2.
+	SphericalHarmonics ProjectIrradiance(const EnvironmentImage& environment, JobSystem& jobs);
+	// Resamples 'environment' onto the faces of a 'size' cubemap, bilinearly, then box filters its mips down to 1x1
+	CubemapData Cubemap(const EnvironmentImage& environment, int size, JobSystem& jobs);
+	// Evaluates 'irradiance' over the faces of a 'size' cubemap with a single level
+	CubemapData Irradiance(const SphericalHarmonics& irradiance, int size);
+	// Prefilters 'environment' (with all its mips) for 'levels' roughnesses from 0 to 1 with GGX importance sampling,
+	// level 0 being 'size'. Samples read the mip their solid angle covers, like prefilter.fs.
+	CubemapData Prefilter(const CubemapData& environment, int size, int levels, JobSystem& jobs);
+	// Split sum scale & bias (RG) of the GGX BRDF over N.V (x) and roughness (y), 'size' x 'size', like brdf.fs
+	std::vector<float> BrdfLUT(int size, JobSystem& jobs);
+}
+
+#endif
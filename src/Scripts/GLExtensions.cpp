@@ -0,0 +1,82 @@
+#include "GLExtensions.h"
+
+#include <cstring>
+
+PFNGLCLIPCONTROLPROC glad_glClipControl = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect = nullptr;
+PFNGLCOPYIMAGESUBDATAPROC glad_glCopyImageSubData = nullptr;
+PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute = nullptr;
+PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier = nullptr;
+PFNGLGETPROGRAMBINARYPROC glad_glGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC glad_glProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC glad_glProgramParameteri = nullptr;
+
+namespace GLExtensions
+{
+	bool ClipControl = false;
+	bool MultiDrawIndirect = false;
+	bool ComputeShaders = false;
+	bool ProgramBinaries = false;
+	bool TextureCompressionS3TC = false;
+	bool TextureCompressionBPTC = false;
+
+	void Load(GLADloadproc loader)
+	{
+		if (HasVersion(4, 5) || HasExtension("GL_ARB_clip_control"))
+			glad_glClipControl = (PFNGLCLIPCONTROLPROC)loader("glClipControl");
+		ClipControl = glad_glClipControl != nullptr;
+
+		// The batched shaders are GLSL 4.30, the extensions alone aren't enough
+		if (HasVersion(4, 3))
+		{
+			glad_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)loader("glMultiDrawElementsIndirect");
+			glad_glCopyImageSubData = (PFNGLCOPYIMAGESUBDATAPROC)loader("glCopyImageSubData");
+		}
+		MultiDrawIndirect = glad_glMultiDrawElementsIndirect != nullptr && glad_glCopyImageSubData != nullptr;
+
+		// Same for the compute shaders, they are GLSL 4.30
+		if (HasVersion(4, 3))
+		{
+			glad_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)loader("glDispatchCompute");
+			glad_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)loader("glMemoryBarrier");
+		}
+		ComputeShaders = glad_glDispatchCompute != nullptr && glad_glMemoryBarrier != nullptr;
+
+		if (HasVersion(4, 1) || HasExtension("GL_ARB_get_program_binary"))
+		{
+			glad_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)loader("glGetProgramBinary");
+			glad_glProgramBinary = (PFNGLPROGRAMBINARYPROC)loader("glProgramBinary");
+			glad_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)loader("glProgramParameteri");
+		}
+		// Drivers may support the functions without any format to save programs in
+		GLint binaryFormats = 0;
+		if (glad_glGetProgramBinary && glad_glProgramBinary && glad_glProgramParameteri)
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+		ProgramBinaries = binaryFormats > 0;
+
+		// Only enums, nothing to load
+		TextureCompressionS3TC = HasExtension("GL_EXT_texture_compression_s3tc") && HasExtension("GL_EXT_texture_sRGB");
+		TextureCompressionBPTC = HasVersion(4, 2) || HasExtension("GL_ARB_texture_compression_bptc");
+	}
+
+	bool HasVersion(int major, int minor)
+	{
+		GLint contextMajor = 0, contextMinor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+		glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+		return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+	}
+
+	bool HasExtension(const char* name)
+	{
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; i++)
+		{
+			const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+			if (extension && std::strcmp(extension, name) == 0)
+				return true;
+		}
+		return false;
+	}
+}
@@ -0,0 +1,91 @@
+#include "HeadlessContext.h"
+
+#include <cstring>
+#include <iostream>
+
+#if defined(SOLAR_SYSTEM_EGL)
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+bool HeadlessContext::Create(int major, int minor)
+{
+	// The surfaceless platform needs no display server, the default display is the fallback for other EGL vendors
+	EGLDisplay display = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay)
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint eglMajor = 0, eglMinor = 0;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &eglMajor, &eglMinor))
+	{
+		std::cout << "ERROR::HEADLESS_CONTEXT::NO_EGL_DISPLAY" << std::endl;
+		return false;
+	}
+	m_Display = display;
+
+	// Without a surface there is nothing a config would describe
+	const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+	if (!extensions || !strstr(extensions, "EGL_KHR_surfaceless_context") || !strstr(extensions, "EGL_KHR_no_config_context"))
+	{
+		std::cout << "ERROR::HEADLESS_CONTEXT::NO_SURFACELESS_CONTEXTS" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	const EGLint attributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, major,
+		EGL_CONTEXT_MINOR_VERSION, minor,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext context = EGL_NO_CONTEXT;
+	if (eglBindAPI(EGL_OPENGL_API))
+		context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+	if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		std::cout << "ERROR::HEADLESS_CONTEXT::CONTEXT_NOT_CREATED: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+		if (context != EGL_NO_CONTEXT)
+			eglDestroyContext(display, context);
+		Destroy();
+		return false;
+	}
+	m_Context = context;
+	return true;
+}
+
+void HeadlessContext::Destroy()
+{
+	if (!m_Display)
+		return;
+
+	eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (m_Context)
+		eglDestroyContext(m_Display, m_Context);
+	eglTerminate(m_Display);
+	m_Display = m_Context = nullptr;
+}
+
+void* HeadlessContext::GetProcAddress(const char* name)
+{
+	return (void*)eglGetProcAddress(name);
+}
+
+#else
+
+bool HeadlessContext::Create(int major, int minor)
+{
+	std::cout << "ERROR::HEADLESS_CONTEXT::BUILT_WITHOUT_EGL" << std::endl;
+	return false;
+}
+
+void HeadlessContext::Destroy() {}
+
+void* HeadlessContext::GetProcAddress(const char* name)
+{
+	return nullptr;
+}
+
+#endif
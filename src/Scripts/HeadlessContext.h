@@ -0,0 +1,27 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+// An OpenGL core context without any window or surface, made with EGL on Mesa's surfaceless platform.
+// Runs anywhere Mesa does, down to llvmpipe on machines with no GPU and no display, so nothing but
+// framebuffer objects can be drawn to. Only available where CMake found EGL (SOLAR_SYSTEM_EGL).
+class HeadlessContext
+{
+public:
+	HeadlessContext() {}
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+	~HeadlessContext() { Destroy(); }
+
+	// Creates a 'major'.'minor' core profile context and makes it current on the calling thread, false if that fails
+	bool Create(int major, int minor);
+	void Destroy();
+
+	// Loader for GLAD & GLExtensions, core functions included
+	static void* GetProcAddress(const char* name);
+
+private:
+	void* m_Display = nullptr;
+	void* m_Context = nullptr;
+};
+
+#endif
@@ -0,0 +1,240 @@
+#include "IBLCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "../../vendor/glm/gtc/packing.hpp"
+
+// Faces a map of 'target' has
+static int faceCount(uint32_t target) { return target == GL_TEXTURE_CUBE_MAP ? 6 : 1; }
+
+static uint32_t channelCount(uint32_t format) { return format == GL_RGB ? 3 : 2; }
+
+// Bytes of level 'level' of a map, all of its faces
+static uint64_t levelBytes(uint32_t target, uint32_t format, uint32_t size, uint32_t level)
+{
+	const uint64_t side = std::max(size >> level, 1u);
+	return faceCount(target) * side * side * channelCount(format) * 2;
+}
+
+// FNV-1a, 64 bit
+static uint64_t hashBytes(uint64_t hash, const unsigned char* bytes, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	return hash;
+}
+
+std::vector<IBLCache::Map> IBLCache::Maps(GLuint environment, GLuint irradiance, GLuint prefilter, GLuint brdfLUT)
+{
+	return
+	{
+		{ environment, GL_TEXTURE_CUBE_MAP, GL_RGB, EnvironmentSize, 1 },
+		{ irradiance, GL_TEXTURE_CUBE_MAP, GL_RGB, IrradianceSize, 1 },
+		{ prefilter, GL_TEXTURE_CUBE_MAP, GL_RGB, PrefilterSize, PrefilterLevels },
+		{ brdfLUT, GL_TEXTURE_2D, GL_RG, BrdfLUTSize, 1 }
+	};
+}
+
+uint64_t IBLCache::Key(const std::vector<std::string>& files, const std::string& baker, const std::vector<Map>& maps)
+{
+	uint64_t hash = hashBytes(14695981039346656037ull, reinterpret_cast<const unsigned char*>(&Version), sizeof(Version));
+	for (const std::string& file : files)
+	{
+		std::shared_ptr<MappedFile> mapped = MappedFile::Open(file.c_str());
+		if (!mapped)
+			return 0;
+		hash = hashBytes(hash, mapped->data(), mapped->size());
+	}
+	hash = hashBytes(hash, reinterpret_cast<const unsigned char*>(baker.data()), baker.size());
+	for (const Map& map : maps)
+	{
+		const uint32_t layout[4] = { (uint32_t)map.target, (uint32_t)map.format, (uint32_t)map.size, (uint32_t)map.levels };
+		hash = hashBytes(hash, reinterpret_cast<const unsigned char*>(layout), sizeof(layout));
+	}
+	// 0 means no key
+	return hash ? hash : 1;
+}
+
+uint64_t IBLCache::BakerKey(const std::string& environment)
+{
+	return Key({ environment }, EnvironmentBaker::Name, Maps(0, 0, 0, 0));
+}
+
+std::vector<unsigned char> IBLCache::Pack(uint64_t key, const std::vector<Map>& maps, const SphericalHarmonics& irradiance,
+	const std::function<void(size_t map, uint32_t level, int face, uint16_t* pixels)>& fill)
+{
+	Header header = {};
+	header.magic = Magic;
+	header.version = Version;
+	header.key = key;
+	header.mapCount = (uint32_t)maps.size();
+	std::memcpy(header.irradiance, irradiance.coefficients, sizeof(header.irradiance));
+
+	std::vector<MapRecord> records(maps.size());
+	uint64_t offset = Package::align(sizeof(Header) + records.size() * sizeof(MapRecord));
+	for (size_t i = 0; i < maps.size(); i++)
+	{
+		MapRecord& record = records[i];
+		std::memset(&record, 0, sizeof(record));
+		record.target = maps[i].target;
+		record.format = maps[i].format;
+		record.size = (uint32_t)maps[i].size;
+		record.levelCount = (uint32_t)std::min(maps[i].levels, (int)MaxLevels);
+		for (uint32_t level = 0; level < record.levelCount; level++)
+		{
+			record.levelOffsets[level] = offset;
+			offset = Package::align(offset + levelBytes(record.target, record.format, record.size, level));
+		}
+	}
+
+	std::vector<unsigned char> bytes((size_t)offset, 0);
+	std::memcpy(bytes.data(), &header, sizeof(header));
+	std::memcpy(bytes.data() + sizeof(header), records.data(), records.size() * sizeof(MapRecord));
+
+	for (size_t i = 0; i < maps.size(); i++)
+	{
+		const MapRecord& record = records[i];
+		for (uint32_t level = 0; level < record.levelCount; level++)
+		{
+			const uint64_t faceBytes = levelBytes(record.target, record.format, record.size, level) / faceCount(record.target);
+			for (int face = 0; face < faceCount(record.target); face++)
+				fill(i, level, face, reinterpret_cast<uint16_t*>(bytes.data() + record.levelOffsets[level] + face * faceBytes));
+		}
+	}
+	return bytes;
+}
+
+std::vector<unsigned char> IBLCache::Serialize(uint64_t key, const std::vector<Map>& maps, const SphericalHarmonics& irradiance)
+{
+	//Rows of Odd Sized RGB Levels Aren't a Multiple of 4 Bytes.
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	std::vector<unsigned char> bytes = Pack(key, maps, irradiance, [&maps](size_t map, uint32_t level, int face, uint16_t* pixels)
+	{
+		glBindTexture(maps[map].target, maps[map].texture);
+		GLenum target = maps[map].target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+		glGetTexImage(target, level, maps[map].format, GL_HALF_FLOAT, pixels);
+		glBindTexture(maps[map].target, 0);
+	});
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	return bytes;
+}
+
+std::vector<unsigned char> IBLCache::Bake(uint64_t key, const EnvironmentImage& environment, JobSystem& jobs)
+{
+	const SphericalHarmonics irradiance = EnvironmentBaker::ProjectIrradiance(environment, jobs);
+	const CubemapData cubemap = EnvironmentBaker::Cubemap(environment, EnvironmentSize, jobs);
+	const CubemapData irradianceMap = EnvironmentBaker::Irradiance(irradiance, IrradianceSize);
+	const CubemapData prefiltered = EnvironmentBaker::Prefilter(cubemap, PrefilterSize, PrefilterLevels, jobs);
+	const std::vector<float> brdfLUT = EnvironmentBaker::BrdfLUT(BrdfLUTSize, jobs);
+
+	const CubemapData* cubemaps[3] = { &cubemap, &irradianceMap, &prefiltered };
+	const std::vector<Map> maps = Maps(0, 0, 0, 0);
+	return Pack(key, maps, irradiance, [&](size_t map, uint32_t level, int face, uint16_t* pixels)
+	{
+		const float* source = map < 3 ? cubemaps[map]->Face(level, face) : brdfLUT.data();
+		const size_t count = levelBytes(maps[map].target, maps[map].format, maps[map].size, level) / faceCount(maps[map].target) / 2;
+		for (size_t i = 0; i < count; i++)
+			pixels[i] = glm::packHalf1x16(source[i]);
+	});
+}
+
+bool IBLCache::Write(const std::string& file, const std::vector<unsigned char>& bytes)
+{
+	const std::string temporary = file + ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		if (!out.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size()))
+		{
+			out.close();
+			std::remove(temporary.c_str());
+			return false;
+		}
+	}
+
+	// Renaming over an existing file fails on Windows
+	std::remove(file.c_str());
+	return std::rename(temporary.c_str(), file.c_str()) == 0;
+}
+
+std::shared_ptr<IBLCacheReader> IBLCacheReader::Open(const char* file, uint64_t key, const std::vector<IBLCache::Map>& maps)
+{
+	std::shared_ptr<MappedFile> mapped = MappedFile::Open(file);
+	if (!mapped)
+		return nullptr;
+	return Validate(mapped, mapped->data(), mapped->size(), key, maps);
+}
+
+std::shared_ptr<IBLCacheReader> IBLCacheReader::Read(std::shared_ptr<const std::vector<unsigned char>> bytes, uint64_t key, const std::vector<IBLCache::Map>& maps)
+{
+	return Validate(bytes, bytes->data(), bytes->size(), key, maps);
+}
+
+std::shared_ptr<IBLCacheReader> IBLCacheReader::Validate(std::shared_ptr<const void> owner, const unsigned char* data, size_t size,
+	uint64_t key, const std::vector<IBLCache::Map>& maps)
+{
+	using namespace IBLCache;
+
+	if (size < sizeof(Header))
+		return nullptr;
+	const Header* header = reinterpret_cast<const Header*>(data);
+	if (header->magic != Magic || header->version != Version || header->key != key || header->mapCount != maps.size())
+		return nullptr;
+	if (size < sizeof(Header) + maps.size() * sizeof(MapRecord))
+		return nullptr;
+
+	// The key covers the layout too, checking it again only guards against a truncated or damaged file
+	const MapRecord* records = reinterpret_cast<const MapRecord*>(data + sizeof(Header));
+	for (size_t i = 0; i < maps.size(); i++)
+	{
+		const MapRecord& record = records[i];
+		if (record.target != maps[i].target || record.format != maps[i].format || record.size != (uint32_t)maps[i].size ||
+			record.levelCount != (uint32_t)maps[i].levels || record.levelCount > MaxLevels)
+			return nullptr;
+		for (uint32_t level = 0; level < record.levelCount; level++)
+		{
+			const uint64_t offset = record.levelOffsets[level], bytes = levelBytes(record.target, record.format, record.size, level);
+			if (offset > size || bytes > size - offset)
+				return nullptr;
+		}
+	}
+
+	std::shared_ptr<IBLCacheReader> reader(new IBLCacheReader());
+	reader->m_Owner = owner;
+	reader->m_Data = data;
+	reader->m_Maps = records;
+	return reader;
+}
+
+void IBLCacheReader::Upload(const std::vector<IBLCache::Map>& maps) const
+{
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (size_t i = 0; i < maps.size(); i++)
+	{
+		const IBLCache::MapRecord& record = m_Maps[i];
+		glBindTexture(record.target, maps[i].texture);
+		for (uint32_t level = 0; level < record.levelCount; level++)
+		{
+			const unsigned char* pixels = m_Data + record.levelOffsets[level];
+			const GLsizei side = (GLsizei)std::max(record.size >> level, 1u);
+			const uint64_t faceBytes = levelBytes(record.target, record.format, record.size, level) / faceCount(record.target);
+			for (int face = 0; face < faceCount(record.target); face++)
+			{
+				GLenum target = record.target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+				glTexSubImage2D(target, level, 0, 0, side, side, record.format, GL_HALF_FLOAT, pixels + face * faceBytes);
+			}
+		}
+		glBindTexture(record.target, 0);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+SphericalHarmonics IBLCacheReader::Irradiance() const
+{
+	SphericalHarmonics irradiance;
+	std::memcpy(irradiance.coefficients, reinterpret_cast<const IBLCache::Header*>(m_Data)->irradiance, sizeof(irradiance.coefficients));
+	return irradiance;
+}
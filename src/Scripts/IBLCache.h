@@ -0,0 +1,114 @@
+#ifndef IBL_CACHE_H
+#define IBL_CACHE_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../vendor/glad/include/glad.h"
+#include "EnvironmentBaker.h"
+#include "JobSystem.h"
+#include "Package.h"
+
+// The image based lighting maps baked from the environment HDR, saved to a file so later launches upload them instead of
+// baking them again, along with the spherical harmonics of the irradiance. A cache is keyed by a hash of the HDR, the baker
+// that baked it (the GPU passes' shaders, or the EnvironmentBaker) and the layout of the maps, one whose key doesn't match
+// is ignored and replaced by the next bake. Pixels are the half floats the maps hold, so a cached map is identical to a
+// baked one. Every level holds all the faces of a cube map one after another, +X to -Z.
+// All values are little endian and every blob starts on a 16 byte boundary.
+namespace IBLCache
+{
+	const uint32_t Magic = 0x4C425353; // "SSBL"
+	const uint32_t Version = 2;
+	const uint32_t MaxLevels = 16;
+
+	// Sizes of the maps the lighting pass samples
+	const int EnvironmentSize = 1024;
+	const int IrradianceSize = 64;
+	const int PrefilterSize = 256;
+	// Mips of the prefiltered map, roughness 0 to 1
+	const int PrefilterLevels = 5;
+	const int BrdfLUTSize = 1024;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		// MapRecord[mapCount] follow the header
+		uint32_t mapCount;
+		uint32_t reserved;
+		// SphericalHarmonics of the irradiance, 9 RGB coefficients
+		float irradiance[27];
+		uint32_t padding;
+	};
+
+	struct MapRecord
+	{
+		// GL_TEXTURE_CUBE_MAP or GL_TEXTURE_2D
+		uint32_t target;
+		// GL_RGB or GL_RG, of half floats
+		uint32_t format;
+		// Width & height of level 0
+		uint32_t size;
+		uint32_t levelCount;
+		uint64_t levelOffsets[MaxLevels];
+	};
+
+	// A map to cache, its texture allocated with 'levels' or more levels
+	struct Map
+	{
+		GLuint texture;
+		GLenum target;
+		GLenum format;
+		int size;
+		// Levels cached, from level 0
+		int levels;
+	};
+
+	// The environment (level 0, its mips are generated), irradiance, prefiltered & BRDF LUT maps in these textures
+	std::vector<Map> Maps(GLuint environment, GLuint irradiance, GLuint prefilter, GLuint brdfLUT);
+
+	// Hash of the contents of 'files', the name of the 'baker' and the layout of 'maps', 0 if a file can't be read
+	uint64_t Key(const std::vector<std::string>& files, const std::string& baker, const std::vector<Map>& maps);
+	// Key of the maps the EnvironmentBaker bakes from the HDR 'environment'
+	uint64_t BakerKey(const std::string& environment);
+
+	// A cache file's bytes under 'key', 'fill' writes the half floats of level 'level' of face 'face' of map 'map'
+	std::vector<unsigned char> Pack(uint64_t key, const std::vector<Map>& maps, const SphericalHarmonics& irradiance,
+		const std::function<void(size_t map, uint32_t level, int face, uint16_t* pixels)>& fill);
+	// Reads 'maps' back from their textures into a cache file's bytes under 'key'. GL thread only.
+	std::vector<unsigned char> Serialize(uint64_t key, const std::vector<Map>& maps, const SphericalHarmonics& irradiance);
+	// Bakes every map of 'environment' with the EnvironmentBaker into a cache file's bytes under 'key'. No GL involved.
+	std::vector<unsigned char> Bake(uint64_t key, const EnvironmentImage& environment, JobSystem& jobs);
+	// Writes 'bytes' to 'file' through a temporary file, so an interrupted write never leaves a cache behind. Any thread.
+	bool Write(const std::string& file, const std::vector<unsigned char>& bytes);
+}
+
+// A mapped cache file, or cache bytes still in memory, checked against the key and layout they're expected to hold.
+class IBLCacheReader
+{
+public:
+	// Maps 'file', returns nullptr if it's missing, isn't keyed 'key' or doesn't hold 'maps' (whose textures are ignored)
+	static std::shared_ptr<IBLCacheReader> Open(const char* file, uint64_t key, const std::vector<IBLCache::Map>& maps);
+	// The same for the bytes of a cache, which the reader keeps alive
+	static std::shared_ptr<IBLCacheReader> Read(std::shared_ptr<const std::vector<unsigned char>> bytes, uint64_t key, const std::vector<IBLCache::Map>& maps);
+
+	// Uploads every cached level into the textures of 'maps', laid out as they were for Open. GL thread only.
+	void Upload(const std::vector<IBLCache::Map>& maps) const;
+	SphericalHarmonics Irradiance() const;
+
+private:
+	IBLCacheReader() = default;
+	static std::shared_ptr<IBLCacheReader> Validate(std::shared_ptr<const void> owner, const unsigned char* data, size_t size,
+		uint64_t key, const std::vector<IBLCache::Map>& maps);
+
+	// Keeps the mapping or the bytes alive
+	std::shared_ptr<const void> m_Owner;
+	const unsigned char* m_Data = nullptr;
+	const IBLCache::MapRecord* m_Maps = nullptr;
+};
+
+#endif
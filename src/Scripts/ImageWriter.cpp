@@ -0,0 +1,184 @@
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "../../vendor/glm/glm.hpp"
+#include "../../vendor/glm/gtc/packing.hpp"
+
+namespace
+{
+	void put32BigEndian(std::vector<uint8_t>& out, uint32_t value)
+	{
+		for (int shift = 24; shift >= 0; shift -= 8)
+			out.push_back((uint8_t)(value >> shift));
+	}
+
+	template<typename T>
+	void putLittleEndian(std::vector<uint8_t>& out, T value)
+	{
+		for (size_t i = 0; i < sizeof(T); i++)
+			out.push_back((uint8_t)((uint64_t)value >> (8 * i)));
+	}
+
+	void putFloat(std::vector<uint8_t>& out, float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		putLittleEndian(out, bits);
+	}
+
+	uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+	{
+		static uint32_t table[256];
+		if (table[1] == 0)
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++)
+					c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				table[i] = c;
+			}
+		}
+
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++)
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	void putChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data)
+	{
+		put32BigEndian(out, (uint32_t)data.size());
+		const size_t start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+		put32BigEndian(out, crc32(&out[start], out.size() - start));
+	}
+
+	void putAttribute(std::vector<uint8_t>& out, const char* name, const char* type, const std::vector<uint8_t>& value)
+	{
+		out.insert(out.end(), name, name + strlen(name) + 1);
+		out.insert(out.end(), type, type + strlen(type) + 1);
+		putLittleEndian(out, (int32_t)value.size());
+		out.insert(out.end(), value.begin(), value.end());
+	}
+
+	bool writeFile(const std::string& path, const std::vector<uint8_t>& bytes)
+	{
+		std::ofstream file(path, std::ios::binary);
+		file.write((const char*)bytes.data(), bytes.size());
+		if (!file)
+		{
+			std::cout << "ERROR::IMAGE_WRITER::FILE_NOT_WRITTEN: " << path << std::endl;
+			return false;
+		}
+		return true;
+	}
+}
+
+bool ImageWriter::WritePNG(const std::string& path, int width, int height, const uint8_t* rgba)
+{
+	// Scanlines of filter type 0 (none) followed by their RGB bytes
+	std::vector<uint8_t> scanlines;
+	scanlines.reserve((size_t)height * (1 + 3 * (size_t)width));
+	for (int y = height - 1; y >= 0; y--)
+	{
+		scanlines.push_back(0);
+		const uint8_t* row = rgba + (size_t)y * width * 4;
+		for (int x = 0; x < width; x++)
+			scanlines.insert(scanlines.end(), row + 4 * x, row + 4 * x + 3);
+	}
+
+	// A zlib stream of stored deflate blocks, at most 65535 bytes each
+	std::vector<uint8_t> zlib = { 0x78, 0x01 };
+	uint32_t a = 1, b = 0;
+	size_t offset = 0;
+	do
+	{
+		const size_t size = std::min<size_t>(65535, scanlines.size() - offset);
+		zlib.push_back(offset + size == scanlines.size() ? 1 : 0);
+		putLittleEndian(zlib, (uint16_t)size);
+		putLittleEndian(zlib, (uint16_t)~size);
+		zlib.insert(zlib.end(), scanlines.begin() + offset, scanlines.begin() + offset + size);
+		// Adler-32 of the uncompressed data closes the stream
+		for (size_t i = offset; i < offset + size; i++)
+		{
+			a = (a + scanlines[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+		offset += size;
+	} while (offset < scanlines.size());
+	put32BigEndian(zlib, (b << 16) | a);
+
+	std::vector<uint8_t> header;
+	put32BigEndian(header, (uint32_t)width);
+	put32BigEndian(header, (uint32_t)height);
+	// 8 bits per channel, RGB, deflate, no filter method beyond the per line ones, not interlaced
+	header.insert(header.end(), { 8, 2, 0, 0, 0 });
+
+	std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	putChunk(png, "IHDR", header);
+	putChunk(png, "IDAT", zlib);
+	putChunk(png, "IEND", {});
+	return writeFile(path, png);
+}
+
+bool ImageWriter::WriteEXR(const std::string& path, int width, int height, const float* rgba)
+{
+	std::vector<uint8_t> exr;
+	putLittleEndian(exr, (uint32_t)20000630);
+	// Version 2, single part scanline file
+	putLittleEndian(exr, (uint32_t)2);
+
+	//Channels Must Be Listed in Alphabetical Order, Each as a Name, Half Pixel Type, Linear Flag & Sampling.
+	std::vector<uint8_t> channels;
+	for (const char* name : { "B", "G", "R" })
+	{
+		channels.insert(channels.end(), name, name + 2);
+		putLittleEndian(channels, (int32_t)1);
+		putLittleEndian(channels, (uint32_t)0);
+		putLittleEndian(channels, (int32_t)1);
+		putLittleEndian(channels, (int32_t)1);
+	}
+	channels.push_back(0);
+
+	std::vector<uint8_t> window;
+	for (int32_t value : { 0, 0, width - 1, height - 1 })
+		putLittleEndian(window, value);
+	std::vector<uint8_t> one, center, noCompression = { 0 }, increasingY = { 0 };
+	putFloat(one, 1.0f);
+	putFloat(center, 0.0f);
+	putFloat(center, 0.0f);
+
+	putAttribute(exr, "channels", "chlist", channels);
+	putAttribute(exr, "compression", "compression", noCompression);
+	putAttribute(exr, "dataWindow", "box2i", window);
+	putAttribute(exr, "displayWindow", "box2i", window);
+	putAttribute(exr, "lineOrder", "lineOrder", increasingY);
+	putAttribute(exr, "pixelAspectRatio", "float", one);
+	putAttribute(exr, "screenWindowCenter", "v2f", center);
+	putAttribute(exr, "screenWindowWidth", "float", one);
+	exr.push_back(0);
+
+	//Every Scanline is Its Own Block: Its y, Its Size, Then The Half Floats of B, G & R One Channel After The Other.
+	const uint32_t lineSize = (uint32_t)width * 3 * 2;
+	uint64_t offset = exr.size() + (uint64_t)height * 8;
+	for (int y = 0; y < height; y++, offset += 8 + lineSize)
+		putLittleEndian(exr, offset);
+	exr.reserve(offset);
+	for (int y = 0; y < height; y++)
+	{
+		putLittleEndian(exr, (int32_t)y);
+		putLittleEndian(exr, lineSize);
+		const float* row = rgba + (size_t)(height - 1 - y) * width * 4;
+		for (int channel = 2; channel >= 0; channel--)
+			for (int x = 0; x < width; x++)
+				putLittleEndian(exr, (uint16_t)glm::packHalf1x16(row[4 * x + channel]));
+	}
+	return writeFile(path, exr);
+}
@@ -0,0 +1,17 @@
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#include <cstdint>
+#include <string>
+
+// Writes rendered frames to disk, without pulling in an image library for it.
+// Both take the rows bottom to top, the way glReadPixels returns them, and write them top to bottom.
+namespace ImageWriter
+{
+	// 8 bit RGBA pixels to an RGB .png. The image data is stored, not deflated, so files are about as large as the pixels.
+	bool WritePNG(const std::string& path, int width, int height, const uint8_t* rgba);
+	// Float RGBA pixels to an uncompressed scanline .exr with half float R, G & B channels.
+	bool WriteEXR(const std::string& path, int width, int height, const float* rgba);
+}
+
+#endif
@@ -0,0 +1,193 @@
+#include "ImpostorRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "../../vendor/glm/gtc/matrix_transform.hpp"
+
+void ImpostorRenderer::Init(Shader& shader, size_t modelCount, float logDepthCoefficient)
+{
+	m_Shader = &shader;
+	shader.use();
+	shader.setInt("albedoImpostors", 0);
+	shader.setInt("emissionImpostors", 1);
+	shader.setFloat("minSpriteRadius", MinSpriteRadius);
+	shader.setFloat("logDepthCoefficient", logDepthCoefficient);
+	m_RightUniform = shader.uniform<glm::vec3>("cameraRight");
+	m_UpUniform = shader.uniform<glm::vec3>("cameraUp");
+	m_LightPositionUniform = shader.uniform<glm::vec3>("lightPosition");
+	m_LightRadianceUniform = shader.uniform<glm::vec3>("lightRadiance");
+	m_PixelsPerRadianUniform = shader.uniform<float>("pixelsPerRadian");
+	m_EmissionStrengthUniform = shader.uniform<float>("emissionStrength");
+
+	m_BakedVersions.assign(modelCount, 0);
+	const GLsizei layers = (GLsizei)std::max<size_t>(modelCount, 1);
+	const GLint levels = (GLint)std::log2((double)Resolution) + 1;
+
+	//One Layer Per Model, Emission is Baked Before Its Strength So Both Fit in Bytes.
+	GLuint* arrays[2] = { &m_AlbedoArray, &m_EmissionArray };
+	const GLenum formats[2] = { GL_RGBA8, GL_RGBA8 };
+	for (int i = 0; i < 2; i++)
+	{
+		glGenTextures(1, arrays[i]);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, *arrays[i]);
+		for (GLint level = 0; level < levels; level++)
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, formats[i], Resolution >> level, Resolution >> level, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	glGenRenderbuffers(1, &m_BakeDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_BakeDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, Resolution, Resolution);
+	glGenFramebuffers(1, &m_BakeFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_BakeFBO);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_BakeDepth);
+	// The model shaders write the gBuffer's albedo & emission to outputs 1 and 2, the rest goes nowhere
+	const GLenum drawBuffers[4] = { GL_NONE, GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_NONE };
+	glDrawBuffers(4, drawBuffers);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_AlbedoArray, 0, 0);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, m_EmissionArray, 0, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::IMPOSTOR_RENDERER::BAKE_FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	//A Quad Every Sprite Stretches Over Its Body, The Bodies Come Per Instance.
+	const float corners[8] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+	glGenVertexArrays(1, &m_VAO);
+	glGenBuffers(1, &m_CornerBuffer);
+	glGenBuffers(1, &m_SpriteBuffer);
+	glBindVertexArray(m_VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_CornerBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+	glBindBuffer(GL_ARRAY_BUFFER, m_SpriteBuffer);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Sprite), (void*)offsetof(Sprite, body));
+	glVertexAttribDivisor(1, 1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(Sprite), (void*)offsetof(Sprite, layer));
+	glVertexAttribDivisor(2, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ImpostorRenderer::Destroy()
+{
+	GLuint textures[] = { m_AlbedoArray, m_EmissionArray };
+	glDeleteTextures(2, textures);
+	glDeleteRenderbuffers(1, &m_BakeDepth);
+	glDeleteFramebuffers(1, &m_BakeFBO);
+	GLuint buffers[] = { m_CornerBuffer, m_SpriteBuffer };
+	glDeleteBuffers(2, buffers);
+	glDeleteVertexArrays(1, &m_VAO);
+
+	m_AlbedoArray = m_EmissionArray = m_BakeDepth = m_BakeFBO = m_CornerBuffer = m_SpriteBuffer = m_VAO = 0;
+	m_SpriteCapacity = 0;
+	m_BakedVersions.clear();
+	m_Sprites.clear();
+}
+
+float ImpostorRenderer::BakeFieldOfView()
+{
+	return glm::degrees(2.0f * std::asin(1.0f / BakeDistance));
+}
+
+bool ImpostorRenderer::NeedsBake(uint32_t model, unsigned int textureVersion) const
+{
+	return model < m_BakedVersions.size() && m_BakedVersions[model] != textureVersion + 1;
+}
+
+glm::mat4 ImpostorRenderer::BeginBake(uint32_t model, float boundingRadius)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_BakeFBO);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_AlbedoArray, 0, (GLint)model);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, m_EmissionArray, 0, (GLint)model);
+	glViewport(0, 0, Resolution, Resolution);
+
+	//Nothing Covered Stays Black & Transparent.
+	const GLfloat clear[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	glClearBufferfv(GL_COLOR, 1, clear);
+	glClearBufferfv(GL_COLOR, 2, clear);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	glEnable(GL_DEPTH_TEST);
+
+	const float scale = boundingRadius > 0.0f ? 1.0f / boundingRadius : 1.0f;
+	return glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -BakeDistance)), glm::vec3(scale));
+}
+
+void ImpostorRenderer::EndBake(uint32_t model, unsigned int textureVersion)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	//Distant Sprites Sample The Smallest Levels, Where The Whole Body Averages Into a Texel.
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_AlbedoArray);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_EmissionArray);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	// Off by one, so 0 can mean never baked
+	m_BakedVersions[model] = textureVersion + 1;
+}
+
+void ImpostorRenderer::Begin()
+{
+	m_Sprites.clear();
+}
+
+void ImpostorRenderer::Add(uint32_t model, const glm::vec3& position, float radius)
+{
+	if (model < m_BakedVersions.size() && m_BakedVersions[model] != 0)
+		m_Sprites.push_back({ glm::vec4(position, radius), model });
+}
+
+void ImpostorRenderer::Draw(const glm::vec3& right, const glm::vec3& up, float pixelsPerRadian, const glm::vec3& lightPosition, const glm::vec3& lightRadiance, float emissionStrength)
+{
+	m_DrawnSprites = (unsigned int)m_Sprites.size();
+	if (m_Sprites.empty())
+		return;
+
+	//Upload This Frame's Sprites, Orphaning Last Frame's Storage.
+	glBindBuffer(GL_ARRAY_BUFFER, m_SpriteBuffer);
+	if (m_Sprites.size() > m_SpriteCapacity)
+		m_SpriteCapacity = m_Sprites.size() + m_Sprites.size() / 2;
+	glBufferData(GL_ARRAY_BUFFER, m_SpriteCapacity * sizeof(Sprite), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, m_Sprites.size() * sizeof(Sprite), m_Sprites.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_Shader->use();
+	m_RightUniform.set(right);
+	m_UpUniform.set(up);
+	m_PixelsPerRadianUniform.set(pixelsPerRadian);
+	m_LightPositionUniform.set(lightPosition);
+	m_LightRadianceUniform.set(lightRadiance);
+	m_EmissionStrengthUniform.set(emissionStrength);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_AlbedoArray);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_EmissionArray);
+
+	//Light Adds Up, Bodies in Front Still Hide The Sprites Behind Them.
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glDisable(GL_CULL_FACE);
+
+	glBindVertexArray(m_VAO);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)m_Sprites.size());
+	glBindVertexArray(0);
+
+	glEnable(GL_CULL_FACE);
+	glDisable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+	glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,86 @@
+#ifndef IMPOSTOR_RENDERER_H
+#define IMPOSTOR_RENDERER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../../vendor/glad/include/glad.h"
+#include "../../vendor/glm/glm.hpp"
+#include "Shader.h"
+
+// Draws the bodies too small on screen for their meshes as lit sprites, all of them in one instanced draw.
+// Every model gets an impostor once it has loaded: its albedo and emission seen from the front, which the app's model
+// shaders render into a layer of two texture arrays between BeginBake and EndBake. It is baked again when the model's
+// textures change. Sprites are lit as spheres by the point light with the impostor's albedo, so a body's brightness follows
+// its distance to the light. A sprite is never smaller than MinSpriteRadius pixels, smaller bodies dim by the share of it
+// they cover instead, so they fade out rather than flicker between pixels.
+// Drawn with Impostor.vs / Impostor.fs. GL thread only.
+class ImpostorRenderer
+{
+public:
+	// Edge of an impostor in texels
+	static const int Resolution = 64;
+	// Bakes look at the model's bounding sphere, scaled to radius 1, from this far away
+	static constexpr float BakeDistance = 3.0f;
+	// Radius in pixels sprites don't shrink below
+	static constexpr float MinSpriteRadius = 1.0f;
+
+	ImpostorRenderer() {}
+	ImpostorRenderer(const ImpostorRenderer&) = delete;
+	ImpostorRenderer& operator=(const ImpostorRenderer&) = delete;
+
+	// Creates room for 'modelCount' impostors and the sprite buffers, caches the uniforms of 'shader'
+	void Init(Shader& shader, size_t modelCount, float logDepthCoefficient);
+	// Deletes every texture and buffer, call while the context is still alive
+	void Destroy();
+
+	// Field of view in degrees that fits the bounding sphere exactly into a bake
+	static float BakeFieldOfView();
+	// True if model 'model' has no impostor yet or its textures changed since it was baked, see Model::TextureVersion
+	bool NeedsBake(uint32_t model, unsigned int textureVersion) const;
+	// Binds and clears the model's layers for drawing, returns the model matrix that puts a model of 'boundingRadius'
+	// into view of a camera at the origin looking down -Z with a BakeFieldOfView projection
+	glm::mat4 BeginBake(uint32_t model, float boundingRadius);
+	// Builds the mip levels the distant sprites sample and marks the model baked at 'textureVersion'. Leaves framebuffer 0 bound.
+	void EndBake(uint32_t model, unsigned int textureVersion);
+
+	// Starts a new frame, forgetting the sprites of the last one
+	void Begin();
+	// Queues a sprite for a body drawing 'model' at 'position' relative to the camera with a bounding 'radius'.
+	// Bodies whose model hasn't been baked yet are left out.
+	void Add(uint32_t model, const glm::vec3& position, float radius);
+	// Draws everything queued since Begin into the bound framebuffer, depth tested but not written and added onto what's there.
+	// 'right' and 'up' span the view, 'lightPosition' is relative to the camera and 'lightRadiance' is its color times intensity.
+	// The baked emission is multiplied by 'emissionStrength', like the lighting pass does with the gBuffer's.
+	void Draw(const glm::vec3& right, const glm::vec3& up, float pixelsPerRadian, const glm::vec3& lightPosition, const glm::vec3& lightRadiance, float emissionStrength);
+
+	// Sprites the last Draw drew
+	unsigned int DrawnSprites() const { return m_DrawnSprites; }
+
+private:
+	// Layout of the instance buffer, read by Impostor.vs
+	struct Sprite
+	{
+		// Camera relative center and bounding radius
+		glm::vec4 body;
+		GLuint layer;
+	};
+
+	Shader* m_Shader = nullptr;
+	Uniform<glm::vec3> m_RightUniform, m_UpUniform, m_LightPositionUniform, m_LightRadianceUniform;
+	Uniform<float> m_PixelsPerRadianUniform, m_EmissionStrengthUniform;
+
+	// Albedo with the coverage in alpha, and emission
+	GLuint m_AlbedoArray = 0, m_EmissionArray = 0;
+	GLuint m_BakeFBO = 0, m_BakeDepth = 0;
+	GLuint m_VAO = 0, m_CornerBuffer = 0, m_SpriteBuffer = 0;
+	size_t m_SpriteCapacity = 0;
+
+	// Texture version every model was baked at, 0 if it hasn't been
+	std::vector<unsigned int> m_BakedVersions;
+	std::vector<Sprite> m_Sprites;
+	unsigned int m_DrawnSprites = 0;
+};
+
+#endif
@@ -0,0 +1,229 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+// Pool and queue index of the worker running on this thread, so jobs scheduled from a job stay local
+static thread_local const JobSystem* t_Owner = nullptr;
+static thread_local int t_WorkerIndex = -1;
+
+JobSystem::JobSystem(unsigned int workerCount)
+{
+	if (workerCount == 0)
+	{
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	m_Queues.reserve(workerCount);
+	for (unsigned int i = 0; i < workerCount; i++)
+		m_Queues.push_back(std::make_unique<WorkerQueue>());
+
+	m_Workers.reserve(workerCount);
+	for (unsigned int i = 0; i < workerCount; i++)
+		m_Workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	Wait();
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_JobAvailable.notify_all();
+	for (std::thread& worker : m_Workers)
+		worker.join();
+}
+
+void JobSystem::Schedule(std::function<void()> job)
+{
+	m_Unfinished++;
+	unsigned int queue = t_Owner == this ? (unsigned int)t_WorkerIndex : m_NextQueue++ % (unsigned int)m_Queues.size();
+	Push(queue, std::move(job));
+}
+
+void JobSystem::Push(unsigned int queue, Job job)
+{
+	// Counted before it is pushed so a thief can never take the count below zero. Taking the sleep mutex
+	// orders the increment before a worker's predicate check, no wake up gets lost.
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Queued++;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_Queues[queue]->mutex);
+		m_Queues[queue]->jobs.push_back(std::move(job));
+	}
+	m_JobAvailable.notify_one();
+}
+
+void JobSystem::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_AllDone.wait(lock, [this] { return m_Unfinished.load() == 0; });
+}
+
+// The chunks of one ParallelFor. The caller and the helper jobs claim them from 'next' until none are left,
+// so the caller only ever runs work of its own loop.
+struct ParallelForLoop
+{
+	const std::function<void(size_t, size_t)>* body;
+	size_t count, grain, chunks;
+	std::atomic<size_t> next{ 0 };
+	std::atomic<size_t> finished{ 0 };
+	std::atomic<bool> failed{ false };
+	std::exception_ptr error;
+	std::mutex mutex;
+	std::condition_variable allFinished;
+
+	void RunChunks()
+	{
+		// A chunk is claimed before 'body' is touched, once they're all claimed a late helper returns without it
+		for (size_t chunk = next++; chunk < chunks; chunk = next++)
+		{
+			// After a failure the remaining chunks are only counted off, the loop is going to throw anyway
+			if (!failed.load())
+			{
+				const size_t begin = chunk * grain;
+				try
+				{
+					(*body)(begin, std::min(begin + grain, count));
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if (!error)
+						error = std::current_exception();
+					failed = true;
+				}
+			}
+
+			if (++finished == chunks)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				allFinished.notify_all();
+			}
+		}
+	}
+};
+
+void JobSystem::ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body)
+{
+	if (count == 0)
+		return;
+	grain = std::max<size_t>(grain, 1);
+
+	// A single chunk isn't worth a round trip through the queues
+	if (count <= grain)
+	{
+		body(0, count);
+		return;
+	}
+
+	std::shared_ptr<ParallelForLoop> loop = std::make_shared<ParallelForLoop>();
+	loop->body = &body;
+	loop->count = count;
+	loop->grain = grain;
+	loop->chunks = (count + grain - 1) / grain;
+
+	// One helper per worker at most, each runs chunks until there are none left to claim
+	const size_t helpers = std::min(loop->chunks - 1, m_Workers.size());
+	for (size_t i = 0; i < helpers; i++)
+		Schedule([loop]() { loop->RunChunks(); });
+
+	// Only chunks of this loop run here, never some other queued job that could take far longer
+	loop->RunChunks();
+	{
+		std::unique_lock<std::mutex> lock(loop->mutex);
+		loop->allFinished.wait(lock, [&loop] { return loop->finished.load() == loop->chunks; });
+	}
+
+	if (loop->error)
+		std::rethrow_exception(loop->error);
+}
+
+bool JobSystem::FindJob(int own, Job& job)
+{
+	if (m_Queued.load() == 0)
+		return false;
+
+	if (own >= 0)
+	{
+		WorkerQueue& queue = *m_Queues[own];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			m_Queued--;
+			return true;
+		}
+	}
+
+	// Steal the oldest job, starting next to our own queue so thieves spread out
+	const unsigned int count = (unsigned int)m_Queues.size();
+	const unsigned int start = own >= 0 ? (unsigned int)own + 1 : m_NextQueue.load();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const unsigned int victim = (start + i) % count;
+		if ((int)victim == own)
+			continue;
+
+		WorkerQueue& queue = *m_Queues[victim];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			m_Queued--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::Run(Job& job)
+{
+	// A failing job must not take the whole pool down with it.
+	try
+	{
+		job();
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "ERROR::JOB_SYSTEM::JOB_FAILED " << e.what() << std::endl;
+	}
+	catch (...)
+	{
+		std::cout << "ERROR::JOB_SYSTEM::JOB_FAILED" << std::endl;
+	}
+
+	if (--m_Unfinished == 0)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_AllDone.notify_all();
+	}
+}
+
+void JobSystem::WorkerLoop(unsigned int index)
+{
+	t_Owner = this;
+	t_WorkerIndex = (int)index;
+
+	while (true)
+	{
+		Job job;
+		if (FindJob((int)index, job))
+		{
+			Run(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_JobAvailable.wait(lock, [this] { return m_Stopping || m_Queued.load() > 0; });
+		if (m_Stopping && m_Queued.load() == 0)
+			return;
+	}
+}
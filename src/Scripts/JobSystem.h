@@ -0,0 +1,67 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed pool of worker threads running fire-and-forget jobs.
+// Every worker owns a deque: it pushes and pops its own jobs at the back (newest first, still warm in cache)
+// and, once it runs dry, steals the oldest job from the front of another worker's deque.
+// Jobs must not touch OpenGL, there is no context on the workers.
+class JobSystem
+{
+public:
+	// Starts 'workerCount' workers, 0 picks one less than the number of hardware threads (at least one).
+	explicit JobSystem(unsigned int workerCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Queues a job, it may run on any worker in any order relative to other jobs.
+	// Jobs scheduled from a worker go to that worker's deque, others are dealt out round robin.
+	void Schedule(std::function<void()> job);
+	// Blocks until every scheduled job, including those scheduled by running jobs, has finished.
+	void Wait();
+	// Calls body(begin, end) over [0, count) in chunks of at most 'grain' items and returns once every chunk ran.
+	// The calling thread runs chunks of this loop too instead of sleeping, so it may be called from inside a job.
+	// If a chunk throws, the chunks not started yet are skipped and the first exception is rethrown here.
+	void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+	unsigned int WorkerCount() const { return (unsigned int)m_Workers.size(); }
+
+private:
+	typedef std::function<void()> Job;
+
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	void WorkerLoop(unsigned int index);
+	void Push(unsigned int queue, Job job);
+	// Pops from the back of queue 'own' if it is valid, otherwise steals from the front of the others
+	bool FindJob(int own, Job& job);
+	void Run(Job& job);
+
+	std::vector<std::thread> m_Workers;
+	std::vector<std::unique_ptr<WorkerQueue>> m_Queues;
+	std::atomic<unsigned int> m_NextQueue{ 0 };
+	///<summary>Jobs sitting in a queue, workers only sleep while it is 0.</summary>
+	std::atomic<unsigned int> m_Queued{ 0 };
+	///<summary>Jobs that are queued or running.</summary>
+	std::atomic<unsigned int> m_Unfinished{ 0 };
+	std::mutex m_Mutex;
+	std::condition_variable m_JobAvailable;
+	std::condition_variable m_AllDone;
+	bool m_Stopping = false;
+};
+
+#endif
@@ -1,6 +1,9 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <stb_image.h>
@@ -12,23 +15,14 @@
 #include "../../vendor/glm/gtc/quaternion.hpp"
 #include "../../vendor/glm/gtc/type_ptr.hpp"
 
+#include "BlockCompression.h"
+#include "GLExtensions.h"
 #include "Shader.h"
+#include "Vertex.h"
 
 using namespace std;
 using namespace glm;
 
-struct Vertex
-{
-    // Vertex Position
-    vec3 Position;
-    // Vertex Normal
-    vec3 Normal;
-    // Vertex Tangent
-    vec3 Tangent;
-    // Texture Coordinates
-    vec2 TexCoord;
-};
-
 enum class TextureType
 {
     None,
@@ -38,29 +32,88 @@ enum class TextureType
     Normal
 };
 
+// Decoded pixels of an image. Decoding is safe on any thread, the upload happens later on the GL thread.
+struct TextureData
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    // True if the pixels are floats (.hdr images)
+    bool hdr = false;
+    // Freed with stbi_image_free once the last copy goes away
+    std::shared_ptr<void> pixels;
+    // Pre-built mip levels 1..n, kept alive by 'pixels'. Empty if the mips should be generated on upload.
+    std::vector<const void*> levels;
+    // Block format of 'pixels' and every level, 'channels' is then what they decode to
+    BlockFormat compression = BlockFormat::None;
+    // Bytes of level 0..n, only needed for compressed data
+    std::vector<size_t> levelSizes;
+
+    bool valid() const { return pixels != nullptr; }
+
+    static TextureData Decode(const char* image, bool hdr = false)
+    {
+        TextureData data;
+        data.hdr = hdr;
+        // Flips the image so it appears right side up, only affects the calling thread
+        stbi_set_flip_vertically_on_load_thread(true);
+        // Reads the image from a file and stores it in bytes
+        void* pixels = hdr ? (void*)stbi_loadf(image, &data.width, &data.height, &data.channels, 0)
+                           : (void*)stbi_load(image, &data.width, &data.height, &data.channels, 0);
+        if (pixels)
+            data.pixels = std::shared_ptr<void>(pixels, stbi_image_free);
+        return data;
+    }
+
+    // Decodes block compressed data back into raw pixels, every level in one allocation. For GPUs that can't sample the format.
+    TextureData Decompress() const
+    {
+        std::vector<size_t> offsets;
+        size_t bytes = 0;
+        for (size_t level = 0; level < levelSizes.size(); level++)
+        {
+            offsets.push_back(bytes);
+            bytes += (size_t)std::max(1, width >> level) * std::max(1, height >> level) * channels;
+        }
+
+        std::shared_ptr<unsigned char> decoded(new unsigned char[bytes], std::default_delete<unsigned char[]>());
+        for (size_t level = 0; level < levelSizes.size(); level++)
+        {
+            const void* blocks = level == 0 ? pixels.get() : levels[level - 1];
+            BlockCompression::Decode(compression, static_cast<const unsigned char*>(blocks),
+                                     std::max(1, width >> level), std::max(1, height >> level), channels, decoded.get() + offsets[level]);
+        }
+
+        TextureData raw;
+        raw.width = width;
+        raw.height = height;
+        raw.channels = channels;
+        raw.pixels = decoded;
+        for (size_t level = 1; level < offsets.size(); level++)
+            raw.levels.push_back(decoded.get() + offsets[level]);
+        return raw;
+    }
+};
+
 struct Texture
 {
     unsigned int ID;
     GLuint slot;
     TextureType type;
-    string path;
 
     Texture()
     {
         ID = 0;
         slot = 0;
         type = TextureType::None;
-        path = std::string();
     }
 
-    Texture(const char* image, TextureType texType, GLuint slot)
+    Texture(const char* image, TextureType texType, GLuint slot) : Texture(TextureData::Decode(image), texType, slot, image) {}
+
+    Texture(const TextureData& data, TextureType texType, GLuint slot, const char* image = "")
     {
-        // Stores the width, height, and the number of color channels of the image
-        int widthImg, heightImg, numColCh;
-        // Flips the image so it appears right side up
-        stbi_set_flip_vertically_on_load(true);
-        // Reads the image from a file and stores it in bytes
-        unsigned char* bytes = stbi_load(image, &widthImg, &heightImg, &numColCh, 0);
+        if (!data.valid())
+            throw std::runtime_error(std::string("Failed to load texture ") + image);
 
         // Generates an OpenGL texture object
         glGenTextures(1, &ID);
@@ -76,33 +129,88 @@ struct Texture
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
+        // Baked block compressed levels upload as they are, the GPU samples them compressed
+        if (data.compression != BlockFormat::None)
+        {
+            GLenum compressedFormat = CompressedFormat(data.compression, texType == TextureType::BaseColor);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            for (int level = 0; level < (int)data.levelSizes.size(); level++)
+                glCompressedTexImage2D(GL_TEXTURE_2D, level, compressedFormat, std::max(1, data.width >> level), std::max(1, data.height >> level), 0,
+                                       (GLsizei)data.levelSizes[level], level == 0 ? data.pixels.get() : data.levels[level - 1]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)data.levelSizes.size() - 1);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+            type = texType;
+            this->slot = slot;
+            glBindTexture(GL_TEXTURE_2D, 0);
+            return;
+        }
 
         // Check what type of color channels the texture has and load it accordingly
-        if (numColCh == 4)
-            glTexImage2D (GL_TEXTURE_2D, 0, texType == TextureType::BaseColor ? GL_SRGB_ALPHA : GL_RGBA, widthImg, heightImg, 0, GL_RGBA, GL_UNSIGNED_BYTE, bytes);
-        else if (numColCh == 3)
-            glTexImage2D (GL_TEXTURE_2D, 0, texType == TextureType::BaseColor ? GL_SRGB_ALPHA : GL_RGBA, widthImg, heightImg, 0, GL_RGB, GL_UNSIGNED_BYTE, bytes);
-        else if (numColCh == 2)
-            glTexImage2D(GL_TEXTURE_2D, 0, texType == TextureType::BaseColor ? GL_SRGB_ALPHA : GL_RGBA, widthImg, heightImg, 0, GL_RG, GL_UNSIGNED_BYTE, bytes);
-        else if (numColCh == 1)
-            glTexImage2D (GL_TEXTURE_2D, 0, texType == TextureType::BaseColor ? GL_SRGB_ALPHA : GL_RGBA, widthImg, heightImg, 0, GL_RED, GL_UNSIGNED_BYTE, bytes);
+        GLenum format;
+        if (data.channels == 4)
+            format = GL_RGBA;
+        else if (data.channels == 3)
+            format = GL_RGB;
+        else if (data.channels == 2)
+            format = GL_RG;
+        else if (data.channels == 1)
+            format = GL_RED;
         else 
             throw std::invalid_argument("Automatic Texture type recognition failed");
 
-        // Generates MipMaps
-        glGenerateMipmap(GL_TEXTURE_2D);
+        // Sized, so TextureArrays can copy it into a layer of the same format
+        GLint internalFormat = texType == TextureType::BaseColor ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, data.width, data.height, 0, format, GL_UNSIGNED_BYTE, data.pixels.get());
 
-        // Deletes the image data as it is already in the OpenGL Texture object
-        stbi_image_free(bytes);
+        if (data.levels.empty())
+        {
+            // Generates MipMaps
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        else
+        {
+            // Baked mips are tightly packed, the smaller levels' rows aren't 4 byte aligned
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            for (int level = 1; level <= (int)data.levels.size(); level++)
+                glTexImage2D(GL_TEXTURE_2D, level, internalFormat, std::max(1, data.width >> level), std::max(1, data.height >> level), 0, format, GL_UNSIGNED_BYTE, data.levels[level - 1]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)data.levels.size());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
 
         // Assigns the type of the texture ot the texture object
         type = texType;
         this->slot = slot;
-        path = image;
 
         // Unbinds the OpenGL Texture object so that it can't accidentally be modified
         glBindTexture(GL_TEXTURE_2D, 0);
     }
+
+    // GL internal format of a block format, sRGB for base colors like the uncompressed GL_SRGB8_ALPHA8
+    static GLenum CompressedFormat(BlockFormat format, bool srgb)
+    {
+        switch (format)
+        {
+        case BlockFormat::BC1: return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case BlockFormat::BC3: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+        case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+        case BlockFormat::BC7: return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+        default: throw std::invalid_argument("Unknown block compression format");
+        }
+    }
+
+    // True if the GPU can sample 'format' directly, otherwise it has to be decoded on the CPU first
+    static bool CompressedFormatSupported(BlockFormat format)
+    {
+        switch (format)
+        {
+        case BlockFormat::BC1:
+        case BlockFormat::BC3: return GLExtensions::TextureCompressionS3TC;
+        case BlockFormat::BC7: return GLExtensions::TextureCompressionBPTC;
+        default: return true;
+        }
+    }
 };
 
 struct Material
@@ -149,6 +257,74 @@ struct Material
     }
 };
 
+// Handles of the uniforms Mesh::Draw sets, looked up once per shader instead of on every draw.
+// Each material sampler gets a fixed texture unit, so a draw only has to bind textures.
+struct MeshUniforms
+{
+    static const GLuint BaseColorUnit = 0;
+    static const GLuint MetallicRoughnessUnit = 1;
+    static const GLuint EmissiveUnit = 2;
+    static const GLuint NormalUnit = 3;
+
+    Uniform<mat4> model;
+    Uniform<unsigned int> hasBCT, hasMRT, hasET, hasNT;
+    Uniform<float> metallicFactor, roughnessFactor;
+
+    MeshUniforms() {}
+
+    // Binds 'shader' to point its samplers at the fixed units
+    explicit MeshUniforms(Shader& shader)
+    {
+        model = shader.uniform<mat4>("model");
+        hasBCT = shader.uniform<unsigned int>("hasBCT");
+        hasMRT = shader.uniform<unsigned int>("hasMRT");
+        hasET = shader.uniform<unsigned int>("hasET");
+        hasNT = shader.uniform<unsigned int>("hasNT");
+        metallicFactor = shader.uniform<float>("metallicFactor");
+        roughnessFactor = shader.uniform<float>("roughnessFactor");
+
+        BindSamplers(shader);
+    }
+
+    // Points the material samplers of 'shader' at the fixed units, for shaders that read the rest of the material elsewhere
+    static void BindSamplers(Shader& shader)
+    {
+        shader.use();
+        shader.setInt("material.baseColorTexture", BaseColorUnit);
+        shader.setInt("material.metallicRoughnessTexture", MetallicRoughnessUnit);
+        shader.setInt("material.emissionTexture", EmissiveUnit);
+        shader.setInt("material.normalTexture", NormalUnit);
+    }
+};
+
+// Axis aligned box and bounding sphere of a mesh's vertices, in the mesh's own space
+struct MeshBounds
+{
+    vec3 min = vec3(0.0f);
+    vec3 max = vec3(0.0f);
+    vec3 center = vec3(0.0f);
+    float radius = 0.0f;
+
+    static MeshBounds FromVertices(const Vertex* vertices, size_t count)
+    {
+        MeshBounds bounds;
+        if (count == 0)
+            return bounds;
+
+        bounds.min = bounds.max = vertices[0].Position;
+        for (size_t i = 1; i < count; i++)
+        {
+            bounds.min = glm::min(bounds.min, vertices[i].Position);
+            bounds.max = glm::max(bounds.max, vertices[i].Position);
+        }
+        // Around the box's middle, a little larger than the smallest sphere but exact for the planets
+        bounds.center = (bounds.min + bounds.max) * 0.5f;
+        for (size_t i = 0; i < count; i++)
+            bounds.radius = glm::max(bounds.radius, glm::length(vertices[i].Position - bounds.center));
+        return bounds;
+    }
+};
+
 class Mesh
 {
 public:
@@ -157,101 +333,101 @@ public:
     vector<unsigned int> indices;
     Material material;
     unsigned int VAO;
+    // computed from the vertices when the mesh is created, for culling
+    MeshBounds bounds;
 
     // constructor
     Mesh(vector<Vertex> vertices, vector<unsigned int> indices, Material material)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->material = material;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->material = std::move(material);
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(this->vertices.data(), this->vertices.size(), this->indices.data(), this->indices.size());
+    }
+
+    // constructor uploading straight from memory owned by someone else (a mapped package), no CPU copy is kept.
+    Mesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, Material material)
+    {
+        this->material = std::move(material);
+        setupMesh(vertices, vertexCount, indices, indexCount);
     }
 
     // render the mesh without any texturing.
-    void SimpleDraw(Shader& shader, mat4 meshMatrix)
+    void SimpleDraw(const MeshUniforms& uniforms, mat4 meshMatrix)
     {
         //Set The Model Uniform
-        glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, value_ptr(meshMatrix));
+        uniforms.model.set(meshMatrix);
 
         // draw mesh
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
     }
 
     // render the mesh
-    void Draw(Shader& shader, mat4 meshMatrix)
+    void Draw(const MeshUniforms& uniforms, mat4 meshMatrix)
     {
-        //Cache Sizes of All Textures.
-        int baseColorTextureOffset = material.baseColorTexture.type != TextureType::None ? 1 : 0;
-        int metallicRoughnessTextureOffset = material.metallicRoughnessTexture.type != TextureType::None ? 1 : 0;
-        int emissiveTextureOffset = material.emissiveTexture.type != TextureType::None ? 1 : 0;
-        int normalTextureOffset = material.normalTexture.type != TextureType::None ? 1 : 0;
-
-        if (baseColorTextureOffset)
-        {
-            //Bind Base Color Texture!
-            glActiveTexture(GL_TEXTURE0);
-            glUniform1i(glGetUniformLocation(shader.ID, "material.baseColorTexture"), 0);
-            glUniform1ui(glGetUniformLocation(shader.ID, "material.hasBCT"), 1);
-            glBindTexture(GL_TEXTURE_2D, material.baseColorTexture.ID);
-        }
-
-        if (metallicRoughnessTextureOffset)
-        {
-            //Bind All Metallic Roughness Textures!
-            glActiveTexture(GL_TEXTURE0 + baseColorTextureOffset);
-            glUniform1i(glGetUniformLocation(shader.ID, "material.metallicRoughnessTexture"), baseColorTextureOffset);
-            glUniform1ui(glGetUniformLocation(shader.ID, "material.hasMRT"), 1);
-            glBindTexture(GL_TEXTURE_2D, material.metallicRoughnessTexture.ID);
-        }
-
-        if (emissiveTextureOffset)
-        {
-            //Bind All Emissive Textures!
-            int offset = baseColorTextureOffset + metallicRoughnessTextureOffset;
-            glActiveTexture(GL_TEXTURE0 + offset);
-            glUniform1i(glGetUniformLocation(shader.ID, "material.emissionTexture"), offset);
-            glUniform1ui(glGetUniformLocation(shader.ID, "material.hasET"), 1);
-            glBindTexture(GL_TEXTURE_2D, material.emissiveTexture.ID);
-        }
-        
-        if (normalTextureOffset)
-        {
-            int offset = baseColorTextureOffset + metallicRoughnessTextureOffset + emissiveTextureOffset;
-            glActiveTexture(GL_TEXTURE0 + offset);
-            glUniform1i(glGetUniformLocation(shader.ID, "material.normalTexture"), offset);
-            glUniform1ui(glGetUniformLocation(shader.ID, "material.hasNT"), 1);
-            glBindTexture(GL_TEXTURE_2D, material.normalTexture.ID);
-        }
+        //Bind The Textures This Material Has To Their Units & Tell The Shader Which Ones Are There.
+        bindTexture(material.baseColorTexture, MeshUniforms::BaseColorUnit, uniforms.hasBCT);
+        bindTexture(material.metallicRoughnessTexture, MeshUniforms::MetallicRoughnessUnit, uniforms.hasMRT);
+        bindTexture(material.emissiveTexture, MeshUniforms::EmissiveUnit, uniforms.hasET);
+        bindTexture(material.normalTexture, MeshUniforms::NormalUnit, uniforms.hasNT);
 
         //Set The Additional Material Properties.
-        glUniform1f(glGetUniformLocation(shader.ID, "material.metallicFactor"), material.metallicFactor);
-        glUniform1f(glGetUniformLocation(shader.ID, "material.roughnessFactor"), material.roughnessFactor);
+        uniforms.metallicFactor.set(material.metallicFactor);
+        uniforms.roughnessFactor.set(material.roughnessFactor);
 
-        glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, value_ptr(meshMatrix));
+        uniforms.model.set(meshMatrix);
         // draw mesh
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
-        glUniform1ui(glGetUniformLocation(shader.ID, "material.hasBCT"), 0);
-        glUniform1ui(glGetUniformLocation(shader.ID, "material.hasMRT"), 0);
-        glUniform1ui(glGetUniformLocation(shader.ID, "material.hasET"), 0);
-        glUniform1ui(glGetUniformLocation(shader.ID, "material.hasNT"), 0);
 
         // always good practice to set everything back to defaults once configured.
         glActiveTexture(GL_TEXTURE0);
     }
 
+    // deletes the buffers, for meshes that come and go (terrain patches). Copies of the mesh are left dangling.
+    void Delete()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        VAO = VBO = EBO = 0;
+    }
+
+    // buffers and sizes, for renderers that copy the mesh into buffers of their own
+    unsigned int vertexBuffer() const { return VBO; }
+    unsigned int indexBuffer() const { return EBO; }
+    GLsizei getVertexCount() const { return vertexCount; }
+    GLsizei getIndexCount() const { return indexCount; }
+
 private:
     // render data 
     unsigned int VBO, EBO;
+    GLsizei vertexCount, indexCount;
+
+    // binds 'texture' to 'unit' if the material has it, the shader ignores the unit otherwise
+    static void bindTexture(const Texture& texture, GLuint unit, const Uniform<unsigned int>& hasTexture)
+    {
+        bool present = texture.type != TextureType::None;
+        if (present)
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(GL_TEXTURE_2D, texture.ID);
+        }
+        hasTexture.set(present ? 1u : 0u);
+    }
 
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    void setupMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount)
     {
+        this->vertexCount = static_cast<GLsizei>(vertexCount);
+        this->indexCount = static_cast<GLsizei>(indexCount);
+        bounds = MeshBounds::FromVertices(vertices, vertexCount);
+
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
@@ -263,10 +439,10 @@ private:
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertices, GL_STATIC_DRAW);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
 
         // set the vertex attribute pointers
         // vertex Positions
@@ -18,67 +18,56 @@ std::string get_file_contents(const char* filename)
 	throw(errno);
 }
 
-Model::Model(const char* file)
+// Reads a binary file straight into a byte vector
+std::vector<unsigned char> get_file_bytes(const char* filename)
 {
-	Create(file);
+	std::ifstream in(filename, std::ios::binary);
+	if (in)
+	{
+		std::vector<unsigned char> contents;
+		in.seekg(0, std::ios::end);
+		contents.resize(in.tellg());
+		in.seekg(0, std::ios::beg);
+		in.read(reinterpret_cast<char*>(contents.data()), contents.size());
+		in.close();
+		return(contents);
+	}
+	throw(errno);
 }
 
-void Model::Create(const char* file)
+// State shared by the decode helpers while a single .gltf is being decoded
+struct DecodeContext
 {
-	// Make a JSON object
-	std::string text = get_file_contents(file);
-	JSON = json::parse(text);
+	json JSON;
+	std::vector<std::vector<unsigned char>> buffers;
+	std::string fileDirectory;
+	ModelData data;
+};
+
+// Loads a single mesh by its index
+static void loadMesh(DecodeContext& context, unsigned int indMesh, const glm::mat4& matrix)
+{
+	const json& JSON = context.JSON;
 
-	// Get the binary data
-	Model::file = file;
-	data = getData();
+	// Get all accessor indices
+	const json& primitive  = JSON["meshes"][indMesh]["primitives"][0];
+	const json& attributes = primitive["attributes"];
 
-	//Initialize Default Blender Import Rotation.
-	blenderImportRotation = glm::mat4(1.0f);
-	blenderImportRotation = glm::rotate(blenderImportRotation, glm::radians(270.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	// Make typed views straight into the loaded buffers
+	AccessorView positions = makeAccessorView(JSON, attributes.value("POSITION", -1), context.buffers);
+	AccessorView normals   = makeAccessorView(JSON, attributes.value("NORMAL", -1), context.buffers);
+	AccessorView tangents  = makeAccessorView(JSON, attributes.value("TANGENT", -1), context.buffers);
+	AccessorView texCoords = makeAccessorView(JSON, attributes.value("TEXCOORD_0", -1), context.buffers);
+	AccessorView indexView = makeAccessorView(JSON, primitive.value("indices", -1), context.buffers);
 
-	// Traverse all nodes
-	for (volatile int i = 0; i < JSON["nodes"].size(); i++)
-		traverseNode(i);
-}
+	MeshData mesh;
+	mesh.matrix = matrix;
 
-void Model::SimpleDraw(Shader& shader, mat4 model)
-{
-	// Go over all meshes and draw each one without any texturing.
-	for (volatile unsigned int i = 0; i < meshes.size(); i++)
-		meshes[i].Mesh::SimpleDraw(shader, model * matricesMeshes[i] * blenderImportRotation);
-}
-
-void Model::Draw(Shader& shader, mat4 model)
-{
-	// Go over all meshes and draw each one
-	for (volatile unsigned int i = 0; i < meshes.size(); i++)
-		meshes[i].Mesh::Draw(shader, model * matricesMeshes[i] * blenderImportRotation);
-}
-
-void Model::loadMesh(unsigned int indMesh)
-{
-	// Get all accessor indices
-	unsigned int posAccInd     = JSON["meshes"][indMesh]["primitives"][0]["attributes"]["POSITION"];
-	unsigned int normalAccInd  = JSON["meshes"][indMesh]["primitives"][0]["attributes"]["NORMAL"];
-	unsigned int tangentAccInd = JSON["meshes"][indMesh]["primitives"][0]["attributes"]["TANGENT"];
-	unsigned int texAccInd     = JSON["meshes"][indMesh]["primitives"][0]["attributes"]["TEXCOORD_0"];
-
-	unsigned int indAccInd     = JSON["meshes"][indMesh]["primitives"][0]["indices"];
-
-	// Use accessor indices to get all vertices components
-	std::vector<float> posVec = getFloats(JSON["accessors"][posAccInd]);
-	std::vector<glm::vec3> positions = groupFloatsVec3(posVec);
-	std::vector<float> normalVec = getFloats(JSON["accessors"][normalAccInd]);
-	std::vector<glm::vec3> normals = groupFloatsVec3(normalVec);
-	std::vector<float> tangentVec = getFloats(JSON["accessors"][tangentAccInd]);
-	std::vector<glm::vec3> tangents = groupFloatsVec4asVec3(tangentVec);
-	std::vector<float> texVec = getFloats(JSON["accessors"][texAccInd]);
-	std::vector<glm::vec2> texUVs = groupFloatsVec2(texVec);
-
-	// Combine all the vertex components and also get the indices and textures
-	std::vector<Vertex> vertices = assembleVertices(positions, normals, tangents, texUVs);
-	std::vector<GLuint> indices = getIndices(JSON["accessors"][indAccInd]);
+	// Combine all the vertex components in one pass and also get the indices
+	mesh.vertices.resize(positions.count);
+	assembleVertices(positions, normals, tangents, texCoords, mesh.vertices.data(), mesh.vertices.size());
+	mesh.indices.resize(indexView.count);
+	readIndices(indexView, mesh.indices.data());
 
 	//Load The Material For This Mesh!
 	//Blender Does textures in Former Way 
@@ -108,66 +97,31 @@ void Model::loadMesh(unsigned int indMesh)
 	unsigned int hasRoughnessFactor = JSON["materials"][indMesh]["pbrMetallicRoughness"].contains("roughnessFactor");
 	float roughnessFactor = hasRoughnessFactor ? (float)(JSON["materials"][indMesh]["pbrMetallicRoughness"]["roughnessFactor"]) : 0.0f;
 
-	std::cout << "\n" << JSON["meshes"][indMesh]["name"] << "\n" << JSON["materials"][indMesh]["name"] << "\n"
+	// Built up front and written at once, meshes of several models may be decoding at the same time.
+	std::ostringstream log;
+	log << "\n" << JSON["meshes"][indMesh]["name"] << "\n" << JSON["materials"][indMesh]["name"] << "\n"
 	<< "Emissive Texture Index               :"	<< emissiveTextureIndex << std::endl
 	<< "Normal Texture Index                 :"	<< normalTextureIndex << std::endl
 	<< "Base Color Texture Index             :"	<< baseColorTextureIndex << std::endl
 	<< "Metallic Roughness Texture Index     :"	<< metallicRoughnessTextureIndex << std::endl
 	<< "Metallic Factor                      :" << metallicFactor << std::endl
 	<< "Roughness Factor                     :" << roughnessFactor << std::endl;
+	std::cout << log.str();
 
 	//Our Convention For Textures Are - 
 	//Base Color - 0, Metallic Roughness - 1, Emissive - 2, Normal - 3
+	mesh.images = { baseColorTextureIndex, metallicRoughnessTextureIndex, emissiveTextureIndex, normalTextureIndex };
+	mesh.metallicFactor = metallicFactor;
+	mesh.roughnessFactor = roughnessFactor;
 
-	vector<Texture> textures;
-
-	//Get The Current File Directory.
-	std::string fileStr = std::string(file);
-	std::string fileDirectory = fileStr.substr(0, fileStr.find_last_of('/') + 1);
-
-	//Load Base Color Texture.
-	if (hasBaseColorTexture)
-	{
-		string textureName = JSON["images"][baseColorTextureIndex]["uri"];
-		Texture baseColorTexture((fileDirectory + textureName).c_str(), TextureType::BaseColor, 0);
-		textures.push_back(baseColorTexture);
-	}
-
-	//Load Metallic Roughness Texture.
-	if (hasMetallicRoughnessTexture)
-	{
-		string textureName = JSON["images"][metallicRoughnessTextureIndex]["uri"];
-		Texture metallicRoughnessTexture((fileDirectory + textureName).c_str(), TextureType::MetallicRoughness, hasBaseColorTexture);
-		textures.push_back(metallicRoughnessTexture);
-	}
-
-	//Load Emissive Texture.
-	if (hasEmissiveTexture)
-	{
-		string textureName = JSON["images"][emissiveTextureIndex]["uri"];
-		Texture emissiveTexture((fileDirectory + textureName).c_str(), TextureType::Emissive, hasBaseColorTexture + hasMetallicRoughnessTexture);
-		textures.push_back(emissiveTexture);
-	}
-
-	//Load Normal Texture.
-	if (hasNormalTexture)
-	{
-		string textureName = JSON["images"][normalTextureIndex]["uri"];
-		Texture normalTexture((fileDirectory + textureName).c_str(), TextureType::Normal, hasBaseColorTexture + hasMetallicRoughnessTexture + hasEmissiveTexture);
-		textures.push_back(normalTexture);
-	}
-
-	//Create Material!
-	Material material(textures, metallicFactor, roughnessFactor);
-
-	// Combine the vertices, indices, and Material into a Mesh
-	meshes.push_back(Mesh(vertices, indices, material));
+	context.data.meshes.push_back(std::move(mesh));
 }
 
-void Model::traverseNode(unsigned int nextNode, glm::mat4 matrix)
+// Traverses a node recursively, so it essentially traverses all connected nodes
+static void traverseNode(DecodeContext& context, unsigned int nextNode, glm::mat4 matrix = glm::mat4(1.0f))
 {
 	// Current node
-	json node = JSON["nodes"][nextNode];
+	const json& node = context.JSON["nodes"][nextNode];
 
 	// Get translation if it exists
 	glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.0f);
@@ -219,165 +173,150 @@ void Model::traverseNode(unsigned int nextNode, glm::mat4 matrix)
 
 	// Check if the node contains a Mesh and if it does load it
 	if (node.find("mesh") != node.end())
-	{
-		matricesMeshes.push_back(matNextNode);
-		loadMesh(node["mesh"]);
-	}
+		loadMesh(context, node["mesh"], matNextNode);
 
 	// Check if the node has children, and if it does, apply this function to them with the matNextNode
 	if (node.find("children") != node.end())
 	{
-		for (volatile unsigned int i = 0; i < node["children"].size(); i++)
-			traverseNode(node["children"][i], matNextNode);
+		for (unsigned int i = 0; i < node["children"].size(); i++)
+			traverseNode(context, node["children"][i], matNextNode);
 	}
 }
 
-std::vector<unsigned char> Model::getData()
+Model::Model()
 {
-	// Create a place to store the raw text, and get the uri of the .bin file
-	std::string bytesText;
-	std::string uri = JSON["buffers"][0]["uri"];
-
-	// Store raw text data into bytesText
-	std::string fileStr = std::string(file);
-	std::string fileDirectory = fileStr.substr(0, fileStr.find_last_of('/') + 1);
-	bytesText = get_file_contents((fileDirectory + uri).c_str());
+	//Initialize Default Blender Import Rotation.
+	blenderImportRotation = glm::mat4(1.0f);
+	blenderImportRotation = glm::rotate(blenderImportRotation, glm::radians(270.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+}
 
-	// Transform the raw text data into bytes and put them in a vector
-	std::vector<unsigned char> data(bytesText.begin(), bytesText.end());
-	return data;
+Model::Model(const char* file) : Model()
+{
+	Create(file);
 }
 
-std::vector<float> Model::getFloats(json accessor)
+void Model::Create(const char* file)
 {
-	std::vector<float> floatVec;
-
-	// Get properties from the accessor
-	unsigned int buffViewInd = accessor.value("bufferView", 1);
-	unsigned int count = accessor["count"];
-	unsigned int accByteOffset = accessor.value("byteOffset", 0);
-	std::string type = accessor["type"];
-
-	// Get properties from the bufferView
-	json bufferView = JSON["bufferViews"][buffViewInd];
-
-	unsigned int byteOffset = bufferView["byteOffset"];
-
-	// Interpret the type and store it into numPerVert
-	unsigned int numPerVert;
-	if (type == "SCALAR") numPerVert = 1;
-	else if (type == "VEC2") numPerVert = 2;
-	else if (type == "VEC3") numPerVert = 3;
-	else if (type == "VEC4") numPerVert = 4;
-	else throw std::invalid_argument("Type is invalid (not SCALAR, VEC2, VEC3, or VEC4)");
-
-	// Go over all the bytes in the data at the correct place using the properties from above
-	unsigned int beginningOfData = byteOffset + accByteOffset;
-	unsigned int lengthOfData = count * 4 * numPerVert;
-	for (volatile unsigned int i = beginningOfData; i < beginningOfData + lengthOfData; i)
-	{
-		unsigned char bytes[] = { data[i++], data[i++], data[i++], data[i++] };
-		float value;
-		std::memcpy(&value, bytes, sizeof(float));
-		floatVec.push_back(value);
-	}
+	ModelData data = Decode(file);
+	Upload(data);
 
-	return floatVec;
+	for (unsigned int image = 0; image < data.imagePaths.size(); image++)
+		UploadTexture(image, TextureData::Decode(data.imagePaths[image].c_str()));
 }
 
-std::vector<GLuint> Model::getIndices(json accessor)
+ModelData Model::Decode(const char* file)
 {
-	std::vector<GLuint> indices;
+	DecodeContext context;
 
-	// Get properties from the accessor
-	unsigned int buffViewInd = accessor.value("bufferView", 0);
-	unsigned int count = accessor["count"];
-	unsigned int accByteOffset = accessor.value("byteOffset", 0);
-	unsigned int componentType = accessor["componentType"];
+	// Make a JSON object
+	std::string text = get_file_contents(file);
+	context.JSON = json::parse(text);
 
-	// Get properties from the bufferView
-	json bufferView = JSON["bufferViews"][buffViewInd];
-	unsigned int byteOffset = bufferView["byteOffset"];
+	// Get the directory the .bin files and images live in, they are referenced relative to the .gltf
+	std::string fileStr = std::string(file);
+	context.fileDirectory = fileStr.substr(0, fileStr.find_last_of('/') + 1);
 
-	// Get indices with regards to their type: unsigned int, unsigned short, or short
-	unsigned int beginningOfData = byteOffset + accByteOffset;
-	if (componentType == 5125)
-	{
-		for (volatile unsigned int i = beginningOfData; i < byteOffset + accByteOffset + count * 4; i)
-		{
-			unsigned char bytes[] = { data[i++], data[i++], data[i++], data[i++] };
-			unsigned int value;
-			std::memcpy(&value, bytes, sizeof(unsigned int));
-			indices.push_back((GLuint)value);
-		}
-	}
-	else if (componentType == 5123)
+	// Read every buffer straight into its own byte vector
+	context.buffers.reserve(context.JSON["buffers"].size());
+	for (const json& buffer : context.JSON["buffers"])
 	{
-		for (volatile unsigned int i = beginningOfData; i < byteOffset + accByteOffset + count * 2; i)
-		{
-			unsigned char bytes[] = { data[i++], data[i++] };
-			unsigned short value;
-			std::memcpy(&value, bytes, sizeof(unsigned short));
-			indices.push_back((GLuint)value);
-		}
-	}
-	else if (componentType == 5122)
-	{
-		for (volatile unsigned int i = beginningOfData; i < byteOffset + accByteOffset + count * 2; i)
-		{
-			unsigned char bytes[] = { data[i++], data[i++] };
-			short value;
-			std::memcpy(&value, bytes, sizeof(short));
-			indices.push_back((GLuint)value);
-		}
+		std::string uri = buffer["uri"];
+		context.buffers.push_back(get_file_bytes((context.fileDirectory + uri).c_str()));
 	}
 
-	return indices;
-}
+	// Traverse all nodes
+	for (unsigned int i = 0; i < context.JSON["nodes"].size(); i++)
+		traverseNode(context, i);
 
-std::vector<Vertex> Model::assembleVertices(std::vector<glm::vec3> positions, std::vector<glm::vec3> normals, std::vector<glm::vec3> tangents, std::vector<glm::vec2> texUVs)
-{
-	std::vector<Vertex> vertices;
-	for (volatile int i = 0; i < positions.size(); i++)
-		vertices.push_back( Vertex { positions[i], normals[i], tangents[i], texUVs[i]} );
-	return vertices;
+	// Resolve the image paths, the meshes only keep indices into this list
+	if (context.JSON.contains("images"))
+		for (const json& image : context.JSON["images"])
+			context.data.imagePaths.push_back(context.fileDirectory + image["uri"].get<std::string>());
+
+	// -1 is an empty slot, anything else has to name one of the images
+	for (const MeshData& mesh : context.data.meshes)
+		for (int image : mesh.images)
+			if (image < -1 || image >= (int)context.data.imagePaths.size())
+				throw std::out_of_range("Texture index " + std::to_string(image) + " is outside of the images");
+
+	return std::move(context.data);
 }
 
-std::vector<glm::vec2> Model::groupFloatsVec2(std::vector<float> floatVec)
+void Model::Upload(ModelData& data)
 {
-	std::vector<glm::vec2> vectors;
-	for (volatile int i = 0; i < floatVec.size(); i)
+	meshes.reserve(data.meshes.size());
+	for (MeshData& mesh : data.meshes)
 	{
-		vectors.push_back(glm::vec2(floatVec[i++], floatVec[i++]));
+		// Textures stream in later through UploadTexture
+		matricesMeshes.push_back(mesh.matrix);
+		meshImages.push_back(mesh.images);
+		meshes.emplace_back(std::move(mesh.vertices), std::move(mesh.indices), Material({}, mesh.metallicFactor, mesh.roughnessFactor));
+		GrowBounds(meshes.back().bounds, mesh.matrix);
 	}
-	return vectors;
 }
-std::vector<glm::vec3> Model::groupFloatsVec3(std::vector<float> floatVec)
+
+void Model::UploadPackage(const PackageReader& package)
 {
-	std::vector<glm::vec3> vectors;
-	for (volatile int i = 0; i < floatVec.size(); i)
+	meshes.reserve(package.meshCount());
+	for (unsigned int i = 0; i < package.meshCount(); i++)
 	{
-		vectors.push_back(glm::vec3(floatVec[i++], floatVec[i++], floatVec[i++]));
+		const Package::MeshRecord& mesh = package.mesh(i);
+		matricesMeshes.push_back(glm::make_mat4(mesh.matrix));
+		meshImages.push_back({ mesh.images[0], mesh.images[1], mesh.images[2], mesh.images[3] });
+		meshes.emplace_back(package.vertices(mesh), mesh.vertexCount, package.indices(mesh), mesh.indexCount, Material({}, mesh.metallicFactor, mesh.roughnessFactor));
+		GrowBounds(meshes.back().bounds, matricesMeshes.back());
 	}
-	return vectors;
 }
-std::vector<glm::vec4> Model::groupFloatsVec4(std::vector<float> floatVec)
+
+void Model::UploadTexture(unsigned int image, const TextureData& data)
 {
-	std::vector<glm::vec4> vectors;
-	for (volatile int i = 0; i < floatVec.size(); i)
+	// An image can be used as several texture types (the Sun's base color is also its emission),
+	// each type needs its own texture because of the sRGB format, but only one per model.
+	Texture uploaded[4];
+	// Textures this image had before, still on the GL side unless BodyRenderer took them over (ID 0)
+	std::vector<GLuint> replaced;
+	for (unsigned int i = 0; i < meshes.size(); i++)
 	{
-		vectors.push_back(glm::vec4(floatVec[i++], floatVec[i++], floatVec[i++], floatVec[i++]));
+		for (unsigned int slot = 0; slot < 4; slot++)
+		{
+			if (meshImages[i][slot] != (int)image)
+				continue;
+
+			TextureType type = static_cast<TextureType>(slot + 1);
+			if (uploaded[slot].type == TextureType::None)
+				uploaded[slot] = Texture(data, type, slot);
+
+			Material& material = meshes[i].material;
+			Texture* slots[4] = { &material.baseColorTexture, &material.metallicRoughnessTexture, &material.emissiveTexture, &material.normalTexture };
+			if (slots[slot]->ID != 0 && std::find(replaced.begin(), replaced.end(), slots[slot]->ID) == replaced.end())
+				replaced.push_back(slots[slot]->ID);
+			*slots[slot] = uploaded[slot];
+		}
 	}
-	return vectors;
+
+	for (GLuint texture : replaced)
+		glDeleteTextures(1, &texture);
+	textureVersion++;
 }
 
-std::vector<glm::vec3> Model::groupFloatsVec4asVec3(std::vector<float> floatVec)
+void Model::GrowBounds(const MeshBounds& bounds, const glm::mat4& matrix)
 {
-	std::vector<glm::vec3> vectors;
-	for (volatile int i = 0; i < floatVec.size(); i)
-	{
-		glm::vec4 temp = glm::vec4(floatVec[i++], floatVec[i++], floatVec[i++], floatVec[i++]);
-		vectors.push_back(glm::vec3(temp.x, temp.y, temp.z));
-	}
-	return vectors;
-}
\ No newline at end of file
+	// The import rotation doesn't change distances from the origin, only the mesh matrix matters
+	const float scale = std::sqrt(std::max({ glm::dot(matrix[0], matrix[0]), glm::dot(matrix[1], matrix[1]), glm::dot(matrix[2], matrix[2]) }));
+	const float distance = glm::length(glm::vec3(matrix * glm::vec4(bounds.center, 1.0f)));
+	boundingRadius = std::max(boundingRadius, distance + bounds.radius * scale);
+}
+
+void Model::SimpleDraw(const MeshUniforms& uniforms, mat4 model)
+{
+	// Go over all meshes and draw each one without any texturing.
+	for (volatile unsigned int i = 0; i < meshes.size(); i++)
+		meshes[i].Mesh::SimpleDraw(uniforms, model * matricesMeshes[i] * blenderImportRotation);
+}
+
+void Model::Draw(const MeshUniforms& uniforms, mat4 model)
+{
+	// Go over all meshes and draw each one
+	for (volatile unsigned int i = 0; i < meshes.size(); i++)
+		meshes[i].Mesh::Draw(uniforms, model * matricesMeshes[i] * blenderImportRotation);
+}
@@ -2,66 +2,83 @@
 #define Model_H
 
 #include <json.h>
+#include <array>
+#include "Accessor.h"
 #include "Mesh.h"
+#include "Package.h"
 
 using json = nlohmann::json;
 
 // Reads a text file and outputs a string with everything in the text file
 std::string get_file_contents(const char* filename);
+// Reads a binary file straight into a byte vector
+std::vector<unsigned char> get_file_bytes(const char* filename);
+
+// CPU side data of a single mesh, decoded off the GL thread
+struct MeshData
+{
+	std::vector<Vertex> vertices;
+	std::vector<GLuint> indices;
+	glm::mat4 matrix = glm::mat4(1.0f);
+	float metallicFactor = 0.0f;
+	float roughnessFactor = 1.0f;
+	// Image used by each texture slot (BaseColor, MetallicRoughness, Emissive, Normal), -1 if the slot is empty
+	std::array<int, 4> images = { -1, -1, -1, -1 };
+};
+
+// Everything Model::Decode gets out of a .gltf and its .bin, without touching OpenGL
+struct ModelData
+{
+	std::vector<MeshData> meshes;
+	// Paths of the images the meshes reference, indexed like MeshData::images
+	std::vector<std::string> imagePaths;
+};
 
 class Model
 {
 public:
-	// Loads in a model from a file and stores tha information in 'data', 'JSON', and 'file'
-	Model() : file(nullptr) {}
+	Model();
+	// Loads in a model from a file, decoding and uploading everything on the calling thread
 	Model(const char* file);
 	~Model() {}
 	void Create(const char* file);
-	void Draw(Shader& shader, mat4 model);
-	void SimpleDraw(Shader& shader, mat4 model);
+	void Draw(const MeshUniforms& uniforms, mat4 model);
+	void SimpleDraw(const MeshUniforms& uniforms, mat4 model);
+
+	// Parses the .gltf, reads its buffers and decodes every mesh. Safe to call from any thread.
+	static ModelData Decode(const char* file);
+	// Creates the vertex buffers of the decoded meshes. GL thread only.
+	void Upload(ModelData& data);
+	// Creates the vertex buffers of a baked package straight from its mapping. GL thread only.
+	// Its textures come in through UploadTexture(image, package.image(image)) like decoded ones.
+	void UploadPackage(const PackageReader& package);
+	// Creates the texture of 'image' and hands it to every mesh slot using it. GL thread only, after Upload.
+	// Calling it again for the same image replaces the texture, the old one is deleted.
+	void UploadTexture(unsigned int image, const TextureData& data);
+
+	// True once the geometry is on the GPU, textures may still be streaming in
+	bool IsLoaded() const { return !meshes.empty(); }
+	// Transformation of mesh 'i' relative to the model, what Draw multiplies the model matrix with
+	glm::mat4 MeshMatrix(size_t i) const { return matricesMeshes[i] * blenderImportRotation; }
+	// Distance of the farthest vertex from the model's origin, before the body's scale
+	float BoundingRadius() const { return boundingRadius; }
+	// Goes up every time a texture is uploaded, so whatever was made from the textures can tell it is out of date
+	unsigned int TextureVersion() const { return textureVersion; }
 
 	// All the meshes and transformations
 	std::vector<Mesh> meshes;
 
 private:
-	// Variables for easy access
-	const char* file;
-	std::vector<unsigned char> data;
-	json JSON;
 	std::vector<glm::mat4> matricesMeshes;
+	// Image index of every texture slot of every mesh, so textures arriving later find their meshes
+	std::vector<std::array<int, 4>> meshImages;
+	float boundingRadius = 0.0f;
+	unsigned int textureVersion = 0;
+
+	// Grows boundingRadius to hold the bounding sphere of a mesh placed by mesh matrix 'matrix'
+	void GrowBounds(const MeshBounds& bounds, const glm::mat4& matrix);
 
 	// The Default Rotation To Align Model as Front Facing(By Rotation of 270 degrees in the Y Axis)
 	glm::mat4 blenderImportRotation;
-
-	// Prevents textures from being loaded twice
-	std::vector<std::string> loadedTexName;
-	std::vector<Texture> loadedTex;
-
-	// Loads a single mesh by its index
-	void loadMesh(unsigned int indMesh);
-
-	// Traverses a node recursively, so it essentially traverses all connected nodes
-	void traverseNode(unsigned int nextNode, glm::mat4 matrix = glm::mat4(1.0f));
-
-	// Gets the binary data from a file
-	std::vector<unsigned char> getData();
-	// Interprets the binary data into floats, indices, and textures
-	std::vector<float> getFloats(json accessor);
-	std::vector<GLuint> getIndices(json accessor);
-
-	// Assembles all the floats into vertices
-	std::vector<Vertex> assembleVertices
-	(
-		std::vector<glm::vec3> positions,
-		std::vector<glm::vec3> normals,
-		std::vector<glm::vec3> tangents,
-		std::vector<glm::vec2> texUVs
-	);
-
-	// Helps with the assembly from above by grouping floats
-	std::vector<glm::vec2> groupFloatsVec2(std::vector<float> floatVec);
-	std::vector<glm::vec3> groupFloatsVec3(std::vector<float> floatVec);
-	std::vector<glm::vec4> groupFloatsVec4(std::vector<float> floatVec);
-	std::vector<glm::vec3> groupFloatsVec4asVec3(std::vector<float> floatVec);
 };
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,405 @@
+#include "NBody.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Orbits.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define NBODY_SSE2
+#endif
+
+// Gravitational constant in scene units^3 / (solar mass day^2), the square of the Gaussian gravitational constant scaled from AU
+static const double G = 0.01720209895 * 0.01720209895 * Orbits::SceneUnitsPerAU * Orbits::SceneUnitsPerAU * Orbits::SceneUnitsPerAU;
+
+// Bits per axis of a Morton code, 3 * 21 fit in 64 bits. Also the deepest the octree goes.
+static const int MortonBits = 21;
+
+// Spreads the low 21 bits of 'v' so there are two zero bits between each of them
+static inline uint64_t spreadBits(uint64_t v)
+{
+	v &= 0x1FFFFF;
+	v = (v | v << 32) & 0x1F00000000FFFF;
+	v = (v | v << 16) & 0x1F0000FF0000FF;
+	v = (v | v << 8) & 0x100F00F00F00F00F;
+	v = (v | v << 4) & 0x10C30C30C30C30C3;
+	v = (v | v << 2) & 0x1249249249249249;
+	return v;
+}
+
+// Adds the pull of 'count' point masses on the point 'p' to the acceleration and potential.
+// 'gm' holds G times each mass. On the SSE2 path 'count' must be even, two interactions run at once.
+static inline void sumInteractions(const double* x, const double* y, const double* z, const double* gm, size_t count,
+								   const glm::dvec3& p, double epsilon2, glm::dvec3& acceleration, double& potential)
+{
+#if defined(NBODY_SSE2)
+	const __m128d px = _mm_set1_pd(p.x), py = _mm_set1_pd(p.y), pz = _mm_set1_pd(p.z);
+	const __m128d e2 = _mm_set1_pd(epsilon2), one = _mm_set1_pd(1.0);
+	__m128d ax = _mm_setzero_pd(), ay = _mm_setzero_pd(), az = _mm_setzero_pd(), phi = _mm_setzero_pd();
+	for (size_t k = 0; k < count; k += 2)
+	{
+		const __m128d dx = _mm_sub_pd(_mm_loadu_pd(x + k), px);
+		const __m128d dy = _mm_sub_pd(_mm_loadu_pd(y + k), py);
+		const __m128d dz = _mm_sub_pd(_mm_loadu_pd(z + k), pz);
+		const __m128d r2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_add_pd(_mm_mul_pd(dz, dz), e2));
+		const __m128d inverse = _mm_div_pd(one, _mm_sqrt_pd(r2));
+		const __m128d g = _mm_mul_pd(_mm_loadu_pd(gm + k), inverse);
+		const __m128d g3 = _mm_mul_pd(g, _mm_mul_pd(inverse, inverse));
+		ax = _mm_add_pd(ax, _mm_mul_pd(dx, g3));
+		ay = _mm_add_pd(ay, _mm_mul_pd(dy, g3));
+		az = _mm_add_pd(az, _mm_mul_pd(dz, g3));
+		phi = _mm_add_pd(phi, g);
+	}
+
+	double lanes[2];
+	_mm_storeu_pd(lanes, ax); acceleration.x += lanes[0] + lanes[1];
+	_mm_storeu_pd(lanes, ay); acceleration.y += lanes[0] + lanes[1];
+	_mm_storeu_pd(lanes, az); acceleration.z += lanes[0] + lanes[1];
+	_mm_storeu_pd(lanes, phi); potential -= lanes[0] + lanes[1];
+#else
+	for (size_t k = 0; k < count; k++)
+	{
+		const glm::dvec3 d(x[k] - p.x, y[k] - p.y, z[k] - p.z);
+		const double inverse = 1.0 / std::sqrt(glm::dot(d, d) + epsilon2);
+		const double g = gm[k] * inverse;
+		acceleration += d * (g * inverse * inverse);
+		potential -= g;
+	}
+#endif
+}
+
+void NBody::Clear()
+{
+	x.clear(); y.clear(); z.clear();
+	vx.clear(); vy.clear(); vz.clear();
+	mass.clear();
+	m_ForcesValid = false;
+}
+
+uint32_t NBody::AddParticle(const glm::dvec3& position, const glm::dvec3& velocity, double particleMass)
+{
+	x.push_back(position.x); y.push_back(position.y); z.push_back(position.z);
+	vx.push_back(velocity.x); vy.push_back(velocity.y); vz.push_back(velocity.z);
+	mass.push_back(particleMass);
+	m_ForcesValid = false;
+	return (uint32_t)(mass.size() - 1);
+}
+
+void NBody::CenterOnBarycenter()
+{
+	glm::dvec3 position(0.0), momentum(0.0);
+	double total = 0.0;
+	for (size_t i = 0; i < size(); i++)
+	{
+		position += mass[i] * glm::dvec3(x[i], y[i], z[i]);
+		momentum += mass[i] * glm::dvec3(vx[i], vy[i], vz[i]);
+		total += mass[i];
+	}
+	if (total <= 0.0)
+		return;
+
+	position /= total;
+	const glm::dvec3 velocity = momentum / total;
+	for (size_t i = 0; i < size(); i++)
+	{
+		x[i] -= position.x; y[i] -= position.y; z[i] -= position.z;
+		vx[i] -= velocity.x; vy[i] -= velocity.y; vz[i] -= velocity.z;
+	}
+	m_ForcesValid = false;
+}
+
+void NBody::Step(double dt)
+{
+	if (size() == 0)
+		return;
+	if (!m_ForcesValid)
+		ComputeForces();
+
+	// Both integrators kick first and last, the final kick's forces are the next step's first so they are
+	// evaluated once per drift: one evaluation per leapfrog step, three per Yoshida step.
+	if (integrator == Integrator::Leapfrog)
+	{
+		Kick(0.5 * dt);
+		Drift(dt);
+		ComputeForces();
+		Kick(0.5 * dt);
+		return;
+	}
+
+	// Yoshida 1990, the leapfrog composed with steps w1, w0, w1 where w0 = -2^(1/3) w1 and 2 w1 + w0 = 1
+	const double cubeRoot2 = std::cbrt(2.0);
+	const double w1 = 1.0 / (2.0 - cubeRoot2);
+	const double w0 = -cubeRoot2 * w1;
+	const double kicks[4] = { 0.5 * w1, 0.5 * (w0 + w1), 0.5 * (w0 + w1), 0.5 * w1 };
+	const double drifts[3] = { w1, w0, w1 };
+	for (int stage = 0; stage < 3; stage++)
+	{
+		Kick(kicks[stage] * dt);
+		Drift(drifts[stage] * dt);
+		ComputeForces();
+	}
+	Kick(kicks[3] * dt);
+}
+
+double NBody::TotalEnergy()
+{
+	if (size() == 0)
+		return 0.0;
+	if (!m_ForcesValid)
+		ComputeForces();
+
+	double kinetic = 0.0, potential = 0.0;
+	for (size_t i = 0; i < size(); i++)
+	{
+		kinetic += 0.5 * mass[i] * (vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]);
+		// Every pair shows up in both particles' potentials
+		potential += 0.5 * mass[i] * m_Potential[i];
+	}
+	return kinetic + potential;
+}
+
+void NBody::Kick(double dt)
+{
+	const size_t count = size();
+	for (size_t i = 0; i < count; i++)
+	{
+		vx[i] += m_AX[i] * dt;
+		vy[i] += m_AY[i] * dt;
+		vz[i] += m_AZ[i] * dt;
+	}
+}
+
+void NBody::Drift(double dt)
+{
+	const size_t count = size();
+	for (size_t i = 0; i < count; i++)
+	{
+		x[i] += vx[i] * dt;
+		y[i] += vy[i] * dt;
+		z[i] += vz[i] * dt;
+	}
+	m_ForcesValid = false;
+}
+
+void NBody::ComputeForces()
+{
+	const size_t count = size();
+	m_AX.resize(count);
+	m_AY.resize(count);
+	m_AZ.resize(count);
+	m_Potential.resize(count);
+
+	BuildTree();
+
+	// One walk per group, its particles are neighbours on the Morton curve and open the same nodes
+	m_Jobs.ParallelFor(m_Groups.size(), grainSize, [this](size_t begin, size_t end)
+	{
+		for (size_t group = begin; group < end; group++)
+			AccumulateGroup(m_Groups[group]);
+	});
+	m_ForcesValid = true;
+}
+
+void NBody::BuildTree()
+{
+	const size_t count = size();
+
+	// Bounding cube of every particle, a little larger so the farthest particle still quantizes inside it
+	glm::dvec3 low(x[0], y[0], z[0]), high = low;
+	for (size_t i = 1; i < count; i++)
+	{
+		low = glm::min(low, glm::dvec3(x[i], y[i], z[i]));
+		high = glm::max(high, glm::dvec3(x[i], y[i], z[i]));
+	}
+	const glm::dvec3 extent = high - low;
+	const double size = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-9)) * 1.0001;
+	const glm::dvec3 center = 0.5 * (low + high);
+	const glm::dvec3 origin = center - glm::dvec3(0.5 * size);
+
+	// Morton code of every particle, the sorted codes list each octree node's particles contiguously
+	const double scale = (double)(1 << MortonBits) / size;
+	const uint64_t maxCell = (1u << MortonBits) - 1;
+	m_Codes.resize(count);
+	m_Order.resize(count);
+	std::vector<std::pair<uint64_t, uint32_t>> keys(count);
+	m_Jobs.ParallelFor(count, 8192, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const uint64_t cx = std::min((uint64_t)std::max(0.0, (x[i] - origin.x) * scale), maxCell);
+			const uint64_t cy = std::min((uint64_t)std::max(0.0, (y[i] - origin.y) * scale), maxCell);
+			const uint64_t cz = std::min((uint64_t)std::max(0.0, (z[i] - origin.z) * scale), maxCell);
+			keys[i] = std::make_pair(spreadBits(cx) | spreadBits(cy) << 1 | spreadBits(cz) << 2, (uint32_t)i);
+		}
+	});
+	std::sort(keys.begin(), keys.end());
+
+	m_SX.resize(count);
+	m_SY.resize(count);
+	m_SZ.resize(count);
+	m_SMass.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		const uint32_t particle = keys[i].second;
+		m_Codes[i] = keys[i].first;
+		m_Order[i] = particle;
+		m_SX[i] = x[particle];
+		m_SY[i] = y[particle];
+		m_SZ[i] = z[particle];
+		m_SMass[i] = mass[particle];
+	}
+
+	m_Nodes.clear();
+	m_Groups.clear();
+	m_Nodes.reserve(count / std::max(leafSize, 1u) * 2 + 64);
+	BuildNode(0, (uint32_t)count, 0, center, size, false);
+}
+
+uint32_t NBody::BuildNode(uint32_t first, uint32_t count, int level, const glm::dvec3& center, double size, bool grouped)
+{
+	const uint32_t index = (uint32_t)m_Nodes.size();
+	m_Nodes.push_back(Node());
+
+	if (!grouped && count <= std::max(groupSize, 1u))
+	{
+		m_Groups.push_back(index);
+		grouped = true;
+	}
+
+	glm::dvec3 weighted(0.0);
+	double total = 0.0;
+	const bool leaf = count <= std::max(leafSize, 1u) || level == MortonBits;
+	if (leaf)
+	{
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			weighted += m_SMass[i] * glm::dvec3(m_SX[i], m_SY[i], m_SZ[i]);
+			total += m_SMass[i];
+		}
+	}
+	else
+	{
+		// The octant at this level is three bits of the code, x in the lowest
+		const int shift = 3 * (MortonBits - 1 - level);
+		uint32_t begin = first;
+		const uint32_t end = first + count;
+		for (uint64_t octant = 0; octant < 8 && begin < end; octant++)
+		{
+			uint32_t childEnd = begin;
+			while (childEnd < end && ((m_Codes[childEnd] >> shift) & 7) == octant)
+				childEnd++;
+			if (childEnd == begin)
+				continue;
+
+			const glm::dvec3 offset((octant & 1) ? 0.25 : -0.25, (octant & 2) ? 0.25 : -0.25, (octant & 4) ? 0.25 : -0.25);
+			const uint32_t child = BuildNode(begin, childEnd - begin, level + 1, center + offset * size, 0.5 * size, grouped);
+			weighted += m_Nodes[child].mass * m_Nodes[child].centerOfMass;
+			total += m_Nodes[child].mass;
+			begin = childEnd;
+		}
+	}
+
+	Node& node = m_Nodes[index];
+	node.mass = total;
+	node.centerOfMass = total > 0.0 ? weighted / total : center;
+	node.center = center;
+	node.size = size;
+	node.first = first;
+	node.count = count;
+	node.next = (uint32_t)m_Nodes.size();
+	node.leaf = leaf;
+	return index;
+}
+
+void NBody::AccumulateGroup(uint32_t groupIndex)
+{
+	const Node& group = m_Nodes[groupIndex];
+	const uint32_t first = group.first, last = group.first + group.count;
+	const double epsilon2 = softening * softening;
+	const double theta2 = theta * theta;
+
+	// Bounds of the group's particles, the opening test uses the distance to the nearest point of it
+	glm::dvec3 low(m_SX[first], m_SY[first], m_SZ[first]), high = low;
+	for (uint32_t i = first + 1; i < last; i++)
+	{
+		low = glm::min(low, glm::dvec3(m_SX[i], m_SY[i], m_SZ[i]));
+		high = glm::max(high, glm::dvec3(m_SX[i], m_SY[i], m_SZ[i]));
+	}
+
+	// Everything the group interacts with as point masses: accepted nodes and the particles of opened leaves
+	static thread_local std::vector<double> lx, ly, lz, lgm;
+	lx.clear(); ly.clear(); lz.clear(); lgm.clear();
+
+	// Stackless walk: accepting or skipping a node jumps past its subtree, opening it steps into its first child
+	const uint32_t nodeCount = (uint32_t)m_Nodes.size();
+	uint32_t index = 0;
+	while (index < nodeCount)
+	{
+		const Node& node = m_Nodes[index];
+		if (node.mass == 0.0 || index == groupIndex)
+		{
+			index = node.next;
+			continue;
+		}
+
+		if (node.leaf)
+		{
+			for (uint32_t j = node.first; j < node.first + node.count; j++)
+			{
+				if (m_SMass[j] == 0.0)
+					continue;
+				lx.push_back(m_SX[j]); ly.push_back(m_SY[j]); lz.push_back(m_SZ[j]); lgm.push_back(G * m_SMass[j]);
+			}
+			index = node.next;
+			continue;
+		}
+
+		// Far enough from every particle of the group to be a single point mass. A node overlapping the group
+		// always opens, otherwise the group's own mass would end up in the monopole.
+		const glm::dvec3 half(0.5 * node.size);
+		const bool overlaps = glm::all(glm::lessThanEqual(node.center - half, high)) && glm::all(glm::lessThanEqual(low, node.center + half));
+		const glm::dvec3 d = node.centerOfMass - glm::clamp(node.centerOfMass, low, high);
+		if (!overlaps && node.size * node.size < theta2 * glm::dot(d, d))
+		{
+			lx.push_back(node.centerOfMass.x); ly.push_back(node.centerOfMass.y); lz.push_back(node.centerOfMass.z); lgm.push_back(G * node.mass);
+			index = node.next;
+		}
+		else
+		{
+			index++;
+		}
+	}
+
+	// Pad to an even count with a massless point far away
+	if (lgm.size() % 2)
+	{
+		lx.push_back(1e30); ly.push_back(1e30); lz.push_back(1e30); lgm.push_back(0.0);
+	}
+
+	for (uint32_t i = first; i < last; i++)
+	{
+		const glm::dvec3 p(m_SX[i], m_SY[i], m_SZ[i]);
+		glm::dvec3 acceleration(0.0);
+		double potential = 0.0;
+		sumInteractions(lx.data(), ly.data(), lz.data(), lgm.data(), lgm.size(), p, epsilon2, acceleration, potential);
+
+		// The group's own particles pairwise, minus the particle itself
+		for (uint32_t j = first; j < last; j++)
+		{
+			if (j == i || m_SMass[j] == 0.0)
+				continue;
+			const glm::dvec3 d(m_SX[j] - p.x, m_SY[j] - p.y, m_SZ[j] - p.z);
+			const double inverse = 1.0 / std::sqrt(glm::dot(d, d) + epsilon2);
+			const double gm = G * m_SMass[j] * inverse;
+			acceleration += d * (gm * inverse * inverse);
+			potential -= gm;
+		}
+
+		const uint32_t particle = m_Order[i];
+		m_AX[particle] = acceleration.x;
+		m_AY[particle] = acceleration.y;
+		m_AZ[particle] = acceleration.z;
+		m_Potential[particle] = potential;
+	}
+}
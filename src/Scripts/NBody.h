@@ -0,0 +1,98 @@
+#ifndef NBODY_H
+#define NBODY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../../vendor/glm/glm.hpp"
+#include "JobSystem.h"
+
+// Symplectic integrators the simulation can step with.
+enum class Integrator
+{
+	// Kick-drift-kick leapfrog, second order, one force evaluation per step
+	Leapfrog,
+	// Yoshida's fourth order composition of three leapfrog steps, three force evaluations per step
+	Yoshida4
+};
+
+// Gravitational N-body simulation in double precision.
+// Forces come from a Barnes-Hut octree rebuilt before every force evaluation, so a step costs O(n log n)
+// and asteroid belts or ring particles in the 100k range stay interactive. The force pass runs on the job system.
+// Units are scene units (1,000,000 km), days and solar masses, the same space the renderer draws in.
+class NBody
+{
+public:
+	// Runs its force passes on 'jobs', which must outlive the simulation
+	explicit NBody(JobSystem& jobs) : m_Jobs(jobs) {}
+
+	// Removes every particle
+	void Clear();
+	// Appends a particle and returns its index. Massless particles feel gravity but don't exert any.
+	uint32_t AddParticle(const glm::dvec3& position, const glm::dvec3& velocity, double mass);
+	// Moves the whole system into the frame of its barycenter, so it doesn't drift away
+	void CenterOnBarycenter();
+
+	// Advances every particle by 'dt' days, negative steps run the simulation backwards
+	void Step(double dt);
+	// Kinetic plus potential energy, the potential is the tree's from the last force evaluation
+	double TotalEnergy();
+
+	size_t size() const { return mass.size(); }
+	glm::dvec3 Position(size_t i) const { return glm::dvec3(x[i], y[i], z[i]); }
+
+	// State of every particle as a structure of arrays
+	std::vector<double> x, y, z;
+	std::vector<double> vx, vy, vz;
+	std::vector<double> mass;
+
+	Integrator integrator = Integrator::Yoshida4;
+	// Barnes-Hut opening angle, a node is treated as a point mass once size / distance drops below it. 0 is exact.
+	double theta = 0.5;
+	// Plummer softening length in scene units, keeps close encounters between particles from blowing up
+	double softening = 1e-6;
+	// Particles per octree leaf
+	unsigned int leafSize = 8;
+	// Most particles in a group, the largest subtrees under this share one tree walk and interaction list
+	unsigned int groupSize = 64;
+	// Groups per force pass job
+	unsigned int grainSize = 16;
+
+private:
+	// An octree node, stored depth first so a node's children follow it and 'next' skips its whole subtree.
+	struct Node
+	{
+		glm::dvec3 centerOfMass;
+		double mass;
+		// Center and edge length of the node's cube
+		glm::dvec3 center;
+		double size;
+		// Range of particles in the Morton sorted arrays, the node's own if it is a leaf
+		uint32_t first, count;
+		uint32_t next;
+		bool leaf;
+	};
+
+	// Kicks every particle by 'dt' with the current accelerations
+	void Kick(double dt);
+	void Drift(double dt);
+	// Rebuilds the tree and recomputes every acceleration and potential
+	void ComputeForces();
+	void BuildTree();
+	uint32_t BuildNode(uint32_t first, uint32_t count, int level, const glm::dvec3& center, double size, bool grouped);
+	// Accelerations and potentials of every particle under node 'group' from the whole tree
+	void AccumulateGroup(uint32_t group);
+
+	JobSystem& m_Jobs;
+	std::vector<double> m_AX, m_AY, m_AZ, m_Potential;
+	bool m_ForcesValid = false;
+
+	std::vector<Node> m_Nodes;
+	std::vector<uint32_t> m_Groups;
+	// Particles sorted along a Morton curve, the tree's leaves are ranges of these arrays
+	std::vector<uint64_t> m_Codes;
+	std::vector<uint32_t> m_Order;
+	std::vector<double> m_SX, m_SY, m_SZ, m_SMass;
+};
+
+#endif
@@ -0,0 +1,316 @@
+#include "Orbits.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define ORBITS_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define ORBITS_SSE2
+#endif
+
+static const double Pi = 3.14159265358979323846;
+static const double TwoPi = 2.0 * Pi;
+static const double Degrees = Pi / 180.0;
+// Gaussian gravitational constant, the Sun's mean motion in radians per day for a 1 AU orbit
+static const double GaussianConstant = 0.01720209895;
+static const double DaysPerCentury = 36525.0;
+// J2000 (2000-01-01 12:00 TT) as UTC seconds since the Unix epoch
+static const double J2000UnixSeconds = 946727935.816;
+
+// The solver stops once every lane moved less than this (radians), or after MaxIterations
+static const float Tolerance = 1e-6f;
+static const int MaxIterations = 12;
+
+void OrbitTable::Add(uint32_t body, const OrbitalElements& elements)
+{
+	const double a = elements.semiMajorAxis;
+	const double e = elements.eccentricity;
+	const double inclination = elements.inclination * Degrees;
+	const double node = elements.longitudeOfAscendingNode * Degrees;
+	const double argumentOfPeriapsis = (elements.longitudeOfPerihelion - elements.longitudeOfAscendingNode) * Degrees;
+
+	double meanAnomaly = (elements.meanLongitude - elements.longitudeOfPerihelion) * Degrees;
+	meanAnomaly -= TwoPi * std::floor(meanAnomaly / TwoPi + 0.5);
+	const double meanMotion = elements.meanLongitudeRate != 0.0 ? elements.meanLongitudeRate * Degrees / DaysPerCentury
+																: GaussianConstant / (a * std::sqrt(a));
+
+	// Periapsis direction and the direction 90 degrees ahead of it, on the J2000 ecliptic
+	const double cw = std::cos(argumentOfPeriapsis), sw = std::sin(argumentOfPeriapsis);
+	const double cn = std::cos(node), sn = std::sin(node);
+	const double ci = std::cos(inclination), si = std::sin(inclination);
+	const glm::dvec3 p(cw * cn - sw * sn * ci, cw * sn + sw * cn * ci, sw * si);
+	const glm::dvec3 q(-sw * cn - cw * sn * ci, -sw * sn + cw * cn * ci, cw * si);
+
+	bodies.push_back(body);
+	meanAnomalies.push_back(meanAnomaly);
+	meanMotions.push_back(meanMotion);
+	eccentricities.push_back((float)e);
+	semiMajorAxes.push_back((float)(a * Orbits::SceneUnitsPerAU));
+	semiMinorAxes.push_back((float)(a * std::sqrt(1.0 - e * e) * Orbits::SceneUnitsPerAU));
+
+	// Ecliptic (x, y, z) to render space (x, z, -y), the ecliptic is the XZ plane with its north pole up
+	px.push_back((float)p.x); py.push_back((float)p.z); pz.push_back((float)-p.y);
+	qx.push_back((float)q.x); qy.push_back((float)q.z); qz.push_back((float)-q.y);
+}
+
+#pragma region Vector Math
+
+#if defined(ORBITS_AVX)
+
+struct Lanes
+{
+	static const int Width = 8;
+	__m256 v;
+};
+
+static inline Lanes load(const float* p) { return { _mm256_loadu_ps(p) }; }
+static inline void store(float* p, Lanes a) { _mm256_storeu_ps(p, a.v); }
+static inline Lanes set1(float x) { return { _mm256_set1_ps(x) }; }
+static inline Lanes operator+(Lanes a, Lanes b) { return { _mm256_add_ps(a.v, b.v) }; }
+static inline Lanes operator-(Lanes a, Lanes b) { return { _mm256_sub_ps(a.v, b.v) }; }
+static inline Lanes operator*(Lanes a, Lanes b) { return { _mm256_mul_ps(a.v, b.v) }; }
+static inline Lanes operator/(Lanes a, Lanes b) { return { _mm256_div_ps(a.v, b.v) }; }
+static inline Lanes roundNearest(Lanes a) { return { _mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC) }; }
+static inline Lanes abs(Lanes a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+static inline Lanes lessThan(Lanes a, Lanes b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+static inline Lanes equal(Lanes a, Lanes b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; }
+static inline Lanes select(Lanes mask, Lanes a, Lanes b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+static inline bool any(Lanes mask) { return _mm256_movemask_ps(mask.v) != 0; }
+
+#elif defined(ORBITS_SSE2)
+
+struct Lanes
+{
+	static const int Width = 4;
+	__m128 v;
+};
+
+static inline Lanes load(const float* p) { return { _mm_loadu_ps(p) }; }
+static inline void store(float* p, Lanes a) { _mm_storeu_ps(p, a.v); }
+static inline Lanes set1(float x) { return { _mm_set1_ps(x) }; }
+static inline Lanes operator+(Lanes a, Lanes b) { return { _mm_add_ps(a.v, b.v) }; }
+static inline Lanes operator-(Lanes a, Lanes b) { return { _mm_sub_ps(a.v, b.v) }; }
+static inline Lanes operator*(Lanes a, Lanes b) { return { _mm_mul_ps(a.v, b.v) }; }
+static inline Lanes operator/(Lanes a, Lanes b) { return { _mm_div_ps(a.v, b.v) }; }
+// Round trip through integers, rounds to nearest under the default MXCSR mode
+static inline Lanes roundNearest(Lanes a) { return { _mm_cvtepi32_ps(_mm_cvtps_epi32(a.v)) }; }
+static inline Lanes abs(Lanes a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+static inline Lanes lessThan(Lanes a, Lanes b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+static inline Lanes equal(Lanes a, Lanes b) { return { _mm_cmpeq_ps(a.v, b.v) }; }
+static inline Lanes select(Lanes mask, Lanes a, Lanes b) { return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) }; }
+static inline bool any(Lanes mask) { return _mm_movemask_ps(mask.v) != 0; }
+
+#endif
+
+#if defined(ORBITS_AVX) || defined(ORBITS_SSE2)
+
+// Sine and cosine of every lane. Cody-Waite reduction to [-pi/4, pi/4] and the single precision
+// minimax polynomials from Cephes, accurate to a few ulp for the |x| < 100 the solver feeds it.
+static inline void sinCos(Lanes x, Lanes& s, Lanes& c)
+{
+	const Lanes quadrants = roundNearest(x * set1(0.63661977236758134f));
+	Lanes r = x - quadrants * set1(1.5703125f);
+	r = r - quadrants * set1(4.837512969970703125e-4f);
+	r = r - quadrants * set1(7.54978995489188216e-8f);
+
+	const Lanes r2 = r * r;
+	const Lanes sinR = r + r * r2 * (set1(-1.6666654611e-1f) + r2 * (set1(8.3321608736e-3f) + r2 * set1(-1.9515295891e-4f)));
+	const Lanes cosR = set1(1.0f) - set1(0.5f) * r2 + r2 * r2 * (set1(4.166664568298827e-2f) + r2 * (set1(-1.388731625493765e-3f) + r2 * set1(2.443315711809948e-5f)));
+
+	// Quadrant 0..3, the offsets keep every rounding away from the .5 ties
+	const Lanes quadrant = quadrants - set1(4.0f) * roundNearest(quadrants * set1(0.25f) - set1(0.375f));
+	const Lanes odd = equal(quadrant - set1(2.0f) * roundNearest(quadrant * set1(0.5f) - set1(0.25f)), set1(1.0f));
+	const Lanes negateSin = lessThan(set1(1.5f), quadrant);
+	const Lanes negateCos = lessThan(abs(quadrant - set1(1.5f)), set1(1.0f));
+
+	const Lanes sinV = select(odd, cosR, sinR);
+	const Lanes cosV = select(odd, sinR, cosR);
+	s = select(negateSin, set1(0.0f) - sinV, sinV);
+	c = select(negateCos, set1(0.0f) - cosV, cosV);
+}
+
+// Solves one batch of Lanes::Width orbits, every pointer points at the batch's first element.
+static inline void solveBatch(const float* meanAnomaly, const float* eccentricity, const float* a, const float* b,
+							  const float* px, const float* py, const float* pz, const float* qx, const float* qy, const float* qz,
+							  float* x, float* y, float* z)
+{
+	const Lanes M = load(meanAnomaly);
+	const Lanes e = load(eccentricity);
+
+	// Danby's starting guess E = M + 0.85 e sign(M) converges for every e < 1
+	const Lanes offset = set1(0.85f) * e;
+	Lanes E = M + select(lessThan(M, set1(0.0f)), set1(0.0f) - offset, offset);
+
+	Lanes s, c;
+	for (int iteration = 0; iteration < MaxIterations; iteration++)
+	{
+		// Newton step on f(E) = E - e sin E - M
+		sinCos(E, s, c);
+		const Lanes step = (E - e * s - M) / (set1(1.0f) - e * c);
+		E = E - step;
+		if (!any(lessThan(set1(Tolerance), abs(step))))
+			break;
+	}
+	sinCos(E, s, c);
+
+	// Position in the orbital plane, then rotated into render space
+	const Lanes along = load(a) * (c - e);
+	const Lanes across = load(b) * s;
+	store(x, load(px) * along + load(qx) * across);
+	store(y, load(py) * along + load(qy) * across);
+	store(z, load(pz) * along + load(qz) * across);
+}
+
+#endif
+
+#pragma endregion
+
+// Mean anomaly of every orbit at 't', wrapped to [-pi, pi] in double so the float solver keeps its precision
+static void meanAnomaliesAt(const OrbitTable& orbits, double t, float* out)
+{
+	const size_t count = orbits.size();
+	for (size_t i = 0; i < count; i++)
+	{
+		double M = orbits.meanAnomalies[i] + orbits.meanMotions[i] * t;
+		out[i] = (float)(M - TwoPi * std::floor(M / TwoPi + 0.5));
+	}
+}
+
+namespace Orbits
+{
+	double DaysSinceJ2000Now()
+	{
+		using namespace std::chrono;
+		double unixSeconds = duration<double>(system_clock::now().time_since_epoch()).count();
+		return (unixSeconds - J2000UnixSeconds) / 86400.0;
+	}
+
+	void CalendarDate(double daysSinceJ2000, int& year, int& month, int& day)
+	{
+		// Meeus, Astronomical Algorithms, chapter 7
+		const double julianDay = Orbits::J2000 + daysSinceJ2000 + 0.5;
+		const double Z = std::floor(julianDay);
+		const double alpha = std::floor((Z - 1867216.25) / 36524.25);
+		const double A = Z + 1.0 + alpha - std::floor(alpha / 4.0);
+		const double B = A + 1524.0;
+		const double C = std::floor((B - 122.1) / 365.25);
+		const double D = std::floor(365.25 * C);
+		const double E = std::floor((B - D) / 30.6001);
+
+		day = (int)(B - D - std::floor(30.6001 * E));
+		month = (int)(E < 14.0 ? E - 1.0 : E - 13.0);
+		year = (int)(month > 2 ? C - 4716.0 : C - 4715.0);
+	}
+
+	void Propagate(const OrbitTable& orbits, double daysSinceJ2000, glm::dvec3* positions)
+	{
+#if defined(ORBITS_AVX) || defined(ORBITS_SSE2)
+		const size_t count = orbits.size();
+		const size_t W = Lanes::Width;
+
+		// Reused between frames, the propagation never allocates once the scene stops growing
+		static thread_local std::vector<float> meanAnomaly, x, y, z;
+		meanAnomaly.resize(count);
+		x.resize(count);
+		y.resize(count);
+		z.resize(count);
+		meanAnomaliesAt(orbits, daysSinceJ2000, meanAnomaly.data());
+
+		size_t i = 0;
+		for (; i + W <= count; i += W)
+		{
+			solveBatch(&meanAnomaly[i], &orbits.eccentricities[i], &orbits.semiMajorAxes[i], &orbits.semiMinorAxes[i],
+					   &orbits.px[i], &orbits.py[i], &orbits.pz[i], &orbits.qx[i], &orbits.qy[i], &orbits.qz[i],
+					   &x[i], &y[i], &z[i]);
+		}
+
+		// The last partial batch runs on a zero padded copy
+		if (i < count)
+		{
+			float tail[13][W] = {};
+			const size_t n = count - i;
+			const std::vector<float>* sources[10] = { &meanAnomaly, &orbits.eccentricities, &orbits.semiMajorAxes, &orbits.semiMinorAxes,
+													  &orbits.px, &orbits.py, &orbits.pz, &orbits.qx, &orbits.qy, &orbits.qz };
+			for (int array = 0; array < 10; array++)
+				std::copy(sources[array]->begin() + i, sources[array]->begin() + i + n, tail[array]);
+
+			solveBatch(tail[0], tail[1], tail[2], tail[3], tail[4], tail[5], tail[6], tail[7], tail[8], tail[9], tail[10], tail[11], tail[12]);
+			std::copy(tail[10], tail[10] + n, &x[i]);
+			std::copy(tail[11], tail[11] + n, &y[i]);
+			std::copy(tail[12], tail[12] + n, &z[i]);
+		}
+
+		for (size_t orbit = 0; orbit < count; orbit++)
+			positions[orbits.bodies[orbit]] = glm::dvec3(x[orbit], y[orbit], z[orbit]);
+#else
+		PropagateScalar(orbits, daysSinceJ2000, positions);
+#endif
+	}
+
+	void PropagateScalar(const OrbitTable& orbits, double daysSinceJ2000, glm::dvec3* positions)
+	{
+		for (size_t i = 0; i < orbits.size(); i++)
+		{
+			double M = orbits.meanAnomalies[i] + orbits.meanMotions[i] * daysSinceJ2000;
+			M -= TwoPi * std::floor(M / TwoPi + 0.5);
+			const double e = orbits.eccentricities[i];
+
+			double E = M + (M < 0.0 ? -0.85 : 0.85) * e;
+			for (int iteration = 0; iteration < 50; iteration++)
+			{
+				double step = (E - e * std::sin(E) - M) / (1.0 - e * std::cos(E));
+				E -= step;
+				if (std::abs(step) < 1e-12)
+					break;
+			}
+
+			const double along = orbits.semiMajorAxes[i] * (std::cos(E) - e);
+			const double across = orbits.semiMinorAxes[i] * std::sin(E);
+			positions[orbits.bodies[i]] = glm::dvec3(
+				orbits.px[i] * along + orbits.qx[i] * across,
+				orbits.py[i] * along + orbits.qy[i] * across,
+				orbits.pz[i] * along + orbits.qz[i] * across);
+		}
+	}
+
+	void StateVector(const OrbitTable& orbits, size_t orbit, double daysSinceJ2000, glm::dvec3& position, glm::dvec3& velocity)
+	{
+		double M = orbits.meanAnomalies[orbit] + orbits.meanMotions[orbit] * daysSinceJ2000;
+		M -= TwoPi * std::floor(M / TwoPi + 0.5);
+		const double e = orbits.eccentricities[orbit];
+
+		double E = M + (M < 0.0 ? -0.85 : 0.85) * e;
+		for (int iteration = 0; iteration < 50; iteration++)
+		{
+			double step = (E - e * std::sin(E) - M) / (1.0 - e * std::cos(E));
+			E -= step;
+			if (std::abs(step) < 1e-12)
+				break;
+		}
+
+		const glm::dvec3 p(orbits.px[orbit], orbits.py[orbit], orbits.pz[orbit]);
+		const glm::dvec3 q(orbits.qx[orbit], orbits.qy[orbit], orbits.qz[orbit]);
+		const double a = orbits.semiMajorAxes[orbit], b = orbits.semiMinorAxes[orbit];
+		const double s = std::sin(E), c = std::cos(E);
+		position = p * (a * (c - e)) + q * (b * s);
+
+		// dE/dt = n / (1 - e cos E)
+		const double rate = orbits.meanMotions[orbit] / (1.0 - e * c);
+		velocity = (p * (-a * s) + q * (b * c)) * rate;
+	}
+
+	const char* SimdPath()
+	{
+#if defined(ORBITS_AVX)
+		return "AVX";
+#elif defined(ORBITS_SSE2)
+		return "SSE2";
+#else
+		return "Scalar";
+#endif
+	}
+}
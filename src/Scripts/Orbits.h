@@ -0,0 +1,73 @@
+#ifndef ORBITS_H
+#define ORBITS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../../vendor/glm/glm.hpp"
+
+// Classic heliocentric orbital elements, in the form JPL's "Approximate Positions of the Planets" tables use.
+// Angles are in degrees and refer to the J2000 ecliptic and equinox.
+struct OrbitalElements
+{
+	// In AU
+	double semiMajorAxis = 1.0;
+	double eccentricity = 0.0;
+	double inclination = 0.0;
+	// Mean longitude at J2000
+	double meanLongitude = 0.0;
+	double longitudeOfPerihelion = 0.0;
+	double longitudeOfAscendingNode = 0.0;
+	// Degrees per Julian century, 0 derives it from the semi-major axis with Kepler's third law
+	double meanLongitudeRate = 0.0;
+};
+
+// Every orbit of the scene as a structure of arrays, orbit 'i' is element 'i' of every array.
+// The elements are pre-digested into what the solver needs per frame: the ellipse axes and
+// the orientation of the orbit as two unit vectors in render space.
+struct OrbitTable
+{
+	// Body each orbit moves, index into the BodyTable
+	std::vector<uint32_t> bodies;
+	// Mean anomaly at J2000 in radians and mean motion in radians per day, double so years of simulated time don't drift
+	std::vector<double> meanAnomalies, meanMotions;
+	std::vector<float> eccentricities;
+	// Semi-major and semi-minor axis in scene units
+	std::vector<float> semiMajorAxes, semiMinorAxes;
+	// Direction of the periapsis (P) and the direction 90 degrees further along the orbit (Q), in render space
+	std::vector<float> px, py, pz, qx, qy, qz;
+
+	size_t size() const { return bodies.size(); }
+	// Appends the orbit of 'body'
+	void Add(uint32_t body, const OrbitalElements& elements);
+};
+
+namespace Orbits
+{
+	// Scene units are 1,000,000 km
+	const double SceneUnitsPerAU = 149.597870700;
+	// Julian date of the J2000 epoch, 2000-01-01 12:00 TT
+	const double J2000 = 2451545.0;
+
+	// Days since J2000 right now, from the system clock
+	double DaysSinceJ2000Now();
+	// Gregorian calendar date (UTC, ignoring the TT offset) 'daysSinceJ2000' days after J2000
+	void CalendarDate(double daysSinceJ2000, int& year, int& month, int& day);
+
+	// Solves Kepler's equation for every orbit at 'daysSinceJ2000' and writes the positions (render space,
+	// scene units, relative to the Sun) to positions[orbits.bodies[i]]. Runs 8 or 4 orbits at once with AVX or SSE2,
+	// in single precision, so positions are good to about 1e-7 of the orbit's size.
+	void Propagate(const OrbitTable& orbits, double daysSinceJ2000, glm::dvec3* positions);
+	// Same result one orbit at a time in double precision with the standard library's sin/cos, the reference for
+	// the vectorized path and precise enough to fly up to a body at real scale
+	void PropagateScalar(const OrbitTable& orbits, double daysSinceJ2000, glm::dvec3* positions);
+
+	// Position (render space, scene units, relative to the Sun) and velocity (scene units per day) of orbit 'orbit'
+	// 'daysSinceJ2000' days after J2000, in double precision. The starting state of an integrated simulation.
+	void StateVector(const OrbitTable& orbits, size_t orbit, double daysSinceJ2000, glm::dvec3& position, glm::dvec3& velocity);
+
+	// Instruction set Propagate was built with: "AVX", "SSE2" or "Scalar"
+	const char* SimdPath();
+}
+
+#endif
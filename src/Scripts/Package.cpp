@@ -0,0 +1,167 @@
+#include "Package.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#pragma region Mapped File
+
+std::shared_ptr<MappedFile> MappedFile::Open(const char* file)
+{
+	std::shared_ptr<MappedFile> mapped(new MappedFile());
+
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return nullptr;
+	mapped->m_File = handle;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0)
+		return nullptr;
+
+	mapped->m_Mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapped->m_Mapping)
+		return nullptr;
+
+	mapped->m_Data = static_cast<const unsigned char*>(MapViewOfFile(mapped->m_Mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!mapped->m_Data)
+		return nullptr;
+	mapped->m_Size = (size_t)size.QuadPart;
+#else
+	int descriptor = open(file, O_RDONLY);
+	if (descriptor < 0)
+		return nullptr;
+
+	struct stat info;
+	if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+	{
+		close(descriptor);
+		return nullptr;
+	}
+
+	void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	// The mapping stays valid after the descriptor is closed
+	close(descriptor);
+	if (data == MAP_FAILED)
+		return nullptr;
+
+	// Everything is uploaded front to back soon after, let the kernel start reading ahead now
+	madvise(data, (size_t)info.st_size, MADV_WILLNEED);
+
+	mapped->m_Data = static_cast<const unsigned char*>(data);
+	mapped->m_Size = (size_t)info.st_size;
+#endif
+
+	return mapped;
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	if (m_Data)
+		UnmapViewOfFile(m_Data);
+	if (m_Mapping)
+		CloseHandle(m_Mapping);
+	if (m_File)
+		CloseHandle(m_File);
+#else
+	if (m_Data)
+		munmap(const_cast<unsigned char*>(m_Data), m_Size);
+#endif
+}
+
+#pragma endregion
+
+#pragma region Package Reader
+
+PackageReader::PackageReader(const char* file) : m_Path(file)
+{
+	m_File = MappedFile::Open(file);
+	if (!m_File)
+		throw std::runtime_error("ERROR::PACKAGE::FILE_NOT_READ " + m_Path);
+
+	const size_t size = m_File->size();
+	auto fits = [size](uint64_t offset, uint64_t bytes) { return offset <= size && bytes <= size - offset; };
+
+	if (!fits(0, sizeof(Package::Header)))
+		throw std::runtime_error("ERROR::PACKAGE::TRUNCATED " + m_Path);
+
+	m_Header = reinterpret_cast<const Package::Header*>(m_File->data());
+	if (m_Header->magic != Package::Magic)
+		throw std::runtime_error("ERROR::PACKAGE::NOT_A_PACKAGE " + m_Path);
+	if (m_Header->version != Package::Version)
+		throw std::runtime_error("ERROR::PACKAGE::VERSION_MISMATCH " + m_Path);
+
+	if (!fits(m_Header->meshTableOffset, (uint64_t)m_Header->meshCount * sizeof(Package::MeshRecord)) ||
+		!fits(m_Header->imageTableOffset, (uint64_t)m_Header->imageCount * sizeof(Package::ImageRecord)))
+		throw std::runtime_error("ERROR::PACKAGE::TRUNCATED " + m_Path);
+
+	m_Meshes = reinterpret_cast<const Package::MeshRecord*>(m_File->data() + m_Header->meshTableOffset);
+	m_Images = reinterpret_cast<const Package::ImageRecord*>(m_File->data() + m_Header->imageTableOffset);
+
+	// Check every blob once here so nothing downstream has to
+	for (uint32_t i = 0; i < m_Header->meshCount; i++)
+	{
+		const Package::MeshRecord& mesh = m_Meshes[i];
+		if (!fits(mesh.vertexOffset, (uint64_t)mesh.vertexCount * sizeof(Vertex)) ||
+			!fits(mesh.indexOffset, (uint64_t)mesh.indexCount * sizeof(uint32_t)))
+			throw std::runtime_error("ERROR::PACKAGE::TRUNCATED " + m_Path);
+
+		for (int32_t image : mesh.images)
+			if (image < -1 || image >= (int32_t)m_Header->imageCount)
+				throw std::runtime_error("ERROR::PACKAGE::BAD_IMAGE_INDEX " + m_Path);
+	}
+
+	for (uint32_t i = 0; i < m_Header->imageCount; i++)
+	{
+		const Package::ImageRecord& image = m_Images[i];
+		const BlockFormat format = (BlockFormat)image.format;
+		if (image.levelCount > Package::MaxLevels || (format != BlockFormat::None && format != BlockFormat::BC1 && format != BlockFormat::BC3 &&
+			format != BlockFormat::BC4 && format != BlockFormat::BC5 && format != BlockFormat::BC7))
+			throw std::runtime_error("ERROR::PACKAGE::BAD_IMAGE " + m_Path);
+
+		for (uint32_t level = 0; level < image.levelCount; level++)
+		{
+			uint64_t width = std::max(1u, image.width >> level);
+			uint64_t height = std::max(1u, image.height >> level);
+			uint64_t expected = format == BlockFormat::None ? width * height * image.channels : BlockCompression::LevelSize(format, (int)width, (int)height);
+			if (image.levelSizes[level] != expected || !fits(image.levelOffsets[level], image.levelSizes[level]))
+				throw std::runtime_error("ERROR::PACKAGE::BAD_IMAGE " + m_Path);
+		}
+	}
+}
+
+TextureData PackageReader::image(unsigned int index, unsigned int firstLevel) const
+{
+	const Package::ImageRecord& record = m_Images[index];
+
+	TextureData data;
+	if (firstLevel >= record.levelCount)
+		return data;
+
+	data.width = (int)std::max(1u, record.width >> firstLevel);
+	data.height = (int)std::max(1u, record.height >> firstLevel);
+	data.channels = (int)record.channels;
+	data.compression = (BlockFormat)record.format;
+	for (uint32_t level = firstLevel; level < record.levelCount; level++)
+		data.levelSizes.push_back((size_t)record.levelSizes[level]);
+	// Shares ownership of the mapping, the pixels stay valid for as long as the texture data is around
+	data.pixels = std::shared_ptr<void>(m_File, const_cast<unsigned char*>(m_File->data() + record.levelOffsets[firstLevel]));
+	for (uint32_t level = firstLevel + 1; level < record.levelCount; level++)
+		data.levels.push_back(m_File->data() + record.levelOffsets[level]);
+
+	return data;
+}
+
+#pragma endregion
@@ -0,0 +1,122 @@
+#ifndef PACKAGE_H
+#define PACKAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Mesh.h"
+
+// A model baked offline by the AssetBaker tool into a single binary file (.pack).
+// It holds the interleaved vertices, 32 bit indices, material records and the pixels of every image
+// with its whole mip chain, raw or block compressed, laid out so the runtime can map the file and upload straight out of it.
+// All values are little endian and every blob starts on a 16 byte boundary.
+namespace Package
+{
+	const uint32_t Magic = 0x4B505353; // "SSPK"
+	const uint32_t Version = 2;
+	const uint32_t Alignment = 16;
+	const uint32_t MaxLevels = 16;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t meshCount;
+		uint32_t imageCount;
+		// MeshRecord[meshCount]
+		uint64_t meshTableOffset;
+		// ImageRecord[imageCount]
+		uint64_t imageTableOffset;
+	};
+
+	struct MeshRecord
+	{
+		float matrix[16];
+		float metallicFactor;
+		float roughnessFactor;
+		// Image used by each texture slot (BaseColor, MetallicRoughness, Emissive, Normal), -1 if the slot is empty
+		int32_t images[4];
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		// Vertex[vertexCount]
+		uint64_t vertexOffset;
+		// uint32_t[indexCount]
+		uint64_t indexOffset;
+	};
+
+	struct ImageRecord
+	{
+		uint32_t width;
+		uint32_t height;
+		// Channels the pixels decode to
+		uint32_t channels;
+		// Level 0 is the full image, every further level halves it down to 1x1. 0 if the image failed to bake.
+		uint32_t levelCount;
+		// BlockFormat of every level, None if they're raw pixels
+		uint32_t format;
+		uint32_t reserved;
+		uint64_t levelOffsets[MaxLevels];
+		uint64_t levelSizes[MaxLevels];
+	};
+
+	// Offset 'offset' rounded up to the next blob boundary
+	inline uint64_t align(uint64_t offset) { return (offset + Alignment - 1) & ~uint64_t(Alignment - 1); }
+}
+
+// A read-only memory mapping of a whole file, unmapped once the last reference goes away.
+class MappedFile
+{
+public:
+	// Maps 'file', returns nullptr if it can't be opened or mapped
+	static std::shared_ptr<MappedFile> Open(const char* file);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const unsigned char* data() const { return m_Data; }
+	size_t size() const { return m_Size; }
+
+private:
+	MappedFile() = default;
+
+	const unsigned char* m_Data = nullptr;
+	size_t m_Size = 0;
+#ifdef _WIN32
+	void* m_File = nullptr;
+	void* m_Mapping = nullptr;
+#endif
+};
+
+// A mapped package whose tables have been checked against the size of the file.
+class PackageReader
+{
+public:
+	// Maps and validates 'file', throws std::runtime_error if it isn't a package this build can read
+	explicit PackageReader(const char* file);
+
+	uint32_t meshCount() const { return m_Header->meshCount; }
+	uint32_t imageCount() const { return m_Header->imageCount; }
+
+	const Package::MeshRecord& mesh(unsigned int index) const { return m_Meshes[index]; }
+	const Vertex* vertices(const Package::MeshRecord& mesh) const { return reinterpret_cast<const Vertex*>(m_File->data() + mesh.vertexOffset); }
+	const uint32_t* indices(const Package::MeshRecord& mesh) const { return reinterpret_cast<const uint32_t*>(m_File->data() + mesh.indexOffset); }
+
+	// Pixels and mip chain of 'index' pointing into the mapping, which they keep alive. Invalid if the image didn't bake.
+	// A 'firstLevel' above 0 leaves out the larger levels, the data then describes a smaller image starting at that level.
+	TextureData image(unsigned int index, unsigned int firstLevel = 0) const;
+	const Package::ImageRecord& imageRecord(unsigned int index) const { return m_Images[index]; }
+
+	const std::string& path() const { return m_Path; }
+
+private:
+	std::shared_ptr<MappedFile> m_File;
+	std::string m_Path;
+	const Package::Header* m_Header = nullptr;
+	const Package::MeshRecord* m_Meshes = nullptr;
+	const Package::ImageRecord* m_Images = nullptr;
+};
+
+#endif
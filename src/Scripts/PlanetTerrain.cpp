@@ -0,0 +1,373 @@
+#include "PlanetTerrain.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../../vendor/glm/gtc/constants.hpp"
+
+// Each face's normal and the directions its s and t coordinates run in, s x t points out of the face
+static const glm::dvec3 s_FaceAxes[6][3] =
+{
+	{ glm::dvec3( 1, 0, 0), glm::dvec3(0, 0, -1), glm::dvec3(0, 1,  0) },
+	{ glm::dvec3(-1, 0, 0), glm::dvec3(0, 0,  1), glm::dvec3(0, 1,  0) },
+	{ glm::dvec3( 0, 1, 0), glm::dvec3(1, 0,  0), glm::dvec3(0, 0, -1) },
+	{ glm::dvec3( 0,-1, 0), glm::dvec3(1, 0,  0), glm::dvec3(0, 0,  1) },
+	{ glm::dvec3( 0, 0, 1), glm::dvec3(1, 0,  0), glm::dvec3(0, 1,  0) },
+	{ glm::dvec3( 0, 0,-1), glm::dvec3(-1, 0, 0), glm::dvec3(0, 1,  0) }
+};
+
+PlanetTerrain::PlanetTerrain(JobSystem& jobs, double radius, double heightScale) : m_Jobs(jobs), m_Radius(radius), m_HeightScale(heightScale)
+{
+	// The geometry pass treats clockwise as front facing, seen from outside the grid runs counter clockwise in s, t
+	const GLuint G = (GLuint)GridSize;
+	for (GLuint j = 0; j + 1 < G; j++)
+		for (GLuint i = 0; i + 1 < G; i++)
+		{
+			const GLuint a = j * G + i, b = a + 1, c = a + G, d = c + 1;
+			m_Indices.insert(m_Indices.end(), { a, c, b, b, c, d });
+		}
+
+	// Skirt vertices follow the grid, one per edge vertex in the order bottom, top, left, right.
+	// Both sides of the skirt are drawn, which side faces the camera depends on the neighbor it covers a crack to.
+	const GLuint skirt = G * G;
+	auto edge = [&](GLuint k, int side) -> GLuint
+	{
+		switch (side)
+		{
+		case 0:  return k;
+		case 1:  return (G - 1) * G + k;
+		case 2:  return k * G;
+		default: return k * G + G - 1;
+		}
+	};
+	for (int side = 0; side < 4; side++)
+		for (GLuint k = 0; k + 1 < G; k++)
+		{
+			const GLuint a = edge(k, side), b = edge(k + 1, side);
+			const GLuint c = skirt + side * G + k, d = c + 1;
+			m_Indices.insert(m_Indices.end(), { a, b, c, b, d, c, a, c, b, b, c, d });
+		}
+}
+
+void PlanetTerrain::SetHeightMap(const TextureData& heightMap)
+{
+	m_HeightMap = heightMap;
+	for (int face = 0; face < 6; face++)
+	{
+		m_Faces[face].reset(new Node());
+		Place(*m_Faces[face], face, 0, 0, 0);
+		Build(*m_Faces[face]);
+	}
+}
+
+bool PlanetTerrain::IsReady() const
+{
+	for (const std::unique_ptr<Node>& face : m_Faces)
+		if (!face || !face->mesh)
+			return false;
+	return true;
+}
+
+void PlanetTerrain::Update(const glm::dvec3& camera, double pixelsPerRadian)
+{
+	m_Camera = camera;
+	m_PixelsPerRadian = pixelsPerRadian;
+
+	//Upload What The Workers Built Since Last Frame.
+	std::vector<Built> built;
+	{
+		std::lock_guard<std::mutex> lock(m_BuiltMutex);
+		built.swap(m_Built);
+	}
+	for (Built& patch : built)
+	{
+		patch.node->mesh.reset(new Mesh(patch.vertices.data(), patch.vertices.size(), m_Indices.data(), m_Indices.size(), Material()));
+		patch.node->building = false;
+		m_BuildsInFlight--;
+	}
+
+	for (std::unique_ptr<Node>& face : m_Faces)
+		if (face)
+			Refine(*face);
+}
+
+void PlanetTerrain::Draw(const MeshUniforms& uniforms, const Material& material, const Frustum& frustum, const glm::dvec3& offset, const glm::mat3& basis)
+{
+	// Largest stretch of the basis, what the patch bounds grow by on screen
+	const float scale = std::sqrt(std::max({ glm::dot(basis[0], basis[0]), glm::dot(basis[1], basis[1]), glm::dot(basis[2], basis[2]) }));
+
+	m_DrawnPatches = 0;
+	for (std::unique_ptr<Node>& face : m_Faces)
+		if (face)
+			DrawNode(*face, uniforms, material, frustum, offset, basis, scale);
+}
+
+void PlanetTerrain::Destroy()
+{
+	if (m_BuildsInFlight > 0)
+		m_Jobs.Wait();
+	{
+		std::lock_guard<std::mutex> lock(m_BuiltMutex);
+		m_Built.clear();
+	}
+	m_BuildsInFlight = 0;
+
+	for (std::unique_ptr<Node>& face : m_Faces)
+	{
+		if (face)
+			DeleteMeshes(*face);
+		face.reset();
+	}
+}
+
+void PlanetTerrain::Place(Node& node, int face, int level, uint32_t x, uint32_t y) const
+{
+	node.face = face;
+	node.level = level;
+	node.x = x;
+	node.y = y;
+
+	const double size = 2.0 / (double)(1u << level);
+	node.center = CubeToSphere(face, -1.0 + (x + 0.5) * size, -1.0 + (y + 0.5) * size) * m_Radius;
+	// The corners are the farthest points of a patch from its middle, heights can lift them further out
+	double radius = 0.0;
+	for (int corner = 0; corner < 4; corner++)
+	{
+		glm::dvec3 point = CubeToSphere(face, -1.0 + (x + (corner & 1)) * size, -1.0 + (y + (corner >> 1)) * size) * m_Radius;
+		radius = std::max(radius, glm::length(point - node.center));
+	}
+	node.radius = radius + m_HeightScale * m_Radius;
+}
+
+bool PlanetTerrain::Build(Node& node)
+{
+	if (m_BuildsInFlight >= MaxBuildsInFlight)
+		return false;
+
+	node.building = true;
+	m_BuildsInFlight++;
+
+	Node* target = &node;
+	TextureData heightMap = m_HeightMap;
+	const double radius = m_Radius, heightScale = m_HeightScale;
+	m_Jobs.Schedule([this, target, heightMap, radius, heightScale]()
+	{
+		std::vector<Vertex> vertices = BuildVertices(*target, heightMap, radius, heightScale);
+		std::lock_guard<std::mutex> lock(m_BuiltMutex);
+		m_Built.push_back({ target, std::move(vertices) });
+	});
+	return true;
+}
+
+void PlanetTerrain::Refine(Node& node)
+{
+	const double pixels = QuadPixels(node);
+	const bool split = node.level < MaxLevel && Visible(node) && pixels > TriangleSize;
+
+	if (split)
+	{
+		if (!node.children[0])
+		{
+			// All four children are created and built together, the node draws until every one of them is ready
+			for (int child = 0; child < 4; child++)
+			{
+				node.children[child].reset(new Node());
+				Place(*node.children[child], node.face, node.level + 1, node.x * 2 + (child & 1), node.y * 2 + (child >> 1));
+			}
+		}
+		for (std::unique_ptr<Node>& child : node.children)
+		{
+			if (!child->mesh && !child->building && !Build(*child))
+				continue;
+			if (child->mesh)
+				Refine(*child);
+		}
+	}
+	else if (node.children[0] && (pixels < TriangleSize * 0.5 || !Visible(node)) && !Building(node))
+	{
+		// Below half the split size, so a camera hovering at the threshold doesn't make patches come and go every frame
+		for (std::unique_ptr<Node>& child : node.children)
+		{
+			DeleteMeshes(*child);
+			child.reset();
+		}
+	}
+	else if (node.children[0])
+	{
+		for (std::unique_ptr<Node>& child : node.children)
+			if (child->mesh)
+				Refine(*child);
+	}
+}
+
+void PlanetTerrain::DrawNode(Node& node, const MeshUniforms& uniforms, const Material& material, const Frustum& frustum, const glm::dvec3& offset, const glm::mat3& basis, float scale)
+{
+	// Only the short hop from the camera to the patch reaches the GPU, in double until then
+	const glm::dvec3 translation = offset + glm::dmat3(basis) * node.center;
+	if (!Visible(node) || !frustum.Intersects(glm::vec3(translation), (float)node.radius * scale))
+		return;
+
+	bool childrenReady = node.children[0] != nullptr;
+	for (int child = 0; child < 4 && childrenReady; child++)
+		childrenReady = node.children[child]->mesh != nullptr;
+
+	if (childrenReady)
+	{
+		for (std::unique_ptr<Node>& child : node.children)
+			DrawNode(*child, uniforms, material, frustum, offset, basis, scale);
+		return;
+	}
+	if (!node.mesh)
+		return;
+
+	glm::mat4 matrix(basis);
+	matrix[3] = glm::vec4(glm::vec3(translation), 1.0f);
+
+	node.mesh->material = material;
+	node.mesh->Draw(uniforms, matrix);
+	m_DrawnPatches++;
+}
+
+bool PlanetTerrain::Visible(const Node& node) const
+{
+	// Past the horizon of a smooth sphere of the base radius nothing of the patch can show, heights only add on top
+	const double distance = glm::length(m_Camera);
+	if (distance <= m_Radius * (1.0 + m_HeightScale))
+		return true;
+
+	const double horizon = std::acos(m_Radius / distance);
+	const double angle = std::acos(std::clamp(glm::dot(m_Camera / distance, glm::normalize(node.center)), -1.0, 1.0));
+	return angle <= horizon + std::asin(std::min(1.0, node.radius / m_Radius)) + std::acos(m_Radius / (m_Radius * (1.0 + m_HeightScale)));
+}
+
+double PlanetTerrain::QuadPixels(const Node& node) const
+{
+	const double quad = m_Radius * glm::half_pi<double>() / (double)(1u << node.level) / (GridSize - 1);
+	const double distance = std::max(glm::length(m_Camera - node.center) - node.radius, m_Radius * 1e-9);
+	return quad / distance * m_PixelsPerRadian;
+}
+
+bool PlanetTerrain::Building(const Node& node)
+{
+	if (node.building)
+		return true;
+	for (const std::unique_ptr<Node>& child : node.children)
+		if (child && Building(*child))
+			return true;
+	return false;
+}
+
+void PlanetTerrain::DeleteMeshes(Node& node)
+{
+	if (node.mesh)
+	{
+		node.mesh->Delete();
+		node.mesh.reset();
+	}
+	for (std::unique_ptr<Node>& child : node.children)
+		if (child)
+			DeleteMeshes(*child);
+}
+
+float PlanetTerrain::SampleHeight(const TextureData& heightMap, double u, double v)
+{
+	// Decoded bottom row first, v = 0 is the south pole
+	const double x = (u - std::floor(u)) * heightMap.width - 0.5;
+	const double y = std::clamp(v, 0.0, 1.0) * (heightMap.height - 1);
+	const int x0 = (int)std::floor(x), y0 = (int)y;
+	const int y1 = std::min(y0 + 1, heightMap.height - 1);
+	const double fx = x - x0, fy = y - y0;
+
+	const unsigned char* pixels = static_cast<const unsigned char*>(heightMap.pixels.get());
+	auto texel = [&](int px, int py)
+	{
+		px = (px % heightMap.width + heightMap.width) % heightMap.width;
+		return pixels[((size_t)py * heightMap.width + px) * heightMap.channels] / 255.0;
+	};
+	const double bottom = texel(x0, y0) * (1.0 - fx) + texel(x0 + 1, y0) * fx;
+	const double top = texel(x0, y1) * (1.0 - fx) + texel(x0 + 1, y1) * fx;
+	return (float)(bottom * (1.0 - fy) + top * fy);
+}
+
+std::vector<Vertex> PlanetTerrain::BuildVertices(const Node& node, const TextureData& heightMap, double radius, double heightScale)
+{
+	const int G = GridSize;
+	const double size = 2.0 / (double)(1u << node.level);
+	const double step = size / (G - 1);
+	const double s0 = -1.0 + node.x * size, t0 = -1.0 + node.y * size;
+
+	// Grid with a one vertex border, so the edge normals see the neighboring patch's heights too
+	const int B = G + 2;
+	std::vector<glm::dvec3> points((size_t)B * B);
+	std::vector<glm::dvec2> texCoords((size_t)B * B);
+	for (int j = 0; j < B; j++)
+		for (int i = 0; i < B; i++)
+		{
+			glm::dvec3 direction = CubeToSphere(node.face, s0 + (i - 1) * step, t0 + (j - 1) * step);
+			// Equirectangular, +Y is north
+			double u = 0.5 + std::atan2(direction.x, direction.z) / glm::two_pi<double>();
+			double v = 0.5 + std::asin(std::clamp(direction.y, -1.0, 1.0)) / glm::pi<double>();
+			double height = heightMap.valid() ? SampleHeight(heightMap, u, v) : 0.0;
+			points[(size_t)j * B + i] = direction * radius * (1.0 + heightScale * height);
+			texCoords[(size_t)j * B + i] = glm::dvec2(u, v);
+		}
+
+	// A patch crossing the date line would wrap its u backwards across the whole texture, keep it continuous instead
+	double minU = 1.0, maxU = 0.0;
+	for (const glm::dvec2& uv : texCoords)
+	{
+		minU = std::min(minU, uv.x);
+		maxU = std::max(maxU, uv.x);
+	}
+	if (maxU - minU > 0.5)
+		for (glm::dvec2& uv : texCoords)
+			if (uv.x < 0.5)
+				uv.x += 1.0;
+
+	std::vector<Vertex> vertices((size_t)G * G + 4 * (size_t)G);
+	for (int j = 0; j < G; j++)
+		for (int i = 0; i < G; i++)
+		{
+			const size_t p = (size_t)(j + 1) * B + (i + 1);
+			glm::dvec3 normal = glm::normalize(glm::cross(points[p + 1] - points[p - 1], points[p + B] - points[p - B]));
+			glm::dvec3 up = glm::normalize(points[p]);
+			if (glm::dot(normal, up) < 0.0)
+				normal = -normal;
+			// East, where u grows. Undefined at the poles, any direction along the surface does there.
+			glm::dvec3 east(up.z, 0.0, -up.x);
+			east = glm::length(east) > 1e-9 ? glm::normalize(east) : glm::dvec3(1.0, 0.0, 0.0);
+
+			Vertex& vertex = vertices[(size_t)j * G + i];
+			vertex.Position = glm::vec3(points[p] - node.center);
+			vertex.Normal = glm::vec3(normal);
+			vertex.Tangent = glm::vec3(east);
+			// Model.vs turns the coordinates by a quarter, hand it (-v, u) so it ends up with (u, v)
+			vertex.TexCoord = glm::vec2((float)-texCoords[p].y, (float)texCoords[p].x);
+		}
+
+	// Skirts hang a few quads down below each edge, deep enough to cover the gap to a coarser neighbor
+	const double depth = radius * glm::half_pi<double>() / (double)(1u << node.level) / (G - 1) * 4.0;
+	for (int side = 0; side < 4; side++)
+		for (int k = 0; k < G; k++)
+		{
+			int i = side == 0 || side == 1 ? k : (side == 2 ? 0 : G - 1);
+			int j = side == 2 || side == 3 ? k : (side == 0 ? 0 : G - 1);
+			Vertex vertex = vertices[(size_t)j * G + i];
+			glm::dvec3 point = glm::dvec3(vertex.Position) + node.center;
+			point -= glm::normalize(point) * depth;
+			vertex.Position = glm::vec3(point - node.center);
+			vertices[(size_t)G * G + side * G + k] = vertex;
+		}
+
+	return vertices;
+}
+
+glm::dvec3 PlanetTerrain::CubeToSphere(int face, double s, double t)
+{
+	const glm::dvec3 p = s_FaceAxes[face][0] + s * s_FaceAxes[face][1] + t * s_FaceAxes[face][2];
+	// Spreads the points more evenly than normalizing would, quads near the cube's corners don't shrink as much
+	const glm::dvec3 q = p * p;
+	return glm::normalize(glm::dvec3(p.x * std::sqrt(1.0 - q.y / 2.0 - q.z / 2.0 + q.y * q.z / 3.0),
+									 p.y * std::sqrt(1.0 - q.z / 2.0 - q.x / 2.0 + q.z * q.x / 3.0),
+									 p.z * std::sqrt(1.0 - q.x / 2.0 - q.y / 2.0 + q.x * q.y / 3.0)));
+}
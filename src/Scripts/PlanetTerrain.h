@@ -0,0 +1,115 @@
+#ifndef PLANET_TERRAIN_H
+#define PLANET_TERRAIN_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Culling.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+
+// A planet drawn as a cube projected onto a sphere, each cube face a quadtree of patches displaced by a height map.
+// Patches split while their quads cover more than TriangleSize pixels on screen and merge once they cover less than half,
+// so the triangle count follows the camera from a dot on the screen down to the surface.
+// Patches are built on the job system and uploaded on the GL thread, a node keeps drawing until all four children are ready.
+// Drawn with Model.vs / Model.fs, the body's model supplies the material.
+class PlanetTerrain
+{
+public:
+	// Vertices along a patch edge
+	static const int GridSize = 33;
+	// Deepest split, about 5 m quads on an Earth sized planet
+	static const int MaxLevel = 16;
+	// Patch builds running at once
+	static const unsigned int MaxBuildsInFlight = 32;
+
+	// 'radius' in model units (5 for the planet models), heights add up to 'heightScale' * radius on top. Builds on 'jobs'.
+	PlanetTerrain(JobSystem& jobs, double radius, double heightScale);
+	~PlanetTerrain() { Destroy(); }
+
+	PlanetTerrain(const PlanetTerrain&) = delete;
+	PlanetTerrain& operator=(const PlanetTerrain&) = delete;
+
+	// An equirectangular image whose first channel is the height, north up. Nothing is built before it arrives. GL thread only.
+	void SetHeightMap(const TextureData& heightMap);
+	// True once the six root patches are on the GPU
+	bool IsReady() const;
+
+	// Splits and merges patches for a camera at 'camera' in the planet's own space (before the body's scale and rotation),
+	// 'pixelsPerRadian' converts angles into pixels on screen. Uploads finished patches. GL thread only.
+	void Update(const glm::dvec3& camera, double pixelsPerRadian);
+	// Draws the patches facing the camera of the last Update and inside 'frustum'. 'offset' is the body's position relative
+	// to the camera and 'basis' its rotation and scale, patches are placed around their own centers in double precision.
+	void Draw(const MeshUniforms& uniforms, const Material& material, const Frustum& frustum, const glm::dvec3& offset, const glm::mat3& basis);
+
+	// Waits for patch builds and deletes every patch, call while the context is still alive
+	void Destroy();
+
+	// Patches the last Draw drew
+	unsigned int DrawnPatches() const { return m_DrawnPatches; }
+	unsigned int BuildsInFlight() const { return m_BuildsInFlight; }
+
+	// Largest quad size in pixels before a patch splits
+	float TriangleSize = 8.0f;
+
+private:
+	struct Node
+	{
+		int face = 0, level = 0;
+		uint32_t x = 0, y = 0;
+		// Point on the undisplaced sphere under the patch's middle, the patch's vertices are relative to it
+		glm::dvec3 center;
+		// Bounding sphere around 'center', displacement included
+		double radius = 0.0;
+		std::unique_ptr<Node> children[4];
+		std::unique_ptr<Mesh> mesh;
+		bool building = false;
+	};
+
+	// A patch a build job finished, waiting for its upload
+	struct Built
+	{
+		Node* node;
+		std::vector<Vertex> vertices;
+	};
+
+	// Fills in the face, level, position and bounds of 'node'
+	void Place(Node& node, int face, int level, uint32_t x, uint32_t y) const;
+	// Queues a build job for 'node' if there is room, returns false if it has to wait
+	bool Build(Node& node);
+	void Refine(Node& node);
+	void DrawNode(Node& node, const MeshUniforms& uniforms, const Material& material, const Frustum& frustum, const glm::dvec3& offset, const glm::mat3& basis, float scale);
+	// True if part of 'node' may be above the camera's horizon
+	bool Visible(const Node& node) const;
+	// Size of one of the node's quads in pixels at its nearest distance to the camera
+	double QuadPixels(const Node& node) const;
+	// True if a build is running anywhere under 'node', it can't be deleted until it finishes
+	static bool Building(const Node& node);
+	static void DeleteMeshes(Node& node);
+
+	// Height map sample in [0, 1] at texture coordinates 'u', 'v', bilinear and wrapping around in 'u'
+	static float SampleHeight(const TextureData& heightMap, double u, double v);
+	// Vertices of 'node', relative to its center: the grid followed by a skirt hanging down from each edge
+	static std::vector<Vertex> BuildVertices(const Node& node, const TextureData& heightMap, double radius, double heightScale);
+	// Maps a point of cube face 'face' to the unit sphere
+	static glm::dvec3 CubeToSphere(int face, double s, double t);
+
+	JobSystem& m_Jobs;
+	double m_Radius, m_HeightScale;
+	TextureData m_HeightMap;
+	std::unique_ptr<Node> m_Faces[6];
+	// Grid and skirt triangles, the same for every patch
+	std::vector<GLuint> m_Indices;
+
+	glm::dvec3 m_Camera = glm::dvec3(0.0);
+	double m_PixelsPerRadian = 1.0;
+
+	std::mutex m_BuiltMutex;
+	std::vector<Built> m_Built;
+	unsigned int m_BuildsInFlight = 0;
+	unsigned int m_DrawnPatches = 0;
+};
+
+#endif
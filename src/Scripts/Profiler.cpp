@@ -0,0 +1,297 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include <json.h>
+#include "../../vendor/imgui/imgui.h"
+
+using json = nlohmann::json;
+
+// Frames the panel averages over
+static const size_t AverageFrames = 60;
+
+void Profiler::Init()
+{
+	GLint bits = 0;
+	glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+	m_GpuTimer = bits > 0;
+	if (!m_GpuTimer)
+		return;
+
+	for (QuerySet& set : m_Sets)
+	{
+		set.queries.resize(2 + 2 * MaxGpuScopes);
+		glGenQueries((GLsizei)set.queries.size(), set.queries.data());
+	}
+}
+
+void Profiler::Destroy()
+{
+	for (QuerySet& set : m_Sets)
+	{
+		if (!set.queries.empty())
+			glDeleteQueries((GLsizei)set.queries.size(), set.queries.data());
+		set = QuerySet();
+	}
+	m_GpuTimer = false;
+	m_History.clear();
+}
+
+double Profiler::Now() const
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Start).count();
+}
+
+void Profiler::BeginFrame()
+{
+	QuerySet& set = m_Sets[m_FrameIndex % FrameLatency];
+	Resolve(set, false);
+
+	set.frame.index = m_FrameIndex;
+	set.frame.scopes.clear();
+	set.frame.gpuBegin = set.frame.gpuEnd = -1.0;
+	m_Stack.clear();
+	m_InFrame = true;
+
+	//Lines The GPU's Clock Up With The CPU's For This Frame, The Two Drift Apart Over a Long Run.
+	set.frame.cpuBegin = Now();
+	if (m_GpuTimer)
+	{
+		GLint64 gpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		set.gpuToCpu = set.frame.cpuBegin * 1e6 - (double)gpuNow;
+		glQueryCounter(set.queries[0], GL_TIMESTAMP);
+	}
+}
+
+void Profiler::EndFrame()
+{
+	if (!m_InFrame)
+		return;
+	while (!m_Stack.empty())
+		End();
+
+	QuerySet& set = m_Sets[m_FrameIndex % FrameLatency];
+	set.frame.cpuEnd = Now();
+	if (m_GpuTimer)
+		glQueryCounter(set.queries[1], GL_TIMESTAMP);
+	set.pending = true;
+	m_InFrame = false;
+	m_FrameIndex++;
+}
+
+void Profiler::Begin(const char* name)
+{
+	if (!m_InFrame)
+		return;
+
+	QuerySet& set = m_Sets[m_FrameIndex % FrameLatency];
+	const size_t index = set.frame.scopes.size();
+	set.frame.scopes.push_back({ name, (int)m_Stack.size(), Now(), 0.0, -1.0, -1.0 });
+	m_Stack.push_back((int)index);
+	if (m_GpuTimer && index < MaxGpuScopes)
+		glQueryCounter(set.queries[2 + 2 * index], GL_TIMESTAMP);
+}
+
+void Profiler::End()
+{
+	if (!m_InFrame || m_Stack.empty())
+		return;
+
+	QuerySet& set = m_Sets[m_FrameIndex % FrameLatency];
+	const size_t index = (size_t)m_Stack.back();
+	m_Stack.pop_back();
+	set.frame.scopes[index].cpuEnd = Now();
+	if (m_GpuTimer && index < MaxGpuScopes)
+		glQueryCounter(set.queries[3 + 2 * index], GL_TIMESTAMP);
+}
+
+void Profiler::Finish()
+{
+	// Oldest first, so the history stays in frame order
+	for (unsigned int i = 0; i < FrameLatency; i++)
+		Resolve(m_Sets[(m_FrameIndex + i) % FrameLatency], true);
+}
+
+void Profiler::Resolve(QuerySet& set, bool wait)
+{
+	if (!set.pending)
+		return;
+	set.pending = false;
+
+	//The Frame's End Query Was Written Last, Once It is Done All Others Are Too.
+	Frame& frame = set.frame;
+	GLint available = 0;
+	if (m_GpuTimer && !wait)
+		glGetQueryObjectiv(set.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (m_GpuTimer && (available || wait))
+	{
+		auto read = [&](size_t query)
+		{
+			GLuint64 time = 0;
+			glGetQueryObjectui64v(set.queries[query], GL_QUERY_RESULT, &time);
+			return ((double)time + set.gpuToCpu) / 1e6;
+		};
+		frame.gpuBegin = read(0);
+		frame.gpuEnd = read(1);
+		for (size_t i = 0; i < std::min<size_t>(frame.scopes.size(), MaxGpuScopes); i++)
+		{
+			frame.scopes[i].gpuBegin = read(2 + 2 * i);
+			frame.scopes[i].gpuEnd = read(3 + 2 * i);
+		}
+	}
+	else if (m_GpuTimer)
+		m_FramesWithoutGpu++;
+
+	m_History.push_back(frame);
+	if (m_History.size() > HistoryFrames)
+		m_History.pop_front();
+}
+
+static ImU32 scopeColor(const char* name)
+{
+	// Same hue for a scope every frame, by its name
+	unsigned int hash = 2166136261u;
+	for (const char* c = name; *c; c++)
+		hash = (hash ^ (unsigned char)*c) * 16777619u;
+	return ImColor::HSV((hash % 360) / 360.0f, 0.55f, 0.75f);
+}
+
+void Profiler::DrawPanel(bool* open, const std::string& tracePath)
+{
+	if (!ImGui::Begin("Profiler", open))
+	{
+		ImGui::End();
+		return;
+	}
+
+	const Frame& last = LastFrame();
+	ImGui::Text("Frame %llu: CPU %.2f ms, GPU %.2f ms", last.index, last.cpuEnd - last.cpuBegin, last.HasGpuTimes() ? last.gpuEnd - last.gpuBegin : 0.0);
+	if (!m_GpuTimer)
+		ImGui::Text("No GPU timestamps on this driver, CPU times only");
+	else if (m_FramesWithoutGpu > 0)
+		ImGui::Text("%llu frame(s) weren't done on the GPU when read back", m_FramesWithoutGpu);
+	if (ImGui::Button("Save Chrome Trace"))
+		WriteChromeTrace(tracePath);
+	ImGui::SameLine();
+	ImGui::TextDisabled("%s", tracePath.c_str());
+
+	//The Last Frame's Scopes, Averaged Over The Frames Before It That Had The Same Scope at The Same Depth.
+	if (ImGui::BeginTable("Scopes", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+	{
+		ImGui::TableSetupColumn("Scope");
+		ImGui::TableSetupColumn("CPU ms", ImGuiTableColumnFlags_WidthFixed, 70.0f);
+		ImGui::TableSetupColumn("GPU ms", ImGuiTableColumnFlags_WidthFixed, 70.0f);
+		ImGui::TableHeadersRow();
+
+		const size_t frames = std::min(m_History.size(), AverageFrames);
+		for (size_t i = 0; i < last.scopes.size(); i++)
+		{
+			const Scope& scope = last.scopes[i];
+			double cpu = 0.0, gpu = 0.0;
+			int cpuCount = 0, gpuCount = 0;
+			for (size_t f = m_History.size() - frames; f < m_History.size(); f++)
+			{
+				for (const Scope& other : m_History[f].scopes)
+				{
+					if (other.name != scope.name || other.depth != scope.depth)
+						continue;
+					cpu += other.CpuMs();
+					cpuCount++;
+					if (other.gpuBegin >= 0.0)
+					{
+						gpu += other.GpuMs();
+						gpuCount++;
+					}
+					break;
+				}
+			}
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::Indent(12.0f * scope.depth + 1.0f);
+			ImGui::TextColored(ImColor(scopeColor(scope.name)), "%s", scope.name);
+			ImGui::Unindent(12.0f * scope.depth + 1.0f);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", cpuCount ? cpu / cpuCount : 0.0);
+			ImGui::TableNextColumn();
+			if (gpuCount)
+				ImGui::Text("%.3f", gpu / gpuCount);
+			else
+				ImGui::TextDisabled("-");
+		}
+		ImGui::EndTable();
+	}
+
+	//The Last Frame as a Flame Graph, The CPU's Scopes on Top & The GPU's Below on The Same Clock.
+	int depth = 1;
+	for (const Scope& scope : last.scopes)
+		depth = std::max(depth, scope.depth + 1);
+	const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+	const float laneHeight = depth * rowHeight;
+	const ImVec2 origin = ImGui::GetCursorScreenPos();
+	const float width = std::max(ImGui::GetContentRegionAvail().x, 100.0f);
+	const float labelWidth = 36.0f;
+	ImGui::Dummy(ImVec2(width, 2.0f * laneHeight + 8.0f));
+
+	const double begin = last.cpuBegin;
+	const double end = std::max(last.cpuEnd, last.HasGpuTimes() ? last.gpuEnd : 0.0);
+	const float scale = end > begin ? (float)((width - labelWidth) / (end - begin)) : 0.0f;
+	ImDrawList* draw = ImGui::GetWindowDrawList();
+	for (int lane = 0; lane < 2; lane++)
+	{
+		const float top = origin.y + lane * (laneHeight + 8.0f);
+		draw->AddText(ImVec2(origin.x, top), ImGui::GetColorU32(ImGuiCol_TextDisabled), lane == 0 ? "CPU" : "GPU");
+		for (const Scope& scope : last.scopes)
+		{
+			const double from = lane == 0 ? scope.cpuBegin : scope.gpuBegin;
+			const double to = lane == 0 ? scope.cpuEnd : scope.gpuEnd;
+			if (from < 0.0)
+				continue;
+
+			const ImVec2 low(origin.x + labelWidth + (float)(from - begin) * scale, top + scope.depth * rowHeight);
+			const ImVec2 high(std::max(low.x + 1.0f, origin.x + labelWidth + (float)(to - begin) * scale), low.y + rowHeight - 1.0f);
+			draw->AddRectFilled(low, high, scopeColor(scope.name));
+			if (high.x - low.x > ImGui::CalcTextSize(scope.name).x + 4.0f)
+				draw->AddText(ImVec2(low.x + 2.0f, low.y + 2.0f), IM_COL32(255, 255, 255, 255), scope.name);
+			if (ImGui::IsMouseHoveringRect(low, high))
+				ImGui::SetTooltip("%s (%s): %.3f ms", scope.name, lane == 0 ? "CPU" : "GPU", to - from);
+		}
+	}
+
+	ImGui::End();
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) const
+{
+	// Complete events in microseconds, one process with the CPU and the GPU as its two threads
+	json events = json::array();
+	const char* threads[2] = { "CPU", "GPU" };
+	for (int tid = 0; tid < 2; tid++)
+		events.push_back({ { "name", "thread_name" }, { "ph", "M" }, { "pid", 1 }, { "tid", tid }, { "args", { { "name", threads[tid] } } } });
+
+	auto event = [&](const char* name, int tid, double from, double to, unsigned long long frame)
+	{
+		events.push_back({ { "name", name }, { "cat", threads[tid] }, { "ph", "X" }, { "pid", 1 }, { "tid", tid },
+						   { "ts", from * 1000.0 }, { "dur", (to - from) * 1000.0 }, { "args", { { "frame", frame } } } });
+	};
+	for (const Frame& frame : m_History)
+	{
+		event("Frame", 0, frame.cpuBegin, frame.cpuEnd, frame.index);
+		if (frame.HasGpuTimes())
+			event("Frame", 1, frame.gpuBegin, frame.gpuEnd, frame.index);
+		for (const Scope& scope : frame.scopes)
+		{
+			event(scope.name, 0, scope.cpuBegin, scope.cpuEnd, frame.index);
+			if (scope.gpuBegin >= 0.0)
+				event(scope.name, 1, scope.gpuBegin, scope.gpuEnd, frame.index);
+		}
+	}
+
+	std::ofstream out(path);
+	if (!out)
+		return false;
+	out << json({ { "traceEvents", events }, { "displayTimeUnit", "ms" } }).dump() << std::endl;
+	return (bool)out;
+}
@@ -0,0 +1,116 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "../../vendor/glad/include/glad.h"
+
+// Times named, nested scopes of every frame on the CPU and the GPU, for finding out what each pass costs.
+// A scope's CPU time comes from the clock between Begin and End. Its GPU time comes from GL_TIMESTAMP queries written at
+// the same two points, which unlike GL_TIME_ELAPSED queries may nest. The queries are double buffered: a frame's results are
+// read when its query set comes around again FrameLatency frames later, and if the GPU isn't done with them by then that
+// frame keeps only its CPU times rather than stalling the next one. GPU times are moved onto the CPU clock, so both line
+// up in the timeline panel and in Chrome traces (chrome://tracing or ui.perfetto.dev). GL thread only.
+class Profiler
+{
+public:
+	// Query sets in flight, a frame's GPU times are read this many frames after it
+	static const unsigned int FrameLatency = 2;
+	// Scopes a frame gets GPU times for, later ones only get CPU times
+	static const unsigned int MaxGpuScopes = 63;
+	// Resolved frames kept for the panel's averages and the trace
+	static const size_t HistoryFrames = 600;
+
+	struct Scope
+	{
+		// Literal passed to Begin, not copied
+		const char* name;
+		// 0 for scopes directly inside the frame
+		int depth;
+		// Milliseconds since Init on the CPU clock, GPU times are negative if the frame has none
+		double cpuBegin, cpuEnd, gpuBegin, gpuEnd;
+
+		double CpuMs() const { return cpuEnd - cpuBegin; }
+		double GpuMs() const { return gpuBegin < 0.0 ? 0.0 : gpuEnd - gpuBegin; }
+	};
+
+	struct Frame
+	{
+		unsigned long long index = 0;
+		double cpuBegin = 0.0, cpuEnd = 0.0, gpuBegin = -1.0, gpuEnd = -1.0;
+		std::vector<Scope> scopes;
+
+		bool HasGpuTimes() const { return gpuBegin >= 0.0; }
+	};
+
+	Profiler() {}
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	// Creates the queries, without timestamp bits on the driver only CPU times are kept
+	void Init();
+	// Deletes the queries, call while the context is still alive
+	void Destroy();
+
+	void BeginFrame();
+	void EndFrame();
+	// Opens a scope inside the innermost open one, 'name' must outlive the profiler (a literal)
+	void Begin(const char* name);
+	// Closes the innermost open scope
+	void End();
+	// Waits for the GPU times of the frames still in flight, before writing a trace at the end of a run
+	void Finish();
+
+	// Newest frame whose times were read back, empty before the first one
+	const Frame& LastFrame() const { return m_History.empty() ? m_Empty : m_History.back(); }
+	// Draws the profiler window: every scope's average times, a timeline of the last frame and a button saving a trace to 'tracePath'
+	void DrawPanel(bool* open, const std::string& tracePath);
+	// Writes the kept frames as a Chrome trace, CPU and GPU as two threads. False if it can't be written.
+	bool WriteChromeTrace(const std::string& path) const;
+
+private:
+	struct QuerySet
+	{
+		// Frame begin & end first, then a begin & end pair per scope
+		std::vector<GLuint> queries;
+		// Offset from the GPU's to the CPU's clock in nanoseconds, taken as the frame began
+		double gpuToCpu = 0.0;
+		bool pending = false;
+		Frame frame;
+	};
+
+	double Now() const;
+	// Adds the frame of 'set' to the history, with its GPU times if they are done or 'wait'
+	void Resolve(QuerySet& set, bool wait);
+
+	bool m_GpuTimer = false;
+	std::chrono::steady_clock::time_point m_Start = std::chrono::steady_clock::now();
+	QuerySet m_Sets[FrameLatency];
+	unsigned long long m_FrameIndex = 0;
+	// Open scopes, indices into the current frame's scopes
+	std::vector<int> m_Stack;
+	bool m_InFrame = false;
+
+	std::deque<Frame> m_History;
+	Frame m_Empty;
+	unsigned long long m_FramesWithoutGpu = 0;
+};
+
+// Times the enclosing block as a scope of 'profiler'
+class ProfileScope
+{
+public:
+	ProfileScope(Profiler& profiler, const char* name) : m_Profiler(profiler) { m_Profiler.Begin(name); }
+	~ProfileScope() { m_Profiler.End(); }
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	Profiler& m_Profiler;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "ProgramCache.h"
+#include "GLExtensions.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// FNV-1a, 64 bit
+static uint64_t hashBytes(uint64_t hash, const void* bytes, size_t count)
+{
+	const unsigned char* data = static_cast<const unsigned char*>(bytes);
+	for (size_t i = 0; i < count; i++)
+		hash = (hash ^ data[i]) * 1099511628211ull;
+	return hash;
+}
+
+// Hashes the length too, so "ab" + "c" and "a" + "bc" differ
+static uint64_t hashString(uint64_t hash, const char* text)
+{
+	const uint64_t length = text ? std::strlen(text) : 0;
+	hash = hashBytes(hash, &length, sizeof(length));
+	return hashBytes(hash, text, (size_t)length);
+}
+
+std::string ProgramCache::File(uint64_t key)
+{
+	// Made on first use, a missing directory only costs a failed save
+	std::error_code error;
+	std::filesystem::create_directories(PROGRAM_CACHE_DIR, error);
+	char name[17];
+	std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+	return std::string(PROGRAM_CACHE_DIR) + "/" + name + ".program";
+}
+
+uint64_t ProgramCache::Key(const std::vector<const std::string*>& sources)
+{
+	uint64_t hash = hashBytes(14695981039346656037ull, &Version, sizeof(Version));
+	const GLenum driver[4] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+	for (GLenum name : driver)
+		hash = hashString(hash, reinterpret_cast<const char*>(glGetString(name)));
+	for (const std::string* source : sources)
+		hash = hashString(hash, source->c_str());
+	return hash;
+}
+
+GLuint ProgramCache::Load(const std::string& file, uint64_t key)
+{
+	if (!GLExtensions::ProgramBinaries)
+		return 0;
+
+	std::ifstream in(file, std::ios::binary);
+	Header header = {};
+	if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+		return 0;
+	if (header.magic != Magic || header.version != Version || header.key != key || header.length == 0)
+		return 0;
+	std::vector<char> binary(header.length);
+	if (!in.read(binary.data(), (std::streamsize)binary.size()))
+		return 0;
+
+	// Drivers turn binaries down after an update even when their version strings stay the same
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+	GLint linked = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked)
+	{
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+void ProgramCache::Retrievable(GLuint program)
+{
+	if (GLExtensions::ProgramBinaries)
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool ProgramCache::Save(GLuint program, const std::string& file, uint64_t key)
+{
+	if (!GLExtensions::ProgramBinaries)
+		return false;
+
+	GLint linked = 0, length = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (!linked || length <= 0)
+		return false;
+
+	Header header = {};
+	header.magic = Magic;
+	header.version = Version;
+	header.key = key;
+	std::vector<char> binary((size_t)length);
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &header.format, binary.data());
+	if (written <= 0)
+		return false;
+	header.length = (uint32_t)written;
+
+	// Through a temporary file, so an interrupted write never leaves a cache behind
+	const std::string temporary = file + ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		if (!out.write(reinterpret_cast<const char*>(&header), sizeof(header)) || !out.write(binary.data(), written))
+		{
+			out.close();
+			std::remove(temporary.c_str());
+			return false;
+		}
+	}
+	// Renaming over an existing file fails on Windows
+	std::remove(file.c_str());
+	return std::rename(temporary.c_str(), file.c_str()) == 0;
+}
@@ -0,0 +1,45 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../../vendor/glad/include/glad.h"
+
+// Linked shader programs saved with glGetProgramBinary to PROGRAM_CACHE_DIR in the build directory, so later launches hand
+// the driver its own binary instead of compiling and linking the GLSL again. A binary is keyed by a hash of all its sources
+// and of the driver's vendor, renderer & version strings and is named after that key, so programs sharing a stage never
+// share a file; one that the driver turns down is compiled again and replaced. Everything here needs
+// GLExtensions::ProgramBinaries and does nothing without it. GL thread only.
+// The file is a Header followed by the binary, little endian.
+namespace ProgramCache
+{
+	const uint32_t Magic = 0x42505353; // "SSPB"
+	const uint32_t Version = 1;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		// Driver specific format glGetProgramBinary returned
+		uint32_t format;
+		// Bytes of the binary following the header
+		uint32_t length;
+	};
+
+	// Hash of 'sources' and the driver they are built by
+	uint64_t Key(const std::vector<const std::string*>& sources);
+	// File the program keyed 'key' is cached in, creates the cache directory if it's missing
+	std::string File(uint64_t key);
+
+	// A linked program loaded from 'file', 0 if it's missing, isn't keyed 'key' or the driver can't load it anymore
+	GLuint Load(const std::string& file, uint64_t key);
+	// Asks the driver to keep the binary of 'program' around, call before linking it
+	void Retrievable(GLuint program);
+	// Saves the binary of the linked 'program' to 'file' under 'key', false if it isn't linked or can't be written
+	bool Save(GLuint program, const std::string& file, uint64_t key);
+}
+
+#endif
@@ -0,0 +1,220 @@
+#include "Scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <json.h>
+#include "../../vendor/glm/gtc/matrix_transform.hpp"
+
+using json = nlohmann::json;
+
+// Scene files give masses in kg
+static const double SolarMassKg = 1.98847e30;
+// Scenes with up to this many orbits are propagated in double precision
+static const size_t PreciseOrbitCount = 64;
+// Lights without a range reach until they give less irradiance than this, well below what shows after exposure
+static const float MinIrradiance = 1e-8f;
+
+static glm::dvec3 readVec3(const json& body, const char* key, glm::dvec3 fallback)
+{
+	if (!body.contains(key))
+		return fallback;
+
+	const json& value = body[key];
+	if (!value.is_array() || value.size() != 3)
+		throw std::invalid_argument(std::string("ERROR::SCENE::BAD_VECTOR ") + key);
+	return glm::dvec3(value[0].get<double>(), value[1].get<double>(), value[2].get<double>());
+}
+
+Scene Scene::Load(const char* file)
+{
+	std::ifstream in(file);
+	if (!in)
+		throw std::invalid_argument(std::string("ERROR::SCENE::FILE_NOT_READ ") + file);
+
+	json JSON = json::parse(in, nullptr, false);
+	if (JSON.is_discarded() || !JSON.contains("bodies") || !JSON["bodies"].is_array())
+		throw std::invalid_argument(std::string("ERROR::SCENE::PARSE_FAILED ") + file);
+
+	// Models are referenced relative to the scene file
+	std::string fileStr = file;
+	std::string directory = fileStr.substr(0, fileStr.find_last_of('/') + 1);
+
+	Scene scene;
+	BodyTable& bodies = scene.bodies;
+	const size_t count = JSON["bodies"].size();
+	bodies.names.reserve(count);
+	bodies.models.reserve(count);
+	bodies.positions.reserve(count);
+	bodies.scales.reserve(count);
+	bodies.rotations.reserve(count);
+	bodies.flags.reserve(count);
+	bodies.masses.reserve(count);
+
+	std::unordered_map<std::string, uint32_t> modelIndices;
+	for (const json& body : JSON["bodies"])
+	{
+		if (!body.contains("name") || !body.contains("model"))
+			throw std::invalid_argument("ERROR::SCENE::BODY_MISSING_NAME_OR_MODEL");
+
+		std::string model = directory + body["model"].get<std::string>();
+		auto it = modelIndices.find(model);
+		if (it == modelIndices.end())
+		{
+			it = modelIndices.emplace(model, (uint32_t)scene.modelPaths.size()).first;
+			scene.modelPaths.push_back(model);
+		}
+
+		uint8_t flags = BodyNone;
+		if (body.value("doubleSided", false))
+			flags |= BodyDoubleSided;
+
+		bodies.names.push_back(body["name"].get<std::string>());
+		bodies.models.push_back(it->second);
+		bodies.positions.push_back(readVec3(body, "position", glm::dvec3(0.0)));
+		bodies.scales.push_back(body.value("scale", 1.0f));
+		bodies.rotations.push_back(glm::vec3(readVec3(body, "rotation", glm::dvec3(0.0))));
+		bodies.flags.push_back(flags);
+		bodies.masses.push_back(body.value("mass", 0.0) / SolarMassKg);
+		if (bodies.masses.back() < 0.0)
+			throw std::invalid_argument("ERROR::SCENE::NEGATIVE_MASS " + bodies.names.back());
+
+		if (body.contains("orbit"))
+		{
+			const json& orbit = body["orbit"];
+			if (!orbit.contains("semiMajorAxis"))
+				throw std::invalid_argument("ERROR::SCENE::ORBIT_MISSING_SEMI_MAJOR_AXIS " + bodies.names.back());
+
+			OrbitalElements elements;
+			elements.semiMajorAxis = orbit["semiMajorAxis"].get<double>();
+			elements.eccentricity = orbit.value("eccentricity", 0.0);
+			elements.inclination = orbit.value("inclination", 0.0);
+			elements.meanLongitude = orbit.value("meanLongitude", 0.0);
+			elements.longitudeOfPerihelion = orbit.value("longitudeOfPerihelion", 0.0);
+			elements.longitudeOfAscendingNode = orbit.value("longitudeOfAscendingNode", 0.0);
+			elements.meanLongitudeRate = orbit.value("meanLongitudeRate", 0.0);
+			if (elements.semiMajorAxis <= 0.0 || elements.eccentricity < 0.0 || elements.eccentricity >= 1.0)
+				throw std::invalid_argument("ERROR::SCENE::ORBIT_NOT_ELLIPTIC " + bodies.names.back());
+
+			scene.orbits.Add((uint32_t)(bodies.size() - 1), elements);
+			bodies.flags.back() |= BodyOrbiting;
+		}
+
+		if (body.contains("terrain"))
+		{
+			const json& terrain = body["terrain"];
+			if (!terrain.contains("heightMap"))
+				throw std::invalid_argument("ERROR::SCENE::TERRAIN_MISSING_HEIGHT_MAP " + bodies.names.back());
+
+			TerrainDesc desc;
+			desc.body = (uint32_t)(bodies.size() - 1);
+			desc.heightMap = directory + terrain["heightMap"].get<std::string>();
+			desc.heightScale = terrain.value("heightScale", 0.0f);
+			desc.radius = terrain.value("radius", 5.0f);
+			if (desc.heightScale < 0.0f || desc.radius <= 0.0f)
+				throw std::invalid_argument("ERROR::SCENE::TERRAIN_BAD_SIZE " + bodies.names.back());
+
+			scene.terrains.push_back(desc);
+			bodies.flags.back() |= BodyTerrain;
+		}
+	}
+
+	if (JSON.contains("lights"))
+	{
+		std::unordered_map<std::string, int32_t> bodyIndices, lightIndices;
+		for (size_t i = 0; i < bodies.size(); i++)
+			bodyIndices.emplace(bodies.names[i], (int32_t)i);
+
+		for (const json& light : JSON["lights"])
+		{
+			LightDesc desc;
+			desc.name = light.value("name", std::string("Light ") + std::to_string(scene.lights.size()));
+			if (light.contains("body"))
+			{
+				auto it = bodyIndices.find(light["body"].get<std::string>());
+				if (it == bodyIndices.end())
+					throw std::invalid_argument("ERROR::SCENE::LIGHT_UNKNOWN_BODY " + desc.name);
+				desc.body = it->second;
+			}
+			desc.position = readVec3(light, "position", glm::dvec3(0.0));
+			desc.color = glm::vec3(readVec3(light, "color", glm::dvec3(1.0)));
+			desc.intensity = light.value("intensity", 1.0f);
+			desc.range = light.value("range", 0.0f);
+			desc.albedo = light.value("albedo", 0.3f);
+			if (light.contains("reflects"))
+			{
+				// Only lights shining by themselves are reflected, planet-shine of planet-shine is too faint to bother
+				auto it = lightIndices.find(light["reflects"].get<std::string>());
+				if (it == lightIndices.end() || scene.lights[it->second].reflects >= 0 || desc.body < 0)
+					throw std::invalid_argument("ERROR::SCENE::LIGHT_BAD_REFLECTION " + desc.name);
+				desc.reflects = it->second;
+			}
+			if (desc.intensity < 0.0f || desc.range < 0.0f || desc.albedo < 0.0f)
+				throw std::invalid_argument("ERROR::SCENE::LIGHT_NEGATIVE " + desc.name);
+
+			lightIndices.emplace(desc.name, (int32_t)scene.lights.size());
+			scene.lights.push_back(desc);
+		}
+	}
+
+	bodies.matrices.resize(count);
+	scene.UpdateMatrices(glm::dvec3(0.0));
+	return scene;
+}
+
+void Scene::Propagate(double daysSinceJ2000)
+{
+	// A few planets cost nothing in double precision, and the camera can get close enough to them to see
+	// the vectorized solver's single precision steps. Large tables (belts, rings) take the vectorized path.
+	if (orbits.size() <= PreciseOrbitCount)
+		Orbits::PropagateScalar(orbits, daysSinceJ2000, bodies.positions.data());
+	else
+		Orbits::Propagate(orbits, daysSinceJ2000, bodies.positions.data());
+}
+
+void Scene::UpdateMatrices(const glm::dvec3& origin)
+{
+	for (size_t i = 0; i < bodies.size(); i++)
+	{
+		// Subtracted in double, only the small camera relative offset is rounded to float
+		glm::mat4 matrix = glm::translate(glm::mat4(1.0f), glm::vec3(bodies.positions[i] - origin));
+		matrix = glm::scale(matrix, glm::vec3(bodies.scales[i]));
+		matrix = glm::rotate(matrix, glm::radians(bodies.rotations[i].x), glm::vec3(1.0f, 0.0f, 0.0f));
+		matrix = glm::rotate(matrix, glm::radians(bodies.rotations[i].y), glm::vec3(0.0f, 1.0f, 0.0f));
+		matrix = glm::rotate(matrix, glm::radians(bodies.rotations[i].z), glm::vec3(0.0f, 0.0f, 1.0f));
+		bodies.matrices[i] = matrix;
+	}
+}
+
+void Scene::EvaluateLights(const float* bodyRadii, const glm::dvec3& origin, std::vector<PointLight>& out) const
+{
+	out.resize(lights.size());
+	std::vector<glm::dvec3> positions(lights.size());
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		const LightDesc& light = lights[i];
+		positions[i] = light.body >= 0 ? bodies.positions[light.body] + light.position : light.position;
+
+		float intensity = light.intensity;
+		glm::vec3 color = light.color;
+		if (light.reflects >= 0)
+		{
+			// A sphere of radius r catches pi r^2 of the source's irradiance and, taken as a point, sends the reflected share
+			// out evenly over 4 pi. Sources come earlier in the list, so their position is already known.
+			const LightDesc& source = lights[light.reflects];
+			const double distanceSquared = glm::max(glm::dot(positions[i] - positions[light.reflects], positions[i] - positions[light.reflects]), 1e-12);
+			const double radius = bodyRadii[light.body];
+			intensity = (float)(light.albedo * source.intensity * radius * radius / (4.0 * distanceSquared));
+			color *= source.color;
+		}
+
+		PointLight& point = out[i];
+		point.position = glm::vec3(positions[i] - origin);
+		point.radiance = color * intensity;
+		const float brightest = std::max(point.radiance.r, std::max(point.radiance.g, point.radiance.b));
+		point.range = light.range > 0.0f ? light.range : std::sqrt(brightest / MinIrradiance);
+	}
+}
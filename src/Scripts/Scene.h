@@ -0,0 +1,110 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../../vendor/glm/glm.hpp"
+#include "Orbits.h"
+
+// Per body flags.
+enum BodyFlags : uint8_t
+{
+	BodyNone = 0,
+	// Drawn without back face culling, for rings and other open meshes
+	BodyDoubleSided = 1 << 0,
+	// Position comes from an orbit in Scene::orbits
+	BodyOrbiting = 1 << 1,
+	// Drawn as a PlanetTerrain from Scene::terrains instead of its model's meshes
+	BodyTerrain = 1 << 2
+};
+
+// Every body of the scene as a structure of arrays, body 'i' is element 'i' of every array.
+// Systems that touch one or two attributes of every body (orbits, matrices, culling) walk tightly packed arrays.
+struct BodyTable
+{
+	std::vector<std::string> names;
+	// Index into Scene::modelPaths, bodies sharing an asset share the model
+	std::vector<uint32_t> models;
+	// In double precision, 32 bit floats are only good to about a kilometer out at Pluto
+	std::vector<glm::dvec3> positions;
+	std::vector<float> scales;
+	// Euler angles in degrees, applied x then y then z
+	std::vector<glm::vec3> rotations;
+	std::vector<uint8_t> flags;
+	// In solar masses, 0 for bodies that don't pull on anything in the N-body simulation
+	std::vector<double> masses;
+	// Filled by Scene::UpdateMatrices, relative to the floating origin
+	std::vector<glm::mat4> matrices;
+
+	size_t size() const { return names.size(); }
+};
+
+// A body drawn as a cube-sphere quadtree displaced by a height map. Its model still supplies the material.
+struct TerrainDesc
+{
+	uint32_t body = 0;
+	// Absolute path of an equirectangular height map, north up
+	std::string heightMap;
+	// Highest point above the surface as a fraction of the radius
+	float heightScale = 0.0f;
+	// Radius of the body in model units, before its scale
+	float radius = 5.0f;
+};
+
+// A point light read from a scene file. A light reflecting another is planet-shine: the other light thrown back by its body,
+// as bright as the body's albedo, size and distance from the source make it.
+struct LightDesc
+{
+	std::string name;
+	// Body the light moves with, -1 for a fixed position
+	int32_t body = -1;
+	// In scene units, relative to the body if it has one
+	glm::dvec3 position = glm::dvec3(0.0);
+	glm::vec3 color = glm::vec3(1.0f);
+	// Irradiance 1 unit away, worked out every frame for reflecting lights
+	float intensity = 1.0f;
+	// Distance past which the light is left out, 0 to work it out from its brightness (see Scene::EvaluateLights)
+	float range = 0.0f;
+	// Index into Scene::lights of the light reflected, -1 for lights shining by themselves
+	int32_t reflects = -1;
+	// Share of the reflected light the body throws back
+	float albedo = 0.3f;
+};
+
+// A light as it is this frame
+struct PointLight
+{
+	// Relative to the floating origin
+	glm::vec3 position;
+	float range;
+	// Color times intensity
+	glm::vec3 radiance;
+};
+
+// The bodies to simulate and draw, read from a scene file.
+class Scene
+{
+public:
+	// Reads a scene file, throws std::invalid_argument if it can't be read or a body is malformed
+	static Scene Load(const char* file);
+
+	// Moves every orbiting body to where it is 'daysSinceJ2000' days after J2000
+	void Propagate(double daysSinceJ2000);
+	// Rebuilds every body's model matrix from its position, scale and rotation. The translation is taken relative
+	// to 'origin' (the camera) in double precision, so the matrices only hold small offsets the GPU's floats keep exact.
+	void UpdateMatrices(const glm::dvec3& origin);
+	// Fills 'out' with every light where it is now, relative to 'origin'. Planet-shine needs the bounding radius of each
+	// body in world units ('bodyRadii', 0 for bodies not loaded yet, which reflect nothing).
+	void EvaluateLights(const float* bodyRadii, const glm::dvec3& origin, std::vector<PointLight>& out) const;
+
+	// Absolute paths of the distinct models the bodies use
+	std::vector<std::string> modelPaths;
+	BodyTable bodies;
+	OrbitTable orbits;
+	std::vector<TerrainDesc> terrains;
+	std::vector<LightDesc> lights;
+};
+
+#endif
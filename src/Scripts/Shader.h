@@ -2,11 +2,39 @@
 #define SHADER_H
 
 #include "../../vendor/glad/include/glad.h"
+#include "../../vendor/glm/glm.hpp"
+#include "GLExtensions.h"
+#include "ProgramCache.h"
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+
+// A uniform location resolved once, setting it is a single glUniform* call on the currently bound program.
+// A handle to a uniform the program doesn't have (or optimized out) stays at -1 and setting it does nothing.
+template<typename T>
+class Uniform
+{
+public:
+    Uniform() {}
+    explicit Uniform(GLint location) : location(location) {}
+
+    void set(const T& value) const;
+    bool valid() const { return location >= 0; }
+
+    GLint location = -1;
+};
+
+template<> inline void Uniform<bool>::set(const bool& value) const { glUniform1i(location, (int)value); }
+template<> inline void Uniform<int>::set(const int& value) const { glUniform1i(location, value); }
+template<> inline void Uniform<unsigned int>::set(const unsigned int& value) const { glUniform1ui(location, value); }
+template<> inline void Uniform<float>::set(const float& value) const { glUniform1f(location, value); }
+template<> inline void Uniform<glm::vec2>::set(const glm::vec2& value) const { glUniform2f(location, value.x, value.y); }
+template<> inline void Uniform<glm::vec3>::set(const glm::vec3& value) const { glUniform3f(location, value.x, value.y, value.z); }
+template<> inline void Uniform<glm::vec4>::set(const glm::vec4& value) const { glUniform4f(location, value.x, value.y, value.z, value.w); }
+template<> inline void Uniform<glm::mat4>::set(const glm::mat4& value) const { glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]); }
 
 class Shader
 {
@@ -51,9 +79,17 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << vertexPath << std::endl;
         }
+        // 2. load the program the driver linked last time from these very sources, if it's still there
+        const uint64_t cacheKey = ProgramCache::Key({ &vertexCode, &fragmentCode });
+        const std::string cacheFile = ProgramCache::File(cacheKey);
+        if ((ID = ProgramCache::Load(cacheFile, cacheKey)) != 0)
+        {
+            cacheUniforms();
+            return;
+        }
         const char* vShaderCode = vertexCode.c_str();
         const char* fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
+        // 3. compile shaders
         unsigned int vertex, fragment;
         // vertex shader
         vertex = glCreateShader(GL_VERTEX_SHADER);
@@ -69,11 +105,55 @@ public:
         ID = glCreateProgram();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
+        ProgramCache::Retrievable(ID);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM", vertexPath);
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
+        ProgramCache::Save(ID, cacheFile, cacheKey);
+        // 4. look every uniform location up once, nothing asks the driver for them after this
+        cacheUniforms();
+    }
+    // generates a compute shader program, needs GLExtensions::ComputeShaders
+    // ------------------------------------------------------------------------
+    void CreateCompute(const char* computePath)
+    {
+        std::string computeCode;
+        std::ifstream cShaderFile;
+        cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            cShaderFile.open(computePath);
+            std::stringstream cShaderStream;
+            cShaderStream << cShaderFile.rdbuf();
+            cShaderFile.close();
+            computeCode = cShaderStream.str();
+        }
+        catch (std::ifstream::failure&)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << computePath << std::endl;
+        }
+        const uint64_t cacheKey = ProgramCache::Key({ &computeCode });
+        const std::string cacheFile = ProgramCache::File(cacheKey);
+        if ((ID = ProgramCache::Load(cacheFile, cacheKey)) != 0)
+        {
+            cacheUniforms();
+            return;
+        }
+        const char* cShaderCode = computeCode.c_str();
+        unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute, 1, &cShaderCode, NULL);
+        glCompileShader(compute);
+        checkCompileErrors(compute, "COMPUTE", computePath);
+        ID = glCreateProgram();
+        glAttachShader(ID, compute);
+        ProgramCache::Retrievable(ID);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM", computePath);
+        glDeleteShader(compute);
+        ProgramCache::Save(ID, cacheFile, cacheKey);
+        cacheUniforms();
     }
 
     // activate the shader
@@ -82,64 +162,125 @@ public:
     {
         glUseProgram(ID);
     }
+    // location of the uniform called 'name', -1 if the program doesn't have it
+    // ------------------------------------------------------------------------
+    GLint location(const std::string& name) const
+    {
+        auto it = uniformLocations.find(name);
+        return it != uniformLocations.end() ? it->second : -1;
+    }
+    // a handle to keep around instead of setting the uniform by name every frame
+    // ------------------------------------------------------------------------
+    template<typename T>
+    Uniform<T> uniform(const std::string& name) const
+    {
+        return Uniform<T>(location(name));
+    }
     // utility uniform functions
     // ------------------------------------------------------------------------
     void setBool(const std::string& name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        glUniform1i(location(name), (int)value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string& name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(location(name), value);
     }
     // ------------------------------------------------------------------------
     void setUInt(const std::string& name, int value) const
     {
-        glUniform1ui(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1ui(location(name), value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string& name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1f(location(name), value);
     }
     // ------------------------------------------------------------------------
     void setVector2(const std::string& name, float value1, float value2) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), value1, value2);
+        glUniform2f(location(name), value1, value2);
     }
     // ------------------------------------------------------------------------
     void setVector2(const std::string& name, glm::vec2 value) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), value.x, value.y);
+        glUniform2f(location(name), value.x, value.y);
     }
     // ------------------------------------------------------------------------
     void setVector3(const std::string& name, float value1, float value2, float value3) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), value1, value2, value3);
+        glUniform3f(location(name), value1, value2, value3);
     }
     // ------------------------------------------------------------------------
     void setVector3(const std::string& name, glm::vec3 value) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), value.x, value.y, value.z);
+        glUniform3f(location(name), value.x, value.y, value.z);
+    }
+    // ------------------------------------------------------------------------
+    void setVector3Array(const std::string& name, const glm::vec3* values, int count) const
+    {
+        glUniform3fv(location(name), count, &values[0].x);
     }
     // ------------------------------------------------------------------------
     void setVector4(const std::string& name, float value1, float value2, float value3, float value4) const
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), value1, value2, value3, value4);
+        glUniform4f(location(name), value1, value2, value3, value4);
     }
     // ------------------------------------------------------------------------
     void setVector4(const std::string& name, glm::vec4 value) const
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), value.x, value.y, value.z, value.w);
+        glUniform4f(location(name), value.x, value.y, value.z, value.w);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string& name, const glm::mat4& mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
+    std::unordered_map<std::string, GLint> uniformLocations;
+
+    // fills the location table with every active uniform of the linked program.
+    // arrays are stored under "name", "name[0]" and every "name[i]".
+    // ------------------------------------------------------------------------
+    void cacheUniforms()
+    {
+        uniformLocations.clear();
+
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        std::string name(maxLength > 0 ? maxLength : 1, '\0');
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, maxLength, &length, &size, &type, &name[0]);
+            std::string uniformName = name.substr(0, length);
+
+            // uniforms inside blocks have no location, they are fed through their buffer
+            GLint uniformLocation = glGetUniformLocation(ID, uniformName.c_str());
+            if (uniformLocation < 0)
+                continue;
+            uniformLocations[uniformName] = uniformLocation;
+
+            std::string::size_type bracket = uniformName.rfind("[0]");
+            if (bracket == std::string::npos || bracket + 3 != uniformName.size())
+                continue;
+
+            std::string arrayName = uniformName.substr(0, bracket);
+            uniformLocations[arrayName] = uniformLocation;
+            for (GLint element = 1; element < size; element++)
+            {
+                std::string elementName = arrayName + "[" + std::to_string(element) + "]";
+                uniformLocations[elementName] = glGetUniformLocation(ID, elementName.c_str());
+            }
+        }
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(unsigned int shader, std::string type, const char* shaderName)
@@ -6,8 +6,14 @@
 
 #include "SolarSystem.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <random>
+#include <stdexcept>
+#include <thread>
 
 #include "../../vendor/glad/include/glad.h"
 #include "../../vendor/glm/gtc/matrix_transform.hpp"
@@ -19,6 +25,8 @@
 
 #include <stb_image.h>
 
+#include "ImageWriter.h"
+
 using namespace glm;
 
 SolarSystem* SolarSystem::GLFWCallbackWrapper::s_application = nullptr;
@@ -48,27 +56,29 @@ void SolarSystem::GLFWCallbackWrapper::SetApplication(SolarSystem* application)
 	GLFWCallbackWrapper::s_application = application;
 }
 
-SolarSystem::SolarSystem() : m_Camera(vec3(0.0f, 0.0f, 1.0f)), m_FinalColorBufferTexture(), 
-	m_ModelMatrix(mat4(1.0f)), m_ProjectionMatrix(mat4(1.0f))
+SolarSystem::SolarSystem(const SimulationOptions& options) : m_Options(options), m_Camera(dvec3(0.0, 0.0, 1.0)), m_AssetLoader(m_Jobs), m_TextureStreamer(m_Jobs), m_NBody(m_Jobs), m_FinalColorBufferTexture(), 
+	m_ProjectionMatrix(mat4(1.0f))
 {
 
 }
 
 SolarSystem::~SolarSystem() { }
 
-void SolarSystem::Simulate()
+bool SolarSystem::Simulate()
 {
 	//If GLFW fails to create a window, then exit the Solar System.
-	if (!Init()) return;
+	if (!Init()) return false;
 
 	// Main Render Loop.
 	RenderLoop();
 
 	// Free the memory allocations.
 	Cleanup();
+	return true;
 }
 
-bool SolarSystem::Init()
+///<summary>Creates The Window & Its Context, Makes It Current & Hooks Up The Input Callbacks.</summary>
+bool SolarSystem::OpenWindow()
 {
 	//Initialize GLFW
 	glfwInit();
@@ -103,9 +113,30 @@ bool SolarSystem::Init()
 	// Set Window Resize Callback
 	glfwSetWindowSizeCallback(m_Window, GLFWCallbackWrapper::WindowResizeCallback);
 
+	return true;
+}
+
+bool SolarSystem::Init()
+{
+	GLADloadproc loader = (GLADloadproc)glfwGetProcAddress;
+	if (m_Options.headless)
+	{
+		//No Window, No Display: Everything Draws Into Framebuffer Objects of The Requested Size.
+		if (!m_HeadlessContext.Create(4, 2))
+		{
+			cout << "Failed To Create a Headless OpenGL Context!" << endl;
+			return false;
+		}
+		loader = (GLADloadproc)HeadlessContext::GetProcAddress;
+		m_BufferWidth = m_Options.width;
+		m_BufferHeight = m_Options.height;
+	}
+	else if (!OpenWindow())
+		return false;
+
 	//Initialize GLAD
 	//Because We Can Call gl Functions Only After GLAD is Initialized!
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	if (!gladLoadGLLoader(loader))
 	{
 		// GLAD Failed Initialization.
 		cout << "Failed To Initialize GLAD!";
@@ -113,32 +144,169 @@ bool SolarSystem::Init()
 		return false;
 	}
 
+	// Load What GLAD's 3.3 Core Profile Doesn't Cover.
+	GLExtensions::Load(loader);
+	// Draws Every Body With Its Own Calls & 2D Textures, to Compare The Batched Path Against.
+	if (m_Options.noBatching)
+		GLExtensions::MultiDrawIndirect = false;
+	m_ReversedZ = GLExtensions::ClipControl;
+	if (!m_ReversedZ)
+		cout << "glClipControl is not supported, falling back to logarithmic depth." << endl;
+
+	// Read the bodies to draw.
+	try
+	{
+		m_Scene = Scene::Load(PROJECT_DIR"/src/Assets/Scene.json");
+	}
+	catch (const std::exception& e)
+	{
+		cout << e.what() << endl;
+		glfwTerminate();
+		return false;
+	}
+
+	// Read the camera flight, its keyframes name bodies of the scene.
+	if (!m_Options.cameraPath.empty())
+	{
+		try
+		{
+			m_CameraPath = CameraPath::Load(m_Options.cameraPath.c_str(), m_Scene.bodies);
+		}
+		catch (const std::exception& e)
+		{
+			cout << e.what() << endl;
+			glfwTerminate();
+			return false;
+		}
+	}
+	if (m_Options.frames == 0)
+		m_Options.frames = m_CameraPath.keyframes.empty() ? 300 : m_Options.warmup + (int)(m_CameraPath.Duration() / m_Options.frameTime) + 1;
+
+	// Put the planets where they are today, scripted runs start on a fixed date so every run renders the same sky.
+	m_SimulationDays = m_Options.Scripted() ? m_Options.days : Orbits::DaysSinceJ2000Now();
+
+	// Start streaming the assets in right away, the decoding overlaps with the rest of the setup.
+	// Bodies pop in as their geometry & textures finish, the render loop uploads them.
+	// Package textures only upload their small levels, the larger ones stream in once a body gets close.
+	m_AssetLoader.SetTextureStreamer(&m_TextureStreamer);
+	m_Models.resize(m_Scene.modelPaths.size());
+	for (size_t i = 0; i < m_Models.size(); i++)
+		m_AssetLoader.LoadModel(m_Models[i], m_Scene.modelPaths[i]);
+
+	// Terrain bodies draw nothing until their height map arrives and the six root patches are built.
+	m_BodyTerrains.assign(m_Scene.bodies.size(), -1);
+	m_TerrainModels.assign(m_Models.size(), false);
+	for (size_t i = 0; i < m_Scene.terrains.size(); i++)
+	{
+		const TerrainDesc& desc = m_Scene.terrains[i];
+		m_BodyTerrains[desc.body] = (int)i;
+		m_TerrainModels[m_Scene.bodies.models[desc.body]] = true;
+		m_Terrains.emplace_back(new PlanetTerrain(m_Jobs, desc.radius, desc.heightScale));
+		PlanetTerrain* terrain = m_Terrains.back().get();
+		m_AssetLoader.LoadPixels(desc.heightMap, false, [terrain](TextureData& data)
+		{
+			if (data.valid())
+				terrain->SetHeightMap(data);
+			else
+				cout << "ERROR::TERRAIN::HEIGHT_MAP_NOT_LOADED" << endl;
+		});
+	}
+
+	// The skybox stays black and the IBL maps stay empty until the HDR arrives.
+	// Maps baked from the same HDR by the same baker are uploaded from the cache next to it, without decoding the HDR.
+	// --cpu-ibl bakes them on the job system instead of with GPU passes, into a cache of its own.
+	m_AssetLoader.Load([this]() -> std::function<void()>
+	{
+		const std::string hdr = PROJECT_DIR"/src/Assets/Space.hdr";
+		const std::string cacheFile = hdr + (m_Options.cpuIBL ? ".cpu.ibl" : ".ibl");
+		const uint64_t key = m_Options.cpuIBL ? IBLCache::BakerKey(hdr) : IBLCache::Key({ hdr, PROJECT_DIR"/src/Shaders/cubemap.vs",
+			PROJECT_DIR"/src/Shaders/equirectangular_to_cubemap.fs", PROJECT_DIR"/src/Shaders/irradiance_convolution.fs",
+			PROJECT_DIR"/src/Shaders/prefilter.fs", PROJECT_DIR"/src/Shaders/brdf.vs", PROJECT_DIR"/src/Shaders/brdf.fs" }, "GPU", IBLMaps());
+		if (std::shared_ptr<IBLCacheReader> cache = key ? IBLCacheReader::Open(cacheFile.c_str(), key, IBLMaps()) : nullptr)
+			return [this, cache, cacheFile]()
+			{
+				SetupPBR(*cache);
+				cout << "IBL maps loaded from " << cacheFile << endl;
+			};
+
+		TextureData data = TextureData::Decode(hdr.c_str(), true);
+		if (!data.valid())
+		{
+			cout << "Texture failed to load at path: " << hdr << endl;
+			return nullptr;
+		}
+		EnvironmentImage environment;
+		environment.pixels = static_cast<const float*>(data.pixels.get());
+		environment.width = data.width;
+		environment.height = data.height;
+		environment.channels = data.channels;
+
+		if (m_Options.cpuIBL)
+		{
+			// Uploaded from the very bytes the cache gets, so a cached bake is the same as a fresh one
+			std::shared_ptr<const std::vector<unsigned char>> bytes = std::make_shared<const std::vector<unsigned char>>(IBLCache::Bake(key, environment, m_Jobs));
+			if (key && !IBLCache::Write(cacheFile, *bytes))
+				cout << "ERROR::IBL_CACHE::FILE_NOT_WRITTEN " << cacheFile << endl;
+			std::shared_ptr<IBLCacheReader> baked = IBLCacheReader::Read(bytes, key, IBLMaps());
+			return [this, baked]() { SetupPBR(*baked); };
+		}
+
+		const SphericalHarmonics irradiance = EnvironmentBaker::ProjectIrradiance(environment, m_Jobs);
+		return [this, data, key, irradiance, cacheFile]()
+		{
+			m_SpaceHDRTexture = UploadHDRTexture(data);
+			//Setup PBR Workflow Based on The Environment Map.
+			SetupPBR(m_SpaceHDRTexture);
+			SetIrradianceSH(irradiance);
+			if (!key)
+				return;
+
+			// Read Back Here, Written to Disk in The Background.
+			std::shared_ptr<std::vector<unsigned char>> bytes = std::make_shared<std::vector<unsigned char>>(IBLCache::Serialize(key, IBLMaps(), irradiance));
+			m_AssetLoader.Load([bytes, cacheFile]() -> std::function<void()>
+			{
+				if (IBLCache::Write(cacheFile, *bytes))
+					cout << "IBL maps cached to " << cacheFile << endl;
+				else
+					cout << "ERROR::IBL_CACHE::FILE_NOT_WRITTEN " << cacheFile << endl;
+				return nullptr;
+			});
+		};
+	});
+
 	// Enable Depth Testing & Face Culling.
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_CULL_FACE);
 	glCullFace(GL_BACK);
-	glDepthFunc(GL_LESS);
+	ApplyDepthConvention();
 	// Enable seamless cubemap sampling for lower mip levels in the pre-filter map.
 	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
 	//Set Clear Color For Background Color.
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-	//Get The FrameBufferSize
-	glfwGetFramebufferSize(m_Window, &m_BufferWidth, &m_BufferHeight);
+	if (!m_Options.headless)
+	{
+		//Get The FrameBufferSize
+		glfwGetFramebufferSize(m_Window, &m_BufferWidth, &m_BufferHeight);
 
-	// Set Window Icon.
-	GLFWimage icon[1];
-	icon[0].pixels = stbi_load(PROJECT_DIR"/src/Assets/icon.png", &icon[0].width, &icon[0].height, 0, 4);
-	glfwSetWindowIcon(m_Window, 1, icon);
-	stbi_image_free(icon[0].pixels);
+		// Set Window Icon.
+		GLFWimage icon[1];
+		icon[0].pixels = stbi_load(PROJECT_DIR"/src/Assets/icon.png", &icon[0].width, &icon[0].height, 0, 4);
+		glfwSetWindowIcon(m_Window, 1, icon);
+		stbi_image_free(icon[0].pixels);
+
+		// Enable Vsync, Benchmarks Want Every Frame as Fast as It Goes.
+		glfwSwapInterval(m_Options.benchmark.empty() ? 1 : 0);
+	}
+
+	if (!m_Options.benchmark.empty())
+		m_Benchmark.Init();
+	m_Profiler.Init();
 
 	//Call glViewport To Set Viewport Transform Or The General Area where OpenGL will Render!
 	glViewport(0, 0, m_BufferWidth, m_BufferHeight);
 
-	// Enable Vsync
-	glfwSwapInterval(1);
-
 	// Setup Dear ImGui context
 	IMGUI_CHECKVERSION();
 	ImGui::CreateContext();
@@ -151,7 +319,8 @@ bool SolarSystem::Init()
 
 	// Setup Platform/Renderer backends
 	const char* glsl_version = "#version 420";
-	ImGui_ImplGlfw_InitForOpenGL(m_Window, true);
+	if (!m_Options.headless)
+		ImGui_ImplGlfw_InitForOpenGL(m_Window, true);
 	ImGui_ImplOpenGL3_Init(glsl_version);
 
 	#pragma region Geometry Framebuffer
@@ -159,63 +328,60 @@ bool SolarSystem::Init()
 	glGenFramebuffers(1, &m_GBuffer);
 	glBindFramebuffer(GL_FRAMEBUFFER, m_GBuffer);
 
-	// position color buffer
-	glGenTextures(1, &m_GPosition);
-	glBindTexture(GL_TEXTURE_2D, m_GPosition);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, m_BufferWidth, m_BufferHeight, 0, GL_RGB, GL_FLOAT, NULL);
+	//Packed For Bandwidth: Positions Come Back From Depth in The Lighting Pass, Normals Are Octahedral & Everything Else is 8 or 10 Bits.
+	// depth buffer, a texture so the lighting pass can rebuild positions from it
+	glGenTextures(1, &m_GDepth);
+	glBindTexture(GL_TEXTURE_2D, m_GDepth);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, m_BufferWidth, m_BufferHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_GPosition, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_GDepth, 0);
 
-	// normal color buffer
+	// normal color buffer, octahedral
 	glGenTextures(1, &m_GNormal);
 	glBindTexture(GL_TEXTURE_2D, m_GNormal);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, m_BufferWidth, m_BufferHeight, 0, GL_RGB, GL_FLOAT, NULL);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16, m_BufferWidth, m_BufferHeight, 0, GL_RG, GL_UNSIGNED_SHORT, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_GNormal, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_GNormal, 0);
 
 	// Albedo color buffer
 	glGenTextures(1, &m_GAlbedo);
 	glBindTexture(GL_TEXTURE_2D, m_GAlbedo);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, m_BufferWidth, m_BufferHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_BufferWidth, m_BufferHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, m_GAlbedo, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_GAlbedo, 0);
 
-	// Emission color buffer
+	// Emission color buffer, before the emission strength the lighting pass multiplies in
 	glGenTextures(1, &m_GEmission);
 	glBindTexture(GL_TEXTURE_2D, m_GEmission);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, m_BufferWidth, m_BufferHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB10_A2, m_BufferWidth, m_BufferHeight, 0, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, m_GEmission, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, m_GEmission, 0);
 
 	// Metallic Roughness color buffer
 	glGenTextures(1, &m_GMetallicRoughness);
 	glBindTexture(GL_TEXTURE_2D, m_GMetallicRoughness);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG, m_BufferWidth, m_BufferHeight, 0, GL_RG, GL_UNSIGNED_BYTE, NULL);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, m_BufferWidth, m_BufferHeight, 0, GL_RG, GL_UNSIGNED_BYTE, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT4, GL_TEXTURE_2D, m_GMetallicRoughness, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, m_GMetallicRoughness, 0);
 
-	unsigned int colorAttachments[5] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4 };
-	glDrawBuffers(5, colorAttachments);
+	unsigned int colorAttachments[4] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
+	glDrawBuffers(4, colorAttachments);
 
-	glGenRenderbuffers(1, &m_GDepth);
-	glBindRenderbuffer(GL_RENDERBUFFER, m_GDepth);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, m_BufferWidth, m_BufferHeight);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_GDepth);
 	// finally check if framebuffer is complete
 	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		cout << "Geometry buffer not complete!" << endl;
@@ -223,28 +389,6 @@ bool SolarSystem::Init()
 
 	#pragma endregion
 
-	#pragma region Bloom Framebuffer
-
-	//Generate Bloom FBO.
-	glGenFramebuffers(2, m_BloomFBO);
-	glGenTextures(2, m_BloomTexture);
-	for (unsigned int i = 0; i < 2; ++i)
-	{
-		glBindFramebuffer(GL_FRAMEBUFFER, m_BloomFBO[i]);
-		glBindTexture(GL_TEXTURE_2D, m_BloomTexture[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_BufferWidth, m_BufferHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_BloomTexture[i], 0);
-		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-			std::cout << "Bloom " + to_string(i) + " Framebuffer not complete!" << std::endl;
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	}
-
-	#pragma endregion
-
 	#pragma region HDR Framebuffer
 
 	glGenFramebuffers(1, &m_RenderFBO);
@@ -268,7 +412,7 @@ bool SolarSystem::Init()
 
 	glGenRenderbuffers(1, &m_FinalRBO);
 	glBindRenderbuffer(GL_RENDERBUFFER, m_FinalRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, m_BufferWidth, m_BufferHeight);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, m_BufferWidth, m_BufferHeight);
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_FinalRBO);
 	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		std::cout << "Render Framebuffer not complete!" << std::endl;
@@ -276,27 +420,46 @@ bool SolarSystem::Init()
 
 	#pragma endregion
 
+	#pragma region Output Framebuffer
+
+	//Headless There is No Window to Present to, The Post Processed Frame Stays in a Texture To Be Read Back.
+	if (m_Options.headless)
+	{
+		glGenFramebuffers(1, &m_OutputFBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_OutputFBO);
+		glGenTextures(1, &m_OutputTexture);
+		glBindTexture(GL_TEXTURE_2D, m_OutputTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_BufferWidth, m_BufferHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_OutputTexture, 0);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "Output Framebuffer not complete!" << std::endl;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	#pragma endregion
+
 	#pragma region Resource Initialization
 
 	m_ModelShader.Create(PROJECT_DIR"/src/Shaders/Model.vs", PROJECT_DIR"/src/Shaders/Model.fs");
 	m_LightShader.Create(PROJECT_DIR"/src/Shaders/LightShader.vs", PROJECT_DIR"/src/Shaders/LightShader.fs");
-	m_BloomShader.Create(PROJECT_DIR"/src/Shaders/blur.vs", PROJECT_DIR"/src/Shaders/blur.fs");
+	if (GLExtensions::ComputeShaders)
+		m_LightCullingShader.CreateCompute(PROJECT_DIR"/src/Shaders/LightCulling.cs");
+	m_TiledLighting.Init(m_LightShader, GLExtensions::ComputeShaders ? &m_LightCullingShader : nullptr, m_BufferWidth, m_BufferHeight,
+						 LogDepthCoefficient(), NEAR_PLANE);
+	m_BloomDownsampleShader.Create(PROJECT_DIR"/src/Shaders/Bloom.vs", PROJECT_DIR"/src/Shaders/BloomDownsample.fs");
+	m_BloomUpsampleShader.Create(PROJECT_DIR"/src/Shaders/Bloom.vs", PROJECT_DIR"/src/Shaders/BloomUpsample.fs");
+	m_Bloom.Init(m_BloomDownsampleShader, m_BloomUpsampleShader, m_BufferWidth, m_BufferHeight);
 	m_PostProcessingShader.Create(PROJECT_DIR"/src/Shaders/postProcessing.vs", PROJECT_DIR"/src/Shaders/postProcessing.fs");
 	m_SkyboxShader.Create(PROJECT_DIR"/src/Shaders/skybox.vs", PROJECT_DIR"/src/Shaders/skybox.fs");
-
-	m_Sun.Create(PROJECT_DIR"/src/Assets/Sun/Sun.gltf");
-	m_Mercury.Create(PROJECT_DIR"/src/Assets/Mercury/Mercury.gltf");
-	m_Venus.Create(PROJECT_DIR"/src/Assets/Venus/Venus.gltf");
-	m_Earth.Create(PROJECT_DIR"/src/Assets/Earth/Earth.gltf");
-	m_Mars.Create(PROJECT_DIR"/src/Assets/Mars/Mars.gltf");
-	m_Jupiter.Create(PROJECT_DIR"/src/Assets/Jupiter/Jupiter.gltf");
-	m_Saturn.Create(PROJECT_DIR"/src/Assets/Saturn/Saturn.gltf");
-	m_Uranus.Create(PROJECT_DIR"/src/Assets/Uranus/Uranus.gltf");
-	m_Neptune.Create(PROJECT_DIR"/src/Assets/Neptune/Neptune.gltf");
-	m_Pluto.Create(PROJECT_DIR"/src/Assets/Pluto/Pluto.gltf");
-
-	//stbi_set_flip_vertically_on_load(true);
-	m_SpaceHDRTexture = LoadHDRTexture(PROJECT_DIR"/src/Assets/Space.hdr");
+	if (GLExtensions::MultiDrawIndirect)
+	{
+		m_BatchedShader.Create(PROJECT_DIR"/src/Shaders/ModelBatched.vs", PROJECT_DIR"/src/Shaders/ModelBatched.fs");
+		m_BodyRenderer.Init(m_BatchedShader);
+	}
+	m_ImpostorShader.Create(PROJECT_DIR"/src/Shaders/Impostor.vs", PROJECT_DIR"/src/Shaders/Impostor.fs");
+	m_Impostors.Init(m_ImpostorShader, m_Models.size(), LogDepthCoefficient());
 
 	#pragma endregion
 
@@ -304,7 +467,7 @@ bool SolarSystem::Init()
 
 	//Use Shader To Set Uniforms.
 	m_LightShader.use();
-	m_LightShader.setInt("gPosition", 0);
+	m_LightShader.setInt("gDepth", 0);
 	m_LightShader.setInt("gNormal", 1);
 	m_LightShader.setInt("gAlbedo", 2);
 	m_LightShader.setInt("gEmission", 3);
@@ -312,20 +475,42 @@ bool SolarSystem::Init()
 	m_LightShader.setInt("irradianceMap", 5);
 	m_LightShader.setInt("prefilterMap", 6);
 	m_LightShader.setInt("brdfLUT", 7);
+	m_LightShader.setInt("tileLights", 8);
 	m_LightShader.setFloat("specularStrength", 0.5f);
 	
-	m_BloomShader.use();
-	m_BloomShader.setInt("brightnessTexture", 0);
-
 	m_PostProcessingShader.use();
 	m_PostProcessingShader.setInt("screenTexture", 0);
 	m_PostProcessingShader.setInt("blurTexture", 1);
 
-	//Setup PBR Workflow Based on The Environment Map.
-	SetupPBR(m_SpaceHDRTexture);
+	m_ModelUniforms = MeshUniforms(m_ModelShader);
+	m_ViewPosUniform = m_LightShader.uniform<vec3>("viewPos");
+	m_EmissionStrengthUniform = m_LightShader.uniform<float>("emissionStrength");
+	m_InverseViewProjectionUniform = m_LightShader.uniform<mat4>("inverseViewProjection");
+	m_SkyViewProjectionUniform = m_SkyboxShader.uniform<mat4>("viewProjection");
+	m_SkyFarDepthUniform = m_SkyboxShader.uniform<float>("farDepth");
+	m_ExposureUniform = m_PostProcessingShader.uniform<float>("exposure");
+	m_ToneMappingUniform = m_PostProcessingShader.uniform<unsigned int>("toneMapping");
+	m_BloomStrengthUniform = m_PostProcessingShader.uniform<float>("bloomStrength");
+
+	//Depth Convention Uniforms Never Change.
+	m_ModelShader.use();
+	m_ModelShader.setFloat("logDepthCoefficient", LogDepthCoefficient());
+	if (GLExtensions::MultiDrawIndirect)
+	{
+		m_BatchedShader.use();
+		m_BatchedShader.setFloat("logDepthCoefficient", LogDepthCoefficient());
+	}
+	m_SkyboxShader.use();
+	m_SkyFarDepthUniform.set(m_ReversedZ ? 0.0f : 1.0f);
 
 	//Perform Perspective Projection for our Projection Matrix.
-	m_ProjectionMatrix = perspective(radians(m_Camera.Zoom), (float)m_BufferWidth / (float)m_BufferHeight, m_NearPlane, m_FarPlane);
+	m_ProjectionMatrix = CalculateProjectionMatrix();
+
+	//The Lighting Pass Undoes The Depth Convention to Rebuild Positions. Clip Space Depth as a Function of View Depth Doesn't Change With The Field of View.
+	m_LightShader.use();
+	m_LightShader.setFloat("logDepthCoefficient", LogDepthCoefficient());
+	m_LightShader.setFloat("farDepth", m_ReversedZ ? 0.0f : 1.0f);
+	m_LightShader.setVector2("clipDepth", vec2(-m_ProjectionMatrix[2][2], m_ProjectionMatrix[3][2]));
 
 	glGenBuffers(1, &m_MatricesUBO);
 	glBindBuffer(GL_UNIFORM_BUFFER, m_MatricesUBO);
@@ -345,78 +530,101 @@ void SolarSystem::RenderLoop()
 	const char* toneMappings[] = { "Exposure", "Reinhard", "Reinhard 2", "Filmic", "ACES Filmic", "Lottes", "Uchimura", "Uncharted 2", "Unreal", "NONE" };
 	static const char* current_toneMapping = "NONE";
 	float exposure = 2.5f;
-	int bloomAmount = 2;
+	int bloomLevels = 6;
+	float bloomRadius = 1.0f;
+	float bloomStrength = 1.0f;
 
 	float emissionStrength = 1.0f;
 
 	float flySpeed = 2.5f;
 
-	glm::vec3 lightPosition = glm::vec3(0.0f);
-	glm::vec3 lightColor = glm::vec3(1.0f);
-	float lightIntensity = 50.0f;
-
-	float sunScale = 0.13914f;
-	glm::vec3 sunRotation = glm::vec3(90.0f, 0.0f, 0.0f);
-
-	glm::vec3 mercuryPosition = glm::vec3(0.0f, 0.0f, 57.9f);
-	float mercuryScale = 0.0004879f;
-	glm::vec3 mercuryRotation = glm::vec3(-80.0, -32.0f, 0.0f);
-
-	glm::vec3 venusPosition = glm::vec3(0.0f, 0.0f, 108.2f);
-	float venusScale = 0.0012104f;
-	glm::vec3 venusRotation = glm::vec3(-90.0f, 0.0f, 0.0f);
-
-	glm::vec3 earthPosition = glm::vec3(0.0f, 0.0f, 149.6f);
-	float earthScale = 0.0012756f;
-	glm::vec3 earthRotation = glm::vec3(0.0f, 300.0f, 0.0f);
-
-	glm::vec3 marsPosition = glm::vec3(0.0f, 0.0f, 227.9f);
-	float marsScale = 0.0006792f;
-	glm::vec3 marsRotation = glm::vec3(0.0f);
+	//Headless Runs Only Start Once Every Asset Queued at Startup is Uploaded, So Each Run Renders The Same Frames.
+	if (m_Options.headless)
+	{
+		while (!m_AssetLoader.IsIdle())
+		{
+			m_AssetLoader.ProcessUploads(100.0);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		m_AssetsStreaming = false;
+		cout << "All assets loaded after " << Seconds() << " seconds, rendering " << m_Options.frames << " frames at "
+			 << m_BufferWidth << "x" << m_BufferHeight << "." << endl;
+	}
+	const double startSeconds = Seconds();
+	const bool scripted = m_Options.Scripted();
+	const bool benchmark = !m_Options.benchmark.empty();
 
-	glm::vec3 jupiterPosition = glm::vec3(0.0f, 0.0f, 778.6f);
-	float jupiterScale = 0.0142984f;
-	glm::vec3 jupiterRotation = glm::vec3(0.0f);
+	for (int frame = 0; (!scripted || frame < m_Options.frames) && (m_Options.headless || !glfwWindowShouldClose(m_Window)); frame++)
+	{
+		if (benchmark)
+			m_Benchmark.BeginFrame();
+		m_Profiler.BeginFrame();
 
-	glm::vec3 saturnPosition = glm::vec3(0.0f, 0.0f, 1433.5f);
-	float saturnScale = 0.0120536f;
-	glm::vec3 saturnRotation = glm::vec3(0.0f);
+		//Calculate Delta Time, Headless & Scripted Frames Step a Fixed Time Whatever They Take.
+		float currentFrame = scripted ? frame * m_Options.frameTime : (float)Seconds();
+		m_DeltaTime = scripted ? m_Options.frameTime : currentFrame - m_LastFrame;
+		m_LastFrame = currentFrame;
 
-	glm::vec3 uranusPosition = glm::vec3(0.0f, 0.0f, 2872.5f);
-	float uranusScale = 0.0051118f;
-	glm::vec3 uranusRotation = glm::vec3(0.0f);
+		if (!m_Options.headless)
+		{
+			//To Make Sure Inputs Are Being Read.
+			glfwPollEvents();
 
-	glm::vec3 neptunePosition = glm::vec3(0.0f, 0.0f, 4495.1f);
-	float neptuneScale = 0.0049528f;
-	glm::vec3 neptuneRotation = glm::vec3(0.0f);
+			//Process Input.
+			ProcessInput(m_Window);
+		}
 
-	glm::vec3 plutoPosition = glm::vec3(0.0f, 0.0f, 5906.38f);
-	float plutoScale = 0.0002376f;
-	glm::vec3 plutoRotation = glm::vec3(0.0f);
+		//Update Camera Speed.
+		m_Camera.MovementSpeed = flySpeed;
 
-	while (!glfwWindowShouldClose(m_Window))
-	{
-		//Calculate Delta Time.
-		float currentFrame = (float)glfwGetTime();
-		m_DeltaTime = currentFrame - m_LastFrame;
-		m_LastFrame = currentFrame;
+		//Upload Whatever The Asset Loader Decoded Since Last Frame, Without Stalling The Frame For Too Long.
+		m_Profiler.Begin("Asset Uploads");
+		m_AssetLoader.ProcessUploads(4.0);
+		if (m_AssetsStreaming && m_AssetLoader.IsIdle())
+		{
+			m_AssetsStreaming = false;
+			cout << "All assets streamed in after " << Seconds() << " seconds." << endl;
+		}
+		m_Profiler.End();
 
-		//To Make Sure Inputs Are Being Read.
-		glfwPollEvents();
+		//Bake The Impostor of One Model a Frame, Once Its Geometry is In & Again Whenever More of Its Textures Arrive.
+		for (uint32_t i = 0; i < m_Models.size(); i++)
+		{
+			if (m_Models[i].IsLoaded() && m_Impostors.NeedsBake(i, m_Models[i].TextureVersion()))
+			{
+				ProfileScope scope(m_Profiler, "Impostor Bake");
+				BakeImpostor(i);
+				break;
+			}
+		}
 
-		//Process Input.
-		ProcessInput(m_Window);
+		//Advance The Simulation & Move Every Body Along Its Orbit, Or Under Gravity in N-Body Mode.
+		m_Profiler.Begin("Simulation");
+		double elapsedDays = (double)m_DeltaTime * m_TimeScale;
+		m_SimulationDays += elapsedDays;
+		if (m_NBodyMode)
+			StepNBody(elapsedDays);
+		else
+			m_Scene.Propagate(m_SimulationDays);
 
-		//Update Camera Speed.
-		m_Camera.MovementSpeed = flySpeed;
+		//A Camera Path Takes Over The Camera, Holding Its First Pose Through The Warmup. Placed After The Bodies Moved So It Keeps Up With Them.
+		if (!m_CameraPath.keyframes.empty())
+		{
+			const CameraPose pose = m_CameraPath.Sample(std::max(0, frame - m_Options.warmup) * (double)m_Options.frameTime, m_Scene.bodies);
+			m_Camera.SetPose(pose.position, pose.yaw, pose.pitch, pose.zoom);
+		}
+		m_Profiler.End();
 
 		#pragma region Deferred Rendering - Geometry Pass
 
+		m_Profiler.Begin("Geometry Pass");
+
 		//Disable Blending.
 		glDisable(GL_BLEND);
 
 		// Bind gBuffer as Current Framebuffer & Draw all The Geomtry & Fill The Samplers.
 		glBindFramebuffer(GL_FRAMEBUFFER, m_GBuffer);
+		glEnable(GL_DEPTH_TEST);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		//Get Camera View Matrix.
 		mat4 view = m_Camera.GetViewMatrix();
@@ -424,7 +632,7 @@ void SolarSystem::RenderLoop()
 		if (m_CamZoomDirty || true)
 		{
 			//Perform Perspective Projection for our Projection Matrix With The New Field of View in Mind.
-			m_ProjectionMatrix = perspective(radians(m_Camera.Zoom), (float)m_BufferWidth / (float)m_BufferHeight, m_NearPlane, m_FarPlane);
+			m_ProjectionMatrix = CalculateProjectionMatrix();
 			m_CamZoomDirty = false;
 		}
 
@@ -438,172 +646,152 @@ void SolarSystem::RenderLoop()
 		
 		glFrontFace(GL_CW);
 
-		m_ModelShader.use();
-		m_ModelShader.setFloat("material.emissionStrength", emissionStrength);
-
-		#pragma region Draw Sun
-		
-		// Sun is at the origin and its radius is 696,340 km, our models have a 5 meter radius.
-		m_ModelMatrix = mat4(1.0f);
-		m_ModelMatrix = translate(m_ModelMatrix, vec3(0.0f, 0.0f, 0.0f));
-		m_ModelMatrix = scale(m_ModelMatrix, vec3(sunScale));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(sunRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(sunRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(sunRotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-		m_Sun.Draw(m_ModelShader, m_ModelMatrix);
-
-		#pragma endregion
-
-		#pragma region Draw Mercury
-
-		// Sun is at the origin and its radius is 696,340 km, our models have a 5 meter radius.
-		m_ModelMatrix = mat4(1.0f);
-		m_ModelMatrix = translate(m_ModelMatrix, mercuryPosition);
-		m_ModelMatrix = scale(m_ModelMatrix, vec3(mercuryScale));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(mercuryRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(mercuryRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(mercuryRotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-		m_Mercury.Draw(m_ModelShader, m_ModelMatrix);
-
-		#pragma endregion
-
-		#pragma region Draw Venus
+		#pragma region Draw Bodies
 
-		// Sun is at the origin and its radius is 696,340 km, our models have a 5 meter radius.
-		m_ModelMatrix = mat4(1.0f);
-		m_ModelMatrix = translate(m_ModelMatrix, venusPosition);
-		m_ModelMatrix = scale(m_ModelMatrix, vec3(venusScale));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(venusRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(venusRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(venusRotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-		m_Venus.Draw(m_ModelShader, m_ModelMatrix);
+		//Floating Origin: Everything is Drawn Relative to The Camera, Which The View Matrix Leaves at The Origin.
+		m_Scene.UpdateMatrices(m_Camera.Position);
 
-		#pragma endregion
-
-		#pragma region Draw Earth
-
-		// Sun is at the origin and its radius is 696,340 km, our models have a 5 meter radius.
-		m_ModelMatrix = mat4(1.0f);
-		m_ModelMatrix = translate(m_ModelMatrix, earthPosition);
-		m_ModelMatrix = scale(m_ModelMatrix, vec3(earthScale));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(earthRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(earthRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(earthRotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-		m_Earth.Draw(m_ModelShader, m_ModelMatrix);
-
-		#pragma endregion
-
-		#pragma region Draw Mars
-
-		// Sun is at the origin and its radius is 696,340 km, our models have a 5 meter radius.
-		m_ModelMatrix = mat4(1.0f);
-		m_ModelMatrix = translate(m_ModelMatrix, marsPosition);
-		m_ModelMatrix = scale(m_ModelMatrix, vec3(marsScale));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(marsRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(marsRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(marsRotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-		m_Mars.Draw(m_ModelShader, m_ModelMatrix);
-
-		#pragma endregion
-
-		#pragma region Draw Jupiter
-
-		// Sun is at the origin and its radius is 696,340 km, our models have a 5 meter radius.
-		m_ModelMatrix = mat4(1.0f);
-		m_ModelMatrix = translate(m_ModelMatrix, jupiterPosition);
-		m_ModelMatrix = scale(m_ModelMatrix, vec3(jupiterScale));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(jupiterRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(jupiterRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(jupiterRotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-		m_Jupiter.Draw(m_ModelShader, m_ModelMatrix);
-
-		#pragma endregion
+		const BodyTable& bodies = m_Scene.bodies;
 
-		//TODO: Replace Rings with asteroids that are instanced.
-		// To make sure we draw the rings of Saturn & Uranus.
-		glDisable(GL_CULL_FACE);
-
-		#pragma region Draw Saturn
-
-		// Sun is at the origin and its radius is 696,340 km, our models have a 5 meter radius.
-		m_ModelMatrix = mat4(1.0f);
-		m_ModelMatrix = translate(m_ModelMatrix, saturnPosition);
-		m_ModelMatrix = scale(m_ModelMatrix, vec3(saturnScale));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(saturnRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(saturnRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(saturnRotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-		m_Saturn.Draw(m_ModelShader, m_ModelMatrix);
-
-		#pragma endregion
-
-		#pragma region Draw Uranus
-
-		// Sun is at the origin and its radius is 696,340 km, our models have a 5 meter radius.
-		m_ModelMatrix = mat4(1.0f);
-		m_ModelMatrix = translate(m_ModelMatrix, uranusPosition);
-		m_ModelMatrix = scale(m_ModelMatrix, vec3(uranusScale));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(uranusRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(uranusRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(uranusRotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-		m_Uranus.Draw(m_ModelShader, m_ModelMatrix);
-
-		#pragma endregion
+		//Cull The Bodies Against The View Before Anything is Drawn. Models Still Loading Have No Radius Yet & Come Out as Points.
+		m_Profiler.Begin("Culling");
+		const double pixelsPerRadian = m_BufferHeight / (2.0 * tan(radians((double)m_Camera.Zoom) * 0.5));
+		const Frustum frustum = Frustum::FromMatrix(viewProjection);
+		m_BodyRadii.resize(bodies.size());
+		for (size_t i = 0; i < bodies.size(); i++)
+		{
+			const int terrain = m_BodyTerrains[i];
+			const float radius = terrain < 0 ? m_Models[bodies.models[i]].BoundingRadius()
+											 : m_Scene.terrains[terrain].radius * (1.0f + m_Scene.terrains[terrain].heightScale);
+			m_BodyRadii[i] = radius * bodies.scales[i];
+		}
+		m_BodyBVH.Update(bodies.positions.data(), m_BodyRadii.data(), bodies.size());
+		m_BodyBVH.Cull(frustum, m_Camera.Position, pixelsPerRadian, m_MinBodyPixels, m_VisibleBodies, m_PointBodies);
+		m_Profiler.End();
+
+		//Ask For Texture Detail by How Large Each Body Appears, The Streamer Loads & Evicts Mip Levels to Match.
+		//Bodies Out of View Ask For Nothing, Their Levels Are The First to Go Once The Budget Runs Out.
+		m_Profiler.Begin("Texture Streaming");
+		m_TextureStreamer.Begin();
+		for (uint32_t i : m_VisibleBodies)
+		{
+			const double radius = m_BodyRadii[i];
+			const double distance = glm::length(bodies.positions[i] - m_Camera.Position);
+			//Inside or Touching The Body Everything is Wanted.
+			const double pixels = distance > radius ? 2.0 * asin(radius / distance) * pixelsPerRadian : 1e9;
+			m_TextureStreamer.Request(m_Models[bodies.models[i]], (float)pixels);
+		}
+		m_TextureStreamer.Update();
+		m_Profiler.End();
 
-		glEnable(GL_CULL_FACE);
+		m_Profiler.Begin("Bodies");
+		if (GLExtensions::MultiDrawIndirect)
+		{
+			//Every Body Goes Out in One Multi Draw, Bodies Sharing a Model Become Instances.
+			m_BatchedShader.use();
+
+			m_BodyRenderer.Begin();
+			for (uint32_t i : m_VisibleBodies)
+				if (!(bodies.flags[i] & BodyTerrain))
+					m_BodyRenderer.Submit(bodies.models[i], bodies.matrices[i], (bodies.flags[i] & BodyDoubleSided) != 0);
+			m_BodyRenderer.Draw(m_Models);
+		}
+		else
+		{
+			m_ModelShader.use();
 
-		#pragma region Draw Neptune
+			bool cullingEnabled = true;
+			for (uint32_t i : m_VisibleBodies)
+			{
+				if (bodies.flags[i] & BodyTerrain)
+					continue;
 
-		// Sun is at the origin and its radius is 696,340 km, our models have a 5 meter radius.
-		m_ModelMatrix = mat4(1.0f);
-		m_ModelMatrix = translate(m_ModelMatrix, neptunePosition);
-		m_ModelMatrix = scale(m_ModelMatrix, vec3(neptuneScale));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(neptuneRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(neptuneRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(neptuneRotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-		m_Neptune.Draw(m_ModelShader, m_ModelMatrix);
+				//TODO: Replace Rings with asteroids that are instanced.
+				// Rings (Saturn & Uranus) have to be drawn from both sides.
+				bool doubleSided = (bodies.flags[i] & BodyDoubleSided) != 0;
+				if (doubleSided == cullingEnabled)
+				{
+					cullingEnabled = !doubleSided;
+					if (cullingEnabled)
+						glEnable(GL_CULL_FACE);
+					else
+						glDisable(GL_CULL_FACE);
+				}
 
-		#pragma endregion
+				m_Models[bodies.models[i]].Draw(m_ModelUniforms, bodies.matrices[i]);
+			}
 
-		#pragma region Draw Pluto
+			if (!cullingEnabled)
+				glEnable(GL_CULL_FACE);
+		}
+		m_Profiler.End();
 
-		// Sun is at the origin and its radius is 696,340 km, our models have a 5 meter radius.
-		m_ModelMatrix = mat4(1.0f);
-		m_ModelMatrix = translate(m_ModelMatrix, plutoPosition);
-		m_ModelMatrix = scale(m_ModelMatrix, vec3(plutoScale));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(plutoRotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(plutoRotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		m_ModelMatrix = rotate(m_ModelMatrix, glm::radians(plutoRotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-		m_Pluto.Draw(m_ModelShader, m_ModelMatrix);
+		//Terrain Bodies in View Refine Their Patches For The Camera, Then Draw With The Material of Their Model.
+		if (!m_Terrains.empty())
+		{
+			ProfileScope scope(m_Profiler, "Terrain");
+			m_ModelShader.use();
+			for (uint32_t body : m_VisibleBodies)
+			{
+				if (m_BodyTerrains[body] < 0)
+					continue;
+
+				const Model& model = m_Models[bodies.models[body]];
+				PlanetTerrain& terrain = *m_Terrains[m_BodyTerrains[body]];
+				if (!terrain.IsReady() || !model.IsLoaded())
+					continue;
+
+				//The Camera in The Body's Own Space, The Matrix Holds Its Rotation & Scale Around The Floating Origin.
+				const mat3 basis = mat3(bodies.matrices[body]);
+				const dvec3 offset = bodies.positions[body] - m_Camera.Position;
+				terrain.Update(inverse(dmat3(basis)) * -offset, pixelsPerRadian);
+				terrain.Draw(m_ModelUniforms, model.meshes[0].material, frustum, offset, basis);
+			}
+		}
 
 		#pragma endregion
 
 		glFrontFace(GL_CCW);
+		m_Profiler.End();
 
 		#pragma endregion
 	
 		#pragma region Deferred Rendering - Lighting Pass
 
+		//Place This Frame's Lights, Then List The Ones Reaching Each Tile of The Screen From The gBuffer's Depth.
+		m_Profiler.Begin("Light Culling");
+		m_Scene.EvaluateLights(m_BodyRadii.data(), m_Camera.Position, m_Lights);
+		m_TiledLighting.Upload(m_Lights);
+		m_TiledLighting.Cull(m_GDepth, view, m_ProjectionMatrix);
+		m_Profiler.End();
+
+		m_Profiler.Begin("Lighting Pass");
+
 		//Calculate Lighting Result Of gBuffer in HDR Render Buffer & Extract Fragment & Brightness Color.
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_RenderFBO);
 
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		//Full Screen Passes Don't Test Depth, a Quad at z = 0 Would Fail The Reversed-Z Test Against The Cleared Depth.
+		glDisable(GL_DEPTH_TEST);
+
 		m_LightShader.use();
 
 		#pragma region Set Lighting Uniforms
 
-		m_LightShader.setVector3("pointLight.position", lightPosition);
-		m_LightShader.setVector3("pointLight.color", lightColor);
-		m_LightShader.setFloat("pointLight.intensity", lightIntensity);
+		//The gBuffer Holds Camera Relative Positions, So Do The Lights & The Viewer Sits at The Origin.
+		m_ViewPosUniform.set(vec3(0.0f));
+		m_EmissionStrengthUniform.set(emissionStrength);
 
-		m_LightShader.setVector3("viewPos", m_Camera.Position);
+		//Positions Are Rebuilt From Depth, Back Through The Same Camera Relative View Projection The Geometry Was Drawn With.
+		m_InverseViewProjectionUniform.set(inverse(viewProjection));
 
 		#pragma endregion
 
 		#pragma region Bind Textures
 
 		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, m_GPosition);
+		glBindTexture(GL_TEXTURE_2D, m_GDepth);
 		glActiveTexture(GL_TEXTURE1);
 		glBindTexture(GL_TEXTURE_2D, m_GNormal);
 		glActiveTexture(GL_TEXTURE2);
@@ -618,41 +806,19 @@ void SolarSystem::RenderLoop()
 		glBindTexture(GL_TEXTURE_CUBE_MAP, m_PrefilterMap);
 		glActiveTexture(GL_TEXTURE7);
 		glBindTexture(GL_TEXTURE_2D, m_BrdfLUTTexture);
+		m_TiledLighting.Bind(8);
 
 		#pragma endregion
 
 		RenderQuad();
-
-		#pragma endregion
-
-		#pragma region Bloom Pass
-
-		bool horizontal = true;
-
-		//Copy The Brightness Texture From m_RenderFBO to m_BloomFBO.
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_RenderFBO);
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_BloomFBO[0]);
-
-		glReadBuffer(GL_COLOR_ATTACHMENT1);
-		glDrawBuffer(GL_COLOR_ATTACHMENT0);
-		glBlitFramebuffer(0, 0, m_BufferWidth, m_BufferHeight, 0, 0, m_BufferWidth, m_BufferHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-
-		m_BloomShader.use();
-		for (int i = 0; i < 2 * bloomAmount; ++i)
-		{
-			//Bind Bloom FBO for Further Blurring of Brightness Texture.
-			glBindFramebuffer(GL_FRAMEBUFFER, m_BloomFBO[horizontal]);
-			m_BloomShader.setInt("horizontal", horizontal);
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, m_BloomTexture[!horizontal]);
-			RenderQuad();
-			horizontal = !horizontal;
-		}
+		m_Profiler.End();
 
 		#pragma endregion
 
 		#pragma region HDR Render Pass
 
+		m_Profiler.Begin("Skybox & Impostors");
+
 		//Copy The Depth Buffer From gBuffer To HDR Render Buffer.
 		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_GBuffer);
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_RenderFBO);
@@ -667,46 +833,110 @@ void SolarSystem::RenderLoop()
 
 		#pragma region Draw Skybox
 
-		glDepthFunc(GL_LEQUAL);
+		//The Skybox Sits Exactly on The Far Plane, So it Only Fills Pixels No Body Covered.
+		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(m_ReversedZ ? GL_GEQUAL : GL_LEQUAL);
 		mat4 skyViewProjection = m_ProjectionMatrix * mat4(mat3(view));
 		m_SkyboxShader.use();
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, m_EnvCubemap);
-		m_SkyboxShader.setMat4("viewProjection", skyViewProjection);
+		m_SkyViewProjectionUniform.set(skyViewProjection);
 		RenderCube();
-		glDepthFunc(GL_LESS);
+		glDepthFunc(m_ReversedZ ? GL_GREATER : GL_LESS);
+		glDisable(GL_DEPTH_TEST);
 
 		#pragma endregion
 
+		#pragma region Draw Impostors
+
+		//Bodies Too Small For Their Meshes Are Sprites, All in One Draw Over The Lit Scene & The Sky, Before Bloom So Bright Ones Bloom.
+		m_Impostors.Begin();
+		for (uint32_t i : m_PointBodies)
+			m_Impostors.Add(bodies.models[i], vec3(bodies.positions[i] - m_Camera.Position), m_BodyRadii[i]);
+		//Sprites Are Lit by The Scene's First Light Alone, The Sun.
+		const PointLight primary = m_Lights.empty() ? PointLight{ vec3(0.0f), 0.0f, vec3(0.0f) } : m_Lights[0];
+		m_Impostors.Draw(m_Camera.Right, m_Camera.Up, (float)pixelsPerRadian, primary.position, primary.radiance, emissionStrength);
+		glDisable(GL_DEPTH_TEST);
+
+		#pragma endregion
+
+		m_Profiler.End();
+
+		#pragma endregion
+
+		#pragma region Bloom Pass
+
+		//Blur The Brightness Down & Back Up a Chain of Ever Smaller Levels, Every Level Widens The Bloom For a Quarter of The Last One's Cost.
+		m_Profiler.Begin("Bloom");
+		bloomLevels = std::min(std::max(bloomLevels, 1), m_Bloom.LevelCount());
+		m_Bloom.Render(m_FinalColorBufferTexture[1], bloomLevels, bloomRadius);
+		m_Profiler.End();
+
 		#pragma endregion
 
 		#pragma region Draw Screen Quad with Post Processing Shader
 
-		// now bind back to default framebuffer and draw a quad plane with the attached framebuffer color texture
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		m_Profiler.Begin("Post Processing");
+
+		// now bind back to default framebuffer (the output texture headless) and draw a quad plane with the attached framebuffer color texture
+		glBindFramebuffer(GL_FRAMEBUFFER, m_OutputFBO);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, m_FinalColorBufferTexture[0]);	// use the color attachment texture as the texture of the quad plane
 		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, m_BloomTexture[!horizontal]);
+		glBindTexture(GL_TEXTURE_2D, m_Bloom.Result());
 		m_PostProcessingShader.use();
-		m_PostProcessingShader.setFloat("exposure", exposure);
-		m_PostProcessingShader.setUInt("toneMapping", toneMapping);
+		m_ExposureUniform.set(exposure);
+		m_ToneMappingUniform.set(toneMapping);
+		//The Result Sums Every Level, Each as Bright as The Brightness Texture.
+		m_BloomStrengthUniform.set(bloomStrength / bloomLevels);
 
 		RenderQuad();
+		m_Profiler.End();
+
+		if (!m_Options.capture.empty() && frame % m_Options.captureInterval == 0)
+		{
+			ProfileScope scope(m_Profiler, "Capture");
+			CaptureFrame(frame);
+		}
 
 		#pragma endregion
 
 		#pragma region Draw ImGui
 
+		m_Profiler.Begin("ImGui");
+
+		//Headless The Settings Still Run, So The Frame Does The Same Work, But Nothing is Drawn.
 		ImGui_ImplOpenGL3_NewFrame();
-		ImGui_ImplGlfw_NewFrame();
+		if (m_Options.headless)
+		{
+			ImGui::GetIO().DisplaySize = ImVec2((float)m_BufferWidth, (float)m_BufferHeight);
+			ImGui::GetIO().DeltaTime = m_Options.frameTime;
+		}
+		else
+			ImGui_ImplGlfw_NewFrame();
 		ImGui::NewFrame();
 
 		ImGui::Begin("Settings");
 
 		// FPS
 		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+		if (GLExtensions::MultiDrawIndirect)
+			ImGui::Text("Bodies: %u meshes in %u multi draw call(s), %u texture arrays", m_BodyRenderer.DrawnMeshes(), m_BodyRenderer.DrawCalls(), m_BodyRenderer.TextureArrayCount());
+		else
+			ImGui::Text("Bodies: one draw call per mesh (no multi draw indirect)");
+		ImGui::Text("Textures: %zu streamed, %.1f MB resident, %u loading", m_TextureStreamer.TextureCount(),
+					m_TextureStreamer.ResidentBytes() / (1024.0 * 1024.0), m_TextureStreamer.LoadsInFlight());
+		ImGui::Text("Culling: %zu of %zu bodies in view, %zu of them sprites (%u drawn)", m_VisibleBodies.size() + m_PointBodies.size(),
+					m_Scene.bodies.size(), m_PointBodies.size(), m_Impostors.DrawnSprites());
+		ImGui::Checkbox("Profiler", &m_ShowProfiler);
+		ImGui::DragFloat("Sprite Below (px)", &m_MinBodyPixels, 0.05f, 0.0f, 16.0f);
+		for (size_t t = 0; t < m_Terrains.size(); t++)
+			ImGui::Text("%s: %u terrain patches, %u building", m_Scene.bodies.names[m_Scene.terrains[t].body].c_str(),
+						m_Terrains[t]->DrawnPatches(), m_Terrains[t]->BuildsInFlight());
+		int textureBudget = (int)(m_TextureStreamer.Budget() >> 20);
+		if (ImGui::DragInt("Texture Budget (MB)", &textureBudget, 4.0f, 64, 16384))
+			m_TextureStreamer.SetBudget((size_t)std::max(64, textureBudget) << 20);
 
 		ImGui::NewLine();
 
@@ -733,109 +963,240 @@ void SolarSystem::RenderLoop()
 		if (toneMapping == 0)
 			ImGui::SliderFloat("Exposure", &exposure, 0.0f, 10.0f);
 
-		ImGui::DragInt("Bloom Amount", &bloomAmount);
+		ImGui::SliderInt("Bloom Levels", &bloomLevels, 1, m_Bloom.LevelCount());
+		ImGui::DragFloat("Bloom Radius", &bloomRadius, 0.01f, 0.0f, 4.0f, "%.2f");
+		ImGui::DragFloat("Bloom Strength", &bloomStrength, 0.01f, 0.0f, 10.0f, "%.2f");
 
 		ImGui::NewLine();
 
 		ImGui::DragFloat("Fly Speed", &flySpeed, 0.01f, 0.0f, 1000000000.0f, "%.2f");
-		ImGui::DragFloat("Near Plane", &m_NearPlane, 0.01f, 0.0f, 1000000000.0f, "%.2f");
-		ImGui::DragFloat("Far Plane", &m_FarPlane, 0.01f, 0.0f, 1000000000.0f, "%.2f");
 
 		ImGui::NewLine();
 
-		ImGui::DragFloat3("Light Position", &lightPosition[0], 0.01f, -1000.0f, 1000.0f, "%.2f");
-		ImGui::ColorEdit3("Light Color", &lightColor[0]);
-		ImGui::DragFloat("Light Intensity", &lightIntensity, 0.01f, 0.0f, 100000000.0f, "%.2f");
+		ImGui::Text("Lights: %u, %s", m_TiledLighting.LightCount(), m_TiledLighting.Tiled() ? "culled per 16x16 tile" : "every light per pixel (no compute shaders)");
+		for (LightDesc& light : m_Scene.lights)
+		{
+			if (!ImGui::TreeNode(light.name.c_str()))
+				continue;
+			if (light.body < 0)
+				ImGui::DragScalarN("Position", ImGuiDataType_Double, &light.position[0], 3, 0.01f);
+			ImGui::ColorEdit3("Color", &light.color[0]);
+			if (light.reflects >= 0)
+				ImGui::SliderFloat("Albedo", &light.albedo, 0.0f, 1.0f);
+			else
+				ImGui::DragFloat("Intensity", &light.intensity, 0.01f, 0.0f, 100000000.0f, "%.2f");
+			ImGui::TreePop();
+		}
 
 		ImGui::DragFloat("Emission Strength", &emissionStrength, 0.01f, 0.0f, 1000.0f, "%.2f");
 
 		ImGui::NewLine();
 
-		ImGui::DragFloat("Sun Scale", &sunScale, 0.01f, 0.0f, 100000000.0f, "%.8f");
-		ImGui::DragFloat3("Sun Rotation", &sunRotation[0], 0.01f, -360.0f, 360.0f, "%.2f");
-
-		ImGui::NewLine();
-
-		ImGui::DragFloat3("Mercury Position", &mercuryPosition[0], 0.01f, -100000000.0f, 1000000000.0f, "%.2f");
-		ImGui::DragFloat("Mercury Scale", &mercuryScale, 0.01f, 0.0f, 100000000.0f, "%.8f");
-		ImGui::DragFloat3("Mercury Rotation", &mercuryRotation[0], 0.01f, -360.0f, 360.0f, "%.2f");
+		int year, month, day;
+		Orbits::CalendarDate(m_SimulationDays, year, month, day);
+		ImGui::Text("Date: %04d-%02d-%02d", year, month, day);
+		ImGui::DragFloat("Time Scale (Days/s)", &m_TimeScale, 0.1f, -100000.0f, 100000.0f, "%.2f");
+		if (ImGui::Button("Now"))
+		{
+			m_SimulationDays = Orbits::DaysSinceJ2000Now();
+			if (m_NBodyMode)
+				StartNBody();
+		}
+		// Starts From Where The Orbits Put The Bodies Today, Switching Back Snaps Them Back Onto Their Orbits.
+		if (ImGui::Checkbox("N-Body Gravity", &m_NBodyMode) && m_NBodyMode)
+			StartNBody();
 
 		ImGui::NewLine();
 
-		ImGui::DragFloat3("Venus Position", &venusPosition[0], 0.01f, -100000000.0f, 1000000000.0f, "%.2f");
-		ImGui::DragFloat("Venus Scale", &venusScale, 0.01f, 0.0f, 100000000.0f, "%.8f");
-		ImGui::DragFloat3("Venus Rotation", &venusRotation[0], 0.01f, -360.0f, 360.0f, "%.2f");
-
-		ImGui::NewLine();
+		BodyTable& editableBodies = m_Scene.bodies;
+		for (size_t i = 0; i < editableBodies.size(); i++)
+		{
+			if (!ImGui::TreeNode(editableBodies.names[i].c_str()))
+				continue;
 
-		ImGui::DragFloat3("Earth Position", &earthPosition[0], 0.01f, -100000000.0f, 1000000000.0f, "%.2f");
-		ImGui::DragFloat("Earth Scale", &earthScale, 0.01f, 0.0f, 100000000.0f, "%.8f");
-		ImGui::DragFloat3("Earth Rotation", &earthRotation[0], 0.01f, -360.0f, 360.0f, "%.2f");
+			// Orbiting bodies get their position from the orbit every frame.
+			if (!(editableBodies.flags[i] & BodyOrbiting))
+			{
+				const double minPosition = -100000000.0, maxPosition = 1000000000.0;
+				ImGui::DragScalarN("Position", ImGuiDataType_Double, &editableBodies.positions[i][0], 3, 0.01f, &minPosition, &maxPosition, "%.2f");
+			}
+			ImGui::DragFloat("Scale", &editableBodies.scales[i], 0.01f, 0.0f, 100000000.0f, "%.8f");
+			ImGui::DragFloat3("Rotation", &editableBodies.rotations[i][0], 0.01f, -360.0f, 360.0f, "%.2f");
+			ImGui::TreePop();
+		}
 
 		ImGui::NewLine();
 
-		ImGui::DragFloat3("Mars Position", &marsPosition[0], 0.01f, -100000000.0f, 1000000000.0f, "%.2f");
-		ImGui::DragFloat("Mars Scale", &marsScale, 0.01f, 0.0f, 100000000.0f, "%.8f");
-		ImGui::DragFloat3("Mars Rotation", &marsRotation[0], 0.01f, -360.0f, 360.0f, "%.2f");
-
-		ImGui::NewLine();
+		ImGui::End();
 
-		ImGui::DragFloat3("Jupiter Position", &jupiterPosition[0], 0.01f, -100000000.0f, 1000000000.0f, "%.2f");
-		ImGui::DragFloat("Jupiter Scale", &jupiterScale, 0.01f, 0.0f, 100000000.0f, "%.8f");
-		ImGui::DragFloat3("Jupiter Rotation", &jupiterRotation[0], 0.01f, -360.0f, 360.0f, "%.2f");
+		if (m_ShowProfiler)
+			m_Profiler.DrawPanel(&m_ShowProfiler, m_Options.trace.empty() ? "SolarSystem.trace.json" : m_Options.trace);
 
-		ImGui::NewLine();
-
-		ImGui::DragFloat3("Saturn Position", &saturnPosition[0], 0.01f, -100000000.0f, 1000000000.0f, "%.2f");
-		ImGui::DragFloat("Saturn Scale", &saturnScale, 0.01f, 0.0f, 100000000.0f, "%.8f");
-		ImGui::DragFloat3("Saturn Rotation", &saturnRotation[0], 0.01f, -360.0f, 360.0f, "%.2f");
+		ImGui::Render();
+		if (!m_Options.headless)
+		{
+			int display_w, display_h;
+			glfwGetFramebufferSize(m_Window, &display_w, &display_h);
+			glViewport(0, 0, display_w, display_h);
+			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		}
+		m_Profiler.End();
 
-		ImGui::NewLine();
+		#pragma endregion
 
-		ImGui::DragFloat3("Uranus Position", &uranusPosition[0], 0.01f, -100000000.0f, 1000000000.0f, "%.2f");
-		ImGui::DragFloat("Uranus Scale", &uranusScale, 0.01f, 0.0f, 100000000.0f, "%.8f");
-		ImGui::DragFloat3("Uranus Rotation", &uranusRotation[0], 0.01f, -360.0f, 360.0f, "%.2f");
+		//The Frame is Submitted, Warmup Frames Let Caches & Streaming Settle Before They Count.
+		if (benchmark)
+			m_Benchmark.EndFrame(frame >= m_Options.warmup);
+		m_Profiler.EndFrame();
 
-		ImGui::NewLine();
+		//Swap Buffers.
+		if (!m_Options.headless)
+			glfwSwapBuffers(m_Window);
+	}
 
-		ImGui::DragFloat3("Neptune Position", &neptunePosition[0], 0.01f, -100000000.0f, 1000000000.0f, "%.2f");
-		ImGui::DragFloat("Neptune Scale", &neptuneScale, 0.01f, 0.0f, 100000000.0f, "%.8f");
-		ImGui::DragFloat3("Neptune Rotation", &neptuneRotation[0], 0.01f, -360.0f, 360.0f, "%.2f");
+	if (m_Options.headless)
+	{
+		glFinish();
+		const double seconds = Seconds() - startSeconds;
+		cout << "Rendered " << m_Options.frames << " frames in " << seconds << " seconds, "
+			 << 1000.0 * seconds / std::max(1, m_Options.frames) << " ms per frame." << endl;
+	}
 
-		ImGui::NewLine();
+	if (benchmark)
+	{
+		m_Benchmark.Finish();
+
+		BenchmarkInfo info;
+		info.renderer = (const char*)glGetString(GL_RENDERER);
+		info.glVersion = (const char*)glGetString(GL_VERSION);
+		info.cameraPath = m_Options.cameraPath;
+		info.width = m_BufferWidth;
+		info.height = m_BufferHeight;
+		info.warmupFrames = m_Options.warmup;
+		info.frameTime = m_Options.frameTime;
+		info.days = m_Options.days;
+		info.reversedZ = m_ReversedZ;
+		info.multiDrawIndirect = GLExtensions::MultiDrawIndirect;
+		if (m_Benchmark.WriteReport(m_Options.benchmark, info))
+			cout << "Benchmark of " << m_Benchmark.MeasuredFrames() << " frames written to " << m_Options.benchmark << endl << m_Benchmark.Summary();
+		else
+			cout << "ERROR::BENCHMARK::REPORT_NOT_WRITTEN " << m_Options.benchmark << endl;
+	}
 
-		ImGui::DragFloat3("Pluto Position", &plutoPosition[0], 0.01f, -100000000.0f, 1000000000.0f, "%.2f");
-		ImGui::DragFloat("Pluto Scale", &plutoScale, 0.01f, 0.0f, 100000000.0f, "%.8f");
-		ImGui::DragFloat3("Pluto Rotation", &plutoRotation[0], 0.01f, -360.0f, 360.0f, "%.2f");
+	if (!m_Options.trace.empty())
+	{
+		m_Profiler.Finish();
+		if (m_Profiler.WriteChromeTrace(m_Options.trace))
+			cout << "Trace of the last " << Profiler::HistoryFrames << " frames written to " << m_Options.trace << endl;
+		else
+			cout << "ERROR::PROFILER::TRACE_NOT_WRITTEN " << m_Options.trace << endl;
+	}
+}
 
-		ImGui::NewLine();
+///<summary>Reads The Post Processed Frame Back & Writes It to The Capture Pattern, Full Floats to .exr, 8 Bits to .png.</summary>
+void SolarSystem::CaptureFrame(int frame)
+{
+	char path[1024];
+	snprintf(path, sizeof(path), m_Options.capture.c_str(), frame);
+	const std::string file = path;
+	const bool exr = file.size() >= 4 && file.compare(file.size() - 4, 4, ".exr") == 0;
+
+	//Headless The Frame is in The Output Texture, Otherwise in The Window's Back Buffer.
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_OutputFBO);
+	if (m_OutputFBO != 0)
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	const size_t pixels = (size_t)m_BufferWidth * m_BufferHeight;
+	if (exr)
+	{
+		std::vector<float> rgba(pixels * 4);
+		glReadPixels(0, 0, m_BufferWidth, m_BufferHeight, GL_RGBA, GL_FLOAT, rgba.data());
+		ImageWriter::WriteEXR(file, m_BufferWidth, m_BufferHeight, rgba.data());
+	}
+	else
+	{
+		std::vector<uint8_t> rgba(pixels * 4);
+		glReadPixels(0, 0, m_BufferWidth, m_BufferHeight, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+		ImageWriter::WritePNG(file, m_BufferWidth, m_BufferHeight, rgba.data());
+	}
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+}
 
-		ImGui::End();
+///<summary>Seeds The N-Body Simulation With Every Body That Has a Mass, At Its Orbital Position & Velocity Right Now.</summary>
+void SolarSystem::StartNBody()
+{
+	const BodyTable& bodies = m_Scene.bodies;
+	const OrbitTable& orbits = m_Scene.orbits;
 
-		ImGui::Render();
-		int display_w, display_h;
-		glfwGetFramebufferSize(m_Window, &display_w, &display_h);
-		glViewport(0, 0, display_w, display_h);
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	m_NBody.Clear();
+	m_NBodyBodies.clear();
+	size_t orbit = 0;
+	for (size_t i = 0; i < bodies.size(); i++)
+	{
+		dvec3 position = bodies.positions[i], velocity(0.0);
+		bool orbiting = orbit < orbits.size() && orbits.bodies[orbit] == i;
+		if (orbiting)
+			Orbits::StateVector(orbits, orbit++, m_SimulationDays, position, velocity);
+		if (bodies.masses[i] <= 0.0)
+			continue;
+
+		m_NBody.AddParticle(position, velocity, bodies.masses[i]);
+		m_NBodyBodies.push_back((uint32_t)i);
+	}
+	m_NBody.CenterOnBarycenter();
+}
 
-		#pragma endregion
+///<summary>Advances The N-Body Simulation by 'days', Split Into Steps Short Enough to Keep Mercury on Its Orbit.</summary>
+void SolarSystem::StepNBody(double days)
+{
+	// Mercury Needs Steps of About a Day, Past MaxSteps a Frame The Steps Get Longer Rather Than Stalling The Frame.
+	const double MaxStepDays = 0.5;
+	const int MaxSteps = 256;
 
-		//Swap Buffers.
-		glfwSwapBuffers(m_Window);
+	int steps = std::min(MaxSteps, (int)std::ceil(std::abs(days) / MaxStepDays));
+	for (int step = 0; step < steps; step++)
+		m_NBody.Step(days / steps);
 
-	}
+	for (size_t particle = 0; particle < m_NBodyBodies.size(); particle++)
+		m_Scene.bodies.positions[m_NBodyBodies[particle]] = m_NBody.Position(particle);
 }
 
 void SolarSystem::Cleanup()
 {
+	// Workers may still be decoding, they must finish before the models they write to go away.
+	m_AssetLoader.Shutdown();
+	m_TextureStreamer.Shutdown();
+	for (std::unique_ptr<PlanetTerrain>& terrain : m_Terrains)
+		terrain->Destroy();
+	m_BodyRenderer.Destroy();
+	m_Impostors.Destroy();
+	m_Benchmark.Destroy();
+	m_Profiler.Destroy();
+	m_Bloom.Destroy();
+	m_TiledLighting.Destroy();
+
 	ImGui_ImplOpenGL3_Shutdown();
-	ImGui_ImplGlfw_Shutdown();
+	if (!m_Options.headless)
+		ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();
 
+	if (m_Options.headless)
+	{
+		m_HeadlessContext.Destroy();
+		return;
+	}
 	glfwDestroyWindow(m_Window);
 	glfwTerminate();
 }
 
+double SolarSystem::Seconds() const
+{
+	if (!m_Options.headless)
+		return glfwGetTime();
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_StartTime).count();
+}
+
 unsigned int SolarSystem::LoadTexture(char const* path, bool sRGB)
 {
 	unsigned int textureID;
@@ -885,27 +1246,28 @@ unsigned int SolarSystem::LoadTexture(char const* path, bool sRGB)
 
 unsigned int SolarSystem::LoadHDRTexture(char const* path)
 {
-	int width, height, nrComponents;
-	float* data = stbi_loadf(path, &width, &height, &nrComponents, 0);
-	unsigned int hdrTexture = 0;
-	if (data)
-	{
-		glGenTextures(1, &hdrTexture);
-		glBindTexture(GL_TEXTURE_2D, hdrTexture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data); // note how we specify the texture's data value to be float
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
-	}
-	else
+	TextureData data = TextureData::Decode(path, true);
+	if (!data.valid())
 	{
 		std::cout << "Failed to load HDR image." << std::endl;
+		return 0;
 	}
 
+	return UploadHDRTexture(data);
+}
+
+unsigned int SolarSystem::UploadHDRTexture(const TextureData& data)
+{
+	unsigned int hdrTexture = 0;
+	glGenTextures(1, &hdrTexture);
+	glBindTexture(GL_TEXTURE_2D, hdrTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, data.width, data.height, 0, GL_RGB, GL_FLOAT, data.pixels.get()); // note how we specify the texture's data value to be float
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
 	return hdrTexture;
 }
 
@@ -1034,7 +1396,7 @@ void SolarSystem::UpdateAllFramebuffersSize(int bufferWidth, int bufferHeight)
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_FinalColorBufferTexture[i], 0);
 	}
 	glBindRenderbuffer(GL_RENDERBUFFER, m_FinalRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, bufferWidth, bufferHeight);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, bufferWidth, bufferHeight);
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_FinalRBO);
 	// tell OpenGL which color attachments we'll use (of this framebuffer) for rendering 
 	unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
@@ -1047,52 +1409,41 @@ void SolarSystem::UpdateAllFramebuffersSize(int bufferWidth, int bufferHeight)
 
 	glBindFramebuffer(GL_FRAMEBUFFER, m_GBuffer);
 
-	// position color buffer
-	glBindTexture(GL_TEXTURE_2D, m_GPosition);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, bufferWidth, bufferHeight, 0, GL_RGB, GL_FLOAT, NULL);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_GPosition, 0);
+	// gDepth Buffer
+	glBindTexture(GL_TEXTURE_2D, m_GDepth);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, bufferWidth, bufferHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_GDepth, 0);
 
 	// normal color buffer
 	glBindTexture(GL_TEXTURE_2D, m_GNormal);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, bufferWidth, bufferHeight, 0, GL_RGB, GL_FLOAT, NULL);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_GNormal, 0);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16, bufferWidth, bufferHeight, 0, GL_RG, GL_UNSIGNED_SHORT, NULL);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_GNormal, 0);
 
 	// Albedo color buffer
 	glBindTexture(GL_TEXTURE_2D, m_GAlbedo);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, bufferWidth, bufferHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, m_GAlbedo, 0);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, bufferWidth, bufferHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_GAlbedo, 0);
 
 	// Emission color buffer
 	glBindTexture(GL_TEXTURE_2D, m_GEmission);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, bufferWidth, bufferHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, m_GEmission, 0);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB10_A2, bufferWidth, bufferHeight, 0, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, NULL);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, m_GEmission, 0);
 
 	// Metallic Roughness color buffer
 	glBindTexture(GL_TEXTURE_2D, m_GMetallicRoughness);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG, bufferWidth, bufferHeight, 0, GL_RG, GL_UNSIGNED_BYTE, NULL);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT4, GL_TEXTURE_2D, m_GMetallicRoughness, 0);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, bufferWidth, bufferHeight, 0, GL_RG, GL_UNSIGNED_BYTE, NULL);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, m_GMetallicRoughness, 0);
 
-	unsigned int colorAttachments[5] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4 };
-	glDrawBuffers(5, colorAttachments);
-
-	// gDepth Buffer
-	glBindRenderbuffer(GL_RENDERBUFFER, m_GDepth);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, bufferWidth, bufferHeight);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_GDepth);
+	unsigned int colorAttachments[4] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
+	glDrawBuffers(4, colorAttachments);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	#pragma endregion
 
 	#pragma region Resize Bloom Buffer
 
-	for (unsigned int i = 0; i < 2; ++i)
-	{
-		glBindFramebuffer(GL_FRAMEBUFFER, m_BloomFBO[i]);
-		glBindTexture(GL_TEXTURE_2D, m_BloomTexture[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, bufferWidth, bufferHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_BloomTexture[i], 0);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	}
+	m_Bloom.Resize(bufferWidth, bufferHeight);
+	m_TiledLighting.Resize(bufferWidth, bufferHeight);
 
 	#pragma endregion
 
@@ -1196,11 +1547,99 @@ void SolarSystem::RenderCube()
 	glBindVertexArray(0);
 }
 
+///<summary>Projection For The Current Field of View & Window.</summary>
+mat4 SolarSystem::CalculateProjectionMatrix() const
+{
+	return CalculateProjectionMatrix(m_Camera.Zoom, (float)m_BufferWidth / (float)m_BufferHeight);
+}
+
+///<summary>Infinite Reversed-Z Projection if Supported, Else a Regular Projection Whose Depth Model.vs Replaces.</summary>
+mat4 SolarSystem::CalculateProjectionMatrix(float fieldOfView, float aspect) const
+{
+	if (!m_ReversedZ)
+		return perspective(radians(fieldOfView), aspect, NEAR_PLANE, LOG_DEPTH_FAR);
+
+	// Depth = Near / Distance: 1 at The Near Plane, Approaching 0 at Infinity, Where a Float's Exponent Keeps The Precision.
+	float focalLength = 1.0f / tan(radians(fieldOfView) * 0.5f);
+	mat4 projection(0.0f);
+	projection[0][0] = focalLength / aspect;
+	projection[1][1] = focalLength;
+	projection[2][3] = -1.0f;
+	projection[3][2] = NEAR_PLANE;
+	return projection;
+}
+
+///<summary>Scale of The Logarithmic Depth The Vertex Shaders Write, 0 With Reversed-Z Where They Keep The Projection's Depth.</summary>
+float SolarSystem::LogDepthCoefficient() const
+{
+	return m_ReversedZ ? 0.0f : 2.0f / log2(LOG_DEPTH_FAR + 1.0f);
+}
+
+///<summary>Renders The Albedo & Emission of a Model Into Its Impostor With The Model Shaders, Seen From The Front.</summary>
+void SolarSystem::BakeImpostor(uint32_t model)
+{
+	const mat4 modelMatrix = m_Impostors.BeginBake(model, m_Models[model].BoundingRadius());
+
+	//The Bake Camera Sits at The Origin Looking Down -Z, Like The Floating Origin View Would Without Turning.
+	const mat4 viewProjection = CalculateProjectionMatrix(ImpostorRenderer::BakeFieldOfView(), 1.0f);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_MatricesUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(mat4), value_ptr(viewProjection));
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	//Rings Are Seen From Both Sides, The Depth Test Sorts Out The Rest.
+	glDisable(GL_CULL_FACE);
+	glFrontFace(GL_CW);
+	//Terrain Draws Sample The 2D Textures of Its Model, Which BodyRenderer Would Move Into Its Arrays & Delete.
+	if (GLExtensions::MultiDrawIndirect && !m_TerrainModels[model])
+	{
+		//Once BodyRenderer Adopted The Textures Only The Batched Shader Can Sample Them.
+		m_BatchedShader.use();
+		m_BodyRenderer.Begin();
+		m_BodyRenderer.Submit(model, modelMatrix, true);
+		m_BodyRenderer.Draw(m_Models);
+	}
+	else
+	{
+		m_ModelShader.use();
+		m_Models[model].Draw(m_ModelUniforms, modelMatrix);
+	}
+	glFrontFace(GL_CCW);
+	glEnable(GL_CULL_FACE);
+
+	m_Impostors.EndBake(model, m_Models[model].TextureVersion());
+	glViewport(0, 0, m_BufferWidth, m_BufferHeight);
+}
+
+///<summary>Sets Clip Control, Depth Clear Value & Depth Test For The Main Passes.</summary>
+void SolarSystem::ApplyDepthConvention()
+{
+	if (m_ReversedZ)
+	{
+		glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+		glClearDepth(0.0);
+		glDepthFunc(GL_GREATER);
+	}
+	else
+	{
+		glClearDepth(1.0);
+		glDepthFunc(GL_LESS);
+	}
+}
+
 void SolarSystem::SetupPBR(unsigned int hdrTexture)
 {
+	// The Capture Passes Use Ordinary Projections, Switch to The Standard Depth Convention Until They're Done.
+	if (m_ReversedZ)
+		glClipControl(GL_LOWER_LEFT, GL_NEGATIVE_ONE_TO_ONE);
+	glEnable(GL_DEPTH_TEST);
+	glClearDepth(1.0);
+	glDepthFunc(GL_LESS);
+
 	// Setup framebuffer
 	// ----------------------
 	if (!m_PbrInitialized)
+		AllocateIBLMaps();
+	if (!m_CaptureFBO)
 	{
 		glGenFramebuffers(1, &m_CaptureFBO);
 		glGenRenderbuffers(1, &m_CaptureRBO);
@@ -1208,25 +1647,9 @@ void SolarSystem::SetupPBR(unsigned int hdrTexture)
 
 	glBindFramebuffer(GL_FRAMEBUFFER, m_CaptureFBO);
 	glBindRenderbuffer(GL_RENDERBUFFER, m_CaptureRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 1024, 1024);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, IBLCache::EnvironmentSize, IBLCache::EnvironmentSize);
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_CaptureRBO);
 
-	// Setup cubemap to render to and attach to framebuffer
-	// ---------------------------------------------------------
-	if (!m_PbrInitialized)	glGenTextures(1, &m_EnvCubemap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_EnvCubemap);
-	if (!m_PbrInitialized)
-	{
-		for (unsigned int i = 0; i < 6; ++i)
-		{
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 1024, 1024, 0, GL_RGB, GL_FLOAT, nullptr);
-		}
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // enable pre-filter mipmap sampling (combatting visible dots artifact)
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	}
 	// pbr: set up projection and view matrices for capturing data onto the 6 cubemap face directions
 	// ----------------------------------------------------------------------------------------------
 	mat4 captureProjection = perspective(radians(90.0f), 1.0f, 0.1f, 10.0f);
@@ -1249,7 +1672,7 @@ void SolarSystem::SetupPBR(unsigned int hdrTexture)
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, hdrTexture);
 
-	glViewport(0, 0, 1024, 1024); // don't forget to configure the viewport to the capture dimensions.
+	glViewport(0, 0, IBLCache::EnvironmentSize, IBLCache::EnvironmentSize); // don't forget to configure the viewport to the capture dimensions.
 	glBindFramebuffer(GL_FRAMEBUFFER, m_CaptureFBO);
 	for (unsigned int i = 0; i < 6; ++i)
 	{
@@ -1266,24 +1689,9 @@ void SolarSystem::SetupPBR(unsigned int hdrTexture)
 
 	// Create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
 	// --------------------------------------------------------------------------------
-	if (!m_PbrInitialized)	glGenTextures(1, &m_IrradianceMap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_IrradianceMap);
-	if (!m_PbrInitialized)
-	{
-		for (unsigned int i = 0; i < 6; ++i)
-		{
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 64, 64, 0, GL_RGB, GL_FLOAT, nullptr);
-		}
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	}
 	glBindFramebuffer(GL_FRAMEBUFFER, m_CaptureFBO);
 	glBindRenderbuffer(GL_RENDERBUFFER, m_CaptureRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 64, 64);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, IBLCache::IrradianceSize, IBLCache::IrradianceSize);
 
 	// pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
 	// -----------------------------------------------------------------------------
@@ -1294,7 +1702,7 @@ void SolarSystem::SetupPBR(unsigned int hdrTexture)
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_CUBE_MAP, m_EnvCubemap);
 
-	glViewport(0, 0, 64, 64); // don't forget to configure the viewport to the capture dimensions.
+	glViewport(0, 0, IBLCache::IrradianceSize, IBLCache::IrradianceSize); // don't forget to configure the viewport to the capture dimensions.
 	glBindFramebuffer(GL_FRAMEBUFFER, m_CaptureFBO);
 	for (unsigned int i = 0; i < 6; ++i)
 	{
@@ -1306,25 +1714,6 @@ void SolarSystem::SetupPBR(unsigned int hdrTexture)
 	}
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-	// Create a pre-filter cubemap, and re-scale capture FBO to pre-filter scale.
-	// --------------------------------------------------------------------------------
-	if (!m_PbrInitialized)	glGenTextures(1, &m_PrefilterMap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_PrefilterMap);
-	if (!m_PbrInitialized)
-	{
-		for (unsigned int i = 0; i < 6; ++i)
-		{
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 256, 256, 0, GL_RGB, GL_FLOAT, nullptr);
-		}
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // be sure to set minification filter to mip_linear 
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	}
-	// Generate mipmaps for the cubemap so OpenGL automatically allocates the required memory.
-	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
 	// Run a quasi monte-carlo simulation on the environment lighting to create a prefilter (cube)map.
 	// ----------------------------------------------------------------------------------------------------
 	Shader prefilterShader(PROJECT_DIR"/src/Shaders/cubemap.vs", PROJECT_DIR"/src/Shaders/prefilter.fs");
@@ -1335,12 +1724,12 @@ void SolarSystem::SetupPBR(unsigned int hdrTexture)
 	glBindTexture(GL_TEXTURE_CUBE_MAP, m_EnvCubemap);
 
 	glBindFramebuffer(GL_FRAMEBUFFER, m_CaptureFBO);
-	unsigned int maxMipLevels = 5;
+	unsigned int maxMipLevels = IBLCache::PrefilterLevels;
 	for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
 	{
 		// reisze framebuffer according to mip-level size.
-		unsigned int mipWidth = static_cast<unsigned int>(256 * std::pow(0.5, mip));
-		unsigned int mipHeight = static_cast<unsigned int>(256 * std::pow(0.5, mip));
+		unsigned int mipWidth = static_cast<unsigned int>(IBLCache::PrefilterSize * std::pow(0.5, mip));
+		unsigned int mipHeight = static_cast<unsigned int>(IBLCache::PrefilterSize * std::pow(0.5, mip));
 		glBindRenderbuffer(GL_RENDERBUFFER, m_CaptureRBO);
 		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
 		glViewport(0, 0, mipWidth, mipHeight);
@@ -1360,28 +1749,15 @@ void SolarSystem::SetupPBR(unsigned int hdrTexture)
 
 	// Generate a 2D LUT from the BRDF equations used.
 	// ----------------------------------------------------
-	if (!m_PbrInitialized)	glGenTextures(1, &m_BrdfLUTTexture);
 	Shader brdfShader(PROJECT_DIR"/src/Shaders/brdf.vs", PROJECT_DIR"/src/Shaders/brdf.fs");
 
-	// pre-allocate enough memory for the LUT texture.
-	glBindTexture(GL_TEXTURE_2D, m_BrdfLUTTexture);
-	if (!m_PbrInitialized)
-	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 1024, 1024, 0, GL_RG, GL_FLOAT, 0);
-		// be sure to set wrapping mode to GL_CLAMP_TO_EDGE
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	}
-
 	// then re-configure capture framebuffer object and render screen-space quad with BRDF shader.
 	glBindFramebuffer(GL_FRAMEBUFFER, m_CaptureFBO);
 	glBindRenderbuffer(GL_RENDERBUFFER, m_CaptureRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 1024, 1024);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, IBLCache::BrdfLUTSize, IBLCache::BrdfLUTSize);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_BrdfLUTTexture, 0);
 
-	glViewport(0, 0, 1024, 1024);
+	glViewport(0, 0, IBLCache::BrdfLUTSize, IBLCache::BrdfLUTSize);
 	brdfShader.use();
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	RenderQuad();
@@ -1390,10 +1766,96 @@ void SolarSystem::SetupPBR(unsigned int hdrTexture)
 	glViewport(0, 0, m_BufferWidth, m_BufferHeight);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+	ApplyDepthConvention();
+}
+
+/// @brief Allocates The Image Based Lighting Maps, Baked by SetupPBR or Uploaded From The Cache.
+void SolarSystem::AllocateIBLMaps()
+{
+	// Setup cubemap to render the environment to.
+	glGenTextures(1, &m_EnvCubemap);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, m_EnvCubemap);
+	for (unsigned int i = 0; i < 6; ++i)
+	{
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, IBLCache::EnvironmentSize, IBLCache::EnvironmentSize, 0, GL_RGB, GL_FLOAT, nullptr);
+	}
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // enable pre-filter mipmap sampling (combatting visible dots artifact)
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// Create an irradiance cubemap.
+	glGenTextures(1, &m_IrradianceMap);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, m_IrradianceMap);
+	for (unsigned int i = 0; i < 6; ++i)
+	{
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, IBLCache::IrradianceSize, IBLCache::IrradianceSize, 0, GL_RGB, GL_FLOAT, nullptr);
+	}
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// Create a pre-filter cubemap.
+	glGenTextures(1, &m_PrefilterMap);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, m_PrefilterMap);
+	for (unsigned int i = 0; i < 6; ++i)
+	{
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, IBLCache::PrefilterSize, IBLCache::PrefilterSize, 0, GL_RGB, GL_FLOAT, nullptr);
+	}
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // be sure to set minification filter to mip_linear 
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	// Generate mipmaps for the cubemap so OpenGL automatically allocates the required memory.
+	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+	// pre-allocate enough memory for the LUT texture.
+	glGenTextures(1, &m_BrdfLUTTexture);
+	glBindTexture(GL_TEXTURE_2D, m_BrdfLUTTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, IBLCache::BrdfLUTSize, IBLCache::BrdfLUTSize, 0, GL_RG, GL_FLOAT, 0);
+	// be sure to set wrapping mode to GL_CLAMP_TO_EDGE
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
 	//Set PBR Initialized as True.
 	m_PbrInitialized = true;
 }
 
+/// @brief The Maps SetupPBR Bakes, as The IBL Cache Stores Them.
+std::vector<IBLCache::Map> SolarSystem::IBLMaps() const
+{
+	return IBLCache::Maps(m_EnvCubemap, m_IrradianceMap, m_PrefilterMap, m_BrdfLUTTexture);
+}
+
+/// @brief Uploads The Maps of a Cache Instead of Baking Them.
+void SolarSystem::SetupPBR(const IBLCacheReader& cache)
+{
+	if (!m_PbrInitialized)
+		AllocateIBLMaps();
+	cache.Upload(IBLMaps());
+	SetIrradianceSH(cache.Irradiance());
+
+	// The Environment's Mips Come From Level 0, Exactly as After a Bake.
+	glBindTexture(GL_TEXTURE_CUBE_MAP, m_EnvCubemap);
+	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+/// @brief Hands The Lighting Pass The Spherical Harmonics of The Irradiance, Which It Reads Instead of The Irradiance Map After a CPU Bake.
+void SolarSystem::SetIrradianceSH(const SphericalHarmonics& irradiance)
+{
+	m_LightShader.use();
+	m_LightShader.setVector3Array("irradianceSH", irradiance.coefficients, 9);
+	m_LightShader.setBool("irradianceFromSH", m_Options.cpuIBL);
+}
+
 /// @brief Custom Styling for ImGui
 /// Credits: https://github.com/malamanteau
 void SolarSystem::SetCustomImGuiStyle()
@@ -1465,11 +1927,101 @@ void SolarSystem::SetCustomImGuiStyle()
 	style.GrabRounding = 3;
 }
 
-int main()
+SimulationOptions SimulationOptions::Parse(int argc, char** argv)
+{
+	SimulationOptions options;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		auto value = [&]() -> std::string
+		{
+			if (i + 1 >= argc)
+				throw std::invalid_argument("ERROR::OPTIONS::MISSING_VALUE: " + argument);
+			return argv[++i];
+		};
+		auto count = [&]() -> int
+		{
+			const std::string text = value();
+			const int number = atoi(text.c_str());
+			if (number < 1)
+				throw std::invalid_argument("ERROR::OPTIONS::NOT_A_POSITIVE_NUMBER: " + argument + " " + text);
+			return number;
+		};
+
+		if (argument == "--headless")
+			options.headless = true;
+		else if (argument == "--frames")
+			options.frames = count();
+		else if (argument == "--capture-every")
+			options.captureInterval = count();
+		else if (argument == "--frame-time")
+			options.frameTime = (float)atof(value().c_str());
+		else if (argument == "--days")
+			options.days = atof(value().c_str());
+		else if (argument == "--camera-path")
+			options.cameraPath = value();
+		else if (argument == "--benchmark")
+			options.benchmark = value();
+		else if (argument == "--trace")
+			options.trace = value();
+		else if (argument == "--cpu-ibl")
+			options.cpuIBL = true;
+		else if (argument == "--no-batching")
+			options.noBatching = true;
+		else if (argument == "--warmup")
+		{
+			const std::string text = value();
+			options.warmup = atoi(text.c_str());
+			if (options.warmup < 0)
+				throw std::invalid_argument("ERROR::OPTIONS::NEGATIVE_WARMUP: " + text);
+		}
+		else if (argument == "--size")
+		{
+			const std::string size = value();
+			if (sscanf(size.c_str(), "%dx%d", &options.width, &options.height) != 2 || options.width < 1 || options.height < 1)
+				throw std::invalid_argument("ERROR::OPTIONS::BAD_SIZE: " + size);
+		}
+		else if (argument == "--capture")
+		{
+			//The Pattern Goes Straight to snprintf, It May Only Hold The One Integer Conversion.
+			options.capture = value();
+			const size_t percent = options.capture.find('%');
+			const size_t conversion = options.capture.find_first_not_of("0123456789", percent + 1);
+			if (percent == std::string::npos || conversion == std::string::npos || options.capture[conversion] != 'd'
+				|| options.capture.find('%', percent + 1) != std::string::npos)
+				throw std::invalid_argument("ERROR::OPTIONS::CAPTURE_NEEDS_ONE_FRAME_NUMBER: " + options.capture + " (e.g. frame_%04d.png)");
+		}
+		else
+			throw std::invalid_argument("ERROR::OPTIONS::UNKNOWN: " + argument);
+	}
+
+#if defined(SOLAR_SYSTEM_HEADLESS_ONLY)
+	// Built without a window system
+	options.headless = true;
+#endif
+	return options;
+}
+
+int main(int argc, char** argv)
 {
-	SolarSystem* solarSystem = new SolarSystem();
-	solarSystem->Simulate();
+	SimulationOptions options;
+	try
+	{
+		options = SimulationOptions::Parse(argc, argv);
+	}
+	catch (const std::invalid_argument& e)
+	{
+		cout << e.what() << endl
+			 << "Usage: SolarSystem [--headless] [--frames N] [--size WxH] [--frame-time SECONDS] [--days DAYS_SINCE_J2000]" << endl
+			 << "                   [--capture PATTERN.png|PATTERN.exr] [--capture-every N]" << endl
+			 << "                   [--camera-path PATH.json] [--benchmark REPORT.json] [--warmup N] [--trace TRACE.json]" << endl
+			 << "                   [--cpu-ibl] [--no-batching]" << endl;
+		return 1;
+	}
+
+	SolarSystem* solarSystem = new SolarSystem(options);
+	const bool ran = solarSystem->Simulate();
 	delete solarSystem;
 
-	return 0;
+	return ran ? 0 : 1;
 }
\ No newline at end of file
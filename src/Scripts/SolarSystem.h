@@ -1,17 +1,74 @@
 #pragma once
 
+#include <chrono>
+
 #include "Camera.h"
 #include "Shader.h"
 #include "Model.h"
+#include "AssetLoader.h"
+#include "TextureStreamer.h"
+#include "PlanetTerrain.h"
+#include "Culling.h"
+#include "Scene.h"
+#include "NBody.h"
+#include "BodyRenderer.h"
+#include "ImpostorRenderer.h"
+#include "BloomRenderer.h"
+#include "TiledLighting.h"
+#include "IBLCache.h"
+#include "GLExtensions.h"
+#include "HeadlessContext.h"
+#include "CameraPath.h"
+#include "BenchmarkRecorder.h"
+#include "Profiler.h"
 #include "../../vendor/glfw/include/GLFW/glfw3.h"
 #include "../../vendor/glm/glm.hpp"
 
+///<summary>How The App Runs, Read From The Command Line.</summary>
+struct SimulationOptions
+{
+	///<summary>Render Offscreen Without a Window or Display, For Batch Rendering & Reproducible Performance Runs.</summary>
+	bool headless = false;
+	///<summary>Size of The Rendered Frames in Headless Mode.</summary>
+	int width = 1280, height = 720;
+	///<summary>Frames a Headless or Scripted Run Renders Before Exiting, 0 For 300 or Once Along The Camera Path After The Warmup.</summary>
+	int frames = 0;
+	///<summary>Simulated Seconds Per Headless or Scripted Frame, Fixed So Every Run Sees The Same Motion.</summary>
+	float frameTime = 1.0f / 60.0f;
+	///<summary>Date a Headless or Scripted Run Starts at in Days Since J2000, Windows Start at The Current Date.</summary>
+	double days = 0.0;
+	///<summary>printf Pattern Taking The Frame Number For The Tone-Mapped Frames to Write, .png or .exr. Empty Writes Nothing.</summary>
+	std::string capture;
+	///<summary>Write Every This Many Frames.</summary>
+	int captureInterval = 1;
+	///<summary>Camera Path File The Camera Follows Instead of The Input, See CameraPath. Empty Flies Freely.</summary>
+	std::string cameraPath;
+	///<summary>Where to Write The Benchmark Report of The Run's CPU & GPU Frame Times. Empty Records Nothing.</summary>
+	std::string benchmark;
+	///<summary>Frames Rendered at The Start of The Camera Path Before The Benchmark Counts Them.</summary>
+	int warmup = 30;
+	///<summary>Where to Write a Chrome Trace of The Passes of The Last Frames at Exit. Empty Writes Nothing, The Profiler Panel Can Still Save One.</summary>
+	std::string trace;
+	///<summary>Bake The Image Based Lighting Maps on The CPU With The EnvironmentBaker Instead of GPU Passes, For Software GL.</summary>
+	bool cpuIBL = false;
+	///<summary>Draw Every Body on Its Own Even Where Multi Draw Indirect Could Batch Them, Captures of Both Should Match.</summary>
+	bool noBatching = false;
+
+	///<summary>True if The Run Steps a Fixed Time Per Frame For a Fixed Number of Frames, Rather Than Following The Clock Until Closed.</summary>
+	bool Scripted() const { return headless || !cameraPath.empty() || !benchmark.empty(); }
+
+	///<summary>Reads --headless, --frames N, --size WxH, --frame-time S, --days D, --capture PATTERN, --capture-every N,
+	/// --camera-path FILE, --benchmark REPORT, --warmup N, --trace FILE, --cpu-ibl & --no-batching. Throws invalid_argument.</summary>
+	static SimulationOptions Parse(int argc, char** argv);
+};
+
 class SolarSystem
 {
 public:
-	SolarSystem();
+	SolarSystem(const SimulationOptions& options = SimulationOptions());
 	~SolarSystem();
-	void Simulate();
+	///<summary>Runs Until The Window Closes or The Headless Frames Are Done, False if It Couldn't Start.</summary>
+	bool Simulate();
 private:
 	/// @brief Used to get callbacks from GLFW which expects static functions.
 	class GLFWCallbackWrapper
@@ -30,11 +87,13 @@ private:
 	};
 private:
 	bool Init();
+	bool OpenWindow();
 	void RenderLoop();
 	void Cleanup();
 
 	static unsigned int LoadTexture(char const* path, bool sRGB = false);
 	static unsigned int LoadHDRTexture(char const* path);
+	static unsigned int UploadHDRTexture(const TextureData& data);
 
 	void WindowResizeCallback(GLFWwindow* window, int width, int height);
 	void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
@@ -48,9 +107,42 @@ private:
 	void RenderQuad();
 	void RenderCube();
 	void SetupPBR(unsigned int hdrTexture);
+	void SetupPBR(const IBLCacheReader& cache);
+	void SetIrradianceSH(const SphericalHarmonics& irradiance);
+	void AllocateIBLMaps();
+	std::vector<IBLCache::Map> IBLMaps() const;
+
+	mat4 CalculateProjectionMatrix() const;
+	mat4 CalculateProjectionMatrix(float fieldOfView, float aspect) const;
+	float LogDepthCoefficient() const;
+	void BakeImpostor(uint32_t model);
+	void ApplyDepthConvention();
+
+	void StartNBody();
+	void StepNBody(double days);
 
 	void SetCustomImGuiStyle();
+
+	///<summary>Seconds Since Startup, From GLFW Unless Headless.</summary>
+	double Seconds() const;
+	void CaptureFrame(int frame);
 private:
+	SimulationOptions m_Options;
+	///<summary>Context of Headless Runs, Which Create No Window.</summary>
+	HeadlessContext m_HeadlessContext;
+	///<summary>When The App Started, The Clock of Headless Runs.</summary>
+	std::chrono::steady_clock::time_point m_StartTime = std::chrono::steady_clock::now();
+	///<summary>Camera Flight of Scripted Runs, Empty Unless --camera-path Was Given.</summary>
+	CameraPath m_CameraPath;
+	///<summary>Frame Times of Benchmark Runs.</summary>
+	BenchmarkRecorder m_Benchmark;
+	///<summary>CPU & GPU Time of Every Pass, Shown in The Profiler Panel.</summary>
+	Profiler m_Profiler;
+	///<summary>True While The Profiler Panel is Open.</summary>
+	bool m_ShowProfiler = false;
+	///<summary>Where The Final Frame Goes Headless, Instead of The Window's Framebuffer 0. Holds Floats So .exr Captures Keep Them.</summary>
+	unsigned int m_OutputFBO = 0, m_OutputTexture = 0;
+
 	///<summary>Screen Width in Screen Coordinates.</summary>
 	unsigned const int SCR_WIDTH = 1280;
 	///<summary>Screen Height in Screen Coordinates.</summary>
@@ -59,10 +151,13 @@ private:
 	///<summary>Number of Samples For Multisampling.</summary>
 	unsigned const int SAMPLES = 4;
 
-	///<summary>Camera Near Plane Distance.</summary>
-	float m_NearPlane = 0.01f; // 1 km
-	///<summary>Camera Far Plane Distance.</summary>
-	float m_FarPlane = 1000.0f; // 1 million km
+	///<summary>Camera Near Plane Distance, There is No Far Plane With Reversed-Z.</summary>
+	const float NEAR_PLANE = 0.00000001f; // 10 m
+	///<summary>Farthest Distance The Logarithmic Depth Fallback Resolves.</summary>
+	const float LOG_DEPTH_FAR = 100000.0f; // 100 billion km
+
+	///<summary>True if Depth Runs From 1 at The Near Plane to 0 at Infinity (Needs glClipControl), Otherwise Model.vs Writes Logarithmic Depth.</summary>
+	bool m_ReversedZ = false;
 
 	///<summary>Buffer width of the window incase the Screen Width is not in Screen Coordinates.</summary>
 	int m_BufferWidth = 0;
@@ -90,6 +185,10 @@ private:
 	float m_DeltaTime = 0.0f;
 	///<summary>The Time At Which Last Frame Was Rendered.</summary>
 	float m_LastFrame = 0.0f;
+	///<summary>Simulated Time in Days Since J2000, Starts at The Current Date.</summary>
+	double m_SimulationDays = 0.0;
+	///<summary>Simulated Days That Pass Per Real Second.</summary>
+	float m_TimeScale = 1.0f;
 
 	//RenderCube() VAO & VBO.
 	unsigned int m_CubeVAO = 0;
@@ -100,21 +199,80 @@ private:
 	unsigned int m_QuadVBO = 0;
 
 	// Shaders
-	Shader m_ModelShader, m_LightShader, m_PostProcessingShader, m_SkyboxShader, m_BloomShader;
+	Shader m_ModelShader, m_LightShader, m_PostProcessingShader, m_SkyboxShader;
+	///<summary>Bloom's Down & Up Filters, Run by BloomRenderer.</summary>
+	Shader m_BloomDownsampleShader, m_BloomUpsampleShader;
+	///<summary>Lists The Lights of Every Screen Tile For The Lighting Pass, Only Created With GLExtensions::ComputeShaders.</summary>
+	Shader m_LightCullingShader;
+	///<summary>Model Shader Reading Transforms, Materials & Texture Arrays From BodyRenderer, Only Created With GLExtensions::MultiDrawIndirect.</summary>
+	Shader m_BatchedShader;
+	///<summary>Draws The Sub-Pixel Bodies as Sprites of Their Impostors.</summary>
+	Shader m_ImpostorShader;
 
-	// Models
-	Model m_Sun, m_Mercury, m_Venus, m_Earth, m_Mars, m_Jupiter, m_Saturn, m_Uranus, m_Neptune, m_Pluto;
+	// Uniforms Set Every Frame, Looked Up Once After The Shaders Are Created.
+	MeshUniforms m_ModelUniforms;
+	Uniform<vec3> m_ViewPosUniform;
+	Uniform<float> m_EmissionStrengthUniform;
+	Uniform<mat4> m_InverseViewProjectionUniform;
+	Uniform<mat4> m_SkyViewProjectionUniform;
+	Uniform<float> m_SkyFarDepthUniform;
+	Uniform<float> m_ExposureUniform;
+	Uniform<unsigned int> m_ToneMappingUniform;
+	Uniform<float> m_BloomStrengthUniform;
+
+	///<summary>Every body to draw, loaded from the scene file.</summary>
+	Scene m_Scene;
+	///<summary>One model per distinct asset of the scene, indexed by BodyTable::models. Sized once, the loader holds references into it.</summary>
+	std::vector<Model> m_Models;
+	///<summary>Draws Every Body With Multi Draw Indirect, Falls Back to a Draw Per Mesh Without It.</summary>
+	BodyRenderer m_BodyRenderer;
+	///<summary>Impostors of The Models, Drawn For Bodies Too Small on Screen For Their Meshes.</summary>
+	ImpostorRenderer m_Impostors;
 
 	// Skybox Texture
-	unsigned int m_SpaceHDRTexture;
+	unsigned int m_SpaceHDRTexture = 0;
+
+	///<summary>Worker Threads Shared by Asset Streaming & The N-Body Force Pass.</summary>
+	JobSystem m_Jobs;
+	///<summary>Decodes models & textures on worker threads and uploads them from the render loop.</summary>
+	AssetLoader m_AssetLoader;
+	///<summary>Keeps Only The Mip Levels of Package Textures Their Bodies Need on Screen, Within a Video Memory Budget.</summary>
+	TextureStreamer m_TextureStreamer;
+	///<summary>True until every asset queued at startup has been uploaded.</summary>
+	bool m_AssetsStreaming = true;
+	//Quadtree Terrain of The Scene's Terrain Bodies, Indexed Like Scene::terrains.
+	std::vector<std::unique_ptr<PlanetTerrain>> m_Terrains;
+	//Index Into m_Terrains of Every Body, -1 For Bodies Drawn From Their Model.
+	std::vector<int> m_BodyTerrains;
+	//True For The Models of Terrain Bodies, They Never Go Through BodyRenderer So Their 2D Textures Stay.
+	std::vector<bool> m_TerrainModels;
 
-	glm::mat4 m_ModelMatrix, m_ProjectionMatrix;
+	//BVH Over The Bodies' Bounding Spheres, Culled Against The View Every Frame Before Anything is Drawn.
+	BodyBVH m_BodyBVH;
+	//Bounding Radius of Every Body in World Units.
+	std::vector<float> m_BodyRadii;
+	//This Frame's Bodies in View, And Those in View Too Small to Cover a Pixel.
+	std::vector<uint32_t> m_VisibleBodies, m_PointBodies;
+	//Bodies Projecting Smaller Than This Many Pixels Across Are Drawn as Impostor Sprites Instead of Meshes.
+	float m_MinBodyPixels = 4.0f;
+
+	///<summary>Integrates The Bodies Under Their Mutual Gravity Instead of Following Their Orbits.</summary>
+	NBody m_NBody;
+	///<summary>True While The N-Body Simulation Moves The Bodies.</summary>
+	bool m_NBodyMode = false;
+	///<summary>Body Each N-Body Particle Moves, Index Into The BodyTable.</summary>
+	std::vector<uint32_t> m_NBodyBodies;
+
+	glm::mat4 m_ProjectionMatrix;
 
 	unsigned int m_MatricesUBO;
 
-	//Bloom Ping-Pong Buffers
-	unsigned int m_BloomFBO[2];
-	unsigned int m_BloomTexture[2];
+	//Bloom Mip Chain, Half The Screen's Size & Smaller
+	BloomRenderer m_Bloom;
+
+	//The Scene's Lights This Frame & The Lists of Those Reaching Each Tile of The Screen
+	std::vector<PointLight> m_Lights;
+	TiledLighting m_TiledLighting;
 
 	//HDR Render Buffer
 	unsigned int m_RenderFBO = 0;
@@ -123,8 +281,8 @@ private:
 
 	//Geometry Buffer
 	unsigned int m_GBuffer = 0;
-	unsigned int m_GPosition = 0, m_GNormal = 0, m_GAlbedo = 0, m_GEmission = 0, m_GMetallicRoughness = 0;
-	unsigned int m_GDepth = 0;
+	unsigned int m_GNormal = 0, m_GAlbedo = 0, m_GEmission = 0, m_GMetallicRoughness = 0;
+	unsigned int m_GDepth = 0;	//A Texture, The Lighting Pass Rebuilds Positions From It.
 
 	//PBR Image Based Lighting
 	bool m_PbrInitialized = false;	//True if PBR has been Initialized atleast once.
@@ -0,0 +1,201 @@
+#include "TextureArrays.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Bytes of a 4x4 block of a compressed format, 0 if the format isn't one
+static GLsizei CompressedBlockBytes(GLenum format)
+{
+	switch (format)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RED_RGTC1:				return 8;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RG_RGTC2:
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:	return 16;
+	default:									return 0;
+	}
+}
+
+// glCopyImageSubData only copies between textures of the same sized format, the Texture constructor asks for these.
+// An unsized GL_RGBA source reads back as GL_RGBA and fails the copy on some drivers, so it isn't taken
+static bool Copyable(GLenum format)
+{
+	switch (format)
+	{
+	case GL_RGBA8:
+	case GL_RGB8:
+	case GL_SRGB8_ALPHA8:
+	case GL_SRGB8:			return true;
+	default:				return CompressedBlockBytes(format) != 0;
+	}
+}
+
+uint32_t TextureArrays::Add(GLuint texture)
+{
+	GLint width = 0, height = 0, format = 0;
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+	if (!Copyable((GLenum)format) || width <= 0 || height <= 0)
+	{
+		glBindTexture(GL_TEXTURE_2D, 0);
+		std::cout << "ERROR::TEXTURE_ARRAYS::FORMAT_NOT_SUPPORTED 0x" << std::hex << format << std::dec << " " << width << "x" << height << std::endl;
+		return None;
+	}
+
+	// Baked packages may stop their mip chain early, copy what is there
+	const GLint fullLevels = (GLint)std::floor(std::log2((double)std::max(width, height))) + 1;
+	GLint sourceLevels = 1;
+	while (sourceLevels < fullLevels)
+	{
+		GLint levelWidth = 0;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, sourceLevels, GL_TEXTURE_WIDTH, &levelWidth);
+		if (levelWidth == 0)
+			break;
+		sourceLevels++;
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// Compressed mips can't be generated, those arrays keep exactly the levels their textures bring
+	const bool compressed = CompressedBlockBytes((GLenum)format) != 0;
+	const GLint levels = compressed ? sourceLevels : fullLevels;
+
+	size_t index = 0;
+	while (index < m_Arrays.size() && !(m_Arrays[index].ID != 0 && m_Arrays[index].width == width && m_Arrays[index].height == height &&
+										m_Arrays[index].format == (GLenum)format && m_Arrays[index].levels == levels))
+		index++;
+	if (index == m_Arrays.size())
+	{
+		// Slots of deleted arrays come first, the indices of the others are baked into locations
+		index = 0;
+		while (index < m_Arrays.size() && m_Arrays[index].ID != 0)
+			index++;
+		if (index == MaxArrays)
+		{
+			std::cout << "ERROR::TEXTURE_ARRAYS::OUT_OF_ARRAYS " << width << "x" << height << " texture has no array left" << std::endl;
+			return None;
+		}
+		if (index == m_Arrays.size())
+			m_Arrays.emplace_back();
+
+		Array& created = m_Arrays[index];
+		created = Array();
+		created.width = width;
+		created.height = height;
+		created.format = (GLenum)format;
+		created.levels = levels;
+	}
+
+	Array& array = m_Arrays[index];
+	GLsizei layer;
+	if (!array.freeLayers.empty())
+	{
+		layer = array.freeLayers.back();
+		array.freeLayers.pop_back();
+	}
+	else
+	{
+		if (array.layers == array.capacity)
+			Grow(array, std::max<GLsizei>(4, array.capacity * 2));
+		layer = array.layers++;
+	}
+	// Errors raised before aren't ours to report
+	while (glGetError() != GL_NO_ERROR) {}
+	for (GLint level = 0; level < sourceLevels; level++)
+		glCopyImageSubData(texture, GL_TEXTURE_2D, level, 0, 0, 0, array.ID, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer,
+						   std::max(1, width >> level), std::max(1, height >> level), 1);
+	const GLenum error = glGetError();
+	if (error != GL_NO_ERROR)
+	{
+		std::cout << "ERROR::TEXTURE_ARRAYS::COPY_FAILED 0x" << std::hex << error << std::dec << " " << width << "x" << height << std::endl;
+		Remove(((uint32_t)index << 16) | (uint32_t)layer);
+		return None;
+	}
+
+	// Only a short chain got copied, rebuild the array's mips (every layer's, which comes out the same for the others)
+	if (sourceLevels < array.levels)
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, array.ID);
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+
+	return ((uint32_t)index << 16) | (uint32_t)layer;
+}
+
+void TextureArrays::Grow(Array& array, GLsizei capacity)
+{
+	GLuint grown;
+	glGenTextures(1, &grown);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, grown);
+	const GLsizei blockBytes = CompressedBlockBytes(array.format);
+	for (GLint level = 0; level < array.levels; level++)
+	{
+		const GLsizei width = std::max(1, array.width >> level), height = std::max(1, array.height >> level);
+		if (blockBytes)
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, array.format, width, height, capacity, 0,
+								   ((width + 3) / 4) * ((height + 3) / 4) * blockBytes * capacity, nullptr);
+		else
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, array.format, width, height, capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	}
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, array.levels - 1);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	if (array.layers > 0)
+	{
+		for (GLint level = 0; level < array.levels; level++)
+			glCopyImageSubData(array.ID, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, grown, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+							   std::max(1, array.width >> level), std::max(1, array.height >> level), array.layers);
+	}
+	glDeleteTextures(1, &array.ID);
+
+	array.ID = grown;
+	array.capacity = capacity;
+}
+
+void TextureArrays::Remove(uint32_t location)
+{
+	const size_t index = location >> 16;
+	if (location == None || index >= m_Arrays.size() || m_Arrays[index].ID == 0)
+		return;
+
+	Array& array = m_Arrays[index];
+	array.freeLayers.push_back((GLsizei)(location & 0xFFFF));
+	if ((GLsizei)array.freeLayers.size() == array.layers)
+	{
+		glDeleteTextures(1, &array.ID);
+		array = Array();
+	}
+}
+
+size_t TextureArrays::size() const
+{
+	return (size_t)std::count_if(m_Arrays.begin(), m_Arrays.end(), [](const Array& array) { return array.ID != 0; });
+}
+
+void TextureArrays::Bind(GLuint firstUnit) const
+{
+	for (GLuint i = 0; i < MaxArrays; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, i < m_Arrays.size() ? m_Arrays[i].ID : 0);
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void TextureArrays::Destroy()
+{
+	for (Array& array : m_Arrays)
+		glDeleteTextures(1, &array.ID);
+	m_Arrays.clear();
+}
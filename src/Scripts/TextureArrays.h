@@ -0,0 +1,59 @@
+#ifndef TEXTURE_ARRAYS_H
+#define TEXTURE_ARRAYS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "GLExtensions.h"
+
+// Size bucketed GL_TEXTURE_2D_ARRAYs holding every material texture, so a shader can reach any of them
+// without a texture being bound per draw. Textures of the same size and format share an array, each is one of its layers.
+// Needs GLExtensions::MultiDrawIndirect (for glCopyImageSubData). GL thread only.
+class TextureArrays
+{
+public:
+	// Arrays a shader can sample, each takes a texture unit
+	static const unsigned int MaxArrays = 16;
+	// Location of a texture that didn't fit in
+	static const uint32_t None = 0xFFFFFFFFu;
+
+	TextureArrays() {}
+	TextureArrays(const TextureArrays&) = delete;
+	TextureArrays& operator=(const TextureArrays&) = delete;
+
+	// Copies every mip level of the 2D texture 'texture' into a layer of the array matching its size and format.
+	// Returns the layer's location, (array << 16) | layer, or None if it needs a new array and all MaxArrays are taken,
+	// its format isn't a sized or compressed one an array can hold, or the copy fails.
+	// 'texture' is left alone, the caller may delete it afterwards unless None came back.
+	uint32_t Add(GLuint texture);
+	// Frees the layer at 'location' for the next Add, an array whose last layer goes is deleted and its index reused
+	void Remove(uint32_t location);
+	// Binds array i to texture unit 'firstUnit' + i, unused units get no texture
+	void Bind(GLuint firstUnit) const;
+	// Deletes every array, call while the context is still alive
+	void Destroy();
+
+	// Arrays holding at least one layer
+	size_t size() const;
+
+private:
+	struct Array
+	{
+		GLuint ID = 0;
+		GLsizei width = 0, height = 0;
+		// Sized internal format, shared by every layer
+		GLenum format = 0;
+		GLint levels = 0;
+		GLsizei layers = 0, capacity = 0;
+		// Layers below 'layers' that were removed, reused before the array grows
+		std::vector<GLsizei> freeLayers;
+	};
+
+	// Reallocates 'array' with room for 'capacity' layers and copies the layers it had over
+	static void Grow(Array& array, GLsizei capacity);
+
+	std::vector<Array> m_Arrays;
+};
+
+#endif
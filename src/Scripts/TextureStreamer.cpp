@@ -0,0 +1,220 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+
+void TextureStreamer::Register(Model& model, std::shared_ptr<PackageReader> package, unsigned int image)
+{
+	const Package::ImageRecord& record = package->imageRecord(image);
+	if (record.levelCount == 0)
+		return;
+
+	Entry entry;
+	entry.model = &model;
+	entry.package = std::move(package);
+	entry.image = image;
+	entry.levelCount = (int)record.levelCount;
+	while (entry.floorLevel < entry.levelCount - 1 && (int)std::max(record.width, record.height) >> entry.floorLevel > ResidentFloor)
+		entry.floorLevel++;
+	// Nothing is resident yet, which is one past the last level
+	entry.resident = entry.levelCount;
+	entry.wanted = entry.floorLevel;
+
+	Reupload(entry, entry.floorLevel, entry.package->image(image, entry.floorLevel));
+	m_Entries.push_back(std::move(entry));
+}
+
+void TextureStreamer::Begin()
+{
+	m_Frame++;
+	for (Entry& entry : m_Entries)
+		entry.pixels = 0.0f;
+}
+
+void TextureStreamer::Request(const Model& model, float pixels)
+{
+	for (Entry& entry : m_Entries)
+		if (entry.model == &model)
+			entry.pixels = std::max(entry.pixels, pixels);
+}
+
+void TextureStreamer::Update()
+{
+	//Upload What The Loads Read Since Last Frame, Evictions First So Their Room is There For The Rest.
+	std::vector<Loaded> loaded;
+	{
+		std::lock_guard<std::mutex> lock(m_LoadedMutex);
+		loaded.swap(m_Loaded);
+	}
+	std::stable_partition(loaded.begin(), loaded.end(), [this](const Loaded& load) { return load.level > m_Entries[load.entry].resident; });
+	std::vector<Loaded> waiting;
+	for (Loaded& load : loaded)
+	{
+		Entry& entry = m_Entries[load.entry];
+		// A larger level waits while the evictions making room for it are still reading
+		if (load.level < entry.resident && m_FreeingBytes > 0 && m_ResidentBytes + entry.loadingBytes > m_Budget)
+		{
+			waiting.push_back(std::move(load));
+			continue;
+		}
+
+		m_PendingBytes -= entry.loadingBytes;
+		m_FreeingBytes -= entry.freeingBytes;
+		m_LoadsInFlight--;
+		entry.loading = -1;
+		entry.loadingBytes = 0;
+		entry.freeingBytes = 0;
+		if (load.level != entry.resident)
+			Reupload(entry, load.level, load.data);
+	}
+	if (!waiting.empty())
+	{
+		std::lock_guard<std::mutex> lock(m_LoadedMutex);
+		std::move(waiting.begin(), waiting.end(), std::back_inserter(m_Loaded));
+	}
+
+	//A Sphere's Texture Wraps Around It, About width / pi Texels Span The Disc Seen Face On.
+	for (Entry& entry : m_Entries)
+	{
+		const Package::ImageRecord& record = entry.package->imageRecord(entry.image);
+		const float texels = (float)std::max(record.width, record.height) / 3.14159265f;
+		entry.wanted = entry.floorLevel;
+		if (entry.pixels > 0.0f)
+		{
+			const float ratio = texels / entry.pixels;
+			entry.wanted = ratio <= 1.0f ? 0 : std::min((int)std::log2(ratio), entry.floorLevel);
+		}
+		if (entry.wanted <= entry.resident)
+			entry.lastUsed = m_Frame;
+	}
+
+	//A Lowered Budget First Drops Unused Levels, Then Levels Still in Use From The Largest Textures Down.
+	if (!MakeRoom(0))
+	{
+		while (ProjectedBytes() > m_Budget)
+		{
+			Entry* largest = nullptr;
+			for (Entry& entry : m_Entries)
+				if (entry.resident < entry.floorLevel && entry.loading < 0 && (!largest || LevelBytes(entry, entry.resident) > LevelBytes(*largest, largest->resident)))
+					largest = &entry;
+			if (!largest)
+				break;
+			Load((size_t)(largest - m_Entries.data()), largest->resident + 1);
+		}
+	}
+
+	//Load One Level More For The Textures Furthest From What They Need.
+	std::vector<size_t> missing;
+	for (size_t i = 0; i < m_Entries.size(); i++)
+		if (m_Entries[i].wanted < m_Entries[i].resident && m_Entries[i].loading < 0)
+			missing.push_back(i);
+	std::sort(missing.begin(), missing.end(), [this](size_t a, size_t b)
+	{
+		return m_Entries[a].resident - m_Entries[a].wanted > m_Entries[b].resident - m_Entries[b].wanted;
+	});
+
+	for (size_t index : missing)
+	{
+		if (m_LoadsInFlight >= MaxLoadsInFlight)
+			break;
+
+		Entry& entry = m_Entries[index];
+		if (!MakeRoom(LevelBytes(entry, entry.resident - 1) - LevelBytes(entry, entry.resident)))
+			continue;
+		Load(index, entry.resident - 1);
+	}
+}
+
+void TextureStreamer::Load(size_t index, int level)
+{
+	Entry& entry = m_Entries[index];
+	entry.loading = level;
+	if (level < entry.resident)
+	{
+		entry.loadingBytes = LevelBytes(entry, level) - LevelBytes(entry, entry.resident);
+		m_PendingBytes += entry.loadingBytes;
+	}
+	else
+	{
+		entry.freeingBytes = LevelBytes(entry, entry.resident) - LevelBytes(entry, level);
+		m_FreeingBytes += entry.freeingBytes;
+	}
+	m_LoadsInFlight++;
+
+	std::shared_ptr<PackageReader> package = entry.package;
+	const unsigned int image = entry.image;
+	m_Jobs.Schedule([this, index, level, package, image]()
+	{
+		TextureData data = package->image(image, level);
+
+		// The mapping reads lazily, touch every page of the new level here so the disk read isn't the GL thread's
+		const volatile unsigned char* bytes = static_cast<const unsigned char*>(data.pixels.get());
+		unsigned char touched = 0;
+		for (size_t offset = 0; offset < data.levelSizes[0]; offset += 4096)
+			touched ^= bytes[offset];
+		(void)touched;
+
+		if (data.compression != BlockFormat::None && !Texture::CompressedFormatSupported(data.compression))
+			data = data.Decompress();
+
+		std::lock_guard<std::mutex> lock(m_LoadedMutex);
+		m_Loaded.push_back({ index, level, std::move(data) });
+	});
+}
+
+void TextureStreamer::Shutdown()
+{
+	m_Jobs.Wait();
+
+	std::lock_guard<std::mutex> lock(m_LoadedMutex);
+	m_Loaded.clear();
+}
+
+size_t TextureStreamer::LevelBytes(const Entry& entry, int level)
+{
+	// Compressed levels take what they take on disk, raw ones are expanded to RGBA8 by the Texture constructor
+	const Package::ImageRecord& record = entry.package->imageRecord(entry.image);
+	const bool compressed = (BlockFormat)record.format != BlockFormat::None && Texture::CompressedFormatSupported((BlockFormat)record.format);
+	size_t bytes = 0;
+	for (int i = level; i < entry.levelCount; i++)
+		bytes += compressed ? (size_t)record.levelSizes[i] : (size_t)std::max(1u, record.width >> i) * std::max(1u, record.height >> i) * 4;
+	return bytes;
+}
+
+bool TextureStreamer::Reupload(Entry& entry, int level, const TextureData& data)
+{
+	try
+	{
+		if (data.compression != BlockFormat::None && !Texture::CompressedFormatSupported(data.compression))
+			entry.model->UploadTexture(entry.image, data.Decompress());
+		else
+			entry.model->UploadTexture(entry.image, data);
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "ERROR::TEXTURE_STREAMER::UPLOAD_FAILED " << e.what() << std::endl;
+		return false;
+	}
+
+	m_ResidentBytes = m_ResidentBytes + LevelBytes(entry, level) - LevelBytes(entry, entry.resident);
+	entry.resident = level;
+	return true;
+}
+
+bool TextureStreamer::MakeRoom(size_t needed)
+{
+	while (ProjectedBytes() + needed > m_Budget)
+	{
+		Entry* unused = nullptr;
+		for (Entry& entry : m_Entries)
+			if (entry.resident < entry.wanted && entry.loading < 0 && (!unused || entry.lastUsed < unused->lastUsed))
+				unused = &entry;
+		if (!unused)
+			return false;
+
+		Load((size_t)(unused - m_Entries.data()), unused->wanted);
+	}
+	return true;
+}
@@ -0,0 +1,115 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Model.h"
+#include "Package.h"
+
+// Keeps only the mip levels of package textures that their models need at their current size on screen.
+// Every texture starts out with its small levels (up to ResidentFloor texels a side), which always stay.
+// Each frame the models are requested with their projected size, and textures that are too coarse for it get
+// their next larger level read from the package mapping on the job system, then uploaded on the GL thread.
+// Levels above what a texture needs are only evicted once the resident levels of all textures would exceed the
+// budget. A texture whose levels change is uploaded again as a smaller or larger image through Model::UploadTexture,
+// evictions read their smaller image on the job system like loads do, only the upload happens on the GL thread.
+class TextureStreamer
+{
+public:
+	// Largest edge of the levels every texture keeps resident, whatever its size on screen
+	static const int ResidentFloor = 256;
+	// Loads reading at the same time, each brings in one level of one texture. Evictions aren't held back by it.
+	static const unsigned int MaxLoadsInFlight = 2;
+
+	// Reads levels on 'jobs', which must outlive the streamer
+	explicit TextureStreamer(JobSystem& jobs, size_t budgetBytes = (size_t)1024 << 20) : m_Jobs(jobs), m_Budget(budgetBytes) {}
+	~TextureStreamer() { Shutdown(); }
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	// Takes over image 'image' of 'package' for 'model' and uploads its resident floor. GL thread only, after the geometry upload.
+	void Register(Model& model, std::shared_ptr<PackageReader> package, unsigned int image);
+
+	// Starts a new frame, forgetting the sizes requested for the last one
+	void Begin();
+	// Asks for the textures of 'model' at a projected diameter of 'pixels' on screen, the largest request of a frame counts
+	void Request(const Model& model, float pixels);
+	// Evicts and uploads levels to match this frame's requests within the budget, starts loads for what's missing. GL thread only.
+	void Update();
+
+	void SetBudget(size_t bytes) { m_Budget = bytes; }
+	size_t Budget() const { return m_Budget; }
+	// Video memory of the levels resident now
+	size_t ResidentBytes() const { return m_ResidentBytes; }
+	size_t TextureCount() const { return m_Entries.size(); }
+	unsigned int LoadsInFlight() const { return m_LoadsInFlight; }
+
+	// Waits for loads in flight and drops their results
+	void Shutdown();
+
+private:
+	struct Entry
+	{
+		Model* model = nullptr;
+		std::shared_ptr<PackageReader> package;
+		unsigned int image = 0;
+		int levelCount = 0;
+		// Finest level kept no matter what
+		int floorLevel = 0;
+		// Finest level on the GPU
+		int resident = 0;
+		// Largest projected diameter in pixels requested this frame
+		float pixels = 0.0f;
+		// Finest level this frame's requests need
+		int wanted = 0;
+		// Level a load is bringing in, coarser than the resident one for an eviction, -1 if none
+		int loading = -1;
+		// What that load adds to the resident bytes
+		size_t loadingBytes = 0;
+		// What that eviction takes off them
+		size_t freeingBytes = 0;
+		// Frame the resident level was last wanted, the longest unused textures are evicted first
+		unsigned int lastUsed = 0;
+	};
+
+	// A load that has finished reading and waits for its upload
+	struct Loaded
+	{
+		size_t entry;
+		int level;
+		TextureData data;
+	};
+
+	// Video memory of 'entry' with 'level' as its finest level
+	static size_t LevelBytes(const Entry& entry, int level);
+	// Uploads 'entry' again as 'data', which starts at 'level'. Returns false if the upload failed and nothing changed.
+	bool Reupload(Entry& entry, int level, const TextureData& data);
+	// Reads 'level' of entry 'index' on the job system, for Update to upload once it's there
+	void Load(size_t index, int level);
+	// Resident bytes once the loads and evictions in flight are uploaded
+	size_t ProjectedBytes() const { return m_ResidentBytes - m_FreeingBytes + m_PendingBytes; }
+	// Starts evicting unwanted levels, longest unused first, until 'needed' more bytes fit. Returns false if they still don't.
+	bool MakeRoom(size_t needed);
+
+	JobSystem& m_Jobs;
+	size_t m_Budget;
+	size_t m_ResidentBytes = 0;
+	// Bytes the loads in flight will add once uploaded, counted against the budget up front
+	size_t m_PendingBytes = 0;
+	// Bytes the evictions in flight will free once uploaded
+	size_t m_FreeingBytes = 0;
+	unsigned int m_LoadsInFlight = 0;
+	unsigned int m_Frame = 0;
+
+	std::vector<Entry> m_Entries;
+
+	std::mutex m_LoadedMutex;
+	std::vector<Loaded> m_Loaded;
+};
+
+#endif
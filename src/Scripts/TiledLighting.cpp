@@ -0,0 +1,132 @@
+#include "TiledLighting.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "GLExtensions.h"
+
+void TiledLighting::Init(Shader& lighting, Shader* culling, int width, int height, float logDepthCoefficient, float nearPlane)
+{
+	m_TiledUniform = lighting.uniform<bool>("tiled");
+	m_TilesPerRowUniform = lighting.uniform<unsigned int>("tilesPerRow");
+
+	//Both Passes Read The Lights From One Uniform Block, The Count After The Full Array.
+	glGenBuffers(1, &m_LightBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_LightBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, MaxLights * sizeof(GpuLight) + 4 * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, LightsBinding, m_LightBuffer);
+	Upload({});
+
+	m_Culling = culling;
+	if (culling)
+	{
+		culling->use();
+		culling->setInt("gDepth", 0);
+		culling->setFloat("logDepthCoefficient", logDepthCoefficient);
+		culling->setFloat("nearPlane", nearPlane);
+		m_ViewUniform = culling->uniform<glm::mat4>("view");
+		m_ProjectionScaleUniform = culling->uniform<glm::vec2>("projectionScale");
+	}
+
+	m_Width = width;
+	m_Height = height;
+	CreateTiles();
+}
+
+void TiledLighting::Resize(int width, int height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+
+	m_Width = width;
+	m_Height = height;
+	DeleteTiles();
+	CreateTiles();
+}
+
+void TiledLighting::Destroy()
+{
+	DeleteTiles();
+	glDeleteBuffers(1, &m_LightBuffer);
+	m_LightBuffer = 0;
+	m_Culling = nullptr;
+}
+
+void TiledLighting::CreateTiles()
+{
+	if (!m_Culling)
+		return;
+
+	m_TilesX = (m_Width + TileSize - 1) / TileSize;
+	m_TilesY = (m_Height + TileSize - 1) / TileSize;
+
+	//Every Tile is a Count Followed By Its Lights, All in One Buffer Texture. Old Drivers May Not Take That Many Texels.
+	const GLint texels = m_TilesX * m_TilesY * (GLint)(MaxLightsPerTile + 1);
+	GLint maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	if (texels > maxTexels)
+	{
+		std::cout << "ERROR::TILED_LIGHTING::TOO_MANY_TILES " << texels << " texels, shading every light per pixel instead" << std::endl;
+		m_Culling = nullptr;
+		return;
+	}
+
+	glGenBuffers(1, &m_TileBuffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, m_TileBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, texels * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	glGenTextures(1, &m_TileTexture);
+	glBindTexture(GL_TEXTURE_BUFFER, m_TileTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_TileBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TilesBinding, m_TileBuffer);
+}
+
+void TiledLighting::DeleteTiles()
+{
+	glDeleteTextures(1, &m_TileTexture);
+	glDeleteBuffers(1, &m_TileBuffer);
+	m_TileTexture = m_TileBuffer = 0;
+}
+
+void TiledLighting::Upload(const std::vector<PointLight>& lights)
+{
+	m_LightCount = (unsigned int)std::min<size_t>(lights.size(), MaxLights);
+	m_Staging.resize(m_LightCount);
+	for (unsigned int i = 0; i < m_LightCount; i++)
+	{
+		m_Staging[i].positionRange = glm::vec4(lights[i].position, lights[i].range);
+		m_Staging[i].radiance = glm::vec4(lights[i].radiance, 0.0f);
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_LightBuffer);
+	if (m_LightCount > 0)
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, m_LightCount * sizeof(GpuLight), m_Staging.data());
+	glBufferSubData(GL_UNIFORM_BUFFER, MaxLights * sizeof(GpuLight), sizeof(GLuint), &m_LightCount);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void TiledLighting::Cull(GLuint depth, const glm::mat4& view, const glm::mat4& projection)
+{
+	if (!m_Culling)
+		return;
+
+	m_Culling->use();
+	m_ViewUniform.set(view);
+	m_ProjectionScaleUniform.set(glm::vec2(projection[0][0], projection[1][1]));
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, depth);
+	glDispatchCompute((GLuint)m_TilesX, (GLuint)m_TilesY, 1);
+
+	//The Lighting Pass Fetches The Lists Through The Buffer Texture.
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void TiledLighting::Bind(GLuint unit)
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_TileTexture);
+	m_TiledUniform.set(Tiled());
+	m_TilesPerRowUniform.set((unsigned int)m_TilesX);
+}
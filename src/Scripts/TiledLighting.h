@@ -0,0 +1,78 @@
+#ifndef TILED_LIGHTING_H
+#define TILED_LIGHTING_H
+
+#include <vector>
+
+#include "../../vendor/glad/include/glad.h"
+#include "../../vendor/glm/glm.hpp"
+#include "Scene.h"
+#include "Shader.h"
+
+// Feeds the lighting pass every light of the scene, with each pixel only shading the lights that reach it.
+// A compute pass splits the screen into TileSize x TileSize tiles, bounds every tile's depth from the gBuffer and lists the
+// lights whose sphere of influence touches the tile's slice of the view, so the lighting pass costs as much as the lights per
+// pixel rather than the lights in the scene. Lights sit in a uniform block at LightsBinding, the tile lists in a buffer
+// texture the lighting pass fetches from. Without compute shaders the lighting pass walks every light instead.
+// Culled with LightCulling.cs, read by LightShader.fs. GL thread only.
+class TiledLighting
+{
+public:
+	// Edge of a tile in pixels, the culling shader's work group size
+	static const int TileSize = 16;
+	// Lights uploaded at most, the size of the shaders' light arrays
+	static const unsigned int MaxLights = 256;
+	// Lights a tile lists at most, the rest are left out of it
+	static const unsigned int MaxLightsPerTile = 63;
+	// Uniform buffer binding of the lights
+	static const GLuint LightsBinding = 1;
+	// Shader storage binding the culling shader writes the tile lists to, after BodyRenderer's
+	static const GLuint TilesBinding = 2;
+
+	TiledLighting() {}
+	TiledLighting(const TiledLighting&) = delete;
+	TiledLighting& operator=(const TiledLighting&) = delete;
+
+	// Creates the light block and, with 'culling' (null without compute shaders), the tile lists for a screen of
+	// 'width' x 'height'. Positions are rebuilt from depth written with 'logDepthCoefficient' (0 for reversed-Z) and 'nearPlane'.
+	void Init(Shader& lighting, Shader* culling, int width, int height, float logDepthCoefficient, float nearPlane);
+	// Recreates the tile lists for a new screen size
+	void Resize(int width, int height);
+	// Deletes every buffer, call while the context is still alive
+	void Destroy();
+
+	// Uploads this frame's lights, those past MaxLights are dropped
+	void Upload(const std::vector<PointLight>& lights);
+	// Lists the lights of every tile against 'depth', the gBuffer's, drawn with 'view' & 'projection'. Nothing without tiles.
+	void Cull(GLuint depth, const glm::mat4& view, const glm::mat4& projection);
+	// Binds the tile lists to texture unit 'unit' and points the lighting shader (in use) at them
+	void Bind(GLuint unit);
+
+	// False if the lighting pass walks every light, without compute shaders or a large enough buffer texture
+	bool Tiled() const { return m_Culling != nullptr; }
+	unsigned int LightCount() const { return m_LightCount; }
+
+private:
+	// Layout of a light in the std140 block
+	struct GpuLight
+	{
+		// Camera relative position, range in w
+		glm::vec4 positionRange;
+		glm::vec4 radiance;
+	};
+
+	void CreateTiles();
+	void DeleteTiles();
+
+	Shader* m_Culling = nullptr;
+	Uniform<glm::mat4> m_ViewUniform;
+	Uniform<glm::vec2> m_ProjectionScaleUniform;
+	Uniform<bool> m_TiledUniform;
+	Uniform<unsigned int> m_TilesPerRowUniform;
+
+	int m_Width = 0, m_Height = 0, m_TilesX = 0, m_TilesY = 0;
+	unsigned int m_LightCount = 0;
+	std::vector<GpuLight> m_Staging;
+	GLuint m_LightBuffer = 0, m_TileBuffer = 0, m_TileTexture = 0;
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef VERTEX_H
+#define VERTEX_H
+
+#include "../../vendor/glm/glm.hpp"
+
+// Interleaved vertex layout shared by the loader, the GPU buffers and the offline tools.
+struct Vertex
+{
+    // Vertex Position
+    glm::vec3 Position;
+    // Vertex Normal
+    glm::vec3 Normal;
+    // Vertex Tangent
+    glm::vec3 Tangent;
+    // Texture Coordinates
+    glm::vec2 TexCoord;
+};
+
+#endif
@@ -0,0 +1,11 @@
+#version 420 core
+
+out vec2 TexCoord;
+
+// One Triangle Covering The Screen, Made From The Vertex Index So It Needs No Buffers.
+void main()
+{
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    TexCoord = corner;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
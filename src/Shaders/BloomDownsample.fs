@@ -0,0 +1,62 @@
+#version 420 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+// The Next Larger Level, Or The Brightness Texture For The First
+uniform sampler2D source;
+// Weights The First Downsample's Boxes by Their Brightness, So a Lone Bright Pixel Doesn't Flicker as It Moves
+uniform bool karisAverage;
+
+float luma(vec3 color)
+{
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// Box Weighted by 1 / (1 + Luma)
+vec4 karis(vec3 color, float weight)
+{
+    float w = weight / (1.0 + luma(color));
+    return vec4(color * w, w);
+}
+
+// 13 Taps Over a 4x4 Texel Area of The Source, Five Overlapping 2x2 Boxes (Jimenez, "Next Generation Post Processing in Call of Duty")
+void main()
+{
+    vec2 texel = 1.0 / textureSize(source, 0);
+
+    vec3 a = texture(source, TexCoord + texel * vec2(-2.0,  2.0)).rgb;
+    vec3 b = texture(source, TexCoord + texel * vec2( 0.0,  2.0)).rgb;
+    vec3 c = texture(source, TexCoord + texel * vec2( 2.0,  2.0)).rgb;
+    vec3 d = texture(source, TexCoord + texel * vec2(-2.0,  0.0)).rgb;
+    vec3 e = texture(source, TexCoord).rgb;
+    vec3 f = texture(source, TexCoord + texel * vec2( 2.0,  0.0)).rgb;
+    vec3 g = texture(source, TexCoord + texel * vec2(-2.0, -2.0)).rgb;
+    vec3 h = texture(source, TexCoord + texel * vec2( 0.0, -2.0)).rgb;
+    vec3 i = texture(source, TexCoord + texel * vec2( 2.0, -2.0)).rgb;
+    vec3 j = texture(source, TexCoord + texel * vec2(-1.0,  1.0)).rgb;
+    vec3 k = texture(source, TexCoord + texel * vec2( 1.0,  1.0)).rgb;
+    vec3 l = texture(source, TexCoord + texel * vec2(-1.0, -1.0)).rgb;
+    vec3 m = texture(source, TexCoord + texel * vec2( 1.0, -1.0)).rgb;
+
+    //The Center Box Counts Half, The Four Corner Boxes an Eighth Each.
+    vec3 color;
+    if (karisAverage)
+    {
+        vec4 sum = karis((j + k + l + m) * 0.25, 0.5);
+        sum += karis((a + b + d + e) * 0.25, 0.125);
+        sum += karis((b + c + e + f) * 0.25, 0.125);
+        sum += karis((d + e + g + h) * 0.25, 0.125);
+        sum += karis((e + f + h + i) * 0.25, 0.125);
+        color = sum.rgb / max(sum.a, 1e-4);
+    }
+    else
+    {
+        color = e * 0.125;
+        color += (a + c + g + i) * 0.03125;
+        color += (b + d + f + h) * 0.0625;
+        color += (j + k + l + m) * 0.125;
+    }
+
+    FragColor = vec4(max(color, 0.0), 1.0);
+}
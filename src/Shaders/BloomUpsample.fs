@@ -0,0 +1,23 @@
+#version 420 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+// The Next Smaller Level, Added Onto The Level Being Drawn
+uniform sampler2D source;
+// Filter Radius in Texels of The Source
+uniform float radius;
+
+// 3x3 Tent Filter, Bilinear Filtering Smooths Out The Blocks of The Smaller Level
+void main()
+{
+    vec2 d = radius / textureSize(source, 0);
+
+    vec3 color = texture(source, TexCoord).rgb * 4.0;
+    color += (texture(source, TexCoord + vec2(-d.x, 0.0)).rgb + texture(source, TexCoord + vec2(d.x, 0.0)).rgb
+            + texture(source, TexCoord + vec2(0.0, -d.y)).rgb + texture(source, TexCoord + vec2(0.0, d.y)).rgb) * 2.0;
+    color += texture(source, TexCoord + vec2(-d.x, -d.y)).rgb + texture(source, TexCoord + vec2(d.x, -d.y)).rgb
+           + texture(source, TexCoord + vec2(-d.x, d.y)).rgb + texture(source, TexCoord + vec2(d.x, d.y)).rgb;
+
+    FragColor = vec4(color / 16.0, 1.0);
+}
@@ -0,0 +1,54 @@
+#version 420 core
+layout (location = 0) out vec4 FragmentColor;
+layout (location = 1) out vec4 BrightColor;
+
+in SPRITE
+{
+    vec2 Corner;
+    flat vec4 Body;
+    flat uint Layer;
+    flat float Coverage;
+} fs_in;
+
+// Albedo & Emission of Every Model Seen From The Front, Albedo Has The Coverage in Alpha.
+uniform sampler2DArray albedoImpostors;
+uniform sampler2DArray emissionImpostors;
+
+uniform vec3 cameraRight, cameraUp;
+uniform vec3 lightPosition;
+// Color Times Intensity of The Point Light.
+uniform vec3 lightRadiance;
+// The Bake Leaves It Out, Like The gBuffer Does.
+uniform float emissionStrength;
+
+const float PI = 3.14159265359;
+
+void main()
+{
+    float r2 = dot(fs_in.Corner, fs_in.Corner);
+    if (r2 > 1.0)
+        discard;
+
+    //The Bake Is Already Black Where The Body Isn't, Its Small Levels Average It With The Body.
+    vec3 texCoord = vec3(fs_in.Corner * 0.5 + 0.5, float(fs_in.Layer));
+    vec3 albedo = texture(albedoImpostors, texCoord).rgb;
+    vec3 emission = emissionStrength * texture(emissionImpostors, texCoord).rgb;
+
+    //Light The Sprite as a Sphere, Like The Lighting Pass Would Light The Body's Surface.
+    vec3 toCamera = normalize(-fs_in.Body.xyz);
+    vec3 N = normalize(cameraRight * fs_in.Corner.x + cameraUp * fs_in.Corner.y + toCamera * sqrt(1.0 - r2));
+    vec3 surface = fs_in.Body.xyz + N * fs_in.Body.w;
+    vec3 toLight = lightPosition - surface;
+    float distanceSquared = max(dot(toLight, toLight), 1e-20);
+    float NdotL = max(dot(N, toLight * inversesqrt(distanceSquared)), 0.0);
+
+    vec3 baseColor = pow(albedo, vec3(2.2));
+    vec3 color = (baseColor / PI * lightRadiance / distanceSquared * NdotL + emission) * fs_in.Coverage;
+
+    color = pow(color, vec3(1.0 / 2.2));
+    FragmentColor = vec4(color, 1.0);
+
+    //Same Brightness Threshold as The Lighting Pass, So Distant Bodies Bloom Like Near Ones.
+    float brightness = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    BrightColor = brightness > 1.5 ? vec4(color, 1.0) : vec4(0.0);
+}
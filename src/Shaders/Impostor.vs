@@ -0,0 +1,43 @@
+#version 420 core
+layout(location = 0) in vec2 corner;
+// Per Sprite: Center Relative to The Camera & Bounding Radius, Then The Impostor's Layer.
+layout(location = 1) in vec4 body;
+layout(location = 2) in uint layer;
+
+out SPRITE
+{
+    vec2 Corner;                                // -1 to 1 Across The Sprite.
+    flat vec4 Body;
+    flat uint Layer;
+    flat float Coverage;                        // How Much of The Sprite The Body Really Covers.
+} vs_out;
+
+uniform vec3 cameraRight, cameraUp;
+uniform float pixelsPerRadian;
+uniform float minSpriteRadius;
+// 2 / log2(far + 1) when the GPU has no reversed-Z (glClipControl), 0 leaves the projection's depth alone
+uniform float logDepthCoefficient;
+
+layout(std140, binding = 0)uniform Matrices
+{
+    mat4 viewProjection;
+};
+
+void main()
+{
+    //Never Smaller Than minSpriteRadius Pixels, Smaller Bodies Get Dimmer Instead.
+    float spriteRadius = max(body.w, minSpriteRadius * length(body.xyz) / pixelsPerRadian);
+    float share = body.w / spriteRadius;
+
+    vs_out.Corner   = corner;
+    vs_out.Body     = body;
+    vs_out.Layer    = layer;
+    vs_out.Coverage = share * share;
+
+    vec3 position = body.xyz + (cameraRight * corner.x + cameraUp * corner.y) * spriteRadius;
+    gl_Position = viewProjection * vec4(position, 1.0);
+
+    // Same depth as the meshes, so bodies in front still hide the sprite
+    if (logDepthCoefficient > 0.0)
+        gl_Position.z = (log2(max(1e-6, 1.0 + gl_Position.w)) * logDepthCoefficient - 1.0) * gl_Position.w;
+}
@@ -0,0 +1,107 @@
+#version 430 core
+// One Work Group Per Tile, One Thread Per Pixel & Per Light.
+layout (local_size_x = 16, local_size_y = 16) in;
+
+const uint MAX_LIGHTS = 256u;               // TiledLighting::MaxLights, Also The Threads of a Group.
+const uint MAX_LIGHTS_PER_TILE = 63u;       // TiledLighting::MaxLightsPerTile.
+
+struct Light
+{
+    vec4 positionRange;                     // Camera Relative Position, Range in w.
+    vec4 radiance;
+};
+
+layout (std140, binding = 1) uniform Lights
+{
+    Light lights[MAX_LIGHTS];
+    uint lightCount;
+};
+
+// Per Tile The Count, Then The Indices of Its Lights in Ascending Order.
+layout (std430, binding = 2) writeonly buffer TileLights
+{
+    uint tileLights[];
+};
+
+uniform sampler2D gDepth;
+// Rotation Only, The Camera Sits at The Origin.
+uniform mat4 view;
+// projection[0][0] & projection[1][1].
+uniform vec2 projectionScale;
+// 0 With Reversed-Z, Otherwise Depth Was Written Logarithmically With This Coefficient.
+uniform float logDepthCoefficient;
+uniform float nearPlane;
+
+shared uint minDepthBits, maxDepthBits;
+shared uint lightMask[MAX_LIGHTS / 32u];
+
+// Distance Along The View Direction, Undoing Whichever Depth Convention Wrote It.
+float viewDepth(float depth)
+{
+    return logDepthCoefficient > 0.0 ? exp2(depth * 2.0 / logDepthCoefficient) - 1.0 : nearPlane / depth;
+}
+
+void main()
+{
+    uint thread = gl_LocalInvocationIndex;
+    if (thread == 0u)
+    {
+        minDepthBits = floatBitsToUint(3.402823e38);
+        maxDepthBits = 0u;
+    }
+    if (thread < MAX_LIGHTS / 32u)
+        lightMask[thread] = 0u;
+    barrier();
+
+    //Depth Range of The Tile, Positive Floats Sort Like Their Bits. Sky Pixels Have Nothing to Light.
+    ivec2 size = textureSize(gDepth, 0);
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (all(lessThan(pixel, size)))
+    {
+        float depth = texelFetch(gDepth, pixel, 0).r;
+        if (depth != (logDepthCoefficient > 0.0 ? 1.0 : 0.0))
+        {
+            uint bits = floatBitsToUint(viewDepth(depth));
+            atomicMin(minDepthBits, bits);
+            atomicMax(maxDepthBits, bits);
+        }
+    }
+    barrier();
+
+    //Side Planes of The Tile Through The Camera in View Space, Normals Pointing In. A Point is Right of x = a * w When x + a * z >= 0.
+    vec2 low = (vec2(gl_WorkGroupID.xy * gl_WorkGroupSize.xy) / vec2(size) * 2.0 - 1.0) / projectionScale;
+    vec2 high = (vec2((gl_WorkGroupID.xy + 1u) * gl_WorkGroupSize.xy) / vec2(size) * 2.0 - 1.0) / projectionScale;
+    vec3 planes[4] = vec3[4](normalize(vec3(1.0, 0.0, low.x)), normalize(vec3(-1.0, 0.0, -high.x)),
+                             normalize(vec3(0.0, 1.0, low.y)), normalize(vec3(0.0, -1.0, -high.y)));
+
+    //Every Thread Tests One Light's Sphere Against The Tile's Slice of The View.
+    float minDepth = uintBitsToFloat(minDepthBits), maxDepth = uintBitsToFloat(maxDepthBits);
+    if (thread < min(lightCount, MAX_LIGHTS) && maxDepthBits != 0u)
+    {
+        vec3 position = mat3(view) * lights[thread].positionRange.xyz;
+        float range = lights[thread].positionRange.w;
+        float w = -position.z;
+        bool inside = w + range >= minDepth && w - range <= maxDepth;
+        for (int i = 0; i < 4; i++)
+            inside = inside && dot(planes[i], position) >= -range;
+        if (inside)
+            atomicOr(lightMask[thread / 32u], 1u << (thread % 32u));
+    }
+    barrier();
+
+    //Compact The Mask in Light Order, So Every Frame Sums The Same Lights The Same Way.
+    uint base = (gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x) * (MAX_LIGHTS_PER_TILE + 1u);
+    uint word = thread / 32u, bit = thread % 32u;
+    uint slot = bitCount(lightMask[word] & ((1u << bit) - 1u));
+    uint total = 0u;
+    for (uint i = 0u; i < MAX_LIGHTS / 32u; i++)
+    {
+        uint count = bitCount(lightMask[i]);
+        slot += i < word ? count : 0u;
+        total += count;
+    }
+    if ((lightMask[word] & (1u << bit)) != 0u && slot < MAX_LIGHTS_PER_TILE)
+        tileLights[base + 1u + slot] = thread;
+    if (thread == 0u)
+        tileLights[base] = min(total, MAX_LIGHTS_PER_TILE);
+}
@@ -4,32 +4,68 @@ layout (location = 1) out vec4 BrightColor;
 
 in vec2 TexCoord;
 
-struct PointLight
+const uint MAX_LIGHTS = 256u;               // TiledLighting::MaxLights.
+const uint MAX_LIGHTS_PER_TILE = 63u;       // TiledLighting::MaxLightsPerTile.
+const int TILE_SIZE = 16;                   // TiledLighting::TileSize.
+
+struct Light
+{
+    vec4 positionRange;                     // Camera Relative Position, Range in w.
+    vec4 radiance;
+};
+
+layout (std140, binding = 1) uniform Lights
 {
-    vec3 position;
-    vec3 color;
-    float intensity;
+    Light lights[MAX_LIGHTS];
+    uint lightCount;
 };
 
-uniform PointLight pointLight;
+// Per Tile The Count, Then The Indices of Its Lights. Without Tiles Every Light is Shaded.
+uniform usamplerBuffer tileLights;
+uniform bool tiled;
+uniform uint tilesPerRow;
 
 uniform vec3 viewPos;
 
 uniform float specularStrength;
+// The gBuffer Holds Emission Before Its Strength.
+uniform float emissionStrength;
 
-uniform sampler2D gPosition;
+uniform sampler2D gDepth;
 uniform sampler2D gNormal;
 uniform sampler2D gAlbedo;
 uniform sampler2D gEmission;
 uniform sampler2D gMetallicRoughness;
 
+// Camera Relative View Projection of The Geometry Pass, Inverted.
+uniform mat4 inverseViewProjection;
+// Clip Space z as a Function of View Depth w: clipDepth.x * w + clipDepth.y.
+uniform vec2 clipDepth;
+// 0 With Reversed-Z, Otherwise Depth Was Written Logarithmically With This Coefficient.
+uniform float logDepthCoefficient;
+// Depth Where Nothing Was Drawn.
+uniform float farDepth;
+
 //PBR
 uniform samplerCube irradianceMap;
 uniform samplerCube prefilterMap;
 uniform sampler2D brdfLUT;
+// Spherical Harmonics of The Irradiance (Divided by PI Like The Irradiance Map), Read Instead of The Map When irradianceFromSH is Set.
+uniform vec3 irradianceSH[9];
+uniform bool irradianceFromSH;
 
 const float PI = 3.14159265359;
 // ----------------------------------------------------------------------------
+// Same Basis as SphericalHarmonics::Evaluate.
+vec3 EvaluateSH(vec3 n)
+{
+    return irradianceSH[0] * 0.282095
+         + irradianceSH[1] * (0.488603 * n.y) + irradianceSH[2] * (0.488603 * n.z) + irradianceSH[3] * (0.488603 * n.x)
+         + irradianceSH[4] * (1.092548 * n.x * n.y) + irradianceSH[5] * (1.092548 * n.y * n.z)
+         + irradianceSH[6] * (0.315392 * (3.0 * n.z * n.z - 1.0)) + irradianceSH[7] * (1.092548 * n.x * n.z)
+         + irradianceSH[8] * (0.546274 * (n.x * n.x - n.y * n.y));
+}
+// ----------------------------------------------------------------------------
 float DistributionGGX(vec3 N, vec3 H, float roughness)
 {
     float a = roughness*roughness;
@@ -75,13 +111,41 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }
 
+// ----------------------------------------------------------------------------
+vec3 decodeNormal(vec2 encoded)
+{
+    vec2 f = encoded * 2.0 - 1.0;
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy -= t * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+// ----------------------------------------------------------------------------
+vec3 reconstructPosition(float depth)
+{
+    // Distance along the view direction, undoing whichever depth convention wrote it
+    float w = logDepthCoefficient > 0.0 ? exp2(depth * 2.0 / logDepthCoefficient) - 1.0 : clipDepth.y / depth;
+    // Back from clip space without a divide, the camera sits at the origin
+    vec4 clip = vec4((TexCoord * 2.0 - 1.0) * w, clipDepth.x * w + clipDepth.y, w);
+    return (inverseViewProjection * clip).xyz;
+}
+
 void main()
 {   
+    //Nothing Was Drawn Here, The Skybox Fills It Later.
+    float depth = texture(gDepth, TexCoord).r;
+    if (depth == farDepth)
+    {
+        FragmentColor = vec4(0.0, 0.0, 0.0, 1.0);
+        BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
     // Retrieve data from gbuffer
-    vec3 FragPos = texture(gPosition, TexCoord).rgb;
-    vec3 Normal = texture(gNormal, TexCoord).rgb;
+    vec3 FragPos = reconstructPosition(depth);
+    vec3 Normal = decodeNormal(texture(gNormal, TexCoord).rg);
     vec3 baseColor = texture(gAlbedo, TexCoord).rgb;
-    vec3 emissionColor = texture(gEmission, TexCoord).rgb;
+    vec3 emissionColor = emissionStrength * texture(gEmission, TexCoord).rgb;
 
     // Get View Direction.
     vec3 viewDir  = normalize(viewPos - FragPos);
@@ -107,38 +171,54 @@ void main()
     // reflectance equation
     vec3 Lo = vec3(0.0);
     
-    // calculate per-light radiance
-    vec3 L = normalize(pointLight.position - FragPos);
-    vec3 H = normalize(viewDir + L);
-    float dist = length(pointLight.position - FragPos);
-    float attenuation = 1.0 / (dist * dist);
-    vec3 radiance = pointLight.color * pointLight.intensity * attenuation;
-
-    // Cook-Torrance BRDF
-    float NDF = DistributionGGX(Normal, H, roughness);
-    float G   = GeometrySmith(Normal, viewDir, L, roughness);
-    vec3 F1    = fresnelSchlick(max(dot(H, viewDir), 0.0), F0);
-            
-    vec3 numerator    = NDF * G * F1;
-    float denominator = 4.0 * max(dot(Normal, viewDir), 0.0) * max(dot(Normal, L), 0.0) + 0.0001; // + 0.0001 to prevent divide by zero
-    vec3 specular1 = numerator / denominator;
-            
-    // kS is equal to Fresnel
-    vec3 kS1 = F1;
-    // for energy conservation, the diffuse and specular light can't
-    // be above 1.0 (unless the surface emits light); to preserve this
-    // relationship the diffuse component (kD) should equal 1.0 - kS.
-    vec3 kD1 = vec3(1.0) - kS1;
-    // multiply kD by the inverse metalness such that only non-metals 
-    // have diffuse lighting, or a linear blend if partly metal (pure metals
-    // have no diffuse light).
-    kD1 *= 1.0 - metallic;	                
-                
-    // scale light by NdotL
-    float NdotL = max(dot(Normal, L), 0.0);        
-
-    // add to outgoing radiance Lo
-    Lo += (kD1 * baseColor / PI + specular1) * radiance * NdotL; // note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
+    //Only The Lights Culling Found Reaching This Pixel's Tile.
+    uint tileBase = 0u;
+    uint count = lightCount;
+    if (tiled)
+    {
+        ivec2 tile = ivec2(gl_FragCoord.xy) / TILE_SIZE;
+        tileBase = (uint(tile.y) * tilesPerRow + uint(tile.x)) * (MAX_LIGHTS_PER_TILE + 1u);
+        count = texelFetch(tileLights, int(tileBase)).r;
+    }
+
+    for (uint i = 0u; i < count; i++)
+    {
+        Light light = lights[tiled ? texelFetch(tileLights, int(tileBase + 1u + i)).r : i];
+
+        // calculate per-light radiance, faded out smoothly before its range so culling leaves no edge
+        vec3 L = normalize(light.positionRange.xyz - FragPos);
+        vec3 H = normalize(viewDir + L);
+        float dist = length(light.positionRange.xyz - FragPos);
+        float falloff = clamp(1.0 - pow(dist / light.positionRange.w, 4.0), 0.0, 1.0);
+        float attenuation = falloff * falloff / (dist * dist);
+        vec3 radiance = light.radiance.rgb * attenuation;
+
+        // Cook-Torrance BRDF
+        float NDF = DistributionGGX(Normal, H, roughness);
+        float G   = GeometrySmith(Normal, viewDir, L, roughness);
+        vec3 F1    = fresnelSchlick(max(dot(H, viewDir), 0.0), F0);
+
+        vec3 numerator    = NDF * G * F1;
+        float denominator = 4.0 * max(dot(Normal, viewDir), 0.0) * max(dot(Normal, L), 0.0) + 0.0001; // + 0.0001 to prevent divide by zero
+        vec3 specular1 = numerator / denominator;
+
+        // kS is equal to Fresnel
+        vec3 kS1 = F1;
+        // for energy conservation, the diffuse and specular light can't
+        // be above 1.0 (unless the surface emits light); to preserve this
+        // relationship the diffuse component (kD) should equal 1.0 - kS.
+        vec3 kD1 = vec3(1.0) - kS1;
+        // multiply kD by the inverse metalness such that only non-metals 
+        // have diffuse lighting, or a linear blend if partly metal (pure metals
+        // have no diffuse light).
+        kD1 *= 1.0 - metallic;	                
+
+        // scale light by NdotL
+        float NdotL = max(dot(Normal, L), 0.0);        
+
+        // add to outgoing radiance Lo
+        Lo += (kD1 * baseColor / PI + specular1) * radiance * NdotL; // note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
+    }
     
     // ambient lighting (we now use IBL as the ambient term)
     vec3 F = fresnelSchlickRoughness(max(dot(Normal, viewDir), 0.0), F0, roughness);
@@ -147,7 +227,7 @@ void main()
     vec3 kD = 1.0 - kS;
     kD *= 1.0 - metallic;
         
-    vec3 irradiance = texture(irradianceMap, Normal).rgb;
+    vec3 irradiance = irradianceFromSH ? max(EvaluateSH(Normal), 0.0) : texture(irradianceMap, Normal).rgb;
     vec3 diffuse    = irradiance * baseColor;
         
     // sample both the pre-filter map and the BRDF lut and combine them together as per the Split-Sum approximation to get the IBL specular part.
@@ -2,64 +2,62 @@
 in VS_OUT
 {
     vec2 TexCoord;
-    vec3 FragPos;
     vec3 Normal;
     mat3 TBN;
+    flat uvec4 TextureFlags;                    // Has Base Color, Metallic Roughness, Emission & Normal Texture.
+    flat vec2 MetallicRoughnessFactors;         // Multiplied By The Blue & Green Channels of The Metallic Roughness Texture.
 } fs_in;
 
-layout (location = 0) out vec3 gPosition;
-layout (location = 1) out vec3 gNormal;
-layout (location = 2) out vec3 gAlbedo;
-layout (location = 3) out vec3 gEmission;
-layout (location = 4) out vec2 gMetallicRoughness;
+// No Position, The Lighting Pass Rebuilds It From Depth.
+layout (location = 0) out vec2 gNormal;     // Octahedral, See encodeNormal.
+layout (location = 1) out vec4 gAlbedo;     // Alpha Marks What The Body Covers, For Impostor Bakes.
+layout (location = 2) out vec3 gEmission;   // Before The Emission Strength, Which The Lighting Pass Multiplies In.
+layout (location = 3) out vec2 gMetallicRoughness;
 
 uniform struct Material
 {
-    uint hasBCT;                                // Tells if There is A Base Color Texture For This Mesh.
     sampler2D baseColorTexture;                 // BCT
-
-    uint hasMRT;                                // Tells if There is a metallicRoughness Texture.
     sampler2D metallicRoughnessTexture;         // Metallic Roughness Texture.
-    float metallicFactor;                       // Metallic Factor Multiplied By The Sampling of the Blue Color of Metallic Roughness Texture.
-    float roughnessFactor;                      // Roughness Factor Multiplied By The Sampling of the Green Color of Metallic Roughness Texture.
 
-    uint hasET;                                 // Tells if There is A Emissive Texture for this Mesh.
-    float emissionStrength;                     // The Strength Of The Emission Texture To Add Color Bleeding.
     sampler2D emissionTexture;                  // Emission Texture.
 
-    uint hasNT;                                 // Tells if There is A Normal Texture for this Mesh.
     sampler2D normalTexture;                    // Normal Texture.
 }material;
 
-void main()
+// Folds The Unit Sphere Onto an Octahedron & Unfolds That Into The Unit Square, Two Channels Without Wasting Precision on The Poles.
+vec2 encodeNormal(vec3 n)
 {
-    //Store The Fragment Position in the First gBuffer Texture.
-    gPosition = fs_in.FragPos;
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 folded = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return folded * 0.5 + 0.5;
+}
 
-    //Store The Fragment Normal in the Second gBuffer Texture.
-    vec3 normal = material.hasNT > 0 ? normalize(fs_in.TBN * (texture(material.normalTexture, fs_in.TexCoord).rgb * 2.0 - 1.0)) : normalize(fs_in.Normal);
-    gNormal = normal;
+void main()
+{
+    //Store The Fragment Normal in the First gBuffer Texture.
+    vec3 normal = fs_in.TextureFlags.w > 0 ? normalize(fs_in.TBN * (texture(material.normalTexture, fs_in.TexCoord).rgb * 2.0 - 1.0)) : normalize(fs_in.Normal);
+    gNormal = encodeNormal(normal);
 
     //Get Emission Color.
-    vec3 emissionColor = material.emissionStrength * material.hasET * texture2D(material.emissionTexture, fs_in.TexCoord).rgb;
+    vec3 emissionColor = fs_in.TextureFlags.z * texture(material.emissionTexture, fs_in.TexCoord).rgb;
 
     //Get Base Color.
-    vec3 baseColor = material.hasBCT * texture2D(material.baseColorTexture, fs_in.TexCoord).rgb;
+    vec3 baseColor = fs_in.TextureFlags.x * texture(material.baseColorTexture, fs_in.TexCoord).rgb;
 
-    //Store The Fragment Albedo Data in the Third gBuffer Texture.
-    gAlbedo = baseColor;
+    //Store The Fragment Albedo Data in the Second gBuffer Texture.
+    gAlbedo = vec4(baseColor, 1.0);
 
-    //Store The Fragment Emission Data in the Fourth gBuffer Texture.
+    //Store The Fragment Emission Data in the Third gBuffer Texture.
     gEmission = emissionColor;
 
     //Get Metallic Roughness Value
     vec2 metallicRoughness = vec2(1.0f);
     //Multiply Roughness & Roughness Factor & Metallicness By Metallic Factor.     
-    metallicRoughness.r *= clamp(material.metallicFactor, 0.0, 1.0);
-    metallicRoughness.g *= clamp(material.roughnessFactor, 0.0, 1.0);
-    if(material.hasMRT > 0)
-        metallicRoughness *= texture2D(material.metallicRoughnessTexture, fs_in.TexCoord).bg;
+    metallicRoughness.r *= clamp(fs_in.MetallicRoughnessFactors.x, 0.0, 1.0);
+    metallicRoughness.g *= clamp(fs_in.MetallicRoughnessFactors.y, 0.0, 1.0);
+    if(fs_in.TextureFlags.y > 0)
+        metallicRoughness *= texture(material.metallicRoughnessTexture, fs_in.TexCoord).bg;
     
-    //Store The Fragment Metallic Roughness Data in the Fifth gBuffer Texture.
+    //Store The Fragment Metallic Roughness Data in the Fourth gBuffer Texture.
     gMetallicRoughness = metallicRoughness;
 }
\ No newline at end of file
@@ -7,12 +7,18 @@ layout(location = 3) in vec2 texCoord;
 out VS_OUT
 {
     vec2 TexCoord;
-    vec3 FragPos;
     vec3 Normal;
     mat3 TBN;
+    flat uvec4 TextureFlags;                    // 1 if The Material Has a Base Color, Metallic Roughness, Emission & Normal Texture.
+    flat vec2 MetallicRoughnessFactors;
 } vs_out;
 
 uniform mat4 model;
+// The Material of The Mesh Being Drawn, Passed on to Model.fs
+uniform uint hasBCT, hasMRT, hasET, hasNT;
+uniform float metallicFactor, roughnessFactor;
+// 2 / log2(far + 1) when the GPU has no reversed-Z (glClipControl), 0 leaves the projection's depth alone
+uniform float logDepthCoefficient;
 
 layout(std140, binding = 0)uniform Matrices
 {
@@ -29,9 +35,14 @@ void main()
     
     vs_out.TexCoord     = mat2(0.0, -1.0, 1.0, 0.0) * texCoord;
     vec4 worldPos       = model * vec4(pos, 1.0);
-    vs_out.FragPos      = vec3(worldPos);
     vs_out.Normal       = N;
     vs_out.TBN          = mat3(T, B, N);
+    vs_out.TextureFlags = uvec4(hasBCT, hasMRT, hasET, hasNT);
+    vs_out.MetallicRoughnessFactors = vec2(metallicFactor, roughnessFactor);
     
     gl_Position     = viewProjection * worldPos;
+
+    // Logarithmic depth spreads the precision evenly from a few meters out to the edge of the system
+    if (logDepthCoefficient > 0.0)
+        gl_Position.z = (log2(max(1e-6, 1.0 + gl_Position.w)) * logDepthCoefficient - 1.0) * gl_Position.w;
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+#version 430 core
+in VS_OUT
+{
+    vec2 TexCoord;
+    vec3 Normal;
+    mat3 TBN;
+    flat uvec4 Textures;                        // (Array << 16) | Layer of The Base Color, Metallic Roughness, Emission & Normal Texture.
+    flat vec2 MetallicRoughnessFactors;         // Multiplied By The Blue & Green Channels of The Metallic Roughness Texture.
+} fs_in;
+
+// No Position, The Lighting Pass Rebuilds It From Depth.
+layout (location = 0) out vec2 gNormal;     // Octahedral, See encodeNormal.
+layout (location = 1) out vec4 gAlbedo;     // Alpha Marks What The Body Covers, For Impostor Bakes.
+layout (location = 2) out vec3 gEmission;   // Before The Emission Strength, Which The Lighting Pass Multiplies In.
+layout (location = 3) out vec2 gMetallicRoughness;
+
+const uint NO_TEXTURE = 0xFFFFFFFFu;
+
+// Every Material Texture, One Array Per Size & Format (TextureArrays::MaxArrays).
+uniform sampler2DArray textureArrays[16];
+
+// The Array Changes Between The Draws of a Multi Draw, So It is Picked With Constant Indices
+// & Sampled With Gradients Taken Outside The Branch.
+vec4 sampleTexture(uint location, vec2 dx, vec2 dy)
+{
+    vec3 coord = vec3(fs_in.TexCoord, float(location & 0xFFFFu));
+    switch (location >> 16)
+    {
+        case 0u:  return textureGrad(textureArrays[0], coord, dx, dy);
+        case 1u:  return textureGrad(textureArrays[1], coord, dx, dy);
+        case 2u:  return textureGrad(textureArrays[2], coord, dx, dy);
+        case 3u:  return textureGrad(textureArrays[3], coord, dx, dy);
+        case 4u:  return textureGrad(textureArrays[4], coord, dx, dy);
+        case 5u:  return textureGrad(textureArrays[5], coord, dx, dy);
+        case 6u:  return textureGrad(textureArrays[6], coord, dx, dy);
+        case 7u:  return textureGrad(textureArrays[7], coord, dx, dy);
+        case 8u:  return textureGrad(textureArrays[8], coord, dx, dy);
+        case 9u:  return textureGrad(textureArrays[9], coord, dx, dy);
+        case 10u: return textureGrad(textureArrays[10], coord, dx, dy);
+        case 11u: return textureGrad(textureArrays[11], coord, dx, dy);
+        case 12u: return textureGrad(textureArrays[12], coord, dx, dy);
+        case 13u: return textureGrad(textureArrays[13], coord, dx, dy);
+        case 14u: return textureGrad(textureArrays[14], coord, dx, dy);
+        case 15u: return textureGrad(textureArrays[15], coord, dx, dy);
+    }
+    return vec4(0.0);
+}
+
+// Folds The Unit Sphere Onto an Octahedron & Unfolds That Into The Unit Square, Two Channels Without Wasting Precision on The Poles.
+vec2 encodeNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 folded = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return folded * 0.5 + 0.5;
+}
+
+void main()
+{
+    vec2 dx = dFdx(fs_in.TexCoord);
+    vec2 dy = dFdy(fs_in.TexCoord);
+    bvec4 hasTexture = notEqual(fs_in.Textures, uvec4(NO_TEXTURE));
+
+    //Store The Fragment Normal in the First gBuffer Texture.
+    vec3 normal = hasTexture.w ? normalize(fs_in.TBN * (sampleTexture(fs_in.Textures.w, dx, dy).rgb * 2.0 - 1.0)) : normalize(fs_in.Normal);
+    gNormal = encodeNormal(normal);
+
+    //Get Emission Color.
+    vec3 emissionColor = hasTexture.z ? sampleTexture(fs_in.Textures.z, dx, dy).rgb : vec3(0.0);
+
+    //Get Base Color.
+    vec3 baseColor = hasTexture.x ? sampleTexture(fs_in.Textures.x, dx, dy).rgb : vec3(0.0);
+
+    //Store The Fragment Albedo Data in the Second gBuffer Texture.
+    gAlbedo = vec4(baseColor, 1.0);
+
+    //Store The Fragment Emission Data in the Third gBuffer Texture.
+    gEmission = emissionColor;
+
+    //Get Metallic Roughness Value
+    vec2 metallicRoughness = vec2(1.0f);
+    //Multiply Roughness & Roughness Factor & Metallicness By Metallic Factor.
+    metallicRoughness.r *= clamp(fs_in.MetallicRoughnessFactors.x, 0.0, 1.0);
+    metallicRoughness.g *= clamp(fs_in.MetallicRoughnessFactors.y, 0.0, 1.0);
+    if(hasTexture.y)
+        metallicRoughness *= sampleTexture(fs_in.Textures.y, dx, dy).bg;
+
+    //Store The Fragment Metallic Roughness Data in the Fourth gBuffer Texture.
+    gMetallicRoughness = metallicRoughness;
+}
@@ -0,0 +1,73 @@
+#version 430 core
+layout(location = 0) in vec3 pos;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec3 tangent;
+layout(location = 3) in vec2 texCoord;
+// baseInstance + gl_InstanceID, read from a buffer counting up since gl_BaseInstance needs GL 4.6
+layout(location = 4) in uint instanceIndex;
+
+out VS_OUT
+{
+    vec2 TexCoord;
+    vec3 Normal;
+    mat3 TBN;
+    flat uvec4 Textures;                        // Texture Array & Layer of The Base Color, Metallic Roughness, Emission & Normal Texture.
+    flat vec2 MetallicRoughnessFactors;
+} vs_out;
+
+// One per mesh of every body, filled by BodyRenderer each frame
+struct Instance
+{
+    mat4 model;
+    uint material;
+};
+
+// One per merged mesh, uploaded when a material changes
+struct MaterialEntry
+{
+    vec2 metallicRoughness;
+    uvec4 textures;                             // (Array << 16) | Layer, 0xFFFFFFFF if The Material Has No Such Texture.
+};
+
+layout(std430, binding = 0) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+layout(std430, binding = 1) readonly buffer Materials
+{
+    MaterialEntry materials[];
+};
+
+// 2 / log2(far + 1) when the GPU has no reversed-Z (glClipControl), 0 leaves the projection's depth alone
+uniform float logDepthCoefficient;
+
+layout(std140, binding = 0)uniform Matrices
+{
+    mat4 viewProjection;
+};
+
+void main()
+{
+    mat4 model = instances[instanceIndex].model;
+    MaterialEntry material = materials[instances[instanceIndex].material];
+
+    mat3 normalMatrix = transpose(inverse(mat3(model)));
+    vec3 N = normalize(normalMatrix * normal);
+    vec3 T = normalize(normalMatrix * tangent);
+    T = normalize(T - dot(T, N) * N);
+    vec3 B = cross(N, T);
+
+    vs_out.TexCoord     = mat2(0.0, -1.0, 1.0, 0.0) * texCoord;
+    vec4 worldPos       = model * vec4(pos, 1.0);
+    vs_out.Normal       = N;
+    vs_out.TBN          = mat3(T, B, N);
+    vs_out.Textures     = material.textures;
+    vs_out.MetallicRoughnessFactors = material.metallicRoughness;
+
+    gl_Position     = viewProjection * worldPos;
+
+    // Logarithmic depth spreads the precision evenly from a few meters out to the edge of the system
+    if (logDepthCoefficient > 0.0)
+        gl_Position.z = (log2(max(1e-6, 1.0 + gl_Position.w)) * logDepthCoefficient - 1.0) * gl_Position.w;
+}
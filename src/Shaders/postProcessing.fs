@@ -7,6 +7,7 @@ uniform sampler2D screenTexture;
 uniform sampler2D blurTexture;
 uniform float exposure;
 uniform uint toneMapping;
+uniform float bloomStrength;
 
 //Exposure Tone Mapping
 vec3 exposureToneMapping(vec3 x){
@@ -125,7 +126,7 @@ void main()
     vec3 color = texture(screenTexture, TexCoord).rgb;
 
     //Add BlurTexture To The Screen Texture if Bloom Effect is Enabled.
-    color += texture(blurTexture, TexCoord).rgb;
+    color += texture(blurTexture, TexCoord).rgb * bloomStrength;
 
     if(toneMapping == 0)
     {
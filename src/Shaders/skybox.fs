@@ -1,7 +1,8 @@
 #version 420 core
 
 in vec3 TexCoord;
-out vec4 FragmentColor;
+layout (location = 0) out vec4 FragmentColor;
+layout (location = 1) out vec4 BrightColor;
 
 uniform samplerCube skybox;
 
@@ -13,4 +14,6 @@ void main()
     envColor = pow(envColor, vec3(1.0/2.2));
 
     FragmentColor = vec4(envColor, 1.0);
+    //Drawn Before The Bloom Pass, The Sky Itself Never Blooms.
+    BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
 }
\ No newline at end of file
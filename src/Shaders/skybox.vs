@@ -4,11 +4,13 @@ layout(location = 0) in vec3 pos;
 out vec3 TexCoord;
 
 uniform mat4 viewProjection;
+// NDC depth of the far plane, 0 with reversed-Z and 1 otherwise
+uniform float farDepth;
 
 void main()
 {
     //TexCoord = vec3(pos.x, -pos.y, pos.z);
     TexCoord = pos;
     vec4 position = viewProjection * vec4(pos, 1.0);
-    gl_Position = position.xyww;
+    gl_Position = vec4(position.xy, farDepth * position.w, position.w);
 }
\ No newline at end of file
@@ -0,0 +1,347 @@
+// Offline asset baker.
+// Turns a .gltf with its buffers and images into a single .pack (see Package.h): the decoded meshes,
+// their material records and every used image with its full mip chain, ready to be mapped and uploaded.
+// Images are block compressed by default (see BlockCompression.h), every level on its own after the mips are filtered.
+//
+// Usage: AssetBaker <model.gltf> <model.pack> [--fast | --uncompressed]
+//   --fast          BC1 / BC3 instead of BC7 for color images, quicker to bake and half the size of BC7 for opaque ones
+//   --uncompressed  raw pixels, the previous package contents
+
+#include "../Scripts/JobSystem.h"
+#include "../Scripts/Model.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#pragma region Mip Generation
+
+static float s_SRGBToLinear[256];
+
+static void InitSRGBTable()
+{
+	for (int i = 0; i < 256; i++)
+	{
+		float c = i / 255.0f;
+		s_SRGBToLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+}
+
+static unsigned char LinearToSRGB(float c)
+{
+	c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+	return (unsigned char)std::min(255.0f, std::max(0.0f, c * 255.0f + 0.5f));
+}
+
+// Halves 'src' into 'dst' by averaging 2x2 blocks, an odd last row or column is averaged with itself.
+// sRGB images are averaged in linear space (alpha never is), like the GPU filters them when sampling.
+static void Downsample(const unsigned char* src, int width, int height, int channels, bool sRGB, unsigned char* dst)
+{
+	const int dstWidth = std::max(1, width >> 1);
+	const int dstHeight = std::max(1, height >> 1);
+
+	for (int y = 0; y < dstHeight; y++)
+	{
+		const int y0 = std::min(y * 2, height - 1);
+		const int y1 = std::min(y * 2 + 1, height - 1);
+		for (int x = 0; x < dstWidth; x++)
+		{
+			const int x0 = std::min(x * 2, width - 1);
+			const int x1 = std::min(x * 2 + 1, width - 1);
+			const unsigned char* texels[4] =
+			{
+				src + ((size_t)y0 * width + x0) * channels,
+				src + ((size_t)y0 * width + x1) * channels,
+				src + ((size_t)y1 * width + x0) * channels,
+				src + ((size_t)y1 * width + x1) * channels
+			};
+
+			unsigned char* out = dst + ((size_t)y * dstWidth + x) * channels;
+			for (int c = 0; c < channels; c++)
+			{
+				if (sRGB && c < 3)
+				{
+					float sum = s_SRGBToLinear[texels[0][c]] + s_SRGBToLinear[texels[1][c]] + s_SRGBToLinear[texels[2][c]] + s_SRGBToLinear[texels[3][c]];
+					out[c] = LinearToSRGB(sum * 0.25f);
+				}
+				else
+				{
+					out[c] = (unsigned char)((texels[0][c] + texels[1][c] + texels[2][c] + texels[3][c] + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+#pragma endregion
+
+#pragma region Compression
+
+enum class Compression { None, Fast, Quality };
+
+// Block format an image is baked to. Base colors keep sampling as sRGB, which only the color formats have,
+// 1 and 2 channel data images get the single and dual channel formats.
+static BlockFormat ChooseFormat(Compression compression, int channels, bool sRGB)
+{
+	if (compression == Compression::None)
+		return BlockFormat::None;
+	if (!sRGB && channels == 1)
+		return BlockFormat::BC4;
+	if (!sRGB && channels == 2)
+		return BlockFormat::BC5;
+	if (compression == Compression::Quality)
+		return BlockFormat::BC7;
+	return channels == 4 ? BlockFormat::BC3 : BlockFormat::BC1;
+}
+
+// Channels a block format decodes to, what the package records so a CPU fallback knows how much to allocate
+static int DecodedChannels(BlockFormat format, int channels)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:	return 3;
+	case BlockFormat::BC4:	return 1;
+	case BlockFormat::BC5:	return 2;
+	case BlockFormat::BC3:	return 4;
+	case BlockFormat::BC7:	return channels == 4 ? 4 : 3;
+	default:				return channels;
+	}
+}
+
+// Encodes one level, rows of blocks are split across the workers
+static std::vector<unsigned char> EncodeLevel(JobSystem& jobs, BlockFormat format, const std::vector<unsigned char>& pixels, int width, int height, int channels)
+{
+	std::vector<unsigned char> blocks(BlockCompression::LevelSize(format, width, height));
+	const size_t blockRows = (size_t)(height + 3) / 4;
+	const size_t rowBytes = BlockCompression::LevelSize(format, width, 4);
+	jobs.ParallelFor(blockRows, 8, [&](size_t begin, size_t end)
+	{
+		const int y = (int)begin * 4;
+		BlockCompression::Encode(format, pixels.data() + (size_t)y * width * channels, width, std::min(height, (int)end * 4) - y, channels,
+								 blocks.data() + begin * rowBytes);
+	});
+	return blocks;
+}
+
+#pragma endregion
+
+#pragma region Package Writer
+
+class PackageWriter
+{
+public:
+	explicit PackageWriter(const std::string& file) : m_Out(file, std::ios::binary | std::ios::trunc) {}
+
+	bool good() const { return m_Out.good(); }
+
+	// Appends a blob on the next aligned offset and returns that offset
+	uint64_t Append(const void* data, uint64_t size)
+	{
+		Pad();
+		uint64_t offset = m_Offset;
+		m_Out.write(static_cast<const char*>(data), (std::streamsize)size);
+		m_Offset += size;
+		return offset;
+	}
+
+	// Overwrites bytes that were reserved earlier, like the tables that are only known at the end
+	void Patch(uint64_t offset, const void* data, uint64_t size)
+	{
+		std::streampos end = m_Out.tellp();
+		m_Out.seekp((std::streamoff)offset);
+		m_Out.write(static_cast<const char*>(data), (std::streamsize)size);
+		m_Out.seekp(end);
+	}
+
+	void Close() { m_Out.close(); }
+
+private:
+	void Pad()
+	{
+		static const char zeros[Package::Alignment] = {};
+		uint64_t aligned = Package::align(m_Offset);
+		m_Out.write(zeros, (std::streamsize)(aligned - m_Offset));
+		m_Offset = aligned;
+	}
+
+	std::ofstream m_Out;
+	uint64_t m_Offset = 0;
+};
+
+#pragma endregion
+
+int main(int argc, char** argv)
+{
+	Compression compression = Compression::Quality;
+	if (argc == 4 && !std::strcmp(argv[3], "--fast"))
+		compression = Compression::Fast;
+	else if (argc == 4 && !std::strcmp(argv[3], "--uncompressed"))
+		compression = Compression::None;
+	else if (argc != 3)
+	{
+		std::cout << "Usage: AssetBaker <model.gltf> <model.pack> [--fast | --uncompressed]" << std::endl;
+		return 1;
+	}
+
+	const std::string source = argv[1];
+	const std::string target = argv[2];
+	// Written next to the target and renamed at the end, so a failed bake never leaves a package behind
+	const std::string temporary = target + ".tmp";
+
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point start = Clock::now();
+	InitSRGBTable();
+
+	ModelData model;
+	try
+	{
+		model = Model::Decode(source.c_str());
+	}
+	catch (...)
+	{
+		std::cout << "ERROR::ASSET_BAKER::MODEL_NOT_LOADED " << source << std::endl;
+		return 1;
+	}
+
+	// Only images some mesh uses get baked, and sRGB ones (base color) get their mips filtered in linear space
+	std::vector<bool> used(model.imagePaths.size(), false), sRGB(model.imagePaths.size(), false);
+	for (const MeshData& mesh : model.meshes)
+	{
+		for (unsigned int slot = 0; slot < mesh.images.size(); slot++)
+		{
+			int image = mesh.images[slot];
+			if (image < 0 || image >= (int)used.size())
+				continue;
+			used[image] = true;
+			if (static_cast<TextureType>(slot + 1) == TextureType::BaseColor)
+				sRGB[image] = true;
+		}
+	}
+
+	PackageWriter writer(temporary);
+	if (!writer.good())
+	{
+		std::cout << "ERROR::ASSET_BAKER::FILE_NOT_WRITTEN " << temporary << std::endl;
+		return 1;
+	}
+
+	Package::Header header = {};
+	header.magic = Package::Magic;
+	header.version = Package::Version;
+	header.meshCount = (uint32_t)model.meshes.size();
+	header.imageCount = (uint32_t)model.imagePaths.size();
+
+	std::vector<Package::MeshRecord> meshRecords(header.meshCount);
+	std::vector<Package::ImageRecord> imageRecords(header.imageCount);
+
+	// Reserve the header and the tables, they are patched in once every blob's offset is known
+	writer.Append(&header, sizeof(header));
+	header.meshTableOffset = writer.Append(meshRecords.data(), meshRecords.size() * sizeof(Package::MeshRecord));
+	header.imageTableOffset = writer.Append(imageRecords.data(), imageRecords.size() * sizeof(Package::ImageRecord));
+
+	for (uint32_t i = 0; i < header.meshCount; i++)
+	{
+		const MeshData& mesh = model.meshes[i];
+		Package::MeshRecord& record = meshRecords[i];
+		std::memcpy(record.matrix, glm::value_ptr(mesh.matrix), sizeof(record.matrix));
+		record.metallicFactor = mesh.metallicFactor;
+		record.roughnessFactor = mesh.roughnessFactor;
+		for (int slot = 0; slot < 4; slot++)
+			record.images[slot] = mesh.images[slot] >= 0 && mesh.images[slot] < (int)header.imageCount ? mesh.images[slot] : -1;
+		record.vertexCount = (uint32_t)mesh.vertices.size();
+		record.indexCount = (uint32_t)mesh.indices.size();
+		record.vertexOffset = writer.Append(mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+		record.indexOffset = writer.Append(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+	}
+
+	JobSystem jobs;
+	uint64_t pixelBytes = 0, rawBytes = 0;
+	for (uint32_t i = 0; i < header.imageCount; i++)
+	{
+		if (!used[i])
+			continue;
+
+		TextureData image = TextureData::Decode(model.imagePaths[i].c_str());
+		if (!image.valid())
+		{
+			// Left with zero levels, the model just goes without this texture like it would at runtime
+			std::cout << "Texture failed to load at path: " << model.imagePaths[i] << std::endl;
+			continue;
+		}
+
+		Package::ImageRecord& record = imageRecords[i];
+		record.width = (uint32_t)image.width;
+		record.height = (uint32_t)image.height;
+		const BlockFormat format = ChooseFormat(compression, image.channels, sRGB[i]);
+		record.channels = (uint32_t)DecodedChannels(format, image.channels);
+		record.format = (uint32_t)format;
+
+		std::vector<unsigned char> level(static_cast<const unsigned char*>(image.pixels.get()),
+										 static_cast<const unsigned char*>(image.pixels.get()) + (size_t)image.width * image.height * image.channels);
+		int width = image.width, height = image.height;
+		while (true)
+		{
+			// What the level takes in video memory uncompressed, the Texture constructor always asks for 4 channels
+			rawBytes += (uint64_t)width * height * 4;
+			if (format == BlockFormat::None)
+			{
+				record.levelOffsets[record.levelCount] = writer.Append(level.data(), level.size());
+				record.levelSizes[record.levelCount] = level.size();
+			}
+			else
+			{
+				std::vector<unsigned char> blocks = EncodeLevel(jobs, format, level, width, height, image.channels);
+				record.levelOffsets[record.levelCount] = writer.Append(blocks.data(), blocks.size());
+				record.levelSizes[record.levelCount] = blocks.size();
+			}
+			pixelBytes += record.levelSizes[record.levelCount];
+			record.levelCount++;
+
+			if ((width == 1 && height == 1) || record.levelCount == Package::MaxLevels)
+				break;
+
+			std::vector<unsigned char> next((size_t)std::max(1, width >> 1) * std::max(1, height >> 1) * image.channels);
+			Downsample(level.data(), width, height, image.channels, sRGB[i], next.data());
+			level = std::move(next);
+			width = std::max(1, width >> 1);
+			height = std::max(1, height >> 1);
+		}
+	}
+
+	writer.Patch(0, &header, sizeof(header));
+	writer.Patch(header.meshTableOffset, meshRecords.data(), meshRecords.size() * sizeof(Package::MeshRecord));
+	writer.Patch(header.imageTableOffset, imageRecords.data(), imageRecords.size() * sizeof(Package::ImageRecord));
+	bool written = writer.good();
+	writer.Close();
+
+	// Read it back the way the app will before it replaces the old package
+	try
+	{
+		if (!written)
+			throw std::runtime_error("ERROR::ASSET_BAKER::FILE_NOT_WRITTEN " + temporary);
+		PackageReader check(temporary.c_str());
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		std::remove(temporary.c_str());
+		return 1;
+	}
+
+	std::remove(target.c_str());
+	if (std::rename(temporary.c_str(), target.c_str()) != 0)
+	{
+		std::cout << "ERROR::ASSET_BAKER::FILE_NOT_WRITTEN " << target << std::endl;
+		return 1;
+	}
+
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	std::cout << std::fixed << std::setprecision(2)
+		<< "Baked " << target << ": " << header.meshCount << " meshes, " << header.imageCount << " images, "
+		<< pixelBytes / (1024.0 * 1024.0) << " MB of pixels (" << rawBytes / (1024.0 * 1024.0) << " MB as RGBA8) in " << seconds << " s" << std::endl;
+	return 0;
+}
@@ -0,0 +1,157 @@
+// Headless check of the block compression encoder.
+// Encodes a crop of every planet image into each block format that fits its channels, decodes it again on the CPU
+// and reports the PSNR and encode speed. Exits with 1 if any format comes out below its quality floor.
+//
+// CompressionBenchmark [--size N]
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "../Scripts/BlockCompression.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const char* s_Planets[] = { "Sun", "Mercury", "Venus", "Earth", "Mars", "Jupiter", "Saturn", "Uranus", "Neptune", "Pluto" };
+
+struct FormatInfo
+{
+	BlockFormat format;
+	const char* name;
+	// Channels the format is meant for, the check only runs it on images that have them
+	int minChannels, maxChannels;
+	// Lowest acceptable PSNR in dB over the channels it stores
+	double floor;
+};
+
+static const FormatInfo s_Formats[] =
+{
+	{ BlockFormat::BC1, "BC1", 3, 4, 34.0 },
+	{ BlockFormat::BC3, "BC3", 4, 4, 40.0 },
+	{ BlockFormat::BC4, "BC4", 1, 4, 36.0 },
+	{ BlockFormat::BC5, "BC5", 2, 4, 38.0 },
+	{ BlockFormat::BC7, "BC7", 3, 4, 40.0 }
+};
+
+// Channels of an image the format keeps
+static int StoredChannels(BlockFormat format, int channels)
+{
+	switch (format)
+	{
+	case BlockFormat::BC4:	return 1;
+	case BlockFormat::BC5:	return std::min(channels, 2);
+	case BlockFormat::BC1:	return std::min(channels, 3);
+	default:				return channels;
+	}
+}
+
+static double PSNR(const unsigned char* a, const unsigned char* b, size_t pixels, int channels, int compared)
+{
+	double squared = 0.0;
+	for (size_t i = 0; i < pixels; i++)
+		for (int c = 0; c < compared; c++)
+		{
+			double d = (double)a[i * channels + c] - (double)b[i * channels + c];
+			squared += d * d;
+		}
+	double mse = squared / ((double)pixels * compared);
+	return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+int main(int argc, char** argv)
+{
+	int size = 512;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!std::strcmp(argv[i], "--size") && i + 1 < argc)
+			size = std::max(0, std::atoi(argv[++i]));
+		else
+		{
+			std::cout << "Usage: CompressionBenchmark [--size N]    (crop edge in texels, 0 encodes whole images)" << std::endl;
+			return 1;
+		}
+	}
+
+	namespace fs = std::filesystem;
+	using Clock = std::chrono::steady_clock;
+
+	bool passed = true;
+	size_t images = 0;
+	double encodedPixels[5] = {}, encodeSeconds[5] = {}, worst[5] = { 99.0, 99.0, 99.0, 99.0, 99.0 };
+	for (const char* planet : s_Planets)
+	{
+		std::error_code error;
+		for (const fs::directory_entry& entry : fs::directory_iterator(fs::path(PROJECT_DIR"/src/Assets") / planet, error))
+		{
+			const std::string extension = entry.path().extension().string();
+			if (extension != ".png" && extension != ".jpg" && extension != ".jpeg")
+				continue;
+
+			int width, height, channels;
+			unsigned char* pixels = stbi_load(entry.path().string().c_str(), &width, &height, &channels, 0);
+			if (!pixels)
+			{
+				std::cout << "ERROR::COMPRESSION_BENCHMARK::IMAGE_NOT_LOADED " << entry.path().string() << std::endl;
+				passed = false;
+				continue;
+			}
+
+			// A crop from the middle keeps the run short while still seeing real surface detail
+			const int cropWidth = size > 0 ? std::min(size, width) : width;
+			const int cropHeight = size > 0 ? std::min(size, height) : height;
+			std::vector<unsigned char> crop((size_t)cropWidth * cropHeight * channels);
+			for (int y = 0; y < cropHeight; y++)
+				std::memcpy(crop.data() + (size_t)y * cropWidth * channels,
+							pixels + ((size_t)(y + (height - cropHeight) / 2) * width + (width - cropWidth) / 2) * channels, (size_t)cropWidth * channels);
+			stbi_image_free(pixels);
+			images++;
+
+			std::cout << planet << "/" << entry.path().filename().string() << " (" << channels << " channels)";
+			for (size_t f = 0; f < sizeof(s_Formats) / sizeof(s_Formats[0]); f++)
+			{
+				const FormatInfo& info = s_Formats[f];
+				if (channels < info.minChannels || channels > info.maxChannels)
+					continue;
+
+				std::vector<unsigned char> blocks(BlockCompression::LevelSize(info.format, cropWidth, cropHeight));
+				std::vector<unsigned char> decoded(crop.size());
+				Clock::time_point start = Clock::now();
+				BlockCompression::Encode(info.format, crop.data(), cropWidth, cropHeight, channels, blocks.data());
+				encodeSeconds[f] += std::chrono::duration<double>(Clock::now() - start).count();
+				encodedPixels[f] += (double)cropWidth * cropHeight;
+				BlockCompression::Decode(info.format, blocks.data(), cropWidth, cropHeight, channels, decoded.data());
+
+				const double psnr = PSNR(crop.data(), decoded.data(), (size_t)cropWidth * cropHeight, channels, StoredChannels(info.format, channels));
+				worst[f] = std::min(worst[f], psnr);
+				if (psnr < info.floor)
+					passed = false;
+				std::cout << "  " << info.name << " " << std::fixed << std::setprecision(1) << psnr << " dB" << (psnr < info.floor ? " (FAIL)" : "");
+			}
+			std::cout << std::endl;
+		}
+	}
+
+	if (images == 0)
+	{
+		std::cout << "ERROR::COMPRESSION_BENCHMARK::NO_IMAGES" << std::endl;
+		return 1;
+	}
+
+	std::cout << std::endl;
+	for (size_t f = 0; f < sizeof(s_Formats) / sizeof(s_Formats[0]); f++)
+	{
+		if (encodedPixels[f] == 0.0)
+			continue;
+		std::cout << s_Formats[f].name << ": worst " << std::fixed << std::setprecision(1) << worst[f] << " dB (floor " << s_Formats[f].floor << "), "
+				  << std::setprecision(2) << encodedPixels[f] / encodeSeconds[f] / 1e6 << " Mpixels/sec" << std::endl;
+	}
+	std::cout << (passed ? "ok" : "FAIL") << std::endl;
+	return passed ? 0 : 1;
+}
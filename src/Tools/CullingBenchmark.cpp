@@ -0,0 +1,146 @@
+// Culling check and benchmark.
+// Culls an asteroid belt from cameras around and inside it with the body BVH, compares every frame's visible and
+// sub-pixel sets with testing each body on its own, then reports the time per frame of both. Runs once with the whole belt
+// moving every frame and once with an eighth of it moving, which the BVH is told about.
+// Exits with 1 if any body is sorted differently (bodies within rounding of a plane or the pixel limit aside).
+
+#include "../Scripts/Culling.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "../../vendor/glm/gtc/matrix_transform.hpp"
+
+static const double Pi = 3.14159265358979323846;
+static const double PixelsPerRadian = 1080.0 / (2.0 * std::tan(45.0 * Pi / 360.0));
+static const float MinPixels = 1.0f;
+
+enum class Sorted { Culled, Visible, Point, Either };
+
+// What the BVH should make of one body, Either if it sits within rounding of a decision
+static Sorted expected(const Frustum& frustum, const glm::vec3& center, float radius)
+{
+	const float slack = 1e-4f * (glm::length(center) + radius);
+	float margin = INFINITY;
+	for (const glm::vec4& plane : frustum.planes)
+		margin = std::min(margin, glm::dot(glm::vec3(plane), center) + plane.w + radius);
+	if (std::abs(margin) < slack)
+		return Sorted::Either;
+	if (margin < 0.0f)
+		return Sorted::Culled;
+
+	const float distance = glm::length(center);
+	const float pixels = (float)(2.0 * radius * PixelsPerRadian) / distance;
+	if (std::abs(pixels - MinPixels) < 1e-3f * MinPixels)
+		return Sorted::Either;
+	return distance > radius && pixels < MinPixels ? Sorted::Point : Sorted::Visible;
+}
+
+// Culls 'frames' frames of the belt at 'belt' with the BVH and by testing each body, then prints the times. Every frame,
+// one in 'slices' bodies is moved along the belt by 'slices' times the turn of a frame. With more than one slice the BVH is
+// told which bodies those were. Returns false if any body is sorted differently.
+static bool run(const char* name, std::vector<glm::dvec3> positions, const std::vector<float>& radii, int slices)
+{
+	const int bodyCount = (int)positions.size();
+	const glm::mat4 projection = glm::perspective((float)(Pi / 4.0), 16.0f / 9.0f, 0.001f, 10000.0f);
+	const int frames = 60;
+
+	BodyBVH bvh;
+	std::vector<uint32_t> visible, points, moved;
+	std::vector<Sorted> sorted(bodyCount);
+	size_t mismatches = 0, totalVisible = 0, totalPoints = 0, refittedLeaves = 0;
+	double buildMs = 0.0, refitMs = 0.0, cullMs = 0.0, bruteMs = 0.0;
+	using Clock = std::chrono::steady_clock;
+
+	for (int frame = 0; frame < frames; frame++)
+	{
+		// The belt turns a little every frame, so the tree is refitted between rebuilds
+		const double turn = 0.001 * slices;
+		moved.clear();
+		for (int i = frame % slices; i < bodyCount; i += slices)
+		{
+			glm::dvec3& position = positions[i];
+			position = glm::dvec3(position.x * std::cos(turn) - position.z * std::sin(turn), position.y, position.x * std::sin(turn) + position.z * std::cos(turn));
+			moved.push_back((uint32_t)i);
+		}
+
+		// Cameras from far above the system down into the belt itself
+		const double height = frame % 3 == 0 ? 2000.0 : (frame % 3 == 1 ? 200.0 : 0.0);
+		const glm::dvec3 camera(400.0 * std::cos(frame * 0.1), height, 400.0 * std::sin(frame * 0.1));
+		const glm::vec3 forward = glm::normalize(glm::vec3(glm::dvec3(std::cos(frame * 0.7), -0.3, std::sin(frame * 1.3))));
+		const Frustum frustum = Frustum::FromMatrix(projection * glm::lookAt(glm::vec3(0.0f), forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+		// The first frame builds the tree, the others only refit the leaves bodies moved out of
+		Clock::time_point start = Clock::now();
+		if (slices == 1)
+			bvh.Update(positions.data(), radii.data(), positions.size());
+		else
+			bvh.Update(positions.data(), radii.data(), positions.size(), moved.data(), moved.size());
+		(frame == 0 ? buildMs : refitMs) += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		if (frame > 0)
+			refittedLeaves += bvh.RefittedLeaves();
+
+		start = Clock::now();
+		bvh.Cull(frustum, camera, PixelsPerRadian, MinPixels, visible, points);
+		cullMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		start = Clock::now();
+		for (int i = 0; i < bodyCount; i++)
+			sorted[i] = expected(frustum, glm::vec3(positions[i] - camera), radii[i]);
+		bruteMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		std::vector<Sorted> found(bodyCount, Sorted::Culled);
+		for (uint32_t body : visible)
+			found[body] = Sorted::Visible;
+		for (uint32_t body : points)
+			found[body] = Sorted::Point;
+		for (int i = 0; i < bodyCount; i++)
+			if (sorted[i] != Sorted::Either && sorted[i] != found[i])
+				mismatches++;
+
+		totalVisible += visible.size();
+		totalPoints += points.size();
+	}
+
+	const bool pass = mismatches == 0;
+	std::cout << (pass ? "ok   " : "FAIL ") << name << ": " << mismatches << " bodies sorted differently from testing each on its own over "
+		<< frames << " frames" << std::endl;
+
+	std::cout << std::fixed << std::setprecision(3)
+		<< "     " << bodyCount << " bodies, " << bvh.NodeCount() << " nodes, on average " << totalVisible / frames << " visible and "
+		<< totalPoints / frames << " sub-pixel" << std::endl
+		<< "     Each body : " << bruteMs / frames << " ms/frame" << std::endl
+		<< "     BVH       : " << buildMs << " ms build, then " << refitMs / (frames - 1) << " ms refit + " << cullMs / frames << " ms cull per frame, "
+		<< refittedLeaves / (frames - 1) << " leaves refitted per frame" << std::endl;
+	return pass;
+}
+
+int main(int argc, char** argv)
+{
+	int bodyCount = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200000;
+
+	// A belt between 2.2 and 3.2 AU (in millions of km), 1 to 500 km across, plus a few planet sized bodies
+	std::mt19937 random(2024);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	std::vector<glm::dvec3> positions(bodyCount);
+	std::vector<float> radii(bodyCount);
+	for (int i = 0; i < bodyCount; i++)
+	{
+		const double angle = 2.0 * Pi * unit(random);
+		const double distance = 330.0 + 150.0 * unit(random);
+		positions[i] = glm::dvec3(std::cos(angle) * distance, (unit(random) - 0.5) * 40.0, std::sin(angle) * distance);
+		radii[i] = (float)(0.0005 * std::pow(unit(random), 4.0) + 0.0000005);
+		if (i % 1000 == 0)
+			radii[i] = 0.07f;
+	}
+
+	// Every body moving every frame has the BVH check all of them. A belt this large is more likely stepped a slice at a time,
+	// then only the slice that moved is checked.
+	bool passed = run("whole belt moving", positions, radii, 1);
+	passed = run("an eighth of the belt moving", positions, radii, 8) && passed;
+	return passed ? 0 : 1;
+}
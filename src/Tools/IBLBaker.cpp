@@ -0,0 +1,126 @@
+// Offline bake of the image based lighting maps of an HDR environment, on the CPU with no GPU or GL context involved.
+// Writes the cache SolarSystem --cpu-ibl loads next to the HDR (or to CACHE) and prints the spherical harmonics of the irradiance.
+// --check bakes twice and fails unless both bakes are identical to the bit, then checks that a uniform environment
+// bakes to the same uniform radiance everywhere. Exits with 1 on failure.
+//
+// IBLBaker [ENVIRONMENT.hdr] [CACHE.ibl] [--check]
+
+#include "../Scripts/EnvironmentBaker.h"
+#include "../Scripts/IBLCache.h"
+#include "../Scripts/JobSystem.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double SecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// A uniform environment of radiance 1 has irradiance / PI 1 in every direction and prefilters to 1 at every roughness
+static bool CheckUniform(JobSystem& jobs)
+{
+	const int width = 256, height = 128;
+	std::vector<float> pixels((size_t)width * height * 3, 1.0f);
+	EnvironmentImage environment;
+	environment.pixels = pixels.data();
+	environment.width = width;
+	environment.height = height;
+
+	double worst = 0.0;
+	const SphericalHarmonics irradiance = EnvironmentBaker::ProjectIrradiance(environment, jobs);
+	const glm::vec3 directions[] = { glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, -1), glm::normalize(glm::vec3(1, -2, 3)) };
+	for (const glm::vec3& direction : directions)
+	{
+		const glm::vec3 value = irradiance.Evaluate(direction);
+		worst = std::max(worst, (double)std::abs(value.r - 1.0f) + std::abs(value.g - 1.0f) + std::abs(value.b - 1.0f));
+	}
+
+	const CubemapData prefiltered = EnvironmentBaker::Prefilter(EnvironmentBaker::Cubemap(environment, 16, jobs), 8, 3, jobs);
+	for (const std::vector<float>& level : prefiltered.levels)
+		for (float value : level)
+			worst = std::max(worst, (double)std::abs(value - 1.0f));
+
+	const bool passed = worst < 1e-3;
+	std::cout << "Uniform environment: worst error " << std::scientific << std::setprecision(2) << worst << std::defaultfloat
+			  << (passed ? "" : " (FAIL)") << std::endl;
+	return passed;
+}
+
+int main(int argc, char** argv)
+{
+	std::string hdr = PROJECT_DIR"/src/Assets/Space.hdr", cache;
+	bool check = false;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!std::strcmp(argv[i], "--check"))
+			check = true;
+		else if (argv[i][0] == '-' || paths.size() == 2)
+		{
+			std::cout << "Usage: IBLBaker [ENVIRONMENT.hdr] [CACHE.ibl] [--check]" << std::endl;
+			return 1;
+		}
+		else
+			paths.push_back(argv[i]);
+	}
+	if (paths.size() > 0)
+		hdr = paths[0];
+	cache = paths.size() > 1 ? paths[1] : hdr + ".cpu.ibl";
+
+	// Rows from the bottom up, the way the app decodes it for GL
+	stbi_set_flip_vertically_on_load(true);
+	int width = 0, height = 0, channels = 0;
+	float* pixels = stbi_loadf(hdr.c_str(), &width, &height, &channels, 3);
+	if (!pixels)
+	{
+		std::cout << "ERROR::IBL_BAKER::IMAGE_NOT_LOADED " << hdr << std::endl;
+		return 1;
+	}
+	EnvironmentImage environment;
+	environment.pixels = pixels;
+	environment.width = width;
+	environment.height = height;
+
+	JobSystem jobs;
+	const uint64_t key = IBLCache::BakerKey(hdr);
+	Clock::time_point start = Clock::now();
+	const std::vector<unsigned char> bytes = IBLCache::Bake(key, environment, jobs);
+	std::cout << hdr << " (" << width << "x" << height << ") baked in " << std::fixed << std::setprecision(2) << SecondsSince(start)
+			  << " s on " << jobs.WorkerCount() << " workers" << std::endl;
+
+	std::shared_ptr<IBLCacheReader> reader = IBLCacheReader::Read(std::make_shared<const std::vector<unsigned char>>(bytes), key, IBLCache::Maps(0, 0, 0, 0));
+	const SphericalHarmonics irradiance = reader->Irradiance();
+	std::cout << "Irradiance SH:" << std::setprecision(6) << std::endl;
+	for (const glm::vec3& coefficient : irradiance.coefficients)
+		std::cout << "  " << coefficient.r << " " << coefficient.g << " " << coefficient.b << std::endl;
+
+	bool passed = true;
+	if (check)
+	{
+		passed = IBLCache::Bake(key, environment, jobs) == bytes;
+		std::cout << "Second bake: " << (passed ? "identical" : "differs (FAIL)") << std::endl;
+		passed = CheckUniform(jobs) && passed;
+	}
+	stbi_image_free(pixels);
+
+	if (!IBLCache::Write(cache, bytes))
+	{
+		std::cout << "ERROR::IBL_BAKER::FILE_NOT_WRITTEN " << cache << std::endl;
+		return 1;
+	}
+	std::cout << "Cache written to " << cache << std::endl;
+	if (check)
+		std::cout << (passed ? "ok" : "FAIL") << std::endl;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+// Loader micro-benchmark.
+// Decodes the vertex and index data of every planet with the old per-float path
+// and with the strided accessor views, and reports vertices/sec for both.
+
+#include "../Scripts/Accessor.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+using json = nlohmann::json;
+
+static const char* s_Planets[] = { "Sun", "Mercury", "Venus", "Earth", "Mars", "Jupiter", "Saturn", "Uranus", "Neptune", "Pluto" };
+
+static std::vector<unsigned char> ReadBytes(const std::string& path)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in) throw std::runtime_error("Failed to open " + path);
+	std::vector<unsigned char> contents;
+	in.seekg(0, std::ios::end);
+	contents.resize(in.tellg());
+	in.seekg(0, std::ios::beg);
+	in.read(reinterpret_cast<char*>(contents.data()), contents.size());
+	return contents;
+}
+
+#pragma region Legacy Decoder
+
+// The decoder Model used before the accessor views, kept here as the baseline.
+namespace Legacy
+{
+	std::vector<float> getFloats(const json& JSON, const std::vector<unsigned char>& data, json accessor)
+	{
+		std::vector<float> floatVec;
+		unsigned int buffViewInd = accessor.value("bufferView", 1);
+		unsigned int count = accessor["count"];
+		unsigned int accByteOffset = accessor.value("byteOffset", 0);
+		std::string type = accessor["type"];
+		json bufferView = JSON["bufferViews"][buffViewInd];
+		unsigned int byteOffset = bufferView["byteOffset"];
+
+		unsigned int numPerVert = componentCount(type);
+		unsigned int beginningOfData = byteOffset + accByteOffset;
+		unsigned int lengthOfData = count * 4 * numPerVert;
+		for (volatile unsigned int i = beginningOfData; i < beginningOfData + lengthOfData; )
+		{
+			unsigned char bytes[4];
+			bytes[0] = data[i++]; bytes[1] = data[i++]; bytes[2] = data[i++]; bytes[3] = data[i++];
+			float value;
+			std::memcpy(&value, bytes, sizeof(float));
+			floatVec.push_back(value);
+		}
+		return floatVec;
+	}
+
+	std::vector<uint32_t> getIndices(const json& JSON, const std::vector<unsigned char>& data, json accessor)
+	{
+		std::vector<uint32_t> indices;
+		unsigned int buffViewInd = accessor.value("bufferView", 0);
+		unsigned int count = accessor["count"];
+		unsigned int accByteOffset = accessor.value("byteOffset", 0);
+		json bufferView = JSON["bufferViews"][buffViewInd];
+		unsigned int byteOffset = bufferView["byteOffset"];
+		unsigned int beginningOfData = byteOffset + accByteOffset;
+		for (volatile unsigned int i = beginningOfData; i < beginningOfData + count * 2; )
+		{
+			unsigned char bytes[2];
+			bytes[0] = data[i++]; bytes[1] = data[i++];
+			unsigned short value;
+			std::memcpy(&value, bytes, sizeof(unsigned short));
+			indices.push_back(value);
+		}
+		return indices;
+	}
+
+	template<int N>
+	std::vector<glm::vec3> groupFloatsVec3(std::vector<float> floatVec)
+	{
+		std::vector<glm::vec3> vectors;
+		for (volatile int i = 0; i < (int)floatVec.size(); )
+		{
+			vectors.push_back(glm::vec3(floatVec[i], floatVec[i + 1], floatVec[i + 2]));
+			i = i + N;
+		}
+		return vectors;
+	}
+
+	std::vector<glm::vec2> groupFloatsVec2(std::vector<float> floatVec)
+	{
+		std::vector<glm::vec2> vectors;
+		for (volatile int i = 0; i < (int)floatVec.size(); )
+		{
+			vectors.push_back(glm::vec2(floatVec[i], floatVec[i + 1]));
+			i = i + 2;
+		}
+		return vectors;
+	}
+
+	std::vector<Vertex> assembleVertices(std::vector<glm::vec3> positions, std::vector<glm::vec3> normals, std::vector<glm::vec3> tangents, std::vector<glm::vec2> texUVs)
+	{
+		std::vector<Vertex> vertices;
+		for (volatile int i = 0; i < (int)positions.size(); i++)
+			vertices.push_back(Vertex{ positions[i], normals[i], tangents[i], texUVs[i] });
+		return vertices;
+	}
+
+	std::vector<Vertex> decodeMesh(const json& JSON, const std::vector<unsigned char>& data, unsigned int indMesh, std::vector<uint32_t>& indices)
+	{
+		const json& attributes = JSON["meshes"][indMesh]["primitives"][0]["attributes"];
+		std::vector<glm::vec3> positions = groupFloatsVec3<3>(getFloats(JSON, data, JSON["accessors"][attributes["POSITION"].get<int>()]));
+		std::vector<glm::vec3> normals = groupFloatsVec3<3>(getFloats(JSON, data, JSON["accessors"][attributes["NORMAL"].get<int>()]));
+		std::vector<glm::vec3> tangents = groupFloatsVec3<4>(getFloats(JSON, data, JSON["accessors"][attributes["TANGENT"].get<int>()]));
+		std::vector<glm::vec2> texUVs = groupFloatsVec2(getFloats(JSON, data, JSON["accessors"][attributes["TEXCOORD_0"].get<int>()]));
+		std::vector<Vertex> vertices = assembleVertices(positions, normals, tangents, texUVs);
+		indices = getIndices(JSON, data, JSON["accessors"][JSON["meshes"][indMesh]["primitives"][0]["indices"].get<int>()]);
+		return vertices;
+	}
+}
+
+#pragma endregion
+
+static std::vector<Vertex> DecodeMeshWithViews(const json& JSON, const std::vector<std::vector<unsigned char>>& buffers, unsigned int indMesh, std::vector<uint32_t>& indices)
+{
+	const json& primitive = JSON["meshes"][indMesh]["primitives"][0];
+	const json& attributes = primitive["attributes"];
+	AccessorView positions = makeAccessorView(JSON, attributes.value("POSITION", -1), buffers);
+	AccessorView normals = makeAccessorView(JSON, attributes.value("NORMAL", -1), buffers);
+	AccessorView tangents = makeAccessorView(JSON, attributes.value("TANGENT", -1), buffers);
+	AccessorView texCoords = makeAccessorView(JSON, attributes.value("TEXCOORD_0", -1), buffers);
+	AccessorView indexView = makeAccessorView(JSON, primitive.value("indices", -1), buffers);
+
+	std::vector<Vertex> vertices(positions.count);
+	assembleVertices(positions, normals, tangents, texCoords, vertices.data(), vertices.size());
+	indices.resize(indexView.count);
+	readIndices(indexView, indices.data());
+	return vertices;
+}
+
+int main(int argc, char** argv)
+{
+	int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 50;
+
+	struct LoadedModel
+	{
+		std::string name;
+		json JSON;
+		std::vector<std::vector<unsigned char>> buffers;
+	};
+
+	// Parse and read everything up front, only the decoding is measured.
+	std::vector<LoadedModel> models;
+	for (const char* planet : s_Planets)
+	{
+		std::string directory = std::string(PROJECT_DIR"/src/Assets/") + planet + "/";
+		LoadedModel model;
+		model.name = planet;
+		std::vector<unsigned char> text = ReadBytes(directory + planet + ".gltf");
+		model.JSON = json::parse(text.begin(), text.end());
+		for (const json& buffer : model.JSON["buffers"])
+			model.buffers.push_back(ReadBytes(directory + buffer["uri"].get<std::string>()));
+		models.push_back(std::move(model));
+	}
+
+	// Both decoders have to agree before their speed means anything.
+	for (const LoadedModel& model : models)
+	{
+		for (unsigned int m = 0; m < model.JSON["meshes"].size(); m++)
+		{
+			std::vector<uint32_t> legacyIndices, viewIndices;
+			std::vector<Vertex> legacy = Legacy::decodeMesh(model.JSON, model.buffers[0], m, legacyIndices);
+			std::vector<Vertex> views = DecodeMeshWithViews(model.JSON, model.buffers, m, viewIndices);
+			if (legacy.size() != views.size() || legacyIndices != viewIndices ||
+				std::memcmp(legacy.data(), views.data(), legacy.size() * sizeof(Vertex)) != 0)
+			{
+				std::cout << "Decoders disagree on " << model.name << " mesh " << m << std::endl;
+				return 1;
+			}
+		}
+	}
+
+	using Clock = std::chrono::steady_clock;
+	size_t legacyVertices = 0, viewVertices = 0;
+	std::vector<uint32_t> indices;
+
+	Clock::time_point start = Clock::now();
+	for (int it = 0; it < iterations; it++)
+		for (const LoadedModel& model : models)
+			for (unsigned int m = 0; m < model.JSON["meshes"].size(); m++)
+				legacyVertices += Legacy::decodeMesh(model.JSON, model.buffers[0], m, indices).size();
+	double legacySeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (int it = 0; it < iterations; it++)
+		for (const LoadedModel& model : models)
+			for (unsigned int m = 0; m < model.JSON["meshes"].size(); m++)
+				viewVertices += DecodeMeshWithViews(model.JSON, model.buffers, m, indices).size();
+	double viewSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::cout << std::fixed << std::setprecision(1)
+		<< "Decoded " << models.size() << " models x " << iterations << " iterations\n"
+		<< "Per-float decoder  : " << legacyVertices / legacySeconds / 1.0e6 << " M vertices/sec (" << legacySeconds * 1000.0 << " ms)\n"
+		<< "Accessor views     : " << viewVertices / viewSeconds / 1.0e6 << " M vertices/sec (" << viewSeconds * 1000.0 << " ms)\n"
+		<< "Speedup            : " << std::setprecision(2) << legacySeconds / viewSeconds << "x" << std::endl;
+
+	return legacyVertices == viewVertices ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+// Headless N-body benchmark.
+// Integrates the scene's planets plus a synthetic asteroid belt under their mutual gravity and reports
+// the relative energy drift and steps/sec. Exits with 1 if the energy drifts more than --tolerance.
+//
+// NBodyBenchmark [--particles N] [--steps N] [--dt DAYS] [--integrator leapfrog|yoshida]
+//                [--theta T] [--threads N] [--tolerance T]
+
+#include "../Scripts/Scene.h"
+#include "../Scripts/NBody.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+// Total mass of the main belt, about 3% of the Moon's, in solar masses
+static const double BeltMass = 1.2e-9;
+
+static void printUsage()
+{
+	std::cout << "Usage: NBodyBenchmark [--particles N] [--steps N] [--dt DAYS] [--integrator leapfrog|yoshida]" << std::endl
+			  << "                      [--theta T] [--threads N] [--tolerance T]" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	int beltParticles = 100000;
+	int steps = 10;
+	double dt = 1.0;
+	double tolerance = 1e-4;
+	unsigned int threads = 0;
+	Integrator integrator = Integrator::Yoshida4;
+	double theta = 0.5;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const bool hasValue = i + 1 < argc;
+		if (!std::strcmp(argv[i], "--particles") && hasValue)
+			beltParticles = std::max(0, std::atoi(argv[++i]));
+		else if (!std::strcmp(argv[i], "--steps") && hasValue)
+			steps = std::max(1, std::atoi(argv[++i]));
+		else if (!std::strcmp(argv[i], "--dt") && hasValue)
+			dt = std::atof(argv[++i]);
+		else if (!std::strcmp(argv[i], "--theta") && hasValue)
+			theta = std::atof(argv[++i]);
+		else if (!std::strcmp(argv[i], "--threads") && hasValue)
+			threads = (unsigned int)std::max(0, std::atoi(argv[++i]));
+		else if (!std::strcmp(argv[i], "--tolerance") && hasValue)
+			tolerance = std::atof(argv[++i]);
+		else if (!std::strcmp(argv[i], "--integrator") && hasValue)
+		{
+			const char* name = argv[++i];
+			if (!std::strcmp(name, "leapfrog"))
+				integrator = Integrator::Leapfrog;
+			else if (!std::strcmp(name, "yoshida"))
+				integrator = Integrator::Yoshida4;
+			else
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else
+		{
+			printUsage();
+			return 1;
+		}
+	}
+
+	Scene scene;
+	try
+	{
+		scene = Scene::Load(PROJECT_DIR"/src/Assets/Scene.json");
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+
+	#pragma region Initial Conditions
+
+	JobSystem jobs(threads);
+	NBody simulation(jobs);
+	simulation.integrator = integrator;
+	simulation.theta = theta;
+
+	// Bodies without an orbit (the Sun) start at rest where the scene puts them, the planets on their J2000 orbits
+	int orbit = 0;
+	for (size_t body = 0; body < scene.bodies.size(); body++)
+	{
+		glm::dvec3 position = scene.bodies.positions[body], velocity(0.0);
+		if (orbit < (int)scene.orbits.size() && scene.orbits.bodies[orbit] == body)
+			Orbits::StateVector(scene.orbits, orbit++, 0.0, position, velocity);
+		simulation.AddParticle(position, velocity, scene.bodies.masses[body]);
+	}
+
+	// Main belt asteroids on Keplerian orbits around the Sun, the planets perturb them from there
+	std::mt19937 random(2024);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	OrbitTable belt;
+	for (int i = 0; i < beltParticles; i++)
+	{
+		OrbitalElements elements;
+		elements.semiMajorAxis = 2.1 + 1.2 * unit(random);
+		elements.eccentricity = 0.2 * unit(random);
+		elements.inclination = 15.0 * unit(random);
+		elements.meanLongitude = 360.0 * unit(random);
+		elements.longitudeOfPerihelion = 360.0 * unit(random);
+		elements.longitudeOfAscendingNode = 360.0 * unit(random);
+		belt.Add((uint32_t)i, elements);
+	}
+	for (size_t i = 0; i < belt.size(); i++)
+	{
+		glm::dvec3 position, velocity;
+		Orbits::StateVector(belt, i, 0.0, position, velocity);
+		simulation.AddParticle(position, velocity, BeltMass / beltParticles);
+	}
+	simulation.CenterOnBarycenter();
+
+	#pragma endregion
+
+	#pragma region Benchmark
+
+	std::cout << simulation.size() << " particles, " << steps << " " << (integrator == Integrator::Leapfrog ? "leapfrog" : "Yoshida")
+			  << " steps of " << dt << " days, theta " << theta << ", " << jobs.WorkerCount() << " worker(s)" << std::endl;
+
+	using Clock = std::chrono::steady_clock;
+	const double initialEnergy = simulation.TotalEnergy();
+	double stepSeconds = 0.0;
+	double worstDrift = 0.0;
+	const int reports = std::min(steps, 10);
+	for (int step = 1; step <= steps; step++)
+	{
+		Clock::time_point start = Clock::now();
+		simulation.Step(dt);
+		stepSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+		if (step % (steps / reports) == 0 || step == steps)
+		{
+			const double drift = std::abs((simulation.TotalEnergy() - initialEnergy) / initialEnergy);
+			worstDrift = std::isfinite(drift) ? std::max(worstDrift, drift) : INFINITY;
+			std::cout << "  day " << std::setw(8) << std::fixed << std::setprecision(1) << step * dt
+					  << "  energy drift " << std::scientific << std::setprecision(3) << drift << std::endl;
+		}
+	}
+
+	const bool stable = worstDrift <= tolerance;
+	std::cout << std::scientific << std::setprecision(3) << (stable ? "ok   " : "FAIL ")
+			  << "worst relative energy drift " << worstDrift << " (tolerance " << tolerance << ")" << std::endl
+			  << std::fixed << std::setprecision(2) << steps / stepSeconds << " steps/sec, "
+			  << std::setprecision(0) << simulation.size() * steps / stepSeconds << " particle steps/sec" << std::endl;
+
+	#pragma endregion
+
+	return stable ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+// Orbit propagation check and benchmark.
+// Propagates the scene's planets and compares them with JPL Horizons positions, checks the vectorized
+// Kepler solver against the double precision reference, then reports bodies/ms for both.
+// Exits with 1 if any check fails.
+
+#include "../Scripts/Scene.h"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+static const double Pi = 3.14159265358979323846;
+
+// Heliocentric J2000 ecliptic positions in AU from JPL Horizons
+struct Ephemeris
+{
+	const char* body;
+	double daysSinceJ2000;
+	glm::dvec3 position;
+};
+
+static const Ephemeris s_Ephemerides[] =
+{
+	{ "Earth",   0.0, glm::dvec3(-0.1771354586,  0.9672416237, -0.0000039000) },
+	{ "Mars",    0.0, glm::dvec3( 1.3907159210, -0.0134157540, -0.0344671530) },
+	{ "Jupiter", 0.0, glm::dvec3( 4.0011770000,  2.9382550000, -0.1017010000) },
+	{ "Saturn",  0.0, glm::dvec3( 6.4064080000,  6.5700150000, -0.3690000000) },
+};
+
+// March equinox 2000-03-20 07:35 UTC, the Sun is at ecliptic longitude 0 so the Earth is at 180 degrees
+static const double s_EquinoxDays = 2451623.816 - Orbits::J2000;
+
+// Render space back to the ecliptic in AU
+static glm::dvec3 toEcliptic(const glm::dvec3& render)
+{
+	return glm::dvec3(render.x, -render.z, render.y) / Orbits::SceneUnitsPerAU;
+}
+
+static int findBody(const Scene& scene, const char* name)
+{
+	for (size_t i = 0; i < scene.bodies.size(); i++)
+		if (scene.bodies.names[i] == name)
+			return (int)i;
+	return -1;
+}
+
+int main(int argc, char** argv)
+{
+	int bodyCount = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100000;
+	bool failed = false;
+
+	Scene scene;
+	try
+	{
+		scene = Scene::Load(PROJECT_DIR"/src/Assets/Scene.json");
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+
+	#pragma region Ephemeris
+
+	std::cout << std::fixed << std::setprecision(4);
+	for (const Ephemeris& expected : s_Ephemerides)
+	{
+		int body = findBody(scene, expected.body);
+		if (body < 0)
+		{
+			std::cout << "FAIL " << expected.body << " is not in the scene" << std::endl;
+			failed = true;
+			continue;
+		}
+
+		scene.Propagate(expected.daysSinceJ2000);
+		glm::dvec3 position = toEcliptic(scene.bodies.positions[body]);
+		// The element tables are only good to a few hundred arcseconds for the outer planets
+		double error = glm::length(position - expected.position);
+		bool pass = error < 0.01 * glm::length(expected.position);
+		failed |= !pass;
+		std::cout << (pass ? "ok   " : "FAIL ") << std::setw(8) << std::left << expected.body << std::right
+			<< " (" << position.x << ", " << position.y << ", " << position.z << ") AU, off by " << error << " AU" << std::endl;
+	}
+
+	int earth = findBody(scene, "Earth");
+	if (earth >= 0)
+	{
+		scene.Propagate(s_EquinoxDays);
+		glm::dvec3 position = toEcliptic(scene.bodies.positions[earth]);
+		double longitude = std::atan2(position.y, position.x) * 180.0 / Pi;
+		if (longitude < 0.0)
+			longitude += 360.0;
+		bool pass = std::abs(longitude - 180.0) < 0.2;
+		failed |= !pass;
+		std::cout << (pass ? "ok   " : "FAIL ") << "Earth at the March 2000 equinox is at longitude " << longitude << " degrees" << std::endl;
+	}
+
+	#pragma endregion
+
+	#pragma region Solver Accuracy
+
+	// Random orbits up to e = 0.97, the vectorized solver has to match the double precision one
+	std::mt19937 random(2024);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	OrbitTable orbits;
+	for (int i = 0; i < bodyCount; i++)
+	{
+		OrbitalElements elements;
+		elements.semiMajorAxis = 0.3 + 50.0 * unit(random);
+		elements.eccentricity = 0.97 * unit(random);
+		elements.inclination = 180.0 * unit(random);
+		elements.meanLongitude = 360.0 * unit(random);
+		elements.longitudeOfPerihelion = 360.0 * unit(random);
+		elements.longitudeOfAscendingNode = 360.0 * unit(random);
+		orbits.Add((uint32_t)i, elements);
+	}
+
+	std::vector<glm::dvec3> vectorized(bodyCount), reference(bodyCount);
+	double worst = 0.0;
+	for (double days : { 0.0, 1234.5, 98765.4 })
+	{
+		Orbits::Propagate(orbits, days, vectorized.data());
+		Orbits::PropagateScalar(orbits, days, reference.data());
+		for (int i = 0; i < bodyCount; i++)
+			worst = std::max(worst, glm::length(vectorized[i] - reference[i]) / orbits.semiMajorAxes[i]);
+	}
+	bool accurate = worst < 1e-4;
+	failed |= !accurate;
+	std::cout << std::scientific << std::setprecision(2) << (accurate ? "ok   " : "FAIL ")
+		<< Orbits::SimdPath() << " solver is within " << worst << " semi-major axes of the reference" << std::endl;
+
+	#pragma endregion
+
+	#pragma region Benchmark
+
+	using Clock = std::chrono::steady_clock;
+	const int iterations = 20;
+
+	Clock::time_point start = Clock::now();
+	for (int it = 0; it < iterations; it++)
+		Orbits::Propagate(orbits, it * 0.5, vectorized.data());
+	double vectorizedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (int it = 0; it < iterations; it++)
+		Orbits::PropagateScalar(orbits, it * 0.5, reference.data());
+	double scalarMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	std::cout << std::fixed << std::setprecision(0)
+		<< "Scalar : " << (double)bodyCount * iterations / scalarMs << " bodies/ms" << std::endl
+		<< std::setw(7) << std::left << Orbits::SimdPath() << std::right << ": " << (double)bodyCount * iterations / vectorizedMs << " bodies/ms"
+		<< std::setprecision(2) << " (" << scalarMs / vectorizedMs << "x)" << std::endl;
+
+	#pragma endregion
+
+	return failed ? 1 : 0;
+}